@@ -9,6 +9,7 @@
 *******************************************************************************/
 #include <stdio.h>
 #include <inttypes.h>
+#include <stdbool.h>
 
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
@@ -22,12 +23,22 @@
 #include "zigbeeManager.h"
 #include "userInterface.h"
 #include "sensorController.h"
+#include "diagCluster.h"
+#include "bootTrace.h"
+#include "powerManager.h"
+#include "eventLoop.h"
+#include "healthMonitor.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
+#define MAIN_PM_STATS_PERIOD_S          (10 * 60)//PM lock stats and health report dump period
+#define MAIN_HEALTH_SAMPLE_PERIOD_S     (60)//Stack and heap sampling period
+#define MAIN_HOUSEKEEPING_PERIOD_MS     (1000)
+#define MAIN_TASK_STACK_SIZE            (3 * 2048)
+
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
@@ -43,6 +54,8 @@
 *******************************************************************************/
 static void networkChangeCallback(ZIGBEE_Nwk_State_t nwk_state);
 
+static void housekeeping(void *pArg);
+
 static void tMainTask(void *pvParameters);
 
 /******************************************************************************
@@ -54,6 +67,13 @@ static void tMainTask(void *pvParameters);
 *   Private Variables
 *******************************************************************************/
 static TaskHandle_t main_task_handle = NULL;
+static StaticTask_t main_task_buffer;
+static StackType_t main_task_stack[MAIN_TASK_STACK_SIZE];
+static bool zigbee_started = false;
+
+#if EVLOOP_ENABLE
+static EVLOOP_Timer_t housekeeping_timer;
+#endif
 
 static const char * TAG = "MAIN";
 
@@ -72,6 +92,18 @@ static const char * TAG = "MAIN";
 *******************************************************************************/
 void app_main(void){
 
+    BOOT_TRACE_Mark(BOOT_TRACE_APP_MAIN);
+
+    //Init power management first, modules acquire their locks during init
+    if(PWR_STATUS_OK != PWR_Init()){
+        ESP_LOGI(TAG, "Failed to init power manager");
+    }
+
+    //Init health monitor before any task is created
+    if(HEALTH_STATUS_OK != HEALTH_Init()){
+        ESP_LOGI(TAG, "Failed to init health monitor");
+    }
+
     /* Print chip information */
     esp_chip_info_t chip_info;
     uint32_t flash_size;
@@ -97,13 +129,15 @@ void app_main(void){
 
     printf("Minimum free heap size: %" PRIu32 " bytes\n", esp_get_minimum_free_heap_size());
 
-    //Create main task
-    if(pdTRUE != xTaskCreate(tMainTask,
-                             "Main task",
-                             3*2048,
-                             NULL,
-                             4,
-                             &main_task_handle)){
+    //Create main task, it runs the event loop after the init (event loop mode)
+    main_task_handle = xTaskCreateStatic(tMainTask,
+                                         "Main task",
+                                         MAIN_TASK_STACK_SIZE,
+                                         NULL,
+                                         4,
+                                         main_task_stack,
+                                         &main_task_buffer);
+    if(main_task_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create main task");
         while(1);
@@ -128,25 +162,30 @@ static void networkChangeCallback(ZIGBEE_Nwk_State_t nwk_state){
     switch(nwk_state){
         case ZIGBEE_NWK_NOT_CONNECTED:
         {
-            UI_PostEvent(UI_EVENT_NOT_CONNECTED, 0);
+            UI_PostEvent(UI_EVENT_NOT_CONNECTED);
         }
         break;
 
         case ZIGBEE_NWK_CONNECTED:
         {
-            UI_PostEvent(UI_EVENT_CONNECTED, 0);
+            UI_PostEvent(UI_EVENT_CONNECTED);
+
+            //Ignore the state restored from NVS before the stack is started
+            if(zigbee_started){
+                SENSOR_NotifyConnected();
+            }
         }
         break;
 
         case ZIGBEE_NWK_NO_PARENT:
         {
-            UI_PostEvent(UI_EVENT_NO_COORDO, 0);
+            UI_PostEvent(UI_EVENT_NO_COORDO);
         }
         break;
 
         case ZIGBEE_NWK_SCANNING:
         {
-            UI_PostEvent(UI_EVENT_SCANNING, 0);
+            UI_PostEvent(UI_EVENT_SCANNING);
         }
         break;
 
@@ -158,10 +197,72 @@ static void networkChangeCallback(ZIGBEE_Nwk_State_t nwk_state){
     }
 }
 
+/***************************************************************************//*!
+*  \brief Housekeeping.
+*
+*   Called every MAIN_HOUSEKEEPING_PERIOD_MS. Dump the boot timeline once at
+*   the end of boot, sample the stacks, heap and TX power stats, and dump the
+*   PM lock stats, the health report and the TX power stats periodically.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void housekeeping(void *pArg){
+
+    static bool boot_trace_dumped = false;
+    static uint32_t pm_stats_cptr = 0;
+    static uint32_t health_cptr = 0;
+
+    //Dump boot timeline once at the end of boot
+    if((!boot_trace_dumped) && BOOT_TRACE_IsComplete()){
+        boot_trace_dumped = true;
+        BOOT_TRACE_Dump();
+
+        if(zigbee_started && (DIAG_CLUSTER_STATUS_OK != DIAG_UpdateBootTrace())){
+            ESP_LOGI(TAG, "Failed to update boot trace attribs");
+        }
+    }
+
+    //Track stack and heap margins, and the TX power control
+    health_cptr++;
+    if(health_cptr >= (MAIN_HEALTH_SAMPLE_PERIOD_S * 1000 / MAIN_HOUSEKEEPING_PERIOD_MS)){
+        health_cptr = 0;
+        HEALTH_Sample();
+
+        if(zigbee_started && (DIAG_CLUSTER_STATUS_OK != DIAG_UpdateHealth())){
+            ESP_LOGI(TAG, "Failed to update health attribs");
+        }
+
+        if(zigbee_started && (DIAG_CLUSTER_STATUS_OK != DIAG_UpdateTxPower())){
+            ESP_LOGI(TAG, "Failed to update TX power attribs");
+        }
+    }
+
+    //Show which modules keep the chip awake, how much stack they need and the radio savings
+    pm_stats_cptr++;
+    if(pm_stats_cptr >= (MAIN_PM_STATS_PERIOD_S * 1000 / MAIN_HOUSEKEEPING_PERIOD_MS)){
+        pm_stats_cptr = 0;
+        PWR_DumpLockStats();
+        HEALTH_DumpReport();
+        if(zigbee_started){
+            ZIGBEE_DumpTxPowerStats();
+        }
+    }
+
+#if EVLOOP_ENABLE
+    EVLOOP_StartTimer(&housekeeping_timer, MAIN_HOUSEKEEPING_PERIOD_MS);
+#endif
+}
+
 /***************************************************************************//*!
 *  \brief Main task.
 *
-*   Main task.
+*   Main task. Init the modules, then run the event loop, or the
+*   housekeeping loop in task mode.
 *   
 *   Preconditions: None.
 *
@@ -173,32 +274,50 @@ static void networkChangeCallback(ZIGBEE_Nwk_State_t nwk_state){
 static void tMainTask(void *pvParameters){
 
     ESP_LOGI(TAG, "Starting Main task");
+    BOOT_TRACE_Mark(BOOT_TRACE_MAIN_TASK);
+
+    //Registered from the task itself, it may exit before app_main resumes
+    HEALTH_RegisterTask(HEALTH_TASK_MAIN, xTaskGetCurrentTaskHandle(), MAIN_TASK_STACK_SIZE);
 
     //Init User Interface
     if(UI_STATUS_OK != UI_Init()){
         ESP_LOGI(TAG, "Failed to init UI");
     }
 
+    BOOT_TRACE_Mark(BOOT_TRACE_UI_INIT);
+
+    //Init sensor (probe sensors before building the Zigbee endpoints)
+    if(SENSOR_STATUS_OK != SENSOR_InitController()){
+        ESP_LOGI(TAG, "Failed to init sensor");
+    }
+    BOOT_TRACE_Mark(BOOT_TRACE_SENSOR_INIT);
+
     //Init Zigbee stack
-    if(ZIGBEE_STATUS_OK != ZIGBEE_InitStack(networkChangeCallback)){
+    if(ZIGBEE_STATUS_OK != ZIGBEE_InitStack(networkChangeCallback, SENSOR_GetCapabilities())){
         ESP_LOGI(TAG, "Failed to init Zigbee stack");
     }
     else{
+        BOOT_TRACE_Mark(BOOT_TRACE_ZB_INIT_DONE);
+
         //Start Zigbee stack
+        zigbee_started = true;
         ZIGBEE_StartStack();
     }
 
-    //Init sensor
-    if(SENSOR_STATUS_OK != SENSOR_InitController()){
-        ESP_LOGI(TAG, "Failed to init sensor");
-    }
+#if EVLOOP_ENABLE
+    //UI, LED, sequencer, sensor and housekeeping now run on the event loop,
+    //on this task stack. Keep the init stack usage in the health report.
+    EVLOOP_InitTimer(&housekeeping_timer, housekeeping, NULL);
+    EVLOOP_StartTimer(&housekeeping_timer, MAIN_HOUSEKEEPING_PERIOD_MS);
 
+    HEALTH_UnregisterTask(HEALTH_TASK_MAIN);
+    EVLOOP_Run(MAIN_TASK_STACK_SIZE);
+#else
     for(;;){
-
-        vTaskDelay(1000/portTICK_PERIOD_MS);
+        housekeeping(NULL);
+        vTaskDelay(MAIN_HOUSEKEEPING_PERIOD_MS/portTICK_PERIOD_MS);
     }
-
-    vTaskDelete(NULL);
+#endif
 }
 
 /******************************************************************************
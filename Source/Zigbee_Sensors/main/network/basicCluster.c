@@ -58,12 +58,13 @@ static const char * TAG = "BASIC";
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-BASIC_Cluster_Ret_t BASIC_IntiCluster(esp_zb_cluster_list_t *pCluster_list){
+BASIC_Cluster_Ret_t BASIC_IntiCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
 
     ESP_LOGI(TAG, "Cluster Initialization");
 
@@ -45,11 +45,12 @@ typedef enum BASIC_Cluster_Ret_e{
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-BASIC_Cluster_Ret_t BASIC_IntiCluster(esp_zb_cluster_list_t *pCluster_list);
+BASIC_Cluster_Ret_t BASIC_IntiCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
 
 #endif//_BASIC_CLUSTER_H
\ No newline at end of file
@@ -0,0 +1,348 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "esp_log.h"
+#include "esp_zigbee_cluster.h"
+
+#include "diagCluster.h"
+#include "zigbeeManager.h"
+#include "bootTrace.h"
+#include "healthMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static uint8_t cluster_endpoint = 0;//Set at cluster init
+
+static const char * TAG = "DIAG";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Diagnostic cluster initialization.
+*
+*   Initialize the manufacturer specific Diagnostic cluster (server role) and
+*   add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    cluster_endpoint = endpoint;
+
+    ESP_LOGI(TAG, "Cluster Initialization");
+
+    esp_zb_attribute_list_t *pDiagCluster = esp_zb_zcl_attr_list_create(DIAG_CLUSTER_ID);
+
+#if BOOT_TRACE_ZIGBEE_ATTR
+    uint32_t not_reached = BOOT_TRACE_NOT_REACHED;
+
+    for(uint8_t i = 0; i < BOOT_TRACE_NB; i++){
+        if(ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                           DIAG_ATTR_BOOT_TRACE_BASE_ID + i,
+                                                           ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                           ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                           &not_reached)){
+
+            ESP_LOGI(TAG, "Failed to add boot trace attribs");
+            return DIAG_CLUSTER_STATUS_ERROR;
+        }
+    }
+#endif
+
+#if HEALTH_ZIGBEE_ATTR
+    uint32_t heap_not_sampled = 0;
+    uint16_t stack_not_sampled = HEALTH_NOT_SAMPLED;
+
+    if((ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_HEAP_MIN_FREE_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &heap_not_sampled)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_HEAP_MIN_BLOCK_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &heap_not_sampled))){
+
+        ESP_LOGI(TAG, "Failed to add heap attribs");
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+
+    for(uint8_t i = 0; i < HEALTH_TASK_NB; i++){
+        if(ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                           DIAG_ATTR_STACK_FREE_BASE_ID + i,
+                                                           ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                                           ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                           &stack_not_sampled)){
+
+            ESP_LOGI(TAG, "Failed to add stack attribs");
+            return DIAG_CLUSTER_STATUS_ERROR;
+        }
+    }
+#endif
+
+#if ZIGBEE_TXP_ZIGBEE_ATTR
+    int8_t tx_power_unknown = 0;
+    uint8_t u8_not_sampled = 0;
+    uint32_t u32_not_sampled = 0;
+
+    if((ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_TX_POWER_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_S8,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &tx_power_unknown)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_PARENT_LQI_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U8,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &u8_not_sampled)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_NB_TX_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &u32_not_sampled)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_NB_TX_FAILED_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &u32_not_sampled)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_TX_LEVEL_CHANGE_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &u32_not_sampled)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pDiagCluster,
+                                                        DIAG_ATTR_TX_ENERGY_SAVED_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U8,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &u8_not_sampled))){
+
+        ESP_LOGI(TAG, "Failed to add TX power attribs");
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+#endif
+
+    if(ESP_OK != esp_zb_cluster_list_add_custom_cluster(pCluster_list,
+                                                        pDiagCluster,
+                                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE)){
+
+        ESP_LOGI(TAG, "Failed to add Diagnostic cluster");
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+
+    return DIAG_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Update boot trace attributes.
+*
+*   Copy the boot milestones times to the Diagnostic cluster attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateBootTrace(void){
+
+#if BOOT_TRACE_ZIGBEE_ATTR
+    esp_zb_zcl_status_t ret = ESP_ZB_ZCL_STATUS_SUCCESS;
+
+    esp_zb_lock_acquire(portMAX_DELAY);
+
+    for(uint8_t i = 0; (i < BOOT_TRACE_NB) && (ret == ESP_ZB_ZCL_STATUS_SUCCESS); i++){
+        uint32_t time_ms = BOOT_TRACE_GetMs(i);
+        ret = esp_zb_zcl_set_attribute_val(cluster_endpoint,
+                                           DIAG_CLUSTER_ID,
+                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                           DIAG_ATTR_BOOT_TRACE_BASE_ID + i,
+                                           &time_ms,
+                                           false);
+    }
+
+    esp_zb_lock_release();
+
+    if(ret != ESP_ZB_ZCL_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "Failed to set attrib: 0x%02x", ret);
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+#endif
+
+    return DIAG_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Update health attributes.
+*
+*   Copy the heap minimums and the lowest free stack of every task to the
+*   Diagnostic cluster attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateHealth(void){
+
+#if HEALTH_ZIGBEE_ATTR
+    esp_zb_zcl_status_t ret = ESP_ZB_ZCL_STATUS_SUCCESS;
+
+    HEALTH_Heap_Stats_t heap;
+    HEALTH_GetHeapStats(&heap);
+
+    uint16_t stack_free_table[HEALTH_TASK_NB];
+    for(uint8_t i = 0; i < HEALTH_TASK_NB; i++){
+        HEALTH_Task_Stats_t stats;
+        stack_free_table[i] = HEALTH_NOT_SAMPLED;
+        if((HEALTH_STATUS_OK == HEALTH_GetTaskStats((HEALTH_Task_Id_t)i, &stats)) &&
+           (stats.min_free < HEALTH_NOT_SAMPLED)){
+
+            stack_free_table[i] = (uint16_t)stats.min_free;
+        }
+    }
+
+    esp_zb_lock_acquire(portMAX_DELAY);
+
+    ret = esp_zb_zcl_set_attribute_val(cluster_endpoint,
+                                       DIAG_CLUSTER_ID,
+                                       ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                       DIAG_ATTR_HEAP_MIN_FREE_ID,
+                                       &heap.min_free,
+                                       false);
+
+    if(ret == ESP_ZB_ZCL_STATUS_SUCCESS){
+        ret = esp_zb_zcl_set_attribute_val(cluster_endpoint,
+                                           DIAG_CLUSTER_ID,
+                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                           DIAG_ATTR_HEAP_MIN_BLOCK_ID,
+                                           &heap.min_largest_block,
+                                           false);
+    }
+
+    for(uint8_t i = 0; (i < HEALTH_TASK_NB) && (ret == ESP_ZB_ZCL_STATUS_SUCCESS); i++){
+        ret = esp_zb_zcl_set_attribute_val(cluster_endpoint,
+                                           DIAG_CLUSTER_ID,
+                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                           DIAG_ATTR_STACK_FREE_BASE_ID + i,
+                                           &stack_free_table[i],
+                                           false);
+    }
+
+    esp_zb_lock_release();
+
+    if(ret != ESP_ZB_ZCL_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "Failed to set attrib: 0x%02x", ret);
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+#endif
+
+    return DIAG_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Update TX power attributes.
+*
+*   Copy the TX power control statistics to the Diagnostic cluster
+*   attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateTxPower(void){
+
+#if ZIGBEE_TXP_ZIGBEE_ATTR
+    ZIGBEE_TxPower_Stats_t stats;
+    if(ZIGBEE_STATUS_OK != ZIGBEE_GetTxPowerStats(&stats)){
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+
+    struct{
+        uint16_t attr_id;
+        void *pValue;
+    }attr_table[] = {
+        {DIAG_ATTR_TX_POWER_ID,         &stats.tx_power_dbm},
+        {DIAG_ATTR_PARENT_LQI_ID,       &stats.parent_lqi},
+        {DIAG_ATTR_NB_TX_ID,            &stats.nb_tx},
+        {DIAG_ATTR_NB_TX_FAILED_ID,     &stats.nb_tx_failed},
+        {DIAG_ATTR_TX_LEVEL_CHANGE_ID,  &stats.nb_level_change},
+        {DIAG_ATTR_TX_ENERGY_SAVED_ID,  &stats.energy_saved_pct},
+    };
+
+    esp_zb_zcl_status_t ret = ESP_ZB_ZCL_STATUS_SUCCESS;
+
+    esp_zb_lock_acquire(portMAX_DELAY);
+
+    for(uint8_t i = 0; (i < (sizeof(attr_table) / sizeof(attr_table[0]))) && (ret == ESP_ZB_ZCL_STATUS_SUCCESS); i++){
+        ret = esp_zb_zcl_set_attribute_val(cluster_endpoint,
+                                           DIAG_CLUSTER_ID,
+                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                           attr_table[i].attr_id,
+                                           attr_table[i].pValue,
+                                           false);
+    }
+
+    esp_zb_lock_release();
+
+    if(ret != ESP_ZB_ZCL_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "Failed to set attrib: 0x%02x", ret);
+        return DIAG_CLUSTER_STATUS_ERROR;
+    }
+#endif
+
+    return DIAG_CLUSTER_STATUS_OK;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
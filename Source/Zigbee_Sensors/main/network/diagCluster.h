@@ -0,0 +1,113 @@
+#ifndef _DIAG_CLUSTER_H
+#define _DIAG_CLUSTER_H
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define DIAG_CLUSTER_ID                 (0xFC01)//Manufacturer specific
+
+#define DIAG_ATTR_BOOT_TRACE_BASE_ID    (0x0000)//One U32 attrib (ms) per boot milestone
+#define DIAG_ATTR_HEAP_MIN_FREE_ID      (0x0100)//U32, lowest free heap (bytes)
+#define DIAG_ATTR_HEAP_MIN_BLOCK_ID     (0x0101)//U32, lowest largest free block (bytes)
+#define DIAG_ATTR_STACK_FREE_BASE_ID    (0x0110)//One U16 attrib (bytes) per HEALTH task
+#define DIAG_ATTR_TX_POWER_ID           (0x0200)//S8, selected TX power (dBm)
+#define DIAG_ATTR_PARENT_LQI_ID         (0x0201)//U8, parent LQI at the last TX power update
+#define DIAG_ATTR_NB_TX_ID              (0x0202)//U32, APS sends
+#define DIAG_ATTR_NB_TX_FAILED_ID       (0x0203)//U32, APS sends not acknowledged
+#define DIAG_ATTR_TX_LEVEL_CHANGE_ID    (0x0204)//U32, TX power changes
+#define DIAG_ATTR_TX_ENERGY_SAVED_ID    (0x0205)//U8, estimated TX energy saved vs max TX power (%)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum DIAG_Cluster_Ret_e{
+    DIAG_CLUSTER_STATUS_ERROR,
+    DIAG_CLUSTER_STATUS_OK,
+}DIAG_Cluster_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Diagnostic cluster initialization.
+*
+*   Initialize the manufacturer specific Diagnostic cluster (server role) and
+*   add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+/***************************************************************************//*!
+*  \brief Update boot trace attributes.
+*
+*   Copy the boot milestones times to the Diagnostic cluster attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateBootTrace(void);
+
+/***************************************************************************//*!
+*  \brief Update health attributes.
+*
+*   Copy the heap minimums and the lowest free stack of every task to the
+*   Diagnostic cluster attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateHealth(void);
+
+/***************************************************************************//*!
+*  \brief Update TX power attributes.
+*
+*   Copy the TX power control statistics to the Diagnostic cluster
+*   attributes.
+*
+*   Preconditions: Diagnostic cluster is initialized. Must not be called from
+*                  the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+DIAG_Cluster_Ret_t DIAG_UpdateTxPower(void);
+
+#endif//_DIAG_CLUSTER_H
@@ -0,0 +1,507 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_zigbee_cluster.h"
+
+#include "historyCluster.h"
+#include "zigbeeManager.h"
+#include "sampleHistory.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define HISTORY_FRAME_PAYLOAD_MAX       (77)//Unfragmented APS payload (82) - manufacturer specific ZCL header (5)
+#define HISTORY_FRAME_HEADER_SIZE       (3)
+#define HISTORY_RECORD_ABS_SIZE         (8)
+#define HISTORY_RECORD_DELTA_MAX_SIZE   (5 + 3 + 3)//Varint u32 + 2 x zigzag varint 17 bits
+
+#define HISTORY_WINDOW_MAX              (8)//Max frames in flight
+#define HISTORY_ACK_TIMEOUT_MS          (5 * 1000)
+#define HISTORY_MAX_RETRIES             (3)
+
+#define HISTORY_ATTR_CAPACITY_ID        (0x0000)
+#define HISTORY_ATTR_SAMPLE_PERIOD_ID   (0x0001)
+
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define GET_U32_LE(p)                   ((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+#define PUT_U16_LE(p, v)                do{ (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); }while(0)
+#define PUT_U32_LE(p, v)                do{ PUT_U16_LE((p), (v)); PUT_U16_LE(&(p)[2], (v) >> 16); }while(0)
+
+#define ZIGZAG(v)                       ((((uint32_t)(v)) << 1) ^ (uint32_t)((v) >> 31))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct HISTORY_Session_s{
+    bool active;
+    bool last_sent;
+    uint16_t client_addr;
+    uint8_t client_ep;
+    uint32_t end_time;
+    uint32_t first_record;//First record of the range
+    uint32_t next_record;//Next record to encode
+    uint8_t base_frame;//Oldest unacknowledged frame
+    uint8_t next_frame;
+    uint8_t credit;
+    uint8_t retries;
+    uint32_t frame_record[HISTORY_WINDOW_MAX];//First record of each frame in flight
+}HISTORY_Session_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint8_t putVarint(uint8_t *pBuffer, uint32_t value);
+static uint8_t buildFrame(uint8_t *pBuffer, uint8_t frame_seq, uint32_t *pRecord_seq, bool *pLast);
+static void sendFrames(void);
+static void ackTimeout(uint8_t param);
+static void startSession(const esp_zb_zcl_custom_cluster_command_message_t *pMessage);
+static void processAck(uint8_t const *pData, uint16_t size);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static HISTORY_Session_t session;
+
+static uint16_t attr_capacity = SHIST_CAPACITY;
+static uint16_t attr_sample_period = SHIST_SAMPLE_PERIOD_S;
+
+static uint8_t cluster_endpoint = 0;//Set at cluster init
+
+static const char * TAG = "HISTORY";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Write a varint.
+*
+*   Encode an unsigned value on 7 bits groups, least significant first.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pBuffer             Output buffer (5 bytes max).
+*   \param[in]  value               Value to encode.
+*
+*   \return     Number of bytes written
+*
+*******************************************************************************/
+static uint8_t putVarint(uint8_t *pBuffer, uint32_t value){
+
+    uint8_t len = 0;
+
+    while(value >= 0x80){
+        pBuffer[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    pBuffer[len++] = (uint8_t)value;
+
+    return len;
+}
+
+/***************************************************************************//*!
+*  \brief Build a data frame.
+*
+*   Pack as many records as possible in a frame. The first record is stored
+*   as absolute values, the next ones as varint deltas to the previous one,
+*   so every frame can be decoded on its own.
+*
+*   Preconditions: Session is active.
+*
+*   Side Effects: None.
+*
+*   \param[out]     pBuffer             Frame buffer (HISTORY_FRAME_PAYLOAD_MAX).
+*   \param[in]      frame_seq           Frame sequence number.
+*   \param[in,out]  pRecord_seq         First record to encode / next record.
+*   \param[out]     pLast               Set when the range is complete.
+*
+*   \return     Frame size
+*
+*******************************************************************************/
+static uint8_t buildFrame(uint8_t *pBuffer, uint8_t frame_seq, uint32_t *pRecord_seq, bool *pLast){
+
+    uint8_t len = HISTORY_FRAME_HEADER_SIZE;
+    uint8_t count = 0;
+    uint8_t flags = 0;
+    uint32_t seq = *pRecord_seq;
+    SHIST_Record_t prev = {0};
+    SHIST_Record_t record;
+
+    *pLast = false;
+
+    for(;;){
+
+        if(SHIST_STATUS_OK != SHIST_Read(seq, &record)){
+            //Record overwritten while streaming -> continue from the oldest one
+            uint32_t oldest_seq = 0;
+            if((count == 0) && (SHIST_STATUS_OK == SHIST_Seek(0, &oldest_seq)) && (oldest_seq > seq)){
+                seq = oldest_seq;
+                continue;
+            }
+            *pLast = true;
+            break;
+        }
+
+        if(record.timestamp > session.end_time){
+            *pLast = true;
+            break;
+        }
+
+        if(count == UINT8_MAX){
+            break;
+        }
+
+        uint8_t tmp[HISTORY_RECORD_DELTA_MAX_SIZE];
+        uint8_t tmp_len = 0;
+
+        if(count == 0){
+            PUT_U32_LE(&tmp[0], record.timestamp);
+            PUT_U16_LE(&tmp[4], (uint16_t)record.temperature);
+            PUT_U16_LE(&tmp[6], record.humidity);
+            tmp_len = HISTORY_RECORD_ABS_SIZE;
+        }
+        else{
+            int32_t d_temp = (int32_t)record.temperature - prev.temperature;
+            int32_t d_rh = (int32_t)record.humidity - prev.humidity;
+
+            tmp_len += putVarint(&tmp[tmp_len], record.timestamp - prev.timestamp);
+            tmp_len += putVarint(&tmp[tmp_len], ZIGZAG(d_temp));
+            tmp_len += putVarint(&tmp[tmp_len], ZIGZAG(d_rh));
+        }
+
+        if((len + tmp_len) > HISTORY_FRAME_PAYLOAD_MAX){
+            break;
+        }
+
+        memcpy(&pBuffer[len], tmp, tmp_len);
+        len += tmp_len;
+        count++;
+        prev = record;
+        seq++;
+    }
+
+    if(seq == *pRecord_seq){
+        //Nothing more to send
+        *pLast = true;
+    }
+
+    if(*pRecord_seq == session.first_record){
+        flags |= HISTORY_FLAG_FIRST;
+    }
+    if(*pLast){
+        flags |= HISTORY_FLAG_LAST;
+    }
+
+    pBuffer[0] = frame_seq;
+    pBuffer[1] = flags;
+    pBuffer[2] = count;
+
+    *pRecord_seq = seq;
+
+    return len;
+}
+
+/***************************************************************************//*!
+*  \brief Send data frames.
+*
+*   Send frames while the client credit allows it.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void sendFrames(void){
+
+    uint8_t frame[HISTORY_FRAME_PAYLOAD_MAX];
+
+    while(session.active &&
+          (!session.last_sent) &&
+          ((uint8_t)(session.next_frame - session.base_frame) < session.credit)){
+
+        bool last = false;
+        session.frame_record[session.next_frame % HISTORY_WINDOW_MAX] = session.next_record;
+        uint8_t len = buildFrame(frame, session.next_frame, &session.next_record, &last);
+
+        esp_zb_zcl_custom_cluster_cmd_req_t req = {
+            .zcl_basic_cmd = {
+                .dst_addr_u.addr_short = session.client_addr,
+                .dst_endpoint = session.client_ep,
+                .src_endpoint = cluster_endpoint,
+            },
+            .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+            .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .cluster_id = HISTORY_CLUSTER_ID,
+            .manuf_specific = 1,
+            .manuf_code = ZIGBEE_MANUFACTURER_CODE,
+            .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+            .dis_default_resp = 1,
+            .custom_cmd_id = HISTORY_CMD_DATA,
+            .data = {
+                .type = ESP_ZB_ZCL_ATTR_TYPE_SET,
+                .size = len,
+                .value = frame,
+            },
+        };
+        esp_zb_zcl_custom_cluster_cmd_req(&req);
+
+        session.next_frame++;
+        session.last_sent = last;
+    }
+
+    //Restart ack timeout while frames are in flight
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)ackTimeout, 0);
+    if(session.active && (session.next_frame != session.base_frame)){
+        esp_zb_scheduler_alarm((esp_zb_callback_t)ackTimeout, 0, HISTORY_ACK_TIMEOUT_MS);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Acknowledge timeout.
+*
+*   Go back to the oldest unacknowledged frame and send again. The session
+*   is dropped after HISTORY_MAX_RETRIES timeouts.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  param               Unused.
+*
+*******************************************************************************/
+static void ackTimeout(uint8_t param){
+
+    if((!session.active) || (session.next_frame == session.base_frame)){
+        return;
+    }
+
+    if(++session.retries > HISTORY_MAX_RETRIES){
+        ESP_LOGI(TAG, "Client not responding, transfer aborted");
+        session.active = false;
+        return;
+    }
+
+    ESP_LOGI(TAG, "Ack timeout, resend from frame %d", session.base_frame);
+
+    session.next_frame = session.base_frame;
+    session.next_record = session.frame_record[session.base_frame % HISTORY_WINDOW_MAX];
+    session.last_sent = false;
+
+    sendFrames();
+}
+
+/***************************************************************************//*!
+*  \brief Start history transfer session.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: Any running session is replaced.
+*
+*   \param[in]  pMessage            Get History command.
+*
+*******************************************************************************/
+static void startSession(const esp_zb_zcl_custom_cluster_command_message_t *pMessage){
+
+    uint8_t const *pData = (uint8_t const *)pMessage->data.value;
+
+    if(pMessage->data.size < 9){
+        return;
+    }
+
+    uint32_t start_time = GET_U32_LE(&pData[0]);
+    uint32_t end_time = GET_U32_LE(&pData[4]);
+    uint8_t credit = pData[8];
+
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)ackTimeout, 0);
+    memset(&session, 0, sizeof(session));
+
+    session.client_addr = pMessage->info.src_address.u.short_addr;
+    session.client_ep = pMessage->info.src_endpoint;
+    session.end_time = end_time;
+    session.credit = (credit == 0) ? 1 : ((credit > HISTORY_WINDOW_MAX) ? HISTORY_WINDOW_MAX : credit);
+    session.active = true;
+
+    if((start_time > end_time) || (SHIST_STATUS_OK != SHIST_Seek(start_time, &session.next_record))){
+        //No record in range -> single empty last frame
+        session.end_time = 0;
+        session.next_record = UINT32_MAX;
+    }
+    session.first_record = session.next_record;
+
+    ESP_LOGI(TAG, "History request [%lu, %lu] from 0x%04x",
+                  (unsigned long)start_time,
+                  (unsigned long)end_time,
+                  session.client_addr);
+
+    sendFrames();
+}
+
+/***************************************************************************//*!
+*  \brief Process client acknowledge.
+*
+*   Acknowledge frames up to the given sequence and update the credit. An
+*   acknowledge of the last acknowledged frame is a pure window update, used
+*   by the client to reopen a window closed with a credit of 0.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Command payload.
+*   \param[in]  size                Command payload size.
+*
+*******************************************************************************/
+static void processAck(uint8_t const *pData, uint16_t size){
+
+    if((!session.active) || (size < 2)){
+        return;
+    }
+
+    uint8_t acked = pData[0];
+    uint8_t credit = pData[1];
+
+    //Ignore acknowledge of frames not sent (base_frame - 1: window update only)
+    uint8_t nb_acked = (uint8_t)(acked + 1 - session.base_frame);
+    if(nb_acked > (uint8_t)(session.next_frame - session.base_frame)){
+        return;
+    }
+
+    if(nb_acked > 0){
+        session.base_frame = acked + 1;
+        session.retries = 0;
+    }
+    session.credit = (credit > HISTORY_WINDOW_MAX) ? HISTORY_WINDOW_MAX : credit;
+
+    if(session.last_sent && (session.base_frame == session.next_frame)){
+        ESP_LOGI(TAG, "History transfer complete");
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)ackTimeout, 0);
+        session.active = false;
+        return;
+    }
+
+    sendFrames();
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief History cluster initialization.
+*
+*   Initialize the manufacturer specific History cluster (server role) and
+*   add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HISTORY_Cluster_Ret_t HISTORY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    cluster_endpoint = endpoint;
+
+    ESP_LOGI(TAG, "Cluster Initialization");
+
+    esp_zb_attribute_list_t *pHistoryCluster = esp_zb_zcl_attr_list_create(HISTORY_CLUSTER_ID);
+
+    if((ESP_OK != esp_zb_custom_cluster_add_custom_attr(pHistoryCluster,
+                                                        HISTORY_ATTR_CAPACITY_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &attr_capacity)) ||
+       (ESP_OK != esp_zb_custom_cluster_add_custom_attr(pHistoryCluster,
+                                                        HISTORY_ATTR_SAMPLE_PERIOD_ID,
+                                                        ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                                        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                                        &attr_sample_period))){
+
+        ESP_LOGI(TAG, "Failed to add History attribs");
+        return HISTORY_CLUSTER_STATUS_ERROR;
+    }
+
+    if(ESP_OK != esp_zb_cluster_list_add_custom_cluster(pCluster_list,
+                                                        pHistoryCluster,
+                                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE)){
+
+        ESP_LOGI(TAG, "Failed to add History cluster");
+        return HISTORY_CLUSTER_STATUS_ERROR;
+    }
+
+    return HISTORY_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Process History cluster command.
+*
+*   Handle history requests, acknowledges and cancel commands.
+*
+*   Preconditions: History cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t HISTORY_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage){
+
+    if(pMessage == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch(pMessage->info.command.id){
+
+        case HISTORY_CMD_GET_HISTORY:
+        {
+            startSession(pMessage);
+        }
+        break;
+
+        case HISTORY_CMD_ACK:
+        {
+            processAck((uint8_t const *)pMessage->data.value, pMessage->data.size);
+        }
+        break;
+
+        case HISTORY_CMD_CANCEL:
+        {
+            ESP_LOGI(TAG, "History transfer cancelled");
+            esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)ackTimeout, 0);
+            session.active = false;
+        }
+        break;
+
+        default:
+        {
+            ESP_LOGI(TAG, "Unsupported History command 0x%02x", pMessage->info.command.id);
+        }
+        break;
+    }
+
+    return ESP_OK;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,82 @@
+#ifndef _HISTORY_CLUSTER_H
+#define _HISTORY_CLUSTER_H
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define HISTORY_CLUSTER_ID              (0xFC00)//Manufacturer specific
+
+//Client to server commands
+#define HISTORY_CMD_GET_HISTORY         (0x00)//Start (u32), End (u32), Credit (u8)
+#define HISTORY_CMD_ACK                 (0x01)//Last frame seq received (u8), Credit (u8)
+#define HISTORY_CMD_CANCEL              (0x02)
+
+//Server to client commands
+#define HISTORY_CMD_DATA                (0x00)//Frame seq (u8), Flags (u8), Count (u8), Records
+
+#define HISTORY_FLAG_FIRST              (0x01)
+#define HISTORY_FLAG_LAST               (0x02)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum HISTORY_Cluster_Ret_e{
+    HISTORY_CLUSTER_STATUS_ERROR,
+    HISTORY_CLUSTER_STATUS_OK,
+}HISTORY_Cluster_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief History cluster initialization.
+*
+*   Initialize the manufacturer specific History cluster (server role) and
+*   add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HISTORY_Cluster_Ret_t HISTORY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+/***************************************************************************//*!
+*  \brief Process History cluster command.
+*
+*   Handle history requests, acknowledges and cancel commands.
+*
+*   Preconditions: History cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t HISTORY_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage);
+
+#endif//_HISTORY_CLUSTER_H
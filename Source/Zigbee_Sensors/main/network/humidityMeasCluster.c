@@ -38,6 +38,8 @@
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+static uint8_t cluster_endpoint = 0;//Set at cluster init
+
 static const char * TAG = "HUMIDITY_MEAS";
 
 /******************************************************************************
@@ -59,12 +61,15 @@ static const char * TAG = "HUMIDITY_MEAS";
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(esp_zb_cluster_list_t *pCluster_list){
+HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    cluster_endpoint = endpoint;
 
     ESP_LOGI(TAG, "Cluster Initialization");
 
@@ -95,15 +100,17 @@ HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(esp_zb_cluster_list_t *pCluster_list
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
+*
 *   \return     Operation status
 *
 *******************************************************************************/
-HUMIDITY_Cluster_Ret_t HUMIDITY_SetupReporting(void){
+HUMIDITY_Cluster_Ret_t HUMIDITY_SetupReporting(uint8_t endpoint){
 
     //Setup cluter attrib reporting
     esp_zb_zcl_reporting_info_t reporting_info = {
         .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
-        .ep = ZIGBEE_ENDPOINT_1,
+        .ep = endpoint,
         .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
         .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
         .attr_id = ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
@@ -151,7 +158,7 @@ HUMIDITY_Cluster_Ret_t HUMIDITY_SetRelHumidity(uint16_t rel_humidity){
 
     esp_zb_lock_acquire(portMAX_DELAY);
 
-    ret = esp_zb_zcl_set_attribute_val(ZIGBEE_ENDPOINT_1, 
+    ret = esp_zb_zcl_set_attribute_val(cluster_endpoint, 
                                        ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT, 
                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, 
                                        ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
@@ -193,13 +200,18 @@ HUMIDITY_Cluster_Ret_t HUMIDITY_GetRelHumidity(uint16_t *pRel_humidity){
 
     esp_zb_lock_acquire(portMAX_DELAY);
 
-    pAttrib = esp_zb_zcl_get_attribute(ZIGBEE_ENDPOINT_1, 
+    pAttrib = esp_zb_zcl_get_attribute(cluster_endpoint, 
                                        ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT, 
                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, 
                                        ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID);
 
     esp_zb_lock_release();
 
+    if(pAttrib == NULL){
+        ESP_LOGI(TAG, "Failed to get attrib");
+        return HUMIDITY_CLUSTER_STATUS_ERROR;
+    }
+
     *pRel_humidity = *(uint16_t*)(pAttrib->data_p);
 
     return HUMIDITY_CLUSTER_STATUS_OK;
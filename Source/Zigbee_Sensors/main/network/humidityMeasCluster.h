@@ -47,12 +47,13 @@ typedef enum HUMIDITY_Cluster_Ret_e{
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(esp_zb_cluster_list_t *pCluster_list);
+HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
 
 /***************************************************************************//*!
 *  \brief Humidity cluster reporting setup.
@@ -63,10 +64,12 @@ HUMIDITY_Cluster_Ret_t HUMIDITY_InitCluster(esp_zb_cluster_list_t *pCluster_list
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
+*
 *   \return     Operation status
 *
 *******************************************************************************/
-HUMIDITY_Cluster_Ret_t HUMIDITY_SetupReporting(void);
+HUMIDITY_Cluster_Ret_t HUMIDITY_SetupReporting(uint8_t endpoint);
 
 /***************************************************************************//*!
 *  \brief Set Humdity measurement value.
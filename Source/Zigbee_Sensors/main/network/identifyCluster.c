@@ -46,12 +46,12 @@ static void identifyCallback(uint8_t identify_on){
     if(identify_on >= 1){
         //Start identifying
         ESP_LOGI(TAG, "Start identifying");
-        UI_PostEvent(UI_EVENT_START_IDENTIFY, 0);
+        UI_PostEvent(UI_EVENT_START_IDENTIFY);
     }
     else{
         //Stop identifying
         ESP_LOGI(TAG, "Stop identifying");
-        UI_PostEvent(UI_EVENT_STOP_IDENTIFY, 0);
+        UI_PostEvent(UI_EVENT_STOP_IDENTIFY);
     }
 }
 
@@ -69,12 +69,13 @@ static void identifyCallback(uint8_t identify_on){
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(esp_zb_cluster_list_t *pCluster_list){
+IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
 
     ESP_LOGI(TAG, "Cluster Initialization");
 
@@ -103,13 +104,15 @@ IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(esp_zb_cluster_list_t *pCluster_list
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
+*
 *   \return     Operation status
 *
 *******************************************************************************/
-IDENTIFY_Cluster_Ret_t IDENTIFY_SetupCmdHandler(void){
+IDENTIFY_Cluster_Ret_t IDENTIFY_SetupCmdHandler(uint8_t endpoint){
 
     //Register Identify callback
-    esp_zb_identify_notify_handler_register(ZIGBEE_ENDPOINT_1,
+    esp_zb_identify_notify_handler_register(endpoint,
                                             (esp_zb_identify_notify_callback_t)identifyCallback);
 
     return IDENTIFY_CLUSTER_STATUS_OK;
@@ -45,12 +45,13 @@ typedef enum IDENTIFY_Cluster_Ret_e{
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(esp_zb_cluster_list_t *pCluster_list);
+IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
 
 /***************************************************************************//*!
 *  \brief Setup Identify cluster cmd handler.
@@ -61,9 +62,11 @@ IDENTIFY_Cluster_Ret_t IDENTIFY_InitCluster(esp_zb_cluster_list_t *pCluster_list
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
+*
 *   \return     Operation status
 *
 *******************************************************************************/
-IDENTIFY_Cluster_Ret_t IDENTIFY_SetupCmdHandler(void);
+IDENTIFY_Cluster_Ret_t IDENTIFY_SetupCmdHandler(uint8_t endpoint);
 
 #endif//_IDENTIFY_CLUSTER_H
\ No newline at end of file
@@ -0,0 +1,358 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_zigbee_cluster.h"
+
+#include "otaCluster.h"
+#include "zigbeeManager.h"
+#include "otaImage.h"
+#include "otaFetch.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define OTA_SERVER_ADDR_UNKNOWN         (0xFFFF)
+#define OTA_SERVER_EP_UNKNOWN           (0xFF)
+
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+#if (OTA_PIPELINED_FETCH == 1)
+static esp_zb_attribute_list_t * createFetchCluster(void);
+#else
+static esp_zb_attribute_list_t * createStackCluster(void);
+#endif
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static uint32_t ota_received_size = 0;
+
+static const char * TAG = "OTA";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+#if (OTA_PIPELINED_FETCH == 1)
+/***************************************************************************//*!
+*  \brief Create OTA cluster for the fetch engine.
+*
+*   Create the standard OTA Upgrade client attributes. Commands are exchanged
+*   by the application fetch engine, the stack OTA client is not enabled
+*   (no client data attribute).
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Cluster attribute list (NULL on error)
+*
+*******************************************************************************/
+static esp_zb_attribute_list_t * createFetchCluster(void){
+
+    //Standard client attribute set (UpgradeServerID, FileOffset, versions, status...)
+    esp_zb_ota_cluster_cfg_t ota_cfg = {
+        .ota_upgrade_file_version = OTA_RUNNING_FILE_VERSION,
+        .ota_upgrade_downloaded_file_ver = OTA_RUNNING_FILE_VERSION,
+        .ota_upgrade_manufacturer = ZIGBEE_MANUFACTURER_CODE,
+        .ota_upgrade_image_type = OTA_IMAGE_TYPE,
+    };
+    esp_zb_attribute_list_t *pOtaCluster = esp_zb_ota_cluster_create(&ota_cfg);
+
+    if(pOtaCluster == NULL){
+        ESP_LOGI(TAG, "Failed to create OTA client attribs");
+    }
+
+    return pOtaCluster;
+}
+#else
+/***************************************************************************//*!
+*  \brief Create OTA cluster for the stack OTA client.
+*
+*   Create the OTA Upgrade client attributes. Block requests are handled by
+*   the Zigbee stack and reported through OTA_ProcessUpgradeValue().
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Cluster attribute list (NULL on error)
+*
+*******************************************************************************/
+static esp_zb_attribute_list_t * createStackCluster(void){
+
+    esp_zb_ota_cluster_cfg_t ota_cfg = {
+        .ota_upgrade_file_version = OTA_RUNNING_FILE_VERSION,
+        .ota_upgrade_downloaded_file_ver = OTA_RUNNING_FILE_VERSION,
+        .ota_upgrade_manufacturer = ZIGBEE_MANUFACTURER_CODE,
+        .ota_upgrade_image_type = OTA_IMAGE_TYPE,
+    };
+    esp_zb_attribute_list_t *pOtaCluster = esp_zb_ota_cluster_create(&ota_cfg);
+
+    esp_zb_zcl_ota_upgrade_client_variable_t client_cfg = {
+        .timer_query = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF,
+        .hw_version = OTA_HW_VERSION,
+        .max_data_size = OTA_MAX_DATA_SIZE,
+    };
+    uint16_t server_addr = OTA_SERVER_ADDR_UNKNOWN;
+    uint8_t server_ep = OTA_SERVER_EP_UNKNOWN;
+
+    if(ESP_OK != esp_zb_ota_cluster_add_attr(pOtaCluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &client_cfg)){
+        ESP_LOGI(TAG, "Failed to add OTA client data attrib");
+        return NULL;
+    }
+
+    if(ESP_OK != esp_zb_ota_cluster_add_attr(pOtaCluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr)){
+        ESP_LOGI(TAG, "Failed to add OTA server addr attrib");
+        return NULL;
+    }
+
+    if(ESP_OK != esp_zb_ota_cluster_add_attr(pOtaCluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_ep)){
+        ESP_LOGI(TAG, "Failed to add OTA server endpoint attrib");
+        return NULL;
+    }
+
+    return pOtaCluster;
+}
+#endif
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief OTA Upgrade cluster initialization.
+*
+*   Initialize OTA Upgrade cluster (client role) and attributes with default
+*   value. It also add the OTA Upgrade cluster to the cluster list passed to
+*   this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_Cluster_Ret_t OTA_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    ESP_LOGI(TAG, "Cluster Initialization");
+
+#if (OTA_PIPELINED_FETCH == 1)
+    if(OTA_FETCH_STATUS_OK != OTA_FETCH_Init(endpoint)){
+        ESP_LOGI(TAG, "Failed to init OTA fetch engine");
+        return OTA_CLUSTER_STATUS_ERROR;
+    }
+
+    //Block requests are sent by the application -> cluster handled as custom cluster
+    esp_zb_attribute_list_t *pOtaCluster = createFetchCluster();
+    if((pOtaCluster == NULL) ||
+       (ESP_OK != esp_zb_cluster_list_add_custom_cluster(pCluster_list,
+                                                         pOtaCluster,
+                                                         ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE))){
+
+        ESP_LOGI(TAG, "Failed to add OTA cluster");
+        return OTA_CLUSTER_STATUS_ERROR;
+    }
+#else
+    esp_zb_attribute_list_t *pOtaCluster = createStackCluster();
+    if((pOtaCluster == NULL) ||
+       (ESP_OK != esp_zb_cluster_list_add_ota_cluster(pCluster_list,
+                                                      pOtaCluster,
+                                                      ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE))){
+
+        ESP_LOGI(TAG, "Failed to add OTA cluster");
+        return OTA_CLUSTER_STATUS_ERROR;
+    }
+#endif
+
+    return OTA_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Start OTA Upgrade client.
+*
+*   Start looking for new images once the device joined a network.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_StartClient(void){
+
+#if (OTA_PIPELINED_FETCH == 1)
+    OTA_FETCH_Start();
+#endif
+}
+
+/***************************************************************************//*!
+*  \brief Process OTA upgrade value message.
+*
+*   Handle the OTA upgrade progress reported by the Zigbee stack and stream
+*   the received image blocks to the OTA partition.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: Device reboots when the upgrade is finished.
+*
+*   \param[in]  pMessage                OTA upgrade value message
+*
+*   \return     ESP_OK to continue the upgrade, error to abort it
+*
+*******************************************************************************/
+esp_err_t OTA_ProcessUpgradeValue(const esp_zb_zcl_ota_upgrade_value_message_t *pMessage){
+
+    if(pMessage == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(pMessage->info.status != ESP_ZB_ZCL_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "OTA message error status: 0x%x", pMessage->info.status);
+        OTA_IMAGE_Abort();
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    switch(pMessage->upgrade_status){
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        {
+            ESP_LOGI(TAG, "OTA start, version: 0x%lx, type: 0x%x, size: %lu",
+                          (unsigned long)pMessage->ota_header.file_version,
+                          pMessage->ota_header.image_type,
+                          (unsigned long)pMessage->ota_header.image_size);
+
+            ota_received_size = 0;
+            if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Begin()){
+                ret = ESP_FAIL;
+            }
+        }
+        break;
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        {
+            ota_received_size += pMessage->payload_size;
+            if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Write(pMessage->payload, pMessage->payload_size)){
+                OTA_IMAGE_Abort();
+                ret = ESP_FAIL;
+            }
+            else if(pMessage->ota_header.image_size != 0){
+                ESP_LOGD(TAG, "OTA progress: %lu / %lu",
+                              (unsigned long)ota_received_size,
+                              (unsigned long)pMessage->ota_header.image_size);
+            }
+        }
+        break;
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        {
+            ESP_LOGI(TAG, "OTA apply");
+        }
+        break;
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        {
+            ESP_LOGI(TAG, "OTA check (%lu bytes received)", (unsigned long)ota_received_size);
+            if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_End()){
+                ret = ESP_FAIL;
+            }
+        }
+        break;
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        {
+            ESP_LOGI(TAG, "OTA finished");
+            if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Apply()){
+                ret = ESP_FAIL;
+            }
+            else{
+                ESP_LOGI(TAG, "Rebooting on new image");
+                esp_restart();
+            }
+        }
+        break;
+
+        case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        {
+            ESP_LOGI(TAG, "OTA aborted");
+            OTA_IMAGE_Abort();
+        }
+        break;
+
+        default:
+        {
+            ESP_LOGI(TAG, "OTA status: %d", pMessage->upgrade_status);
+        }
+        break;
+    }
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Process OTA cluster command.
+*
+*   Handle OTA Upgrade cluster commands received from the server when the
+*   application block fetch engine is used.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t OTA_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage){
+
+#if (OTA_PIPELINED_FETCH == 1)
+    return OTA_FETCH_ProcessCommand(pMessage);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/***************************************************************************//*!
+*  \brief Process ZCL command send status.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Send status message
+*
+*******************************************************************************/
+void OTA_ProcessSendStatus(const esp_zb_zcl_command_send_status_message_t *pMessage){
+
+#if (OTA_PIPELINED_FETCH == 1)
+    OTA_FETCH_ProcessSendStatus(pMessage);
+#endif
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,118 @@
+#ifndef _OTA_CLUSTER_H
+#define _OTA_CLUSTER_H
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define OTA_IMAGE_TYPE                  (0x1001)
+#define OTA_RUNNING_FILE_VERSION        (0x00000001)
+#define OTA_HW_VERSION                  (0x0001)
+#define OTA_MAX_DATA_SIZE               (64)
+#define OTA_PIPELINED_FETCH             (1)//1: application block fetch engine, 0: stack OTA client
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum OTA_Cluster_Ret_e{
+    OTA_CLUSTER_STATUS_ERROR,
+    OTA_CLUSTER_STATUS_OK,
+}OTA_Cluster_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief OTA Upgrade cluster initialization.
+*
+*   Initialize OTA Upgrade cluster (client role) and attributes with default
+*   value. It also add the OTA Upgrade cluster to the cluster list passed to
+*   this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_Cluster_Ret_t OTA_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+/***************************************************************************//*!
+*  \brief Start OTA Upgrade client.
+*
+*   Start looking for new images once the device joined a network.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_StartClient(void);
+
+/***************************************************************************//*!
+*  \brief Process OTA upgrade value message.
+*
+*   Handle the OTA upgrade progress reported by the Zigbee stack and stream
+*   the received image blocks to the OTA partition.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: Device reboots when the upgrade is finished.
+*
+*   \param[in]  pMessage                OTA upgrade value message
+*
+*   \return     ESP_OK to continue the upgrade, error to abort it
+*
+*******************************************************************************/
+esp_err_t OTA_ProcessUpgradeValue(const esp_zb_zcl_ota_upgrade_value_message_t *pMessage);
+
+/***************************************************************************//*!
+*  \brief Process OTA cluster command.
+*
+*   Handle OTA Upgrade cluster commands received from the server when the
+*   application block fetch engine is used.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t OTA_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage);
+
+/***************************************************************************//*!
+*  \brief Process ZCL command send status.
+*
+*   Preconditions: OTA Upgrade cluster is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Send status message
+*
+*******************************************************************************/
+void OTA_ProcessSendStatus(const esp_zb_zcl_command_send_status_message_t *pMessage);
+
+#endif//_OTA_CLUSTER_H
@@ -0,0 +1,1315 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_zigbee_cluster.h"
+
+#include "otaFetch.h"
+#include "otaCluster.h"
+#include "otaImage.h"
+#include "zigbeeManager.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define OTA_FETCH_NVS_NAMESPACE             ("OtaFetch")
+#define OTA_FETCH_CHECKPOINT_NVS            ("Checkpoint")
+
+#define OTA_FETCH_TICK_MS                   (100)
+#define OTA_FETCH_IDLE_TICK_MS              (1000)
+#define OTA_FETCH_QUERY_PERIOD_MS           (60 * 60 * 1000)
+#define OTA_FETCH_RETRY_PERIOD_MS           (60 * 1000)
+#define OTA_FETCH_RESPONSE_TIMEOUT_MS       (5 * 1000)
+#define OTA_FETCH_BLOCK_TIMEOUT_MS          (3 * 1000)
+#define OTA_FETCH_BLOCK_MAX_RETRIES         (8)
+#define OTA_FETCH_WAIT_FOR_DATA_MIN_MS      (1000)
+#define OTA_FETCH_UPGRADE_WAIT_MAX_MS       (60 * 60 * 1000)
+#define OTA_FETCH_CHECKPOINT_INTERVAL       (16 * 1024)//File bytes between two NVS checkpoints
+
+#define OTA_FETCH_BLOCK_SIZE_STEP           (8)//Additive increase
+#define OTA_FETCH_BLOCK_SIZE_INCREASE_AFTER (8)//Successful blocks before increase
+
+#define OTA_FILE_HEADER_SIZE_MIN            (56)
+#define OTA_FILE_HEADER_SIZE_OFFSET         (6)
+
+//OTA Upgrade cluster commands
+#define OTA_CMD_IMAGE_NOTIFY                (0x00)
+#define OTA_CMD_QUERY_NEXT_IMAGE_REQ        (0x01)
+#define OTA_CMD_QUERY_NEXT_IMAGE_RSP        (0x02)
+#define OTA_CMD_IMAGE_BLOCK_REQ             (0x03)
+#define OTA_CMD_IMAGE_BLOCK_RSP             (0x05)
+#define OTA_CMD_UPGRADE_END_REQ             (0x06)
+#define OTA_CMD_UPGRADE_END_RSP             (0x07)
+
+//OTA Upgrade cluster status
+#define OTA_ZCL_STATUS_SUCCESS              (0x00)
+#define OTA_ZCL_STATUS_ABORT                (0x95)
+#define OTA_ZCL_STATUS_INVALID_IMAGE        (0x96)
+#define OTA_ZCL_STATUS_WAIT_FOR_DATA        (0x97)
+
+#define OTA_QUERY_FIELD_CTRL_HW_VERSION     (0x01)
+#define OTA_UPGRADE_TIME_WAIT               (0xFFFFFFFF)
+
+#define LOG_LOCAL_LEVEL                     (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define GET_U16_LE(p)                       ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET_U32_LE(p)                       ((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+#define PUT_U16_LE(p, v)                    do{ (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); }while(0)
+#define PUT_U32_LE(p, v)                    do{ PUT_U16_LE((p), (v)); PUT_U16_LE(&(p)[2], (v) >> 16); }while(0)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef enum OTA_Fetch_State_e{
+    OTA_FETCH_STATE_IDLE,
+    OTA_FETCH_STATE_DISCOVERY,
+    OTA_FETCH_STATE_QUERY,
+    OTA_FETCH_STATE_DOWNLOAD,
+    OTA_FETCH_STATE_PAUSED,
+    OTA_FETCH_STATE_UPGRADE_END,
+    OTA_FETCH_STATE_WAIT_UPGRADE,
+
+    OTA_FETCH_STATE_INVALID,
+}OTA_Fetch_State_t;
+
+typedef enum OTA_Slot_State_e{
+    OTA_SLOT_FREE,
+    OTA_SLOT_SENT,
+    OTA_SLOT_WAIT,//Server asked to wait before asking again
+    OTA_SLOT_DONE,
+}OTA_Slot_State_t;
+
+typedef enum OTA_Upgrade_Status_e{
+    OTA_UPGRADE_STATUS_NORMAL,
+    OTA_UPGRADE_STATUS_DOWNLOAD_IN_PROGRESS,
+    OTA_UPGRADE_STATUS_DOWNLOAD_COMPLETE,
+    OTA_UPGRADE_STATUS_WAITING_TO_UPGRADE,
+}OTA_Upgrade_Status_t;
+
+typedef struct OTA_Fetch_Slot_s{
+    uint32_t offset;
+    int64_t deadline_ms;
+    uint8_t size;
+    uint8_t received;
+    uint8_t retries;
+    uint8_t tsn;
+    OTA_Slot_State_t state;
+    uint8_t data[OTA_FETCH_BLOCK_SIZE_MAX];
+}OTA_Fetch_Slot_t;
+
+typedef struct OTA_Fetch_Checkpoint_s{
+    uint32_t file_version;
+    uint32_t file_size;
+    uint32_t file_offset;
+    uint16_t header_size;
+    OTA_IMAGE_Checkpoint_t image;
+}OTA_Fetch_Checkpoint_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static int64_t getTimeMs(void);
+static bool isConnected(void);
+static uint8_t sendCommand(uint8_t cmd_id, uint8_t *pPayload, uint16_t size);
+static void setImageStatus(OTA_Upgrade_Status_t status);
+
+static void startDiscovery(void);
+static void matchDescCallback(esp_zb_zdp_status_t zdo_status, uint16_t addr, uint8_t endpoint, void *user_ctx);
+static void sendQueryNextImage(void);
+static void scheduleQuery(uint32_t delay_ms);
+
+static void startDownload(uint32_t version, uint32_t size);
+static void pauseDownload(uint32_t delay_ms);
+static void abortDownload(void);
+static void finishDownload(void);
+static void applyUpgrade(void);
+
+static void sendBlockRequest(OTA_Fetch_Slot_t *pSlot);
+static void fillPipeline(void);
+static void checkTimeouts(void);
+static void commitSlots(void);
+static OTA_FETCH_Ret_t commitData(uint32_t offset, uint8_t const *pData, size_t size);
+static void adaptOnSuccess(void);
+static void adaptOnError(void);
+
+static void saveCheckpoint(void);
+static void clearCheckpoint(void);
+
+static void processQueryNextImageRsp(uint8_t const *pData, uint16_t size);
+static void processImageBlockRsp(uint8_t tsn, uint8_t const *pData, uint16_t size);
+static void processUpgradeEndRsp(uint8_t const *pData, uint16_t size);
+
+static void engineTick(uint8_t param);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static OTA_Fetch_State_t fetch_state = OTA_FETCH_STATE_INVALID;
+static int64_t state_deadline_ms = 0;
+static bool tick_running = false;
+
+static uint16_t server_addr = 0xFFFF;
+static uint8_t server_ep = 0xFF;
+
+static uint32_t file_version = 0;
+static uint32_t file_size = 0;
+static uint16_t header_size = 0;
+static uint32_t commit_offset = 0;
+static uint32_t request_offset = 0;
+static uint32_t checkpoint_offset = 0;
+
+static uint8_t block_size = OTA_FETCH_BLOCK_SIZE_INIT;
+static uint8_t block_limit = OTA_FETCH_BLOCK_SIZE_MAX;
+static uint8_t success_cptr = 0;
+
+static uint32_t nb_blocks = 0;
+static uint32_t nb_retries = 0;
+
+static OTA_Fetch_Slot_t slot_table[OTA_FETCH_PIPELINE_DEPTH];
+static OTA_Fetch_Checkpoint_t checkpoint;
+static bool checkpoint_valid = false;
+
+static uint8_t local_endpoint = 0;//Set at init
+
+static const char * TAG = "OTA_FETCH";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Get current time in ms.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Time since boot in ms
+*
+*******************************************************************************/
+static int64_t getTimeMs(void){
+    return (esp_timer_get_time() / 1000);
+}
+
+/***************************************************************************//*!
+*  \brief Check network connection.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     true if the device is connected to its parent
+*
+*******************************************************************************/
+static bool isConnected(void){
+    return (ZIGBEE_GetNwkState() == ZIGBEE_NWK_CONNECTED);
+}
+
+/***************************************************************************//*!
+*  \brief Send OTA cluster command.
+*
+*   Send a client to server OTA Upgrade cluster command to the OTA server.
+*
+*   Preconditions: OTA server address is known.
+*
+*   Side Effects: None.
+*
+*   \param[in]  cmd_id              Command ID.
+*   \param[in]  pPayload            Command payload.
+*   \param[in]  size                Command payload size.
+*
+*   \return     Command transaction sequence number
+*
+*******************************************************************************/
+static uint8_t sendCommand(uint8_t cmd_id, uint8_t *pPayload, uint16_t size){
+
+    esp_zb_zcl_custom_cluster_cmd_req_t req = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = server_addr,
+            .dst_endpoint = server_ep,
+            .src_endpoint = local_endpoint,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
+        .dis_default_resp = 1,
+        .custom_cmd_id = cmd_id,
+        //Payload sent as is: already encoded as the ZCL command fields
+        .data = {
+            .type = ESP_ZB_ZCL_ATTR_TYPE_SET,
+            .size = size,
+            .value = pPayload,
+        },
+    };
+
+    return esp_zb_zcl_custom_cluster_cmd_req(&req);
+}
+
+/***************************************************************************//*!
+*  \brief Set OTA image status attribute.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  status              Image upgrade status.
+*
+*******************************************************************************/
+static void setImageStatus(OTA_Upgrade_Status_t status){
+
+    uint8_t value = status;
+    esp_zb_zcl_set_attribute_val(local_endpoint,
+                                 ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                                 ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                 ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID,
+                                 &value,
+                                 false);
+}
+
+/***************************************************************************//*!
+*  \brief Start OTA server discovery.
+*
+*   Broadcast a match descriptor request for the OTA Upgrade cluster server.
+*
+*   Preconditions: Device is connected.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void startDiscovery(void){
+
+    ESP_LOGI(TAG, "Looking for OTA server");
+
+    static uint16_t cluster_list[] = {ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE};
+    esp_zb_zdo_match_desc_req_param_t req = {
+        .dst_nwk_addr = 0xFFFD,
+        .addr_of_interest = 0xFFFD,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .num_in_clusters = 1,
+        .num_out_clusters = 0,
+        .cluster_list = cluster_list,
+    };
+
+    fetch_state = OTA_FETCH_STATE_DISCOVERY;
+    state_deadline_ms = getTimeMs() + OTA_FETCH_RESPONSE_TIMEOUT_MS;
+    esp_zb_zdo_match_cluster(&req, matchDescCallback, NULL);
+}
+
+/***************************************************************************//*!
+*  \brief Match descriptor response callback.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  zdo_status          ZDO command status.
+*   \param[in]  addr                Server short address.
+*   \param[in]  endpoint            Server endpoint.
+*   \param[in]  user_ctx            Pointer to user context (optional).
+*
+*******************************************************************************/
+static void matchDescCallback(esp_zb_zdp_status_t zdo_status, uint16_t addr, uint8_t endpoint, void *user_ctx){
+
+    if(fetch_state != OTA_FETCH_STATE_DISCOVERY){
+        return;
+    }
+
+    if(zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "No OTA server found");
+        scheduleQuery(OTA_FETCH_RETRY_PERIOD_MS);
+        return;
+    }
+
+    ESP_LOGI(TAG, "OTA server 0x%04x, endpoint %d", addr, endpoint);
+    server_addr = addr;
+    server_ep = endpoint;
+
+    sendQueryNextImage();
+}
+
+/***************************************************************************//*!
+*  \brief Send Query Next Image request.
+*
+*   Preconditions: OTA server address is known.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void sendQueryNextImage(void){
+
+    uint8_t payload[11];
+    payload[0] = OTA_QUERY_FIELD_CTRL_HW_VERSION;
+    PUT_U16_LE(&payload[1], ZIGBEE_MANUFACTURER_CODE);
+    PUT_U16_LE(&payload[3], OTA_IMAGE_TYPE);
+    PUT_U32_LE(&payload[5], OTA_RUNNING_FILE_VERSION);
+    PUT_U16_LE(&payload[9], OTA_HW_VERSION);
+
+    fetch_state = OTA_FETCH_STATE_QUERY;
+    state_deadline_ms = getTimeMs() + OTA_FETCH_RESPONSE_TIMEOUT_MS;
+    sendCommand(OTA_CMD_QUERY_NEXT_IMAGE_REQ, payload, sizeof(payload));
+}
+
+/***************************************************************************//*!
+*  \brief Schedule next image query.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  delay_ms            Delay before next query.
+*
+*******************************************************************************/
+static void scheduleQuery(uint32_t delay_ms){
+
+    fetch_state = OTA_FETCH_STATE_IDLE;
+    state_deadline_ms = getTimeMs() + delay_ms;
+}
+
+/***************************************************************************//*!
+*  \brief Start image download.
+*
+*   Open the OTA partition, resuming from the NVS checkpoint when it matches
+*   the offered image, and fill the request pipeline.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  version             Offered file version.
+*   \param[in]  size                Offered file size.
+*
+*******************************************************************************/
+static void startDownload(uint32_t version, uint32_t size){
+
+    file_version = version;
+    file_size = size;
+    commit_offset = 0;
+    header_size = 0;
+
+    if(checkpoint_valid &&
+       (checkpoint.file_version == version) &&
+       (checkpoint.file_size == size) &&
+       (OTA_IMAGE_STATUS_OK == OTA_IMAGE_Resume(&checkpoint.image))){
+
+        commit_offset = checkpoint.file_offset;
+        header_size = checkpoint.header_size;
+        ESP_LOGI(TAG, "Resuming download at %lu / %lu", (unsigned long)commit_offset, (unsigned long)size);
+    }
+    else{
+        clearCheckpoint();
+        if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Begin()){
+            scheduleQuery(OTA_FETCH_RETRY_PERIOD_MS);
+            return;
+        }
+        ESP_LOGI(TAG, "Starting download of %lu bytes", (unsigned long)size);
+    }
+
+    memset(slot_table, 0, sizeof(slot_table));
+    request_offset = commit_offset;
+    checkpoint_offset = commit_offset;
+    nb_blocks = 0;
+    nb_retries = 0;
+
+    fetch_state = OTA_FETCH_STATE_DOWNLOAD;
+    setImageStatus(OTA_UPGRADE_STATUS_DOWNLOAD_IN_PROGRESS);
+    fillPipeline();
+}
+
+/***************************************************************************//*!
+*  \brief Pause image download.
+*
+*   Drop in-flight requests. The download restarts from the last committed
+*   offset once the device is connected and the delay elapsed.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  delay_ms            Minimum pause duration.
+*
+*******************************************************************************/
+static void pauseDownload(uint32_t delay_ms){
+
+    ESP_LOGI(TAG, "Download paused at %lu / %lu", (unsigned long)commit_offset, (unsigned long)file_size);
+
+    memset(slot_table, 0, sizeof(slot_table));
+    request_offset = commit_offset;
+
+    //Keep progress across a reboot
+    saveCheckpoint();
+
+    fetch_state = OTA_FETCH_STATE_PAUSED;
+    state_deadline_ms = getTimeMs() + delay_ms;
+}
+
+/***************************************************************************//*!
+*  \brief Abort image download.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void abortDownload(void){
+
+    ESP_LOGI(TAG, "Download aborted");
+
+    OTA_IMAGE_Abort();
+    clearCheckpoint();
+    memset(slot_table, 0, sizeof(slot_table));
+    setImageStatus(OTA_UPGRADE_STATUS_NORMAL);
+
+    scheduleQuery(OTA_FETCH_QUERY_PERIOD_MS);
+}
+
+/***************************************************************************//*!
+*  \brief Finish image download.
+*
+*   Validate the image and send the Upgrade End request to the server.
+*
+*   Preconditions: All image blocks were committed.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void finishDownload(void){
+
+    ESP_LOGI(TAG, "Download complete (%lu blocks, %lu retries, block size %d)",
+                  (unsigned long)nb_blocks,
+                  (unsigned long)nb_retries,
+                  block_size);
+
+    uint8_t status = OTA_ZCL_STATUS_SUCCESS;
+    if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_End()){
+        status = OTA_ZCL_STATUS_INVALID_IMAGE;
+    }
+    clearCheckpoint();
+
+    uint8_t payload[9];
+    payload[0] = status;
+    PUT_U16_LE(&payload[1], ZIGBEE_MANUFACTURER_CODE);
+    PUT_U16_LE(&payload[3], OTA_IMAGE_TYPE);
+    PUT_U32_LE(&payload[5], file_version);
+    sendCommand(OTA_CMD_UPGRADE_END_REQ, payload, sizeof(payload));
+
+    if(status != OTA_ZCL_STATUS_SUCCESS){
+        setImageStatus(OTA_UPGRADE_STATUS_NORMAL);
+        scheduleQuery(OTA_FETCH_QUERY_PERIOD_MS);
+    }
+    else{
+        setImageStatus(OTA_UPGRADE_STATUS_DOWNLOAD_COMPLETE);
+        fetch_state = OTA_FETCH_STATE_UPGRADE_END;
+        state_deadline_ms = getTimeMs() + OTA_FETCH_RESPONSE_TIMEOUT_MS;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Apply downloaded image and reboot.
+*
+*   Preconditions: Image was validated.
+*
+*   Side Effects: Device reboots on success.
+*
+*******************************************************************************/
+static void applyUpgrade(void){
+
+    if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Apply()){
+        setImageStatus(OTA_UPGRADE_STATUS_NORMAL);
+        scheduleQuery(OTA_FETCH_QUERY_PERIOD_MS);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Rebooting on new image");
+    esp_restart();
+}
+
+/***************************************************************************//*!
+*  \brief Send Image Block request.
+*
+*   Request the part of the slot block that was not received yet.
+*
+*   Preconditions: Slot is allocated.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSlot               Pointer to request slot.
+*
+*******************************************************************************/
+static void sendBlockRequest(OTA_Fetch_Slot_t *pSlot){
+
+    uint8_t payload[14];
+    payload[0] = 0x00;//Field control
+    PUT_U16_LE(&payload[1], ZIGBEE_MANUFACTURER_CODE);
+    PUT_U16_LE(&payload[3], OTA_IMAGE_TYPE);
+    PUT_U32_LE(&payload[5], file_version);
+    PUT_U32_LE(&payload[9], pSlot->offset + pSlot->received);
+    payload[13] = pSlot->size - pSlot->received;
+
+    pSlot->tsn = sendCommand(OTA_CMD_IMAGE_BLOCK_REQ, payload, sizeof(payload));
+    pSlot->state = OTA_SLOT_SENT;
+    pSlot->deadline_ms = getTimeMs() + OTA_FETCH_BLOCK_TIMEOUT_MS;
+}
+
+/***************************************************************************//*!
+*  \brief Fill request pipeline.
+*
+*   Allocate free slots to the next image blocks and send their requests.
+*
+*   Preconditions: Download is running.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void fillPipeline(void){
+
+    for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+
+        if(request_offset >= file_size){
+            break;
+        }
+
+        OTA_Fetch_Slot_t *pSlot = &slot_table[i];
+        if(pSlot->state == OTA_SLOT_FREE){
+            uint32_t size = file_size - request_offset;
+            if(size > block_size){
+                size = block_size;
+            }
+
+            pSlot->offset = request_offset;
+            pSlot->size = (uint8_t)size;
+            pSlot->received = 0;
+            pSlot->retries = 0;
+            request_offset += size;
+
+            sendBlockRequest(pSlot);
+        }
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Check in-flight requests timeout.
+*
+*   Re-send timed out requests. The download is paused when a block keeps
+*   failing.
+*
+*   Preconditions: Download is running.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void checkTimeouts(void){
+
+    int64_t now = getTimeMs();
+
+    for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+
+        OTA_Fetch_Slot_t *pSlot = &slot_table[i];
+        if(((pSlot->state != OTA_SLOT_SENT) && (pSlot->state != OTA_SLOT_WAIT)) ||
+           (now < pSlot->deadline_ms)){
+
+            continue;
+        }
+
+        if(pSlot->state == OTA_SLOT_SENT){
+            adaptOnError();
+            nb_retries++;
+
+            if(++pSlot->retries > OTA_FETCH_BLOCK_MAX_RETRIES){
+                ESP_LOGI(TAG, "Block 0x%lx keeps failing", (unsigned long)pSlot->offset);
+                pauseDownload(OTA_FETCH_RETRY_PERIOD_MS);
+                return;
+            }
+        }
+
+        sendBlockRequest(pSlot);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Commit received blocks.
+*
+*   Pass the received blocks to the image writer in file order, checkpoint
+*   the progress and finish the download when the whole file was received.
+*
+*   Preconditions: Download is running.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void commitSlots(void){
+
+    bool committed = true;
+
+    while(committed){
+
+        committed = false;
+
+        for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+
+            OTA_Fetch_Slot_t *pSlot = &slot_table[i];
+            if((pSlot->state == OTA_SLOT_DONE) && (pSlot->offset == commit_offset)){
+
+                if(OTA_FETCH_STATUS_OK != commitData(pSlot->offset, pSlot->data, pSlot->size)){
+                    abortDownload();
+                    return;
+                }
+
+                commit_offset += pSlot->size;
+                pSlot->state = OTA_SLOT_FREE;
+                committed = true;
+            }
+        }
+    }
+
+    if(commit_offset >= file_size){
+        finishDownload();
+    }
+    else if((commit_offset - checkpoint_offset) >= OTA_FETCH_CHECKPOINT_INTERVAL){
+        saveCheckpoint();
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Commit file data.
+*
+*   Skip the OTA file header and pass the image data to the image writer.
+*
+*   Preconditions: Data is committed in file order.
+*
+*   Side Effects: None.
+*
+*   \param[in]  offset              File offset.
+*   \param[in]  pData               File data.
+*   \param[in]  size                File data size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_FETCH_Ret_t commitData(uint32_t offset, uint8_t const *pData, size_t size){
+
+    if(header_size == 0){
+        //First block holds the header length field
+        if((offset != 0) || (size < (OTA_FILE_HEADER_SIZE_OFFSET + 2))){
+            return OTA_FETCH_STATUS_ERROR;
+        }
+
+        header_size = GET_U16_LE(&pData[OTA_FILE_HEADER_SIZE_OFFSET]);
+        if((header_size < OTA_FILE_HEADER_SIZE_MIN) || (header_size > file_size)){
+            ESP_LOGI(TAG, "Invalid OTA header size %d", header_size);
+            return OTA_FETCH_STATUS_ERROR;
+        }
+    }
+
+    if((offset + size) <= header_size){
+        return OTA_FETCH_STATUS_OK;
+    }
+
+    if(offset < header_size){
+        pData += (header_size - offset);
+        size -= (header_size - offset);
+    }
+
+    if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_Write(pData, size)){
+        return OTA_FETCH_STATUS_ERROR;
+    }
+
+    return OTA_FETCH_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Adapt block size on success.
+*
+*   Additive increase of the block size, bounded by the observed limit.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void adaptOnSuccess(void){
+
+    nb_blocks++;
+
+    if(++success_cptr >= OTA_FETCH_BLOCK_SIZE_INCREASE_AFTER){
+        success_cptr = 0;
+
+        uint16_t new_size = block_size + OTA_FETCH_BLOCK_SIZE_STEP;
+        block_size = (new_size > block_limit) ? block_limit : (uint8_t)new_size;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Adapt block size on error.
+*
+*   Multiplicative decrease of the block size.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void adaptOnError(void){
+
+    success_cptr = 0;
+
+    block_size /= 2;
+    if(block_size < OTA_FETCH_BLOCK_SIZE_MIN){
+        block_size = OTA_FETCH_BLOCK_SIZE_MIN;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Save download checkpoint.
+*
+*   Flush image data to flash and save the download state in NVS.
+*
+*   Preconditions: Download is running.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void saveCheckpoint(void){
+
+    if(commit_offset == checkpoint_offset){
+        return;
+    }
+
+    checkpoint.file_version = file_version;
+    checkpoint.file_size = file_size;
+    checkpoint.file_offset = commit_offset;
+    checkpoint.header_size = header_size;
+    if(OTA_IMAGE_STATUS_OK != OTA_IMAGE_GetCheckpoint(&checkpoint.image)){
+        return;
+    }
+
+    nvs_handle_t nvs_handle;
+    if(ESP_OK != nvs_open(OTA_FETCH_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle)){
+        ESP_LOGI(TAG, "Failed to open NVS");
+        return;
+    }
+
+    if(ESP_OK == nvs_set_blob(nvs_handle, OTA_FETCH_CHECKPOINT_NVS, &checkpoint, sizeof(checkpoint))){
+        nvs_commit(nvs_handle);
+        checkpoint_valid = true;
+        checkpoint_offset = commit_offset;
+
+        uint32_t attr_offset = commit_offset;
+        esp_zb_zcl_set_attribute_val(local_endpoint,
+                                     ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                                     ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                     ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID,
+                                     &attr_offset,
+                                     false);
+
+        ESP_LOGI(TAG, "Checkpoint at %lu / %lu (block size %d)",
+                      (unsigned long)commit_offset,
+                      (unsigned long)file_size,
+                      block_size);
+    }
+    nvs_close(nvs_handle);
+}
+
+/***************************************************************************//*!
+*  \brief Clear download checkpoint.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void clearCheckpoint(void){
+
+    if(!checkpoint_valid){
+        return;
+    }
+
+    nvs_handle_t nvs_handle;
+    if(ESP_OK == nvs_open(OTA_FETCH_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle)){
+        nvs_erase_key(nvs_handle, OTA_FETCH_CHECKPOINT_NVS);
+        nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+    }
+
+    checkpoint_valid = false;
+}
+
+/***************************************************************************//*!
+*  \brief Process Query Next Image response.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Command payload.
+*   \param[in]  size                Command payload size.
+*
+*******************************************************************************/
+static void processQueryNextImageRsp(uint8_t const *pData, uint16_t size){
+
+    if(fetch_state != OTA_FETCH_STATE_QUERY){
+        return;
+    }
+
+    if((size < 1) || (pData[0] != OTA_ZCL_STATUS_SUCCESS)){
+        ESP_LOGI(TAG, "No image available");
+        scheduleQuery(OTA_FETCH_QUERY_PERIOD_MS);
+        return;
+    }
+
+    if(size < 13){
+        scheduleQuery(OTA_FETCH_RETRY_PERIOD_MS);
+        return;
+    }
+
+    uint16_t manufacturer = GET_U16_LE(&pData[1]);
+    uint16_t image_type = GET_U16_LE(&pData[3]);
+    uint32_t version = GET_U32_LE(&pData[5]);
+    uint32_t size_bytes = GET_U32_LE(&pData[9]);
+
+    ESP_LOGI(TAG, "Image available: version 0x%lx, size %lu", (unsigned long)version, (unsigned long)size_bytes);
+
+    if((manufacturer != ZIGBEE_MANUFACTURER_CODE) ||
+       (image_type != OTA_IMAGE_TYPE) ||
+       (version == OTA_RUNNING_FILE_VERSION) ||
+       (size_bytes <= OTA_FILE_HEADER_SIZE_MIN)){
+
+        scheduleQuery(OTA_FETCH_QUERY_PERIOD_MS);
+        return;
+    }
+
+    startDownload(version, size_bytes);
+}
+
+/***************************************************************************//*!
+*  \brief Process Image Block response.
+*
+*   Store the block data in its request slot. Short blocks lower the block
+*   size limit and the missing part is requested again.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  tsn                 Response transaction sequence number.
+*   \param[in]  pData               Command payload.
+*   \param[in]  size                Command payload size.
+*
+*******************************************************************************/
+static void processImageBlockRsp(uint8_t tsn, uint8_t const *pData, uint16_t size){
+
+    if((fetch_state != OTA_FETCH_STATE_DOWNLOAD) || (size < 1)){
+        return;
+    }
+
+    if(pData[0] == OTA_ZCL_STATUS_ABORT){
+        abortDownload();
+        return;
+    }
+
+    if(pData[0] == OTA_ZCL_STATUS_WAIT_FOR_DATA){
+        if(size < 9){
+            return;
+        }
+
+        uint32_t current_time = GET_U32_LE(&pData[1]);
+        uint32_t request_time = GET_U32_LE(&pData[5]);
+        uint32_t delay_ms = OTA_FETCH_WAIT_FOR_DATA_MIN_MS;
+        if(request_time > current_time){
+            delay_ms = (request_time - current_time) * 1000;
+        }
+
+        for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+            if((slot_table[i].state == OTA_SLOT_SENT) && (slot_table[i].tsn == tsn)){
+                slot_table[i].state = OTA_SLOT_WAIT;
+                slot_table[i].deadline_ms = getTimeMs() + delay_ms;
+            }
+        }
+        return;
+    }
+
+    if((pData[0] != OTA_ZCL_STATUS_SUCCESS) || (size < 14)){
+        return;
+    }
+
+    uint32_t version = GET_U32_LE(&pData[5]);
+    uint32_t offset = GET_U32_LE(&pData[9]);
+    uint8_t data_size = pData[13];
+
+    if((version != file_version) || (size < (14 + data_size))){
+        return;
+    }
+
+    //Find request slot waiting for this offset
+    OTA_Fetch_Slot_t *pSlot = NULL;
+    for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+        if((slot_table[i].state == OTA_SLOT_SENT) &&
+           ((slot_table[i].offset + slot_table[i].received) == offset)){
+
+            pSlot = &slot_table[i];
+            break;
+        }
+    }
+
+    if(pSlot == NULL){
+        //Duplicate or late response
+        return;
+    }
+
+    uint8_t missing = pSlot->size - pSlot->received;
+    if(data_size > missing){
+        data_size = missing;
+    }
+
+    if(data_size == 0){
+        adaptOnError();
+        sendBlockRequest(pSlot);
+        return;
+    }
+
+    memcpy(&pSlot->data[pSlot->received], &pData[14], data_size);
+    pSlot->received += data_size;
+
+    if(pSlot->received < pSlot->size){
+        //Server or APS payload limit is lower than the requested size
+        if(data_size < block_limit){
+            block_limit = (data_size < OTA_FETCH_BLOCK_SIZE_MIN) ? OTA_FETCH_BLOCK_SIZE_MIN : data_size;
+            if(block_size > block_limit){
+                block_size = block_limit;
+            }
+            ESP_LOGI(TAG, "Block size limited to %d", block_limit);
+        }
+
+        sendBlockRequest(pSlot);
+        return;
+    }
+
+    pSlot->state = OTA_SLOT_DONE;
+    adaptOnSuccess();
+
+    commitSlots();
+
+    if(fetch_state == OTA_FETCH_STATE_DOWNLOAD){
+        fillPipeline();
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Process Upgrade End response.
+*
+*   Schedule the image activation at the upgrade time given by the server.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Command payload.
+*   \param[in]  size                Command payload size.
+*
+*******************************************************************************/
+static void processUpgradeEndRsp(uint8_t const *pData, uint16_t size){
+
+    if(((fetch_state != OTA_FETCH_STATE_UPGRADE_END) && (fetch_state != OTA_FETCH_STATE_WAIT_UPGRADE)) ||
+       (size < 16)){
+
+        return;
+    }
+
+    uint32_t current_time = GET_U32_LE(&pData[8]);
+    uint32_t upgrade_time = GET_U32_LE(&pData[12]);
+
+    uint32_t delay_ms = 0;
+    if(upgrade_time == OTA_UPGRADE_TIME_WAIT){
+        delay_ms = OTA_FETCH_UPGRADE_WAIT_MAX_MS;
+    }
+    else if(upgrade_time > current_time){
+        delay_ms = (upgrade_time - current_time) * 1000;
+    }
+
+    ESP_LOGI(TAG, "Upgrade in %lu ms", (unsigned long)delay_ms);
+
+    setImageStatus(OTA_UPGRADE_STATUS_WAITING_TO_UPGRADE);
+    fetch_state = OTA_FETCH_STATE_WAIT_UPGRADE;
+    state_deadline_ms = getTimeMs() + delay_ms;
+}
+
+/***************************************************************************//*!
+*  \brief OTA fetch engine tick.
+*
+*   Periodic engine processing, scheduled on the Zigbee stack scheduler.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  param               Unused.
+*
+*******************************************************************************/
+static void engineTick(uint8_t param){
+
+    int64_t now = getTimeMs();
+    uint32_t next_tick_ms = OTA_FETCH_TICK_MS;
+
+    switch(fetch_state){
+
+        case OTA_FETCH_STATE_IDLE:
+        {
+            if((now >= state_deadline_ms) && isConnected()){
+                if(server_addr == 0xFFFF){
+                    startDiscovery();
+                }
+                else{
+                    sendQueryNextImage();
+                }
+            }
+            else{
+                next_tick_ms = OTA_FETCH_IDLE_TICK_MS;
+            }
+        }
+        break;
+
+        case OTA_FETCH_STATE_DISCOVERY:
+        case OTA_FETCH_STATE_QUERY:
+        {
+            if(now >= state_deadline_ms){
+                ESP_LOGI(TAG, "OTA server not responding");
+                server_addr = 0xFFFF;
+                scheduleQuery(OTA_FETCH_RETRY_PERIOD_MS);
+            }
+        }
+        break;
+
+        case OTA_FETCH_STATE_DOWNLOAD:
+        {
+            if(!isConnected()){
+                pauseDownload(0);
+            }
+            else{
+                checkTimeouts();
+                if(fetch_state == OTA_FETCH_STATE_DOWNLOAD){
+                    fillPipeline();
+                }
+            }
+        }
+        break;
+
+        case OTA_FETCH_STATE_PAUSED:
+        {
+            if((now >= state_deadline_ms) && isConnected()){
+                ESP_LOGI(TAG, "Download resumed at %lu", (unsigned long)commit_offset);
+                fetch_state = OTA_FETCH_STATE_DOWNLOAD;
+                fillPipeline();
+            }
+            else{
+                next_tick_ms = OTA_FETCH_IDLE_TICK_MS;
+            }
+        }
+        break;
+
+        case OTA_FETCH_STATE_UPGRADE_END:
+        case OTA_FETCH_STATE_WAIT_UPGRADE:
+        {
+            //No Upgrade End response -> apply image anyway
+            if(now >= state_deadline_ms){
+                applyUpgrade();
+            }
+            else{
+                next_tick_ms = OTA_FETCH_IDLE_TICK_MS;
+            }
+        }
+        break;
+
+        default:
+        break;
+    }
+
+    esp_zb_scheduler_alarm((esp_zb_callback_t)engineTick, 0, next_tick_ms);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief OTA fetch engine initialization.
+*
+*   Initialize the block fetch engine and restore the download checkpoint
+*   stored in NVS (if any).
+*
+*   Preconditions: NVS is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Local endpoint of the OTA client.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_FETCH_Ret_t OTA_FETCH_Init(uint8_t endpoint){
+
+    local_endpoint = endpoint;
+    memset(slot_table, 0, sizeof(slot_table));
+    block_size = OTA_FETCH_BLOCK_SIZE_INIT;
+    block_limit = OTA_FETCH_BLOCK_SIZE_MAX;
+    checkpoint_valid = false;
+
+    nvs_handle_t nvs_handle;
+    if(ESP_OK != nvs_open(OTA_FETCH_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle)){
+        ESP_LOGI(TAG, "Failed to open NVS");
+        return OTA_FETCH_STATUS_ERROR;
+    }
+
+    size_t length = sizeof(checkpoint);
+    if((ESP_OK == nvs_get_blob(nvs_handle, OTA_FETCH_CHECKPOINT_NVS, &checkpoint, &length)) &&
+       (length == sizeof(checkpoint))){
+
+        ESP_LOGI(TAG, "Found checkpoint for version 0x%lx at %lu / %lu",
+                      (unsigned long)checkpoint.file_version,
+                      (unsigned long)checkpoint.file_offset,
+                      (unsigned long)checkpoint.file_size);
+        checkpoint_valid = true;
+    }
+    nvs_close(nvs_handle);
+
+    scheduleQuery(0);
+
+    return OTA_FETCH_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Start OTA fetch engine.
+*
+*   Start the engine periodic processing. The engine looks for an OTA server,
+*   queries the next image and downloads it while the device is connected.
+*
+*   Preconditions: Must be called from the Zigbee task context once the
+*                  device joined a network.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_FETCH_Start(void){
+
+    if(!tick_running){
+        tick_running = true;
+        esp_zb_scheduler_alarm((esp_zb_callback_t)engineTick, 0, OTA_FETCH_IDLE_TICK_MS);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Process OTA cluster command.
+*
+*   Handle a command received from the OTA server (Image Notify, Query Next
+*   Image response, Image Block response, Upgrade End response).
+*
+*   Preconditions: OTA fetch engine is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t OTA_FETCH_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage){
+
+    if(pMessage == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t const *pData = (uint8_t const *)pMessage->data.value;
+    uint16_t size = pMessage->data.size;
+
+    switch(pMessage->info.command.id){
+
+        case OTA_CMD_IMAGE_NOTIFY:
+        {
+            if(fetch_state == OTA_FETCH_STATE_IDLE){
+                ESP_LOGI(TAG, "Image notify from 0x%04x", pMessage->info.src_address.u.short_addr);
+                server_addr = pMessage->info.src_address.u.short_addr;
+                server_ep = pMessage->info.src_endpoint;
+                scheduleQuery(0);
+            }
+        }
+        break;
+
+        case OTA_CMD_QUERY_NEXT_IMAGE_RSP:
+        {
+            processQueryNextImageRsp(pData, size);
+        }
+        break;
+
+        case OTA_CMD_IMAGE_BLOCK_RSP:
+        {
+            processImageBlockRsp(pMessage->info.header.tsn, pData, size);
+        }
+        break;
+
+        case OTA_CMD_UPGRADE_END_RSP:
+        {
+            processUpgradeEndRsp(pData, size);
+        }
+        break;
+
+        default:
+        {
+            ESP_LOGI(TAG, "Unsupported OTA command 0x%02x", pMessage->info.command.id);
+        }
+        break;
+    }
+
+    return ESP_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Process ZCL command send status.
+*
+*   Report the APS delivery status of a command sent by the engine. Failed
+*   block requests are retried right away.
+*
+*   Preconditions: OTA fetch engine is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Send status message
+*
+*******************************************************************************/
+void OTA_FETCH_ProcessSendStatus(const esp_zb_zcl_command_send_status_message_t *pMessage){
+
+    if((pMessage == NULL) || (pMessage->status == ESP_OK) || (fetch_state != OTA_FETCH_STATE_DOWNLOAD)){
+        return;
+    }
+
+    for(uint8_t i=0; i<OTA_FETCH_PIPELINE_DEPTH; i++){
+
+        OTA_Fetch_Slot_t *pSlot = &slot_table[i];
+        if((pSlot->state == OTA_SLOT_SENT) && (pSlot->tsn == pMessage->tsn)){
+            adaptOnError();
+            nb_retries++;
+
+            //Let the timeout handle the retry if the link keeps failing
+            if(++pSlot->retries <= OTA_FETCH_BLOCK_MAX_RETRIES){
+                sendBlockRequest(pSlot);
+            }
+            break;
+        }
+    }
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,112 @@
+#ifndef _OTA_FETCH_H
+#define _OTA_FETCH_H
+
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define OTA_FETCH_PIPELINE_DEPTH        (4)//Block requests kept in flight
+#define OTA_FETCH_BLOCK_SIZE_MIN        (16)
+#define OTA_FETCH_BLOCK_SIZE_INIT       (32)
+#define OTA_FETCH_BLOCK_SIZE_MAX        (64)//Fits an unfragmented APS frame
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum OTA_FETCH_Ret_e{
+    OTA_FETCH_STATUS_ERROR,
+    OTA_FETCH_STATUS_OK,
+}OTA_FETCH_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (OTA_FETCH_PIPELINE_DEPTH < 1)
+#error "OTA_FETCH_PIPELINE_DEPTH must be at least 1"
+#endif
+
+#if (OTA_FETCH_BLOCK_SIZE_MIN < 8) || (OTA_FETCH_BLOCK_SIZE_MAX > 255) || \
+    (OTA_FETCH_BLOCK_SIZE_INIT < OTA_FETCH_BLOCK_SIZE_MIN) || (OTA_FETCH_BLOCK_SIZE_INIT > OTA_FETCH_BLOCK_SIZE_MAX)
+#error "Invalid OTA fetch block size configuration"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief OTA fetch engine initialization.
+*
+*   Initialize the block fetch engine and restore the download checkpoint
+*   stored in NVS (if any).
+*
+*   Preconditions: NVS is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Local endpoint of the OTA client.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_FETCH_Ret_t OTA_FETCH_Init(uint8_t endpoint);
+
+/***************************************************************************//*!
+*  \brief Start OTA fetch engine.
+*
+*   Start the engine periodic processing. The engine looks for an OTA server,
+*   queries the next image and downloads it while the device is connected.
+*
+*   Preconditions: Must be called from the Zigbee task context once the
+*                  device joined a network.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_FETCH_Start(void);
+
+/***************************************************************************//*!
+*  \brief Process OTA cluster command.
+*
+*   Handle a command received from the OTA server (Image Notify, Query Next
+*   Image response, Image Block response, Upgrade End response).
+*
+*   Preconditions: OTA fetch engine is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Custom cluster command message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t OTA_FETCH_ProcessCommand(const esp_zb_zcl_custom_cluster_command_message_t *pMessage);
+
+/***************************************************************************//*!
+*  \brief Process ZCL command send status.
+*
+*   Report the APS delivery status of a command sent by the engine. Failed
+*   block requests are retried right away.
+*
+*   Preconditions: OTA fetch engine is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Send status message
+*
+*******************************************************************************/
+void OTA_FETCH_ProcessSendStatus(const esp_zb_zcl_command_send_status_message_t *pMessage);
+
+#endif//_OTA_FETCH_H
@@ -47,12 +47,13 @@ typedef enum TEMP_Cluster_Ret_e{
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
 *   \param[in]  pCluster_list           Zigbee cluster list.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-TEMP_Cluster_Ret_t TEMP_InitCluster(esp_zb_cluster_list_t *pCluster_list);
+TEMP_Cluster_Ret_t TEMP_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
 
 /***************************************************************************//*!
 *  \brief Temperate cluster reporting setup.
@@ -63,10 +64,12 @@ TEMP_Cluster_Ret_t TEMP_InitCluster(esp_zb_cluster_list_t *pCluster_list);
 *
 *   Side Effects: None. 
 *
+*   \param[in]  endpoint                Endpoint ID.
+*
 *   \return     Operation status
 *
 *******************************************************************************/
-TEMP_Cluster_Ret_t TEMP_SetupReporting(void);
+TEMP_Cluster_Ret_t TEMP_SetupReporting(uint8_t endpoint);
 
 /***************************************************************************//*!
 *  \brief Set Temperature measurement value.
@@ -0,0 +1,420 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_cluster.h"
+
+#include "timeCluster.h"
+#include "zigbeeManager.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define TIME_SYNC_INTERVAL_MIN_S        (15 * 60)
+#define TIME_SYNC_INTERVAL_MAX_S        (24 * 60 * 60)
+#define TIME_SYNC_RETRY_S               (60)//First retry delay, doubled up to the resync interval
+
+#define TIME_SYNC_TOLERANCE_S           (2)//Prediction error allowing a longer interval
+#define TIME_STEP_THRESHOLD_S           (60)//Prediction error considered as a time change
+#define TIME_DRIFT_MIN_SPAN_S           (6 * 60 * 60)//1s resolution -> < 50ppm error
+#define TIME_DRIFT_MAX_PPM              (500)
+
+#define TIME_UTC_INVALID                (0xFFFFFFFF)
+#define TIME_SERVER_EP_UNKNOWN          (0xFF)
+
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define ABS(x)                          (((x) < 0) ? -(x) : (x))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static int64_t computeUtc(int64_t local_us);
+static void updateSync(uint32_t utc, int64_t local_us);
+static void matchDescCallback(esp_zb_zdp_status_t zdo_status, uint16_t addr, uint8_t endpoint, void *user_ctx);
+static void sendTimeReadReq(uint8_t param);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static bool time_synced = false;
+
+//Last synchronization point
+static int64_t ref_local_us = 0;
+static uint32_t ref_utc = 0;
+
+//Drift characterization start point
+static int64_t origin_local_us = 0;
+static uint32_t origin_utc = 0;
+
+static int32_t drift_ppm = 0;
+static uint32_t sync_interval_s = TIME_SYNC_INTERVAL_MIN_S;
+static uint32_t retry_delay_s = TIME_SYNC_RETRY_S;
+
+static uint8_t server_endpoint = TIME_SERVER_EP_UNKNOWN;//From the match descriptor response
+
+static SemaphoreHandle_t time_mutex_handle = NULL;
+static StaticSemaphore_t time_mutex_buffer;
+
+static uint8_t cluster_endpoint = 0;//Set at cluster init
+
+static const char * TAG = "TIME";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Compute UTC time.
+*
+*   Extrapolate the UTC time from the last synchronization point, corrected
+*   with the estimated local clock drift.
+*
+*   Preconditions: Mutex is taken. Time is synchronized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  local_us            Local time (esp_timer).
+*
+*   \return     UTC time in seconds
+*
+*******************************************************************************/
+static int64_t computeUtc(int64_t local_us){
+
+    int64_t elapsed_us = local_us - ref_local_us;
+
+    elapsed_us += (elapsed_us * drift_ppm) / 1000000;
+
+    return (int64_t)ref_utc + (elapsed_us / 1000000);
+}
+
+/***************************************************************************//*!
+*  \brief Update synchronization.
+*
+*   Compare the received time with the predicted one. The resync interval is
+*   doubled while the prediction stays within tolerance and halved otherwise.
+*   The drift is measured over the whole span since the first sync so the
+*   1 second resolution of the Time attribute becomes negligible.
+*
+*   Preconditions: Mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  utc                 Received UTC time.
+*   \param[in]  local_us            Local time at reception.
+*
+*******************************************************************************/
+static void updateSync(uint32_t utc, int64_t local_us){
+
+    if(time_synced){
+        int64_t error_s = (int64_t)utc - computeUtc(local_us);
+
+        ESP_LOGI(TAG, "Sync error: %llds, drift: %ldppm", error_s, (long)drift_ppm);
+
+        if(ABS(error_s) > TIME_STEP_THRESHOLD_S){
+            //Coordinator time changed -> restart drift characterization
+            origin_local_us = local_us;
+            origin_utc = utc;
+            drift_ppm = 0;
+            sync_interval_s = TIME_SYNC_INTERVAL_MIN_S;
+        }
+        else if(ABS(error_s) <= TIME_SYNC_TOLERANCE_S){
+            sync_interval_s *= 2;
+            if(sync_interval_s > TIME_SYNC_INTERVAL_MAX_S){
+                sync_interval_s = TIME_SYNC_INTERVAL_MAX_S;
+            }
+        }
+        else{
+            sync_interval_s /= 2;
+            if(sync_interval_s < TIME_SYNC_INTERVAL_MIN_S){
+                sync_interval_s = TIME_SYNC_INTERVAL_MIN_S;
+            }
+        }
+
+        int64_t span_s = (int64_t)utc - origin_utc;
+        int64_t local_span_us = local_us - origin_local_us;
+        if((span_s >= TIME_DRIFT_MIN_SPAN_S) && (local_span_us > 0)){
+            int64_t ppm = (((span_s * 1000000) - local_span_us) * 1000000) / local_span_us;
+            if(ppm > TIME_DRIFT_MAX_PPM){
+                ppm = TIME_DRIFT_MAX_PPM;
+            }
+            else if(ppm < -TIME_DRIFT_MAX_PPM){
+                ppm = -TIME_DRIFT_MAX_PPM;
+            }
+            drift_ppm = (int32_t)ppm;
+        }
+    }
+    else{
+        origin_local_us = local_us;
+        origin_utc = utc;
+        sync_interval_s = TIME_SYNC_INTERVAL_MIN_S;
+    }
+
+    ref_local_us = local_us;
+    ref_utc = utc;
+    time_synced = true;
+}
+
+/***************************************************************************//*!
+*  \brief Match descriptor response callback.
+*
+*   Keep the endpoint of the coordinator Time server and read the time right
+*   away. On failure the pending retry starts a new discovery.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  zdo_status          ZDO command status.
+*   \param[in]  addr                Server short address.
+*   \param[in]  endpoint            Server endpoint.
+*   \param[in]  user_ctx            Pointer to user context (optional).
+*
+*******************************************************************************/
+static void matchDescCallback(esp_zb_zdp_status_t zdo_status, uint16_t addr, uint8_t endpoint, void *user_ctx){
+
+    if(zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "No Time server found");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Time server 0x%04x, endpoint %d", addr, endpoint);
+    server_endpoint = endpoint;
+
+    //Replace the discovery retry by the read request
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)sendTimeReadReq, 0);
+    retry_delay_s = TIME_SYNC_RETRY_S;
+    sendTimeReadReq(0);
+}
+
+/***************************************************************************//*!
+*  \brief Send Time read request.
+*
+*   Read the Time attribute of the coordinator, once its Time server endpoint
+*   was found with a match descriptor request. A new request is scheduled in
+*   case no response is received, the retry delay doubles up to the resync
+*   interval.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  param               Unused.
+*
+*******************************************************************************/
+static void sendTimeReadReq(uint8_t param){
+
+    if(server_endpoint == TIME_SERVER_EP_UNKNOWN){
+        static uint16_t cluster_list[] = {ESP_ZB_ZCL_CLUSTER_ID_TIME};
+        esp_zb_zdo_match_desc_req_param_t match_req = {
+            .dst_nwk_addr = TIME_SERVER_ADDR,
+            .addr_of_interest = TIME_SERVER_ADDR,
+            .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .num_in_clusters = 1,
+            .num_out_clusters = 0,
+            .cluster_list = cluster_list,
+        };
+        esp_zb_zdo_match_cluster(&match_req, matchDescCallback, NULL);
+    }
+    else{
+        uint16_t attr_id = ESP_ZB_ZCL_ATTR_TIME_TIME_ID;
+
+        esp_zb_zcl_read_attr_cmd_t req = {
+            .zcl_basic_cmd = {
+                .dst_addr_u.addr_short = TIME_SERVER_ADDR,
+                .dst_endpoint = server_endpoint,
+                .src_endpoint = cluster_endpoint,
+            },
+            .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+            .clusterID = ESP_ZB_ZCL_CLUSTER_ID_TIME,
+            .attr_number = 1,
+            .attr_field = &attr_id,
+        };
+        esp_zb_zcl_read_attr_cmd_req(&req);
+    }
+
+    esp_zb_scheduler_alarm((esp_zb_callback_t)sendTimeReadReq, 0, retry_delay_s * 1000);
+
+    retry_delay_s *= 2;
+    if(retry_delay_s > sync_interval_s){
+        retry_delay_s = sync_interval_s;
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Time cluster initialization.
+*
+*   Initialize the Time cluster (client role) and add it to the cluster list
+*   passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+TIME_Cluster_Ret_t TIME_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    cluster_endpoint = endpoint;
+
+    ESP_LOGI(TAG, "Cluster Initialization");
+
+    if(time_mutex_handle == NULL){
+        time_mutex_handle = xSemaphoreCreateMutexStatic(&time_mutex_buffer);
+        if(time_mutex_handle == NULL){
+            ESP_LOGI(TAG, "Failed to create time mutex");
+            return TIME_CLUSTER_STATUS_ERROR;
+        }
+    }
+
+    esp_zb_attribute_list_t *pTimeCluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TIME);
+
+    if(ESP_OK != esp_zb_cluster_list_add_time_cluster(pCluster_list,
+                                                      pTimeCluster,
+                                                      ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE)){
+
+        ESP_LOGI(TAG, "Failed to add Time cluster");
+        return TIME_CLUSTER_STATUS_ERROR;
+    }
+
+    return TIME_CLUSTER_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Start time synchronization.
+*
+*   Find the Time server endpoint of the coordinator, read the UTC time from
+*   it, then keep reading it periodically.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void TIME_StartSync(void){
+
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)sendTimeReadReq, 0);
+    server_endpoint = TIME_SERVER_EP_UNKNOWN;
+    retry_delay_s = TIME_SYNC_RETRY_S;
+    sendTimeReadReq(0);
+}
+
+/***************************************************************************//*!
+*  \brief Process read attribute response.
+*
+*   Handle the Time attribute read response from the coordinator.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Read attribute response message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t TIME_ProcessReadResp(const esp_zb_zcl_cmd_read_attr_resp_message_t *pMessage){
+
+    if(pMessage == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t local_us = esp_timer_get_time();
+
+    if(pMessage->info.status != ESP_ZB_ZCL_STATUS_SUCCESS){
+        return ESP_OK;
+    }
+
+    for(esp_zb_zcl_read_attr_resp_variable_t *pVar = pMessage->variables; pVar != NULL; pVar = pVar->next){
+
+        if((pVar->status != ESP_ZB_ZCL_STATUS_SUCCESS) ||
+           (pVar->attribute.id != ESP_ZB_ZCL_ATTR_TIME_TIME_ID) ||
+           (pVar->attribute.data.value == NULL)){
+            continue;
+        }
+
+        uint32_t utc = *(uint32_t *)pVar->attribute.data.value;
+        if(utc == TIME_UTC_INVALID){
+            ESP_LOGI(TAG, "Coordinator time not set");
+            continue;
+        }
+
+        xSemaphoreTake(time_mutex_handle, portMAX_DELAY);
+        updateSync(utc, local_us);
+        uint32_t next_sync_ms = sync_interval_s * 1000;
+        xSemaphoreGive(time_mutex_handle);
+
+        ESP_LOGI(TAG, "Time synchronized: %lu, next sync in %lus",
+                      (unsigned long)utc,
+                      (unsigned long)(next_sync_ms / 1000));
+
+        //Replace the retry by the next periodic sync
+        retry_delay_s = TIME_SYNC_RETRY_S;
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)sendTimeReadReq, 0);
+        esp_zb_scheduler_alarm((esp_zb_callback_t)sendTimeReadReq, 0, next_sync_ms);
+    }
+
+    return ESP_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Get UTC time.
+*
+*   Return the drift corrected UTC time, in seconds since 2000-01-01
+*   (Zigbee epoch).
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pUtc                    UTC time in seconds.
+*
+*   \return     Operation status (error if time was never synchronized)
+*
+*******************************************************************************/
+TIME_Cluster_Ret_t TIME_GetUtc(uint32_t *pUtc){
+
+    if((pUtc == NULL) || (time_mutex_handle == NULL)){
+        return TIME_CLUSTER_STATUS_ERROR;
+    }
+
+    TIME_Cluster_Ret_t ret = TIME_CLUSTER_STATUS_ERROR;
+
+    xSemaphoreTake(time_mutex_handle, portMAX_DELAY);
+    if(time_synced){
+        *pUtc = (uint32_t)computeUtc(esp_timer_get_time());
+        ret = TIME_CLUSTER_STATUS_OK;
+    }
+    xSemaphoreGive(time_mutex_handle);
+
+    return ret;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,103 @@
+#ifndef _TIME_CLUSTER_H
+#define _TIME_CLUSTER_H
+
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define TIME_SERVER_ADDR                (0x0000)//Coordinator
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum TIME_Cluster_Ret_e{
+    TIME_CLUSTER_STATUS_ERROR,
+    TIME_CLUSTER_STATUS_OK,
+}TIME_Cluster_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Time cluster initialization.
+*
+*   Initialize the Time cluster (client role) and add it to the cluster list
+*   passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  endpoint                Endpoint ID.
+*   \param[in]  pCluster_list           Zigbee cluster list
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+TIME_Cluster_Ret_t TIME_InitCluster(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+/***************************************************************************//*!
+*  \brief Start time synchronization.
+*
+*   Find the Time server endpoint of the coordinator, read the UTC time from
+*   it, then keep reading it periodically.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void TIME_StartSync(void);
+
+/***************************************************************************//*!
+*  \brief Process read attribute response.
+*
+*   Handle the Time attribute read response from the coordinator.
+*
+*   Preconditions: Must be called from the Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pMessage                Read attribute response message
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+esp_err_t TIME_ProcessReadResp(const esp_zb_zcl_cmd_read_attr_resp_message_t *pMessage);
+
+/***************************************************************************//*!
+*  \brief Get UTC time.
+*
+*   Return the drift corrected UTC time, in seconds since 2000-01-01
+*   (Zigbee epoch).
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pUtc                    UTC time in seconds.
+*
+*   \return     Operation status (error if time was never synchronized)
+*
+*******************************************************************************/
+TIME_Cluster_Ret_t TIME_GetUtc(uint32_t *pUtc);
+
+#endif//_TIME_CLUSTER_H
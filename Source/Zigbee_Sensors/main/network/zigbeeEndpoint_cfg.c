@@ -0,0 +1,260 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "zigbeeEndpoint_cfg.h"
+#include "zigbeeManager.h"
+#include "basicCluster.h"
+#include "identifyCluster.h"
+#include "tempMeasCluster.h"
+#include "humidityMeasCluster.h"
+#include "otaCluster.h"
+#include "timeCluster.h"
+#include "historyCluster.h"
+#include "diagCluster.h"
+#include "sensorController.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+//Adapt a cluster module init/setup function to the table callback type
+#define CLUSTER_INIT_CB(name, init_fn, status_ok)                                       \
+    static ZB_EP_CFG_Ret_t name(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){\
+        bool success = (status_ok == init_fn(endpoint, pCluster_list));                 \
+        return success ? ZB_EP_CFG_STATUS_OK : ZB_EP_CFG_STATUS_ERROR;                  \
+    }
+
+#define CLUSTER_SETUP_CB(name, setup_fn, status_ok)                                     \
+    static ZB_EP_CFG_Ret_t name(uint8_t endpoint){                                      \
+        bool success = (status_ok == setup_fn(endpoint));                               \
+        return success ? ZB_EP_CFG_STATUS_OK : ZB_EP_CFG_STATUS_ERROR;                  \
+    }
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef ZB_EP_CFG_Ret_t (*ZB_EP_CFG_InitCluster_Cb_t)(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+typedef ZB_EP_CFG_Ret_t (*ZB_EP_CFG_SetupCluster_Cb_t)(uint8_t endpoint);
+
+typedef struct ZB_EP_CFG_Cluster_s{
+    uint32_t required_caps;                     //Sensor capabilities required (0: always created)
+    ZB_EP_CFG_InitCluster_Cb_t init;            //Create the cluster and add it to the cluster list
+    ZB_EP_CFG_SetupCluster_Cb_t setup;          //Setup after device registration (NULL: nothing to setup)
+}ZB_EP_CFG_Cluster_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static ZB_EP_CFG_Ret_t initBasic(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initIdentify(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initTemperature(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initHumidity(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initOta(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initTime(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initHistory(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+static ZB_EP_CFG_Ret_t initDiag(uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+static ZB_EP_CFG_Ret_t setupIdentify(uint8_t endpoint);
+static ZB_EP_CFG_Ret_t setupTemperature(uint8_t endpoint);
+static ZB_EP_CFG_Ret_t setupHumidity(uint8_t endpoint);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const ZB_EP_CFG_Endpoint_t endpoint_table[ZB_EP_CFG_NB_ENDPOINT] = {
+    {
+        .endpoint = ZIGBEE_ENDPOINT_1,
+        .device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+        .cluster_mask = ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_BASIC) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_IDENTIFY) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_TEMPERATURE) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_HUMIDITY) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_OTA) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_TIME) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_HISTORY) |
+                        ZB_EP_CFG_CLUSTER_BIT(ZB_EP_CFG_CLUSTER_DIAG),
+    },
+};
+
+static const ZB_EP_CFG_Cluster_t cluster_table[ZB_EP_CFG_CLUSTER_NB] = {
+    [ZB_EP_CFG_CLUSTER_BASIC] = {
+        .required_caps = 0,
+        .init = initBasic,
+        .setup = NULL,
+    },
+    [ZB_EP_CFG_CLUSTER_IDENTIFY] = {
+        .required_caps = 0,
+        .init = initIdentify,
+        .setup = setupIdentify,
+    },
+    [ZB_EP_CFG_CLUSTER_TEMPERATURE] = {
+        .required_caps = SENSOR_CAP_TEMPERATURE,
+        .init = initTemperature,
+        .setup = setupTemperature,
+    },
+    [ZB_EP_CFG_CLUSTER_HUMIDITY] = {
+        .required_caps = SENSOR_CAP_HUMIDITY,
+        .init = initHumidity,
+        .setup = setupHumidity,
+    },
+    [ZB_EP_CFG_CLUSTER_OTA] = {
+        .required_caps = 0,
+        .init = initOta,
+        .setup = NULL,
+    },
+    [ZB_EP_CFG_CLUSTER_TIME] = {
+        .required_caps = 0,
+        .init = initTime,
+        .setup = NULL,
+    },
+    [ZB_EP_CFG_CLUSTER_HISTORY] = {
+        .required_caps = SENSOR_CAP_TEMPERATURE | SENSOR_CAP_HUMIDITY,
+        .init = initHistory,
+        .setup = NULL,
+    },
+    [ZB_EP_CFG_CLUSTER_DIAG] = {
+        .required_caps = 0,
+        .init = initDiag,
+        .setup = NULL,
+    },
+};
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+_Static_assert(ZB_EP_CFG_CLUSTER_NB <= 32, "Cluster mask is limited to 32 clusters");
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+CLUSTER_INIT_CB(initBasic, BASIC_IntiCluster, BASIC_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initIdentify, IDENTIFY_InitCluster, IDENTIFY_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initTemperature, TEMP_InitCluster, TEMP_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initHumidity, HUMIDITY_InitCluster, HUMIDITY_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initOta, OTA_InitCluster, OTA_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initTime, TIME_InitCluster, TIME_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initHistory, HISTORY_InitCluster, HISTORY_CLUSTER_STATUS_OK)
+CLUSTER_INIT_CB(initDiag, DIAG_InitCluster, DIAG_CLUSTER_STATUS_OK)
+
+CLUSTER_SETUP_CB(setupIdentify, IDENTIFY_SetupCmdHandler, IDENTIFY_CLUSTER_STATUS_OK)
+CLUSTER_SETUP_CB(setupTemperature, TEMP_SetupReporting, TEMP_CLUSTER_STATUS_OK)
+CLUSTER_SETUP_CB(setupHumidity, HUMIDITY_SetupReporting, HUMIDITY_CLUSTER_STATUS_OK)
+
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Get endpoint descriptor.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index                   Endpoint index (< ZB_EP_CFG_NB_ENDPOINT).
+*
+*   \return     Endpoint descriptor (NULL if index is invalid)
+*
+*******************************************************************************/
+const ZB_EP_CFG_Endpoint_t * ZB_EP_CFG_GetEndpoint(uint8_t index){
+
+    if(index >= ZB_EP_CFG_NB_ENDPOINT){
+        return NULL;
+    }
+
+    return &endpoint_table[index];
+}
+
+/***************************************************************************//*!
+*  \brief Check if a cluster is supported.
+*
+*   A cluster is supported when all the sensor capabilities it requires were
+*   detected at boot.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  sensor_caps             Detected sensor capabilities.
+*
+*   \return     true if the cluster must be created
+*
+*******************************************************************************/
+bool ZB_EP_CFG_IsClusterSupported(ZB_EP_CFG_ClusterId_t cluster_id, uint32_t sensor_caps){
+
+    if(cluster_id >= ZB_EP_CFG_CLUSTER_NB){
+        return false;
+    }
+
+    uint32_t required_caps = cluster_table[cluster_id].required_caps;
+
+    return ((sensor_caps & required_caps) == required_caps);
+}
+
+/***************************************************************************//*!
+*  \brief Init cluster.
+*
+*   Create the cluster and add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  endpoint                Endpoint ID the cluster list belongs to.
+*   \param[in]  pCluster_list           Zigbee cluster list.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZB_EP_CFG_Ret_t ZB_EP_CFG_InitCluster(ZB_EP_CFG_ClusterId_t cluster_id, uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list){
+
+    if(cluster_id >= ZB_EP_CFG_CLUSTER_NB){
+        return ZB_EP_CFG_STATUS_ERROR;
+    }
+
+    return cluster_table[cluster_id].init(endpoint, pCluster_list);
+}
+
+/***************************************************************************//*!
+*  \brief Setup cluster.
+*
+*   Perform the cluster setup needing a registered device (reporting,
+*   command handlers, ...).
+*
+*   Preconditions: This function must be called AFTER esp_zb_device_register().
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  endpoint                Endpoint ID the cluster was created on.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZB_EP_CFG_Ret_t ZB_EP_CFG_SetupCluster(ZB_EP_CFG_ClusterId_t cluster_id, uint8_t endpoint){
+
+    if(cluster_id >= ZB_EP_CFG_CLUSTER_NB){
+        return ZB_EP_CFG_STATUS_ERROR;
+    }
+
+    if(cluster_table[cluster_id].setup == NULL){
+        return ZB_EP_CFG_STATUS_OK;//Nothing to setup
+    }
+
+    return cluster_table[cluster_id].setup(endpoint);
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,127 @@
+#ifndef _ZIGBEE_ENDPOINT_CFG_H
+#define _ZIGBEE_ENDPOINT_CFG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_zigbee_core.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define ZB_EP_CFG_NB_ENDPOINT               (1)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+#define ZB_EP_CFG_CLUSTER_BIT(id)           (1UL << (id))
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum ZB_EP_CFG_ClusterId_e{
+    ZB_EP_CFG_CLUSTER_BASIC,
+    ZB_EP_CFG_CLUSTER_IDENTIFY,
+    ZB_EP_CFG_CLUSTER_TEMPERATURE,
+    ZB_EP_CFG_CLUSTER_HUMIDITY,
+    ZB_EP_CFG_CLUSTER_OTA,
+    ZB_EP_CFG_CLUSTER_TIME,
+    ZB_EP_CFG_CLUSTER_HISTORY,
+    ZB_EP_CFG_CLUSTER_DIAG,
+
+    ZB_EP_CFG_CLUSTER_NB,
+}ZB_EP_CFG_ClusterId_t;
+
+typedef struct ZB_EP_CFG_Endpoint_s{
+    uint8_t endpoint;
+    uint16_t device_id;
+    uint32_t cluster_mask;//ZB_EP_CFG_CLUSTER_BIT() of the candidate clusters
+}ZB_EP_CFG_Endpoint_t;
+
+typedef enum ZB_EP_CFG_Ret_e{
+    ZB_EP_CFG_STATUS_ERROR,
+    ZB_EP_CFG_STATUS_OK,
+}ZB_EP_CFG_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Get endpoint descriptor.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index                   Endpoint index (< ZB_EP_CFG_NB_ENDPOINT).
+*
+*   \return     Endpoint descriptor (NULL if index is invalid)
+*
+*******************************************************************************/
+const ZB_EP_CFG_Endpoint_t * ZB_EP_CFG_GetEndpoint(uint8_t index);
+
+/***************************************************************************//*!
+*  \brief Check if a cluster is supported.
+*
+*   A cluster is supported when all the sensor capabilities it requires were
+*   detected at boot.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  sensor_caps             Detected sensor capabilities.
+*
+*   \return     true if the cluster must be created
+*
+*******************************************************************************/
+bool ZB_EP_CFG_IsClusterSupported(ZB_EP_CFG_ClusterId_t cluster_id, uint32_t sensor_caps);
+
+/***************************************************************************//*!
+*  \brief Init cluster.
+*
+*   Create the cluster and add it to the cluster list passed to this function.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  endpoint                Endpoint ID the cluster list belongs to.
+*   \param[in]  pCluster_list           Zigbee cluster list.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZB_EP_CFG_Ret_t ZB_EP_CFG_InitCluster(ZB_EP_CFG_ClusterId_t cluster_id, uint8_t endpoint, esp_zb_cluster_list_t *pCluster_list);
+
+/***************************************************************************//*!
+*  \brief Setup cluster.
+*
+*   Perform the cluster setup needing a registered device (reporting,
+*   command handlers, ...).
+*
+*   Preconditions: This function must be called AFTER esp_zb_device_register().
+*
+*   Side Effects: None.
+*
+*   \param[in]  cluster_id              Cluster ID.
+*   \param[in]  endpoint                Endpoint ID the cluster was created on.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZB_EP_CFG_Ret_t ZB_EP_CFG_SetupCluster(ZB_EP_CFG_ClusterId_t cluster_id, uint8_t endpoint);
+
+#endif//_ZIGBEE_ENDPOINT_CFG_H
@@ -1,7 +1,9 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <stdbool.h>
 
 #include "freertos/FreeRTOS.h"
@@ -14,10 +16,13 @@
 #include "esp_log.h"
 
 #include "zigbeeManager.h"
-#include "basicCluster.h"
-#include "tempMeasCluster.h"
-#include "humidityMeasCluster.h"
-#include "identifyCluster.h"
+#include "otaCluster.h"
+#include "historyCluster.h"
+#include "timeCluster.h"
+#include "zigbeeEndpoint_cfg.h"
+#include "bootTrace.h"
+#include "powerManager.h"
+#include "healthMonitor.h"
 
 /******************************************************************************
 *   Private Definitions
@@ -31,6 +36,15 @@
 #define NWK_COORDO_DETECT_PERIOD_MS                 (30 * 1000)
 #define NWK_COORD_DETECT_TIMEOUT_MS                 (5 * 1000)
 
+#define TXP_WINDOW_SIZE                             (16)//APS sends per evaluation window
+#define TXP_LQI_HIGH                                (200)//Parent LQI allowing a step down
+#define TXP_LQI_LOW                                 (120)//Parent LQI forcing a step up
+#define TXP_CONSECUTIVE_FAIL_MAX                    (2)//Consecutive failures forcing a step up
+#define TXP_HOLD_WINDOWS_MAX                        (32)//Max windows before a new step down
+#define TXP_BACKOFF_DECAY_WINDOWS                   (8)//Healthy windows halving the hold backoff
+
+#define ZIGBEE_TASK_STACK_SIZE                      (4096)
+
 #define LOG_LOCAL_LEVEL                             (ESP_LOG_INFO)
 
 /******************************************************************************
@@ -41,7 +55,10 @@
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
-
+typedef struct ZIGBEE_TxPower_Level_s{
+    int8_t tx_power_dbm;
+    uint16_t tx_current_ma;//Approximate radio TX current
+}ZIGBEE_TxPower_Level_t;
 
 /******************************************************************************
 *   Private Functions Declaration
@@ -57,6 +74,14 @@ static void ieeeAddrResponseCallback(esp_zb_zdp_status_t zdo_status,
 
 static void updateNetworkState(ZIGBEE_Nwk_State_t state);
 
+static void txPowerApply(uint8_t level);
+static void txPowerReset(void);
+static uint8_t getParentLqi(void);
+static void txPowerUpdate(esp_err_t send_status);
+
+static esp_err_t zbActionHandler(esp_zb_core_action_callback_id_t callback_id, const void *message);
+static void zbSendStatusHandler(esp_zb_zcl_command_send_status_message_t message);
+
 static void tZigbeeTask(void *pvParameters);
 
 /******************************************************************************
@@ -71,10 +96,38 @@ static ZIGBEE_Nwk_State_t network_state = ZIGBEE_NWK_INVALID;
 static uint8_t network_steering_attempt = 0;
 static networkStateChangeCallback_t nwk_state_change_callback;
 static bool connected_at_boot = false;
+static bool radio_lock_held = false;//PWR_LOCK_ZIGBEE_RADIO held (commissioning)
 
 static TaskHandle_t zigbee_task_handle = NULL;
+static StaticTask_t zigbee_task_buffer;
+static StackType_t zigbee_task_stack[ZIGBEE_TASK_STACK_SIZE];
 static SemaphoreHandle_t zigbee_mutex_handle = NULL;
+static StaticSemaphore_t zigbee_mutex_buffer;
 static TimerHandle_t ieee_req_timer_handle = NULL;
+static StaticTimer_t ieee_req_timer_buffer;
+
+//TX power levels, from highest to lowest power
+static const ZIGBEE_TxPower_Level_t txp_level_table[] = {
+    {20, 330},
+    {16, 260},
+    {12, 210},
+    { 8, 170},
+    { 4, 140},
+    { 0, 120},
+    {-4, 110},
+};
+#define TXP_NB_LEVEL                                (sizeof(txp_level_table) / sizeof(txp_level_table[0]))
+
+static uint8_t txp_level = 0;
+static uint8_t txp_window_tx = 0;
+static uint8_t txp_window_fail = 0;
+static uint8_t txp_consecutive_fail = 0;
+static uint8_t txp_hold_windows = 0;
+static uint8_t txp_hold_backoff = 0;
+static uint8_t txp_healthy_windows = 0;
+static uint64_t txp_charge = 0;//Sum of TX current of every send
+static uint64_t txp_charge_max = 0;//Same at max power
+static ZIGBEE_TxPower_Stats_t txp_stats;
 
 static const char * TAG = "ZIGBEE";
 
@@ -257,6 +310,16 @@ static void updateNetworkState(ZIGBEE_Nwk_State_t state){
             nvs_commit(nvs_handle);
             nvs_close(nvs_handle);
 
+            //Keep the radio awake for the whole commissioning window
+            bool radio_window = (state == ZIGBEE_NWK_SCANNING);
+            if(radio_window && !radio_lock_held){
+                PWR_AcquireLock(PWR_LOCK_ZIGBEE_RADIO);
+            }
+            else if(!radio_window && radio_lock_held){
+                PWR_ReleaseLock(PWR_LOCK_ZIGBEE_RADIO);
+            }
+            radio_lock_held = radio_window;
+
             //Update global value
             network_state = state;
 
@@ -265,6 +328,247 @@ static void updateNetworkState(ZIGBEE_Nwk_State_t state){
     }
 }
 
+/***************************************************************************//*!
+*  \brief Apply TX power level.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \param[in]  level           Index in the TX power level table.
+*
+*******************************************************************************/
+static void txPowerApply(uint8_t level){
+
+    if(level >= TXP_NB_LEVEL){
+        return;
+    }
+
+    if(level != txp_level){
+        ESP_LOGI(TAG, "TX power: %d dBm", txp_level_table[level].tx_power_dbm);
+        txp_stats.nb_level_change++;
+    }
+
+    txp_level = level;
+    esp_zb_set_tx_power(txp_level_table[level].tx_power_dbm);
+
+    txp_window_tx = 0;
+    txp_window_fail = 0;
+    txp_consecutive_fail = 0;
+
+    txp_stats.tx_power_dbm = txp_level_table[level].tx_power_dbm;
+}
+
+/***************************************************************************//*!
+*  \brief Reset TX power control.
+*
+*   Restart from the highest TX power, used when (re)joining a parent.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void txPowerReset(void){
+
+    xSemaphoreTake(zigbee_mutex_handle, portMAX_DELAY);
+    txp_hold_windows = 0;
+    txp_hold_backoff = 0;
+    txp_healthy_windows = 0;
+    txPowerApply(0);
+    xSemaphoreGive(zigbee_mutex_handle);
+}
+
+/***************************************************************************//*!
+*  \brief Get parent LQI.
+*
+*   Preconditions: Called from Zigbee task context.
+*
+*   Side Effects: None.
+*
+*   \return     LQI of the parent (0 if not found)
+*
+*******************************************************************************/
+static uint8_t getParentLqi(void){
+
+    esp_zb_nwk_info_iterator_t iterator = ESP_ZB_NWK_INFO_ITERATOR_INIT;
+    esp_zb_nwk_neighbor_info_t neighbor;
+
+    while(ESP_OK == esp_zb_nwk_get_next_neighbor(&iterator, &neighbor)){
+        if(neighbor.relationship == ESP_ZB_NWK_RELATIONSHIP_PARENT){
+            return neighbor.lqi;
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************//*!
+*  \brief Update TX power control.
+*
+*   Step the TX power up as soon as sends fail or the parent LQI gets low,
+*   and step it down after a full window of acknowledged sends with a good
+*   parent LQI. Every step up caused by failures doubles the number of
+*   windows to wait before the next step down (hysteresis), and every
+*   TXP_BACKOFF_DECAY_WINDOWS windows without failure halve it again.
+*
+*   Preconditions: Called from Zigbee task context. Mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  send_status     APS send status.
+*
+*******************************************************************************/
+static void txPowerUpdate(esp_err_t send_status){
+
+    txp_stats.nb_tx++;
+    txp_charge += txp_level_table[txp_level].tx_current_ma;
+    txp_charge_max += txp_level_table[0].tx_current_ma;
+    txp_stats.energy_saved_pct = (uint8_t)(100 - ((txp_charge * 100) / txp_charge_max));
+
+    txp_window_tx++;
+
+    if(send_status != ESP_OK){
+        txp_stats.nb_tx_failed++;
+        txp_window_fail++;
+        txp_consecutive_fail++;
+
+        if((txp_consecutive_fail >= TXP_CONSECUTIVE_FAIL_MAX) && (txp_level > 0)){
+            //Last step down was too far -> wait longer before the next one
+            txp_hold_backoff = (txp_hold_backoff == 0) ? 1 : (txp_hold_backoff * 2);
+            if(txp_hold_backoff > TXP_HOLD_WINDOWS_MAX){
+                txp_hold_backoff = TXP_HOLD_WINDOWS_MAX;
+            }
+            txp_hold_windows = txp_hold_backoff;
+            txp_healthy_windows = 0;
+            txPowerApply(txp_level - 1);
+        }
+        return;
+    }
+
+    txp_consecutive_fail = 0;
+
+    if(txp_window_tx < TXP_WINDOW_SIZE){
+        return;
+    }
+
+    //End of evaluation window
+    uint8_t lqi = getParentLqi();
+    txp_stats.parent_lqi = lqi;
+
+    //A stable link slowly forgets the past failures
+    if((txp_window_fail == 0) && (lqi >= TXP_LQI_LOW)){
+        if(++txp_healthy_windows >= TXP_BACKOFF_DECAY_WINDOWS){
+            txp_healthy_windows = 0;
+            txp_hold_backoff /= 2;
+        }
+    }
+    else{
+        txp_healthy_windows = 0;
+    }
+
+    if((lqi < TXP_LQI_LOW) && (txp_level > 0)){
+        txPowerApply(txp_level - 1);
+    }
+    else if(txp_hold_windows > 0){
+        txp_hold_windows--;
+        txp_window_tx = 0;
+        txp_window_fail = 0;
+    }
+    else if((txp_window_fail == 0) && (lqi >= TXP_LQI_HIGH) && (txp_level < (TXP_NB_LEVEL - 1))){
+        txPowerApply(txp_level + 1);
+    }
+    else{
+        txp_window_tx = 0;
+        txp_window_fail = 0;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Zigbee core action handler.
+*
+*   Dispatch Zigbee core action callbacks to the cluster owning them.
+*   
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  callback_id         Core action callback ID.
+*   \param[in]  message             Pointer to callback message.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static esp_err_t zbActionHandler(esp_zb_core_action_callback_id_t callback_id, const void *message){
+
+    esp_err_t ret = ESP_OK;
+
+    switch(callback_id){
+
+        case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+        {
+            ret = OTA_ProcessUpgradeValue((const esp_zb_zcl_ota_upgrade_value_message_t *)message);
+        }
+        break;
+
+        case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID:
+        {
+            const esp_zb_zcl_cmd_read_attr_resp_message_t *pResp = message;
+            if(pResp->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_TIME){
+                ret = TIME_ProcessReadResp(pResp);
+            }
+        }
+        break;
+
+        case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        {
+            const esp_zb_zcl_custom_cluster_command_message_t *pCmd = message;
+            if(pCmd->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE){
+                ret = OTA_ProcessCommand(pCmd);
+            }
+            else if(pCmd->info.cluster == HISTORY_CLUSTER_ID){
+                ret = HISTORY_ProcessCommand(pCmd);
+            }
+        }
+        break;
+
+        case ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID:
+        {
+            //Routine response to the commands we send, nothing to do
+        }
+        break;
+
+        default:
+        {
+            ESP_LOGD(TAG, "Unhandled core action callback: 0x%x", callback_id);
+        }
+        break;
+    }
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Zigbee ZCL command send status handler.
+*
+*   Dispatch the APS delivery status of sent ZCL commands.
+*   
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  message             Send status message.
+*
+*******************************************************************************/
+static void zbSendStatusHandler(esp_zb_zcl_command_send_status_message_t message){
+
+    OTA_ProcessSendStatus(&message);
+
+    xSemaphoreTake(zigbee_mutex_handle, portMAX_DELAY);
+    txPowerUpdate(message.status);
+    xSemaphoreGive(zigbee_mutex_handle);
+}
+
 /**
  * @brief Zigbee stack application signal handler.
  * @anchor esp_zb_app_signal_handler
@@ -308,6 +612,11 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct){
                 esp_zb_scheduler_alarm((esp_zb_callback_t)sendIeeeAddrReqCallback, 
                                        0, 
                                        NWK_COORDO_DETECT_PERIOD_MS);
+
+                BOOT_TRACE_Mark(BOOT_TRACE_ZB_NWK_JOINED);
+                txPowerReset();
+                OTA_StartClient();
+                TIME_StartSync();
             }
             else{
 
@@ -335,6 +644,13 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct){
         }
         break;
 
+        case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
+        {
+            //Stack is idle until its next poll/event, enter light sleep
+            esp_zb_sleep_now();
+        }
+        break;
+
         case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:
         {
             if(connected_at_boot){
@@ -344,6 +660,16 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct){
                 esp_zb_scheduler_alarm((esp_zb_callback_t)sendIeeeAddrReqCallback, 
                                        0, 
                                        NWK_INITIAL_COORDO_DETECT_PERIOD_MS);
+
+                //Notify of rejoined network
+                if(nwk_state_change_callback != NULL){
+                    nwk_state_change_callback(network_state);
+                }
+
+                BOOT_TRACE_Mark(BOOT_TRACE_ZB_NWK_JOINED);
+                txPowerReset();
+                OTA_StartClient();
+                TIME_StartSync();
             }
         }
         break;
@@ -375,6 +701,7 @@ static void tZigbeeTask(void *pvParameters){
 
     //Start zigbee stack
     esp_zb_start(false);
+    BOOT_TRACE_Mark(BOOT_TRACE_ZB_STACK_START);
 
     for(;;){
         //Zigbee stack loop
@@ -392,31 +719,37 @@ static void tZigbeeTask(void *pvParameters){
 *   This function perform the zigbee stack initialization.
 *   If notification on network state change are desired, set param
 *   nwk_change_callback with a non-NULL value.   
+*   Endpoints and clusters are created from the endpoint descriptor table,
+*   only for the sensors detected at boot.
 *
-*   Preconditions: None.
+*   Preconditions: Sensors were probed (SENSOR_GetCapabilities()).
 *
 *   Side Effects: None.
 *
 *   \param[in]  nwk_change_callback     Network state change callback.
+*   \param[in]  sensor_caps             Detected sensor capabilities.
 *
 *   \return     Status of operation.   
 *
 *******************************************************************************/
-ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback){
+ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback, uint32_t sensor_caps){
+
+    BOOT_TRACE_Mark(BOOT_TRACE_ZB_INIT_START);
 
     //Create zigbee mutex
-    zigbee_mutex_handle = xSemaphoreCreateMutex();
+    zigbee_mutex_handle = xSemaphoreCreateMutexStatic(&zigbee_mutex_buffer);
     if(zigbee_mutex_handle == NULL){
         ESP_LOGI(TAG, "Failed to create zigbee mutex");
         return ZIGBEE_STATUS_ERROR;
     }
 
     //Create ieee request timer
-    ieee_req_timer_handle = xTimerCreate("IEEE_TIMER",
-                                         NWK_COORD_DETECT_TIMEOUT_MS/portTICK_PERIOD_MS,
-                                         pdFALSE,
-                                         NULL,
-                                         ieeeAddrResponseTimeout);
+    ieee_req_timer_handle = xTimerCreateStatic("IEEE_TIMER",
+                                               NWK_COORD_DETECT_TIMEOUT_MS/portTICK_PERIOD_MS,
+                                               pdFALSE,
+                                               NULL,
+                                               ieeeAddrResponseTimeout,
+                                               &ieee_req_timer_buffer);
     
     if(ieee_req_timer_handle == NULL){
         ESP_LOGI(TAG, "Failed to create ieee request timer");
@@ -489,65 +822,71 @@ ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback){
             .keep_alive = ZIGBEE_ED_KEEP_ALIVE_MS,
         },
     };
+    //Let the stack sleep between parent polls (sleepy end device)
+    esp_zb_sleep_enable(PWR_LIGHT_SLEEP_ENABLE);
     esp_zb_init(&zb_nwk_config);
 
-    //Create cluster list
-    esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
-    if(TEMP_CLUSTER_STATUS_OK != TEMP_InitCluster(cluster_list)){
-        ESP_LOGI(TAG, "Failed to init Temperature cluster");
-        return ZIGBEE_STATUS_ERROR;
-    }
+    //Create endpoints from the descriptor table, with the clusters supported by detected sensors
+    uint32_t created_clusters[ZB_EP_CFG_NB_ENDPOINT] = {0};
+    esp_zb_ep_list_t *ep_list = esp_zb_ep_list_create();
+    for(uint8_t i = 0; i < ZB_EP_CFG_NB_ENDPOINT; i++){
 
-    if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_InitCluster(cluster_list)){
-        ESP_LOGI(TAG, "Failed to init humidity cluster");
-        return ZIGBEE_STATUS_ERROR;
-    }
+        const ZB_EP_CFG_Endpoint_t *pEndpoint = ZB_EP_CFG_GetEndpoint(i);
+        esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
 
-    if(BASIC_CLUSTER_STATUS_OK != BASIC_IntiCluster(cluster_list)){
-        ESP_LOGI(TAG, "Failed to init Basic cluster");
-        return ZIGBEE_STATUS_ERROR;
-    }
+        for(uint8_t cluster_id = 0; cluster_id < ZB_EP_CFG_CLUSTER_NB; cluster_id++){
 
-    if(IDENTIFY_CLUSTER_STATUS_OK != IDENTIFY_InitCluster(cluster_list)){
-        ESP_LOGI(TAG, "Failed to init Identify cluster");
-        return ZIGBEE_STATUS_ERROR;
-    }
+            if(((pEndpoint->cluster_mask & ZB_EP_CFG_CLUSTER_BIT(cluster_id)) == 0) ||
+               (!ZB_EP_CFG_IsClusterSupported(cluster_id, sensor_caps))){
+                continue;
+            }
 
-    //Create device enpoint
-    esp_zb_ep_list_t *ep_list = esp_zb_ep_list_create();
-    esp_zb_endpoint_config_t endpoint_config = {
-        .endpoint = ZIGBEE_ENDPOINT_1,
-        .app_device_version = 0,
-        .app_device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-    };
-    if(ESP_OK != esp_zb_ep_list_add_ep(ep_list, cluster_list, endpoint_config)){
-        ESP_LOGI(TAG, "Failed to add endpoint");
-        return ZIGBEE_STATUS_ERROR;
+            if(ZB_EP_CFG_STATUS_OK != ZB_EP_CFG_InitCluster(cluster_id, pEndpoint->endpoint, cluster_list)){
+                ESP_LOGI(TAG, "Failed to init cluster %d on endpoint %d", cluster_id, pEndpoint->endpoint);
+                return ZIGBEE_STATUS_ERROR;
+            }
+            created_clusters[i] |= ZB_EP_CFG_CLUSTER_BIT(cluster_id);
+        }
+
+        //Create device enpoint
+        esp_zb_endpoint_config_t endpoint_config = {
+            .endpoint = pEndpoint->endpoint,
+            .app_device_version = 0,
+            .app_device_id = pEndpoint->device_id,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        };
+        if(ESP_OK != esp_zb_ep_list_add_ep(ep_list, cluster_list, endpoint_config)){
+            ESP_LOGI(TAG, "Failed to add endpoint");
+            return ZIGBEE_STATUS_ERROR;
+        }
     }
 
     if(ESP_OK != esp_zb_device_register(ep_list)){
         ESP_LOGI(TAG, "Failed to register device");
         return ZIGBEE_STATUS_ERROR;
     }
+    BOOT_TRACE_Mark(BOOT_TRACE_ZB_DEVICE_REGISTER);
 
-    //Config cluster attrib reporting
-    if(TEMP_CLUSTER_STATUS_OK != TEMP_SetupReporting()){
-        ESP_LOGI(TAG, "Failed to setup Temp cluster reporting");
-        return ZIGBEE_STATUS_ERROR;
-    }
+    //Config cluster attrib reporting and cmd handlers on each endpoint
+    for(uint8_t i = 0; i < ZB_EP_CFG_NB_ENDPOINT; i++){
 
-    if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetupReporting()){
-        ESP_LOGI(TAG, "Failed to setup Humidity cluster reporting");
-        return ZIGBEE_STATUS_ERROR;
-    }
+        const ZB_EP_CFG_Endpoint_t *pEndpoint = ZB_EP_CFG_GetEndpoint(i);
 
-    //Config Identify cluster cmd handler
-    if(IDENTIFY_CLUSTER_STATUS_OK != IDENTIFY_SetupCmdHandler()){
-        ESP_LOGI(TAG, "Failed to setup Identify cluster cmd handler");
-        return ZIGBEE_STATUS_ERROR;
+        for(uint8_t cluster_id = 0; cluster_id < ZB_EP_CFG_CLUSTER_NB; cluster_id++){
+
+            if((created_clusters[i] & ZB_EP_CFG_CLUSTER_BIT(cluster_id)) &&
+               (ZB_EP_CFG_STATUS_OK != ZB_EP_CFG_SetupCluster(cluster_id, pEndpoint->endpoint))){
+
+                ESP_LOGI(TAG, "Failed to setup cluster %d on endpoint %d", cluster_id, pEndpoint->endpoint);
+                return ZIGBEE_STATUS_ERROR;
+            }
+        }
     }
 
+    //Register core action handler (OTA upgrade, ...)
+    esp_zb_core_action_handler_register(zbActionHandler);
+    esp_zb_zcl_command_send_status_handler_register(zbSendStatusHandler);
+
     esp_zb_set_primary_network_channel_set(ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK);
 
     return ZIGBEE_STATUS_OK;
@@ -565,16 +904,19 @@ ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback){
 *******************************************************************************/
 void ZIGBEE_StartStack(void){
 
-    if(pdTRUE != xTaskCreate(tZigbeeTask,
-                             "Zigbee Task",
-                             4096,
-                             NULL,
-                             8,
-                             &zigbee_task_handle)){
+    zigbee_task_handle = xTaskCreateStatic(tZigbeeTask,
+                                           "Zigbee Task",
+                                           ZIGBEE_TASK_STACK_SIZE,
+                                           NULL,
+                                           8,
+                                           zigbee_task_stack,
+                                           &zigbee_task_buffer);
+    if(zigbee_task_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create Zigbee stask");
         while(1);//Stall here
     }
+    HEALTH_RegisterTask(HEALTH_TASK_ZIGBEE, zigbee_task_handle, ZIGBEE_TASK_STACK_SIZE);
 }
 
 /***************************************************************************//*!
@@ -666,7 +1008,62 @@ ZIGBEE_Nwk_State_t ZIGBEE_GetNwkState(void){
     return tmp_state;
 }
 
+/***************************************************************************//*!
+*  \brief Get TX power control statistics.
+*
+*   Return the TX power currently selected from the link quality, with the
+*   estimated radio TX energy saved compared to the max TX power.
+*
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats                  TX power statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZIGBEE_Ret_t ZIGBEE_GetTxPowerStats(ZIGBEE_TxPower_Stats_t *pStats){
+
+    if((pStats == NULL) || (zigbee_mutex_handle == NULL)){
+        return ZIGBEE_STATUS_ERROR;
+    }
+
+    xSemaphoreTake(zigbee_mutex_handle, portMAX_DELAY);
+    *pStats = txp_stats;
+    xSemaphoreGive(zigbee_mutex_handle);
+
+    return ZIGBEE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Dump TX power control statistics.
+*
+*   Print the selected TX power, the link statistics and the estimated TX
+*   energy saved on the console.
+*
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void ZIGBEE_DumpTxPowerStats(void){
+
+    ZIGBEE_TxPower_Stats_t stats;
+    if(ZIGBEE_STATUS_OK != ZIGBEE_GetTxPowerStats(&stats)){
+        return;
+    }
+
+    printf("TX power %d dBm, parent LQI %d, %" PRIu32 " level changes\n",
+           stats.tx_power_dbm,
+           stats.parent_lqi,
+           stats.nb_level_change);
+    printf("  %" PRIu32 " sends, %" PRIu32 " failed, %d%% TX energy saved\n",
+           stats.nb_tx,
+           stats.nb_tx_failed,
+           stats.energy_saved_pct);
+}
+
 /******************************************************************************
 *   Interrupts
 *******************************************************************************/
-
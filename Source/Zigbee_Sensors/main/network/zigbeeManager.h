@@ -11,10 +11,12 @@
 *******************************************************************************/
 #define ZIGBEE_DEVICE_TYPE              (ESP_ZB_DEVICE_TYPE_ED)
 #define ZIGBEE_ENDPOINT_1               (1)
+#define ZIGBEE_MANUFACTURER_CODE        (0x131B)
 #define ZIGBEE_INSTALLCODE_POLICY       (false)
 #define ZIGBEE_ED_AGING_TIMEOUT         (ESP_ZB_ED_AGING_TIMEOUT_64MIN)
 #define ZIGBEE_ED_KEEP_ALIVE_MS         (7 * 1000)
 #define ZIGBEE_PRIMARY_CHANNEL_MASK     (ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK)
+#define ZIGBEE_TXP_ZIGBEE_ATTR          (1)//Expose TX power stats in the Diagnostic cluster
 
 /******************************************************************************
 *   Public Macros
@@ -40,6 +42,15 @@ typedef enum ZIGBEE_Ret_e{
     ZIGBEE_STATUS_OK,
 }ZIGBEE_Ret_t;
 
+typedef struct ZIGBEE_TxPower_Stats_s{
+    int8_t tx_power_dbm;//Current TX power
+    uint8_t parent_lqi;//Last parent LQI
+    uint32_t nb_tx;//APS sends
+    uint32_t nb_tx_failed;//APS sends not acknowledged
+    uint32_t nb_level_change;
+    uint8_t energy_saved_pct;//Estimated TX energy saved vs max TX power
+}ZIGBEE_TxPower_Stats_t;
+
 typedef void(*networkStateChangeCallback_t)(ZIGBEE_Nwk_State_t nwk_state);
 
 /******************************************************************************
@@ -61,17 +72,20 @@ typedef void(*networkStateChangeCallback_t)(ZIGBEE_Nwk_State_t nwk_state);
 *   This function perform the zigbee stack initialization.
 *   If notification on network state change are desired, set param
 *   nwk_change_callback with a non-NULL value.   
+*   Endpoints and clusters are created from the endpoint descriptor table,
+*   only for the sensors detected at boot.
 *
-*   Preconditions: None.
+*   Preconditions: Sensors were probed (SENSOR_GetCapabilities()).
 *
 *   Side Effects: None.
 *
 *   \param[in]  nwk_change_callback     Network state change callback.
+*   \param[in]  sensor_caps             Detected sensor capabilities.
 *
 *   \return     Status of operation.   
 *
 *******************************************************************************/
-ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback);
+ZIGBEE_Ret_t ZIGBEE_InitStack(networkStateChangeCallback_t nwk_change_callback, uint32_t sensor_caps);
 
 /***************************************************************************//*!
 *  \brief Zigbee start stack
@@ -125,4 +139,34 @@ void ZIGBEE_LeaveNetwork(void);
 *******************************************************************************/
 ZIGBEE_Nwk_State_t ZIGBEE_GetNwkState(void);
 
+/***************************************************************************//*!
+*  \brief Get TX power control statistics.
+*
+*   Return the TX power currently selected from the link quality, with the
+*   estimated radio TX energy saved compared to the max TX power.
+*
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats                  TX power statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+ZIGBEE_Ret_t ZIGBEE_GetTxPowerStats(ZIGBEE_TxPower_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Dump TX power control statistics.
+*
+*   Print the selected TX power, the link statistics and the estimated TX
+*   energy saved on the console.
+*
+*   Preconditions: Zigbee stack is initialized.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void ZIGBEE_DumpTxPowerStats(void);
+
 #endif//_NETORK_MANAGER_H
\ No newline at end of file
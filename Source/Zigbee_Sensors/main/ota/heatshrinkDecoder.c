@@ -0,0 +1,304 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+
+#include "heatshrinkDecoder.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define HSD_WINDOW_MASK(pDec)               ((uint16_t)((1U << (pDec)->window_bits) - 1))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint8_t fillBits(HSD_Decoder_t *pDecoder,
+                        uint8_t nb_bits,
+                        uint8_t const *pIn,
+                        size_t in_size,
+                        size_t *pIn_index);
+static uint16_t takeBits(HSD_Decoder_t *pDecoder, uint8_t nb_bits);
+static void pushByte(HSD_Decoder_t *pDecoder, uint8_t value, uint8_t *pOut, size_t *pOut_index);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Fill bit buffer.
+*
+*   Load input bytes in the bit buffer until it holds at least nb_bits bits
+*   or the input is exhausted.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      pDecoder            Pointer to decoder instance.
+*   \param[in]      nb_bits             Number of bits needed (max 16).
+*   \param[in]      pIn                 Input bytes.
+*   \param[in]      in_size             Number of input bytes.
+*   \param[in,out]  pIn_index           Current input index.
+*
+*   \return     (1 -> enough bits available / 0 -> need more input)
+*
+*******************************************************************************/
+static uint8_t fillBits(HSD_Decoder_t *pDecoder,
+                        uint8_t nb_bits,
+                        uint8_t const *pIn,
+                        size_t in_size,
+                        size_t *pIn_index){
+
+    while((pDecoder->bit_count < nb_bits) && (*pIn_index < in_size)){
+        pDecoder->bit_buffer = (pDecoder->bit_buffer << 8) | pIn[*pIn_index];
+        pDecoder->bit_count += 8;
+        (*pIn_index)++;
+    }
+
+    return (pDecoder->bit_count >= nb_bits);
+}
+
+/***************************************************************************//*!
+*  \brief Take bits.
+*
+*   Extract nb_bits bits (MSB first) from the bit buffer.
+*
+*   Preconditions: Bit buffer holds at least nb_bits bits.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pDecoder            Pointer to decoder instance.
+*   \param[in]  nb_bits             Number of bits to take (max 16).
+*
+*   \return     Extracted value
+*
+*******************************************************************************/
+static uint16_t takeBits(HSD_Decoder_t *pDecoder, uint8_t nb_bits){
+
+    pDecoder->bit_count -= nb_bits;
+
+    return (uint16_t)((pDecoder->bit_buffer >> pDecoder->bit_count) & ((1UL << nb_bits) - 1));
+}
+
+/***************************************************************************//*!
+*  \brief Push output byte.
+*
+*   Write a decoded byte to the output and to the decoder window.
+*
+*   Preconditions: Output buffer has room for one byte.
+*
+*   Side Effects: None.
+*
+*   \param[in]      pDecoder            Pointer to decoder instance.
+*   \param[in]      value               Decoded byte.
+*   \param[out]     pOut                Output buffer.
+*   \param[in,out]  pOut_index          Current output index.
+*
+*******************************************************************************/
+static void pushByte(HSD_Decoder_t *pDecoder, uint8_t value, uint8_t *pOut, size_t *pOut_index){
+
+    pDecoder->window[pDecoder->head & HSD_WINDOW_MASK(pDecoder)] = value;
+    pDecoder->head++;
+
+    pOut[*pOut_index] = value;
+    (*pOut_index)++;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Heatshrink decoder initialization.
+*
+*   Reset a decoder instance for a new stream. The window and lookahead sizes
+*   must match the ones used to compress the stream. The decoder does not
+*   allocate any memory: all its state lives in the decoder structure.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pDecoder            Pointer to decoder instance.
+*   \param[in]  window_bits         Window size (log2).
+*   \param[in]  lookahead_bits      Lookahead size (log2).
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HSD_Ret_t HSD_Init(HSD_Decoder_t *pDecoder, uint8_t window_bits, uint8_t lookahead_bits){
+
+    if(pDecoder == NULL){
+        return HSD_STATUS_ERROR;
+    }
+
+    if((window_bits < HSD_WINDOW_BITS_MIN) || (window_bits > HSD_WINDOW_BITS_MAX)){
+        return HSD_STATUS_ERROR;
+    }
+
+    if((lookahead_bits < HSD_LOOKAHEAD_BITS_MIN) || (lookahead_bits >= window_bits)){
+        return HSD_STATUS_ERROR;
+    }
+
+    memset(pDecoder, 0, sizeof(HSD_Decoder_t));
+    pDecoder->window_bits = window_bits;
+    pDecoder->lookahead_bits = lookahead_bits;
+    pDecoder->state = HSD_STATE_TAG_BIT;
+
+    return HSD_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Decode a chunk of heatshrink stream.
+*
+*   Decode input bytes into the output buffer. Decoding stops when all the
+*   input was consumed or when the output buffer is full. The caller must
+*   flush the output and call the function again with the remaining input
+*   (in_size - *pIn_consumed) for as long as input remains or the output
+*   buffer comes back full.
+*
+*   Preconditions: Decoder is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pDecoder            Pointer to decoder instance.
+*   \param[in]  pIn                 Input (compressed) bytes.
+*   \param[in]  in_size             Number of input bytes.
+*   \param[out] pIn_consumed        Number of input bytes consumed.
+*   \param[out] pOut                Output (decompressed) buffer.
+*   \param[in]  out_size            Output buffer size.
+*   \param[out] pOut_produced       Number of bytes written to output.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HSD_Ret_t HSD_Decode(HSD_Decoder_t *pDecoder,
+                     uint8_t const *pIn,
+                     size_t in_size,
+                     size_t *pIn_consumed,
+                     uint8_t *pOut,
+                     size_t out_size,
+                     size_t *pOut_produced){
+
+    if((pDecoder == NULL) || (pIn_consumed == NULL) || (pOut == NULL) || (pOut_produced == NULL)){
+        return HSD_STATUS_ERROR;
+    }
+
+    if((pIn == NULL) && (in_size != 0)){
+        return HSD_STATUS_ERROR;
+    }
+
+    size_t in_index = 0;
+    size_t out_index = 0;
+    uint8_t suspend = 0;
+
+    while(!suspend){
+
+        switch(pDecoder->state){
+
+            case HSD_STATE_TAG_BIT:
+            {
+                if(!fillBits(pDecoder, 1, pIn, in_size, &in_index)){
+                    suspend = 1;
+                }
+                else{
+                    //Tag bit set -> literal / Tag bit clear -> back-reference
+                    pDecoder->state = (takeBits(pDecoder, 1) ? HSD_STATE_LITERAL : HSD_STATE_BACKREF_INDEX);
+                }
+            }
+            break;
+
+            case HSD_STATE_LITERAL:
+            {
+                if(out_index >= out_size){
+                    suspend = 1;
+                }
+                else if(!fillBits(pDecoder, 8, pIn, in_size, &in_index)){
+                    suspend = 1;
+                }
+                else{
+                    pushByte(pDecoder, (uint8_t)takeBits(pDecoder, 8), pOut, &out_index);
+                    pDecoder->state = HSD_STATE_TAG_BIT;
+                }
+            }
+            break;
+
+            case HSD_STATE_BACKREF_INDEX:
+            {
+                if(!fillBits(pDecoder, pDecoder->window_bits, pIn, in_size, &in_index)){
+                    suspend = 1;
+                }
+                else{
+                    pDecoder->backref_index = takeBits(pDecoder, pDecoder->window_bits) + 1;
+                    pDecoder->state = HSD_STATE_BACKREF_COUNT;
+                }
+            }
+            break;
+
+            case HSD_STATE_BACKREF_COUNT:
+            {
+                if(!fillBits(pDecoder, pDecoder->lookahead_bits, pIn, in_size, &in_index)){
+                    suspend = 1;
+                }
+                else{
+                    pDecoder->backref_count = takeBits(pDecoder, pDecoder->lookahead_bits) + 1;
+                    pDecoder->state = HSD_STATE_BACKREF_YIELD;
+                }
+            }
+            break;
+
+            case HSD_STATE_BACKREF_YIELD:
+            {
+                while((pDecoder->backref_count > 0) && (out_index < out_size)){
+                    uint16_t src = (uint16_t)(pDecoder->head - pDecoder->backref_index);
+                    pushByte(pDecoder, pDecoder->window[src & HSD_WINDOW_MASK(pDecoder)], pOut, &out_index);
+                    pDecoder->backref_count--;
+                }
+
+                if(pDecoder->backref_count == 0){
+                    pDecoder->state = HSD_STATE_TAG_BIT;
+                }
+                else{
+                    //Output full
+                    suspend = 1;
+                }
+            }
+            break;
+
+            case HSD_STATE_INVALID:
+            default:
+            {
+                return HSD_STATUS_ERROR;
+            }
+            break;
+        }
+    }
+
+    *pIn_consumed = in_index;
+    *pOut_produced = out_index;
+
+    return HSD_STATUS_OK;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
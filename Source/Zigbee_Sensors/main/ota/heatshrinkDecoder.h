@@ -0,0 +1,114 @@
+#ifndef _HEATSHRINK_DECODER_H
+#define _HEATSHRINK_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define HSD_WINDOW_BITS_MIN                 (4)
+#define HSD_WINDOW_BITS_MAX                 (11)
+#define HSD_LOOKAHEAD_BITS_MIN              (3)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum HSD_State_e{
+    HSD_STATE_TAG_BIT,
+    HSD_STATE_LITERAL,
+    HSD_STATE_BACKREF_INDEX,
+    HSD_STATE_BACKREF_COUNT,
+    HSD_STATE_BACKREF_YIELD,
+
+    HSD_STATE_INVALID,
+}HSD_State_t;
+
+typedef struct HSD_Decoder_s{
+    uint8_t window[1 << HSD_WINDOW_BITS_MAX];
+    uint32_t bit_buffer;
+    uint16_t head;
+    uint16_t backref_index;
+    uint16_t backref_count;
+    uint8_t bit_count;
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint8_t state;
+}HSD_Decoder_t;
+
+typedef enum HSD_Ret_e{
+    HSD_STATUS_ERROR,
+    HSD_STATUS_OK,
+}HSD_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Heatshrink decoder initialization.
+*
+*   Reset a decoder instance for a new stream. The window and lookahead sizes
+*   must match the ones used to compress the stream. The decoder does not
+*   allocate any memory: all its state lives in the decoder structure.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pDecoder            Pointer to decoder instance.
+*   \param[in]  window_bits         Window size (log2).
+*   \param[in]  lookahead_bits      Lookahead size (log2).
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HSD_Ret_t HSD_Init(HSD_Decoder_t *pDecoder, uint8_t window_bits, uint8_t lookahead_bits);
+
+/***************************************************************************//*!
+*  \brief Decode a chunk of heatshrink stream.
+*
+*   Decode input bytes into the output buffer. Decoding stops when all the
+*   input was consumed or when the output buffer is full. The caller must
+*   flush the output and call the function again with the remaining input
+*   (in_size - *pIn_consumed) for as long as input remains or the output
+*   buffer comes back full.
+*
+*   Preconditions: Decoder is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pDecoder            Pointer to decoder instance.
+*   \param[in]  pIn                 Input (compressed) bytes.
+*   \param[in]  in_size             Number of input bytes.
+*   \param[out] pIn_consumed        Number of input bytes consumed.
+*   \param[out] pOut                Output (decompressed) buffer.
+*   \param[in]  out_size            Output buffer size.
+*   \param[out] pOut_produced       Number of bytes written to output.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HSD_Ret_t HSD_Decode(HSD_Decoder_t *pDecoder,
+                     uint8_t const *pIn,
+                     size_t in_size,
+                     size_t *pIn_consumed,
+                     uint8_t *pOut,
+                     size_t out_size,
+                     size_t *pOut_produced);
+
+#endif//_HEATSHRINK_DECODER_H
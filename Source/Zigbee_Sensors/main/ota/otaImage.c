@@ -0,0 +1,760 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+
+#include "otaImage.h"
+#include "heatshrinkDecoder.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define OTA_ELEMENT_HEADER_SIZE             (6)//Tag ID (2 bytes) + Length (4 bytes)
+#define OTA_COMPRESSED_HEADER_SIZE          (6)//Window bits + Lookahead bits + Image size (4 bytes)
+#define OTA_WRITE_BUFFER_SIZE               (512)
+#define OTA_FLASH_SECTOR_SIZE               (4096)//Flash erase unit
+#define OTA_FLASH_ERASED                    (0xFF)
+
+#define LOG_LOCAL_LEVEL                     (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define GET_U16_LE(p)                       ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET_U32_LE(p)                       ((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef enum OTA_Element_State_e{
+    OTA_ELEMENT_STATE_HEADER,
+    OTA_ELEMENT_STATE_RAW,
+    OTA_ELEMENT_STATE_COMPRESSED_HEADER,
+    OTA_ELEMENT_STATE_COMPRESSED,
+    OTA_ELEMENT_STATE_SKIP,
+
+    OTA_ELEMENT_STATE_INVALID,
+}OTA_Element_State_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static OTA_IMAGE_Ret_t writeOutput(uint8_t const *pData, size_t size);
+static OTA_IMAGE_Ret_t flushOutput(void);
+static OTA_IMAGE_Ret_t decompressData(uint8_t const *pData, size_t size);
+static void parseElementHeader(void);
+static OTA_IMAGE_Ret_t parseCompressedHeader(void);
+static OTA_IMAGE_Ret_t copyFlash(uint32_t src_offset, uint32_t dst_offset, uint32_t size);
+static OTA_IMAGE_Ret_t restorePartialSector(uint32_t image_offset);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const esp_partition_t *pUpdate_partition = NULL;
+static esp_ota_handle_t ota_handle = 0;
+static bool ota_in_progress = false;
+static bool ota_image_found = false;
+
+static OTA_Element_State_t element_state = OTA_ELEMENT_STATE_INVALID;
+static uint8_t header_buffer[OTA_ELEMENT_HEADER_SIZE];
+static uint8_t header_len = 0;
+static uint32_t element_remaining = 0;
+static uint32_t expected_image_size = 0;
+static uint32_t image_size = 0;
+
+static HSD_Decoder_t decoder;
+static uint8_t write_buffer[OTA_WRITE_BUFFER_SIZE];
+static size_t write_len = 0;
+
+static const char * TAG = "OTA_IMAGE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Write output data.
+*
+*   Copy image data in the write buffer. The buffer is written to flash
+*   each time it is full.
+*
+*   Preconditions: OTA partition is open.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Image data.
+*   \param[in]  size                Image data size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t writeOutput(uint8_t const *pData, size_t size){
+
+    while(size > 0){
+        size_t len = OTA_WRITE_BUFFER_SIZE - write_len;
+        if(len > size){
+            len = size;
+        }
+
+        memcpy(&write_buffer[write_len], pData, len);
+        write_len += len;
+        image_size += len;
+        pData += len;
+        size -= len;
+
+        if(write_len == OTA_WRITE_BUFFER_SIZE){
+            if(OTA_IMAGE_STATUS_OK != flushOutput()){
+                return OTA_IMAGE_STATUS_ERROR;
+            }
+        }
+    }
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Flush output data.
+*
+*   Write the content of the write buffer to the OTA partition.
+*
+*   Preconditions: OTA partition is open.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t flushOutput(void){
+
+    if(write_len == 0){
+        return OTA_IMAGE_STATUS_OK;
+    }
+
+    esp_err_t ret = esp_ota_write(ota_handle, write_buffer, write_len);
+    if(ret != ESP_OK){
+        ESP_LOGI(TAG, "Failed to write OTA data (%s)", esp_err_to_name(ret));
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    write_len = 0;
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Decompress image data.
+*
+*   Run the heatshrink decoder on compressed element data. Decoded bytes
+*   are produced directly in the write buffer.
+*
+*   Preconditions: Decoder is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Compressed data.
+*   \param[in]  size                Compressed data size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t decompressData(uint8_t const *pData, size_t size){
+
+    bool output_full = false;
+
+    do{
+        size_t consumed = 0;
+        size_t produced = 0;
+
+        if(HSD_STATUS_OK != HSD_Decode(&decoder,
+                                       pData,
+                                       size,
+                                       &consumed,
+                                       &write_buffer[write_len],
+                                       OTA_WRITE_BUFFER_SIZE - write_len,
+                                       &produced)){
+
+            ESP_LOGI(TAG, "Failed to decompress OTA data");
+            return OTA_IMAGE_STATUS_ERROR;
+        }
+
+        pData += consumed;
+        size -= consumed;
+        write_len += produced;
+        image_size += produced;
+
+        //Decoder may still hold back-reference bytes when the output is full
+        output_full = (write_len == OTA_WRITE_BUFFER_SIZE);
+        if(output_full){
+            if(OTA_IMAGE_STATUS_OK != flushOutput()){
+                return OTA_IMAGE_STATUS_ERROR;
+            }
+        }
+    }while((size > 0) || output_full);
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Parse sub-element header.
+*
+*   Parse the sub-element header stored in the header buffer and select
+*   how the element data must be processed.
+*
+*   Preconditions: Header buffer holds a complete sub-element header.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void parseElementHeader(void){
+
+    uint16_t tag_id = GET_U16_LE(&header_buffer[0]);
+    element_remaining = GET_U32_LE(&header_buffer[2]);
+    header_len = 0;
+
+    ESP_LOGI(TAG, "Sub-element tag: 0x%04x, length: %lu", tag_id, (unsigned long)element_remaining);
+
+    if(tag_id == OTA_IMAGE_TAG_UPGRADE_IMAGE){
+        ota_image_found = true;
+        expected_image_size = element_remaining;
+        element_state = OTA_ELEMENT_STATE_RAW;
+    }
+    else if(tag_id == OTA_IMAGE_TAG_COMPRESSED_IMAGE){
+        ota_image_found = true;
+        element_state = OTA_ELEMENT_STATE_COMPRESSED_HEADER;
+    }
+    else{
+        //Unsupported element (signature, certificate, ...)
+        element_state = OTA_ELEMENT_STATE_SKIP;
+    }
+
+    if(element_remaining == 0){
+        element_state = OTA_ELEMENT_STATE_HEADER;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Parse compressed element header.
+*
+*   Parse the compressed element header stored in the header buffer and
+*   initialize the decoder with the stream parameters.
+*
+*   Preconditions: Header buffer holds a complete compressed header.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t parseCompressedHeader(void){
+
+    uint8_t window_bits = header_buffer[0];
+    uint8_t lookahead_bits = header_buffer[1];
+    expected_image_size = GET_U32_LE(&header_buffer[2]);
+    header_len = 0;
+
+    ESP_LOGI(TAG, "Compressed image W: %d, L: %d, size: %lu",
+                  window_bits,
+                  lookahead_bits,
+                  (unsigned long)expected_image_size);
+
+    if(HSD_STATUS_OK != HSD_Init(&decoder, window_bits, lookahead_bits)){
+        ESP_LOGI(TAG, "Unsupported compression parameters");
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    element_state = OTA_ELEMENT_STATE_COMPRESSED;
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Copy flash data.
+*
+*   Copy data between two offsets of the OTA partition, through the write
+*   buffer.
+*
+*   Preconditions: Destination is erased, write buffer is empty.
+*
+*   Side Effects: None.
+*
+*   \param[in]  src_offset          Source partition offset.
+*   \param[in]  dst_offset          Destination partition offset.
+*   \param[in]  size                Data size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t copyFlash(uint32_t src_offset, uint32_t dst_offset, uint32_t size){
+
+    while(size > 0){
+        uint32_t len = (size > OTA_WRITE_BUFFER_SIZE) ? OTA_WRITE_BUFFER_SIZE : size;
+
+        if((ESP_OK != esp_partition_read(pUpdate_partition, src_offset, write_buffer, len)) ||
+           (ESP_OK != esp_partition_write(pUpdate_partition, dst_offset, write_buffer, len))){
+
+            ESP_LOGI(TAG, "Failed to copy OTA data");
+            return OTA_IMAGE_STATUS_ERROR;
+        }
+
+        src_offset += len;
+        dst_offset += len;
+        size -= len;
+    }
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Restore partial sector.
+*
+*   Sequential OTA writes only erase a sector when they enter it, so the end
+*   of the sector holding the resume offset is not erased again. Data written
+*   there after the checkpoint (before the reboot) can't be programmed over:
+*   the kept start of the sector is moved to the next sector, the sector is
+*   erased and the kept data is copied back.
+*
+*   Preconditions: OTA partition is selected, write buffer is empty.
+*
+*   Side Effects: None.
+*
+*   \param[in]  image_offset        Resume offset.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static OTA_IMAGE_Ret_t restorePartialSector(uint32_t image_offset){
+
+    uint32_t sector_offset = image_offset - (image_offset % OTA_FLASH_SECTOR_SIZE);
+    uint32_t next_sector_offset = sector_offset + OTA_FLASH_SECTOR_SIZE;
+    uint32_t kept_size = image_offset - sector_offset;
+    bool erased = true;
+
+    //Next sector is erased by the first write entering it
+    if(kept_size == 0){
+        return OTA_IMAGE_STATUS_OK;
+    }
+
+    if((next_sector_offset + OTA_FLASH_SECTOR_SIZE) > pUpdate_partition->size){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    //Nothing written after the checkpoint, the sector can be resumed as is
+    for(uint32_t offset=image_offset; erased && (offset < next_sector_offset); offset += OTA_WRITE_BUFFER_SIZE){
+
+        uint32_t len = next_sector_offset - offset;
+        if(len > OTA_WRITE_BUFFER_SIZE){
+            len = OTA_WRITE_BUFFER_SIZE;
+        }
+
+        if(ESP_OK != esp_partition_read(pUpdate_partition, offset, write_buffer, len)){
+            ESP_LOGI(TAG, "Failed to read OTA data");
+            return OTA_IMAGE_STATUS_ERROR;
+        }
+
+        for(uint32_t i=0; i<len; i++){
+            if(write_buffer[i] != OTA_FLASH_ERASED){
+                erased = false;
+                break;
+            }
+        }
+    }
+
+    if(erased){
+        return OTA_IMAGE_STATUS_OK;
+    }
+
+    ESP_LOGI(TAG, "Restoring partial sector at 0x%lx", (unsigned long)sector_offset);
+
+    if((ESP_OK != esp_partition_erase_range(pUpdate_partition, next_sector_offset, OTA_FLASH_SECTOR_SIZE)) ||
+       (OTA_IMAGE_STATUS_OK != copyFlash(sector_offset, next_sector_offset, kept_size)) ||
+       (ESP_OK != esp_partition_erase_range(pUpdate_partition, sector_offset, OTA_FLASH_SECTOR_SIZE)) ||
+       (OTA_IMAGE_STATUS_OK != copyFlash(next_sector_offset, sector_offset, kept_size))){
+
+        ESP_LOGI(TAG, "Failed to restore partial sector");
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Begin OTA image download.
+*
+*   Select the next OTA partition and open it for sequential writes. Any
+*   previous unfinished download is aborted.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Begin(void){
+
+    OTA_IMAGE_Abort();
+
+    pUpdate_partition = esp_ota_get_next_update_partition(NULL);
+    if(pUpdate_partition == NULL){
+        ESP_LOGI(TAG, "No OTA partition available");
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    esp_err_t ret = esp_ota_begin(pUpdate_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
+    if(ret != ESP_OK){
+        ESP_LOGI(TAG, "Failed to begin OTA (%s)", esp_err_to_name(ret));
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    ESP_LOGI(TAG, "Writing to partition %s at 0x%lx",
+                  pUpdate_partition->label,
+                  (unsigned long)pUpdate_partition->address);
+
+    ota_in_progress = true;
+    ota_image_found = false;
+    element_state = OTA_ELEMENT_STATE_HEADER;
+    header_len = 0;
+    element_remaining = 0;
+    expected_image_size = 0;
+    image_size = 0;
+    write_len = 0;
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Write OTA image block.
+*
+*   Feed a block of the Zigbee OTA image payload (sub-elements following the
+*   OTA file header). Sub-element headers may be split across blocks. Raw
+*   image elements are written as is, compressed image elements are
+*   decompressed on the fly and unknown elements are skipped.
+*
+*   Preconditions: OTA_IMAGE_Begin() was called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Block data.
+*   \param[in]  size                Block size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Write(uint8_t const *pData, size_t size){
+
+    if(!ota_in_progress){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    if((pData == NULL) && (size != 0)){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    while(size > 0){
+
+        size_t len = size;
+
+        switch(element_state){
+
+            case OTA_ELEMENT_STATE_HEADER:
+            {
+                if(len > (size_t)(OTA_ELEMENT_HEADER_SIZE - header_len)){
+                    len = OTA_ELEMENT_HEADER_SIZE - header_len;
+                }
+                memcpy(&header_buffer[header_len], pData, len);
+                header_len += len;
+
+                if(header_len == OTA_ELEMENT_HEADER_SIZE){
+                    parseElementHeader();
+                }
+            }
+            break;
+
+            case OTA_ELEMENT_STATE_COMPRESSED_HEADER:
+            {
+                if(len > (size_t)(OTA_COMPRESSED_HEADER_SIZE - header_len)){
+                    len = OTA_COMPRESSED_HEADER_SIZE - header_len;
+                }
+                if(len > element_remaining){
+                    ESP_LOGI(TAG, "Truncated compressed element");
+                    return OTA_IMAGE_STATUS_ERROR;
+                }
+                memcpy(&header_buffer[header_len], pData, len);
+                header_len += len;
+                element_remaining -= len;
+
+                if(header_len == OTA_COMPRESSED_HEADER_SIZE){
+                    if(OTA_IMAGE_STATUS_OK != parseCompressedHeader()){
+                        return OTA_IMAGE_STATUS_ERROR;
+                    }
+                }
+            }
+            break;
+
+            case OTA_ELEMENT_STATE_RAW:
+            case OTA_ELEMENT_STATE_COMPRESSED:
+            case OTA_ELEMENT_STATE_SKIP:
+            {
+                if(len > element_remaining){
+                    len = element_remaining;
+                }
+
+                OTA_IMAGE_Ret_t ret = OTA_IMAGE_STATUS_OK;
+                if(element_state == OTA_ELEMENT_STATE_RAW){
+                    ret = writeOutput(pData, len);
+                }
+                else if(element_state == OTA_ELEMENT_STATE_COMPRESSED){
+                    ret = decompressData(pData, len);
+                }
+
+                if(ret != OTA_IMAGE_STATUS_OK){
+                    return OTA_IMAGE_STATUS_ERROR;
+                }
+
+                element_remaining -= len;
+            }
+            break;
+
+            case OTA_ELEMENT_STATE_INVALID:
+            default:
+            {
+                return OTA_IMAGE_STATUS_ERROR;
+            }
+            break;
+        }
+
+        //Element completed -> wait for next sub-element header
+        if((element_state != OTA_ELEMENT_STATE_HEADER) && (element_remaining == 0)){
+            element_state = OTA_ELEMENT_STATE_HEADER;
+        }
+
+        pData += len;
+        size -= len;
+    }
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Resume OTA image download.
+*
+*   Re-open the next OTA partition at the offset saved in a checkpoint and
+*   restore the sub-element parser and decoder state. Data already written
+*   up to the checkpoint is kept, data written after it is erased.
+*
+*   Preconditions: Checkpoint was taken on the same OTA partition.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pCheckpoint         Checkpoint to resume from.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Resume(const OTA_IMAGE_Checkpoint_t *pCheckpoint){
+
+    if(pCheckpoint == NULL){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    if((pCheckpoint->element_state >= OTA_ELEMENT_STATE_INVALID) ||
+       (pCheckpoint->header_len > sizeof(header_buffer))){
+
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    OTA_IMAGE_Abort();
+
+    pUpdate_partition = esp_ota_get_next_update_partition(NULL);
+    if(pUpdate_partition == NULL){
+        ESP_LOGI(TAG, "No OTA partition available");
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    //Write buffer is empty (aborted), used to move the partial sector data
+    if(OTA_IMAGE_STATUS_OK != restorePartialSector(pCheckpoint->image_offset)){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    esp_err_t ret = esp_ota_resume(pUpdate_partition,
+                                   OTA_WITH_SEQUENTIAL_WRITES,
+                                   pCheckpoint->image_offset,
+                                   &ota_handle);
+    if(ret != ESP_OK){
+        ESP_LOGI(TAG, "Failed to resume OTA (%s)", esp_err_to_name(ret));
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    ESP_LOGI(TAG, "Resuming partition %s at offset %lu",
+                  pUpdate_partition->label,
+                  (unsigned long)pCheckpoint->image_offset);
+
+    ota_in_progress = true;
+    ota_image_found = pCheckpoint->image_found;
+    element_state = (OTA_Element_State_t)pCheckpoint->element_state;
+    header_len = pCheckpoint->header_len;
+    memcpy(header_buffer, pCheckpoint->header_buffer, sizeof(header_buffer));
+    element_remaining = pCheckpoint->element_remaining;
+    expected_image_size = pCheckpoint->expected_image_size;
+    image_size = pCheckpoint->image_offset;
+    memcpy(&decoder, &pCheckpoint->decoder, sizeof(HSD_Decoder_t));
+    write_len = 0;
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Get OTA image checkpoint.
+*
+*   Flush pending data to flash and capture the parser and decoder state.
+*   After a reboot, the download can be resumed from the checkpoint by
+*   feeding the data that follows the last byte passed to OTA_IMAGE_Write().
+*
+*   Preconditions: OTA_IMAGE_Begin() or OTA_IMAGE_Resume() was called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pCheckpoint         Checkpoint.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_GetCheckpoint(OTA_IMAGE_Checkpoint_t *pCheckpoint){
+
+    if((!ota_in_progress) || (pCheckpoint == NULL)){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    //Flash content must match the captured state
+    if(OTA_IMAGE_STATUS_OK != flushOutput()){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    pCheckpoint->image_offset = image_size;
+    pCheckpoint->element_remaining = element_remaining;
+    pCheckpoint->expected_image_size = expected_image_size;
+    pCheckpoint->element_state = element_state;
+    pCheckpoint->header_len = header_len;
+    memcpy(pCheckpoint->header_buffer, header_buffer, sizeof(header_buffer));
+    pCheckpoint->image_found = ota_image_found;
+    memcpy(&pCheckpoint->decoder, &decoder, sizeof(HSD_Decoder_t));
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief End OTA image download.
+*
+*   Flush pending data and validate the written application image.
+*
+*   Preconditions: OTA_IMAGE_Begin() was called.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_End(void){
+
+    if(!ota_in_progress){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    if((element_state != OTA_ELEMENT_STATE_HEADER) || (header_len != 0)){
+        ESP_LOGI(TAG, "OTA image is truncated");
+        OTA_IMAGE_Abort();
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    if((!ota_image_found) || (image_size != expected_image_size)){
+        ESP_LOGI(TAG, "Invalid image size (%lu / %lu)",
+                      (unsigned long)image_size,
+                      (unsigned long)expected_image_size);
+        OTA_IMAGE_Abort();
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    if(OTA_IMAGE_STATUS_OK != flushOutput()){
+        OTA_IMAGE_Abort();
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    ota_in_progress = false;
+
+    //Validate image
+    esp_err_t ret = esp_ota_end(ota_handle);
+    if(ret != ESP_OK){
+        ESP_LOGI(TAG, "Failed to validate OTA image (%s)", esp_err_to_name(ret));
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    ESP_LOGI(TAG, "OTA image validated (%lu bytes)", (unsigned long)image_size);
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Apply OTA image.
+*
+*   Set the downloaded partition as the boot partition. The new image runs
+*   after the next reboot.
+*
+*   Preconditions: OTA_IMAGE_End() returned OTA_IMAGE_STATUS_OK.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Apply(void){
+
+    if(pUpdate_partition == NULL){
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    esp_err_t ret = esp_ota_set_boot_partition(pUpdate_partition);
+    if(ret != ESP_OK){
+        ESP_LOGI(TAG, "Failed to set boot partition (%s)", esp_err_to_name(ret));
+        return OTA_IMAGE_STATUS_ERROR;
+    }
+
+    return OTA_IMAGE_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Abort OTA image download.
+*
+*   Release the OTA partition handle and discard the written data.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_IMAGE_Abort(void){
+
+    if(ota_in_progress){
+        ESP_LOGI(TAG, "Abort OTA");
+        esp_ota_abort(ota_handle);
+    }
+
+    ota_in_progress = false;
+    element_state = OTA_ELEMENT_STATE_INVALID;
+    write_len = 0;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
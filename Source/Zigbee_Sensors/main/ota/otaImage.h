@@ -0,0 +1,165 @@
+#ifndef _OTA_IMAGE_H
+#define _OTA_IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "heatshrinkDecoder.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define OTA_IMAGE_TAG_UPGRADE_IMAGE         (0x0000)//Raw ESP-IDF application image
+#define OTA_IMAGE_TAG_COMPRESSED_IMAGE      (0xF000)//Heatshrink compressed application image
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct OTA_IMAGE_Checkpoint_s{
+    uint32_t image_offset;
+    uint32_t element_remaining;
+    uint32_t expected_image_size;
+    uint8_t element_state;
+    uint8_t header_len;
+    uint8_t header_buffer[6];
+    bool image_found;
+    HSD_Decoder_t decoder;
+}OTA_IMAGE_Checkpoint_t;
+
+typedef enum OTA_IMAGE_Ret_e{
+    OTA_IMAGE_STATUS_ERROR,
+    OTA_IMAGE_STATUS_OK,
+}OTA_IMAGE_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Begin OTA image download.
+*
+*   Select the next OTA partition and open it for sequential writes. Any
+*   previous unfinished download is aborted.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Begin(void);
+
+/***************************************************************************//*!
+*  \brief Write OTA image block.
+*
+*   Feed a block of the Zigbee OTA image payload (sub-elements following the
+*   OTA file header). Sub-element headers may be split across blocks. Raw
+*   image elements are written as is, compressed image elements are
+*   decompressed on the fly and unknown elements are skipped.
+*
+*   Preconditions: OTA_IMAGE_Begin() was called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Block data.
+*   \param[in]  size                Block size.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Write(uint8_t const *pData, size_t size);
+
+/***************************************************************************//*!
+*  \brief Resume OTA image download.
+*
+*   Re-open the next OTA partition at the offset saved in a checkpoint and
+*   restore the sub-element parser and decoder state. Data already written
+*   up to the checkpoint is kept, data written after it is erased.
+*
+*   Preconditions: Checkpoint was taken on the same OTA partition.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pCheckpoint         Checkpoint to resume from.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Resume(const OTA_IMAGE_Checkpoint_t *pCheckpoint);
+
+/***************************************************************************//*!
+*  \brief Get OTA image checkpoint.
+*
+*   Flush pending data to flash and capture the parser and decoder state.
+*   After a reboot, the download can be resumed from the checkpoint by
+*   feeding the data that follows the last byte passed to OTA_IMAGE_Write().
+*
+*   Preconditions: OTA_IMAGE_Begin() or OTA_IMAGE_Resume() was called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pCheckpoint         Checkpoint.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_GetCheckpoint(OTA_IMAGE_Checkpoint_t *pCheckpoint);
+
+/***************************************************************************//*!
+*  \brief End OTA image download.
+*
+*   Flush pending data and validate the written application image.
+*
+*   Preconditions: OTA_IMAGE_Begin() was called.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_End(void);
+
+/***************************************************************************//*!
+*  \brief Apply OTA image.
+*
+*   Set the downloaded partition as the boot partition. The new image runs
+*   after the next reboot.
+*
+*   Preconditions: OTA_IMAGE_End() returned OTA_IMAGE_STATUS_OK.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+OTA_IMAGE_Ret_t OTA_IMAGE_Apply(void);
+
+/***************************************************************************//*!
+*  \brief Abort OTA image download.
+*
+*   Release the OTA partition handle and discard the written data.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void OTA_IMAGE_Abort(void);
+
+#endif//_OTA_IMAGE_H
@@ -0,0 +1,268 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "powerManager.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct PWR_Lock_Cfg_s{
+    const char *name;
+    esp_pm_lock_type_t type;
+}PWR_Lock_Cfg_t;
+
+typedef struct PWR_Lock_Info_s{
+    esp_pm_lock_handle_t handle;        //NULL when power management is disabled
+    uint32_t nb_holder;
+    uint32_t nb_acquire;
+    int64_t acquire_time_us;
+    uint64_t held_time_us;              //Completed holds only
+}PWR_Lock_Info_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+//LEDC and I2C run from XTAL, which is gated in light sleep: frequency can scale
+static const PWR_Lock_Cfg_t lock_cfg_table[PWR_LOCK_NB] = {
+    [PWR_LOCK_SENSOR_I2C]   = {.name = "sensor_i2c",    .type = ESP_PM_NO_LIGHT_SLEEP},
+    [PWR_LOCK_LED_PWM]      = {.name = "led_pwm",       .type = ESP_PM_NO_LIGHT_SLEEP},
+    [PWR_LOCK_ZIGBEE_RADIO] = {.name = "zigbee_radio",  .type = ESP_PM_NO_LIGHT_SLEEP},
+};
+
+static PWR_Lock_Info_t lock_info_table[PWR_LOCK_NB];
+static portMUX_TYPE lock_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char * TAG = "PWR";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Power manager initialization.
+*
+*   This function enables dynamic frequency scaling and automatic light
+*   sleep, and creates the power management lock of every module.
+*
+*   Preconditions: Called first in app_main, before any lock is used.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_Init(void){
+
+    ESP_LOGI(TAG, "Initialization");
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = PWR_MAX_CPU_FREQ_MHZ,
+        .min_freq_mhz = PWR_MIN_CPU_FREQ_MHZ,
+        .light_sleep_enable = PWR_LIGHT_SLEEP_ENABLE,
+    };
+    if(ESP_OK != esp_pm_configure(&pm_config)){
+        ESP_LOGI(TAG, "Failed to configure power management");
+        return PWR_STATUS_ERROR;
+    }
+
+    for(uint8_t i = 0; i < PWR_LOCK_NB; i++){
+        if(ESP_OK != esp_pm_lock_create(lock_cfg_table[i].type, 
+                                        0, 
+                                        lock_cfg_table[i].name, 
+                                        &lock_info_table[i].handle)){
+
+            ESP_LOGI(TAG, "Failed to create %s lock", lock_cfg_table[i].name);
+            return PWR_STATUS_ERROR;
+        }
+    }
+#else
+    //Locks only keep statistics
+    ESP_LOGI(TAG, "Power management disabled (CONFIG_PM_ENABLE)");
+#endif
+
+    return PWR_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Acquire a power management lock.
+*
+*   This function keeps the chip awake for a module. Acquires are counted,
+*   each one must be balanced by a PWR_ReleaseLock.
+*
+*   Preconditions: Power manager is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_AcquireLock(PWR_Lock_Id_t lock_id){
+
+    if(lock_id >= PWR_LOCK_NB){
+        return PWR_STATUS_ERROR;
+    }
+
+    PWR_Lock_Info_t *pLock = &lock_info_table[lock_id];
+
+    if((pLock->handle != NULL) && (ESP_OK != esp_pm_lock_acquire(pLock->handle))){
+        return PWR_STATUS_ERROR;
+    }
+
+    portENTER_CRITICAL(&lock_spinlock);
+    if(pLock->nb_holder == 0){
+        pLock->nb_acquire++;
+        pLock->acquire_time_us = esp_timer_get_time();
+    }
+    pLock->nb_holder++;
+    portEXIT_CRITICAL(&lock_spinlock);
+
+    return PWR_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Release a power management lock.
+*
+*   Preconditions: Lock is acquired.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_ReleaseLock(PWR_Lock_Id_t lock_id){
+
+    if(lock_id >= PWR_LOCK_NB){
+        return PWR_STATUS_ERROR;
+    }
+
+    PWR_Lock_Info_t *pLock = &lock_info_table[lock_id];
+    bool released = false;
+
+    portENTER_CRITICAL(&lock_spinlock);
+    if(pLock->nb_holder > 0){
+        pLock->nb_holder--;
+        if(pLock->nb_holder == 0){
+            pLock->held_time_us += (uint64_t)(esp_timer_get_time() - pLock->acquire_time_us);
+        }
+        released = true;
+    }
+    portEXIT_CRITICAL(&lock_spinlock);
+
+    if(!released){
+        ESP_LOGI(TAG, "Unbalanced release of %s lock", lock_cfg_table[lock_id].name);
+        return PWR_STATUS_ERROR;
+    }
+
+    if((pLock->handle != NULL) && (ESP_OK != esp_pm_lock_release(pLock->handle))){
+        return PWR_STATUS_ERROR;
+    }
+
+    return PWR_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Get lock statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*   \param[out] pStats              Lock statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_GetLockStats(PWR_Lock_Id_t lock_id, PWR_Lock_Stats_t *pStats){
+
+    if((lock_id >= PWR_LOCK_NB) || (pStats == NULL)){
+        return PWR_STATUS_ERROR;
+    }
+
+    PWR_Lock_Info_t *pLock = &lock_info_table[lock_id];
+
+    portENTER_CRITICAL(&lock_spinlock);
+    pStats->nb_acquire = pLock->nb_acquire;
+    pStats->held_time_us = pLock->held_time_us;
+    pStats->held = (pLock->nb_holder > 0);
+    if(pStats->held){
+        pStats->held_time_us += (uint64_t)(esp_timer_get_time() - pLock->acquire_time_us);
+    }
+    portEXIT_CRITICAL(&lock_spinlock);
+
+    return PWR_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Dump lock statistics.
+*
+*   Print the held time of every lock on the console, to find which module
+*   keeps the chip awake.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void PWR_DumpLockStats(void){
+
+    int64_t uptime_us = esp_timer_get_time();
+
+    printf("PM locks (uptime %" PRIu32 " s)\n", (uint32_t)(uptime_us / 1000000));
+    printf("  %-14s %8s %12s %6s %5s\n", "Lock", "Acquire", "Held ms", "Held%", "Now");
+
+    for(uint8_t i = 0; i < PWR_LOCK_NB; i++){
+        PWR_Lock_Stats_t stats;
+        PWR_GetLockStats((PWR_Lock_Id_t)i, &stats);
+
+        printf("  %-14s %8" PRIu32 " %12" PRIu64 " %5" PRIu32 "%% %5s\n",
+               lock_cfg_table[i].name,
+               stats.nb_acquire,
+               stats.held_time_us / 1000,
+               (uint32_t)((uptime_us > 0) ? ((stats.held_time_us * 100) / (uint64_t)uptime_us) : 0),
+               stats.held ? "yes" : "no");
+    }
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
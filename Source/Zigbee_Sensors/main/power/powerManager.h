@@ -0,0 +1,128 @@
+#ifndef _POWER_MANAGER_H
+#define _POWER_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define PWR_LIGHT_SLEEP_ENABLE          (1)//Auto light sleep when no lock is held
+#define PWR_MAX_CPU_FREQ_MHZ            (160)
+#define PWR_MIN_CPU_FREQ_MHZ            (40)//XTAL frequency
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum PWR_Lock_Id_e{
+    PWR_LOCK_SENSOR_I2C,                //AHT10 I2C transfer
+    PWR_LOCK_LED_PWM,                   //LEDC PWM while a led is lit
+    PWR_LOCK_ZIGBEE_RADIO,              //Zigbee commissioning radio window
+
+    PWR_LOCK_NB,
+}PWR_Lock_Id_t;
+
+typedef struct PWR_Lock_Stats_s{
+    uint32_t nb_acquire;                //Number of idle to held transitions
+    uint64_t held_time_us;              //Total held time, current hold included
+    bool held;
+}PWR_Lock_Stats_t;
+
+typedef enum PWR_Ret_e{
+    PWR_STATUS_ERROR,
+    PWR_STATUS_OK,
+}PWR_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Power manager initialization.
+*
+*   This function enables dynamic frequency scaling and automatic light
+*   sleep, and creates the power management lock of every module.
+*
+*   Preconditions: Called first in app_main, before any lock is used.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_Init(void);
+
+/***************************************************************************//*!
+*  \brief Acquire a power management lock.
+*
+*   This function keeps the chip awake for a module. Acquires are counted,
+*   each one must be balanced by a PWR_ReleaseLock.
+*
+*   Preconditions: Power manager is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_AcquireLock(PWR_Lock_Id_t lock_id);
+
+/***************************************************************************//*!
+*  \brief Release a power management lock.
+*
+*   Preconditions: Lock is acquired.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_ReleaseLock(PWR_Lock_Id_t lock_id);
+
+/***************************************************************************//*!
+*  \brief Get lock statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  lock_id             Lock ID.
+*   \param[out] pStats              Lock statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+PWR_Ret_t PWR_GetLockStats(PWR_Lock_Id_t lock_id, PWR_Lock_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Dump lock statistics.
+*
+*   Print the held time of every lock on the console, to find which module
+*   keeps the chip awake.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void PWR_DumpLockStats(void);
+
+#endif//_POWER_MANAGER_H
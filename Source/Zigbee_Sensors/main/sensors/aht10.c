@@ -8,6 +8,7 @@
 #include "esp_log.h"
 
 #include "aht10.h"
+#include "powerManager.h"
 
 /******************************************************************************
 *   Private Definitions
@@ -20,6 +21,9 @@
 #define AHT10_CMD_INIT                  (0xE1)
 #define AHT10_CMD_MEAS                  (0xAC)
 
+#define AHT10_STATUS_BUSY               (0x80)
+#define AHT10_STATUS_CALIBRATED         (0x08)
+
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
 /******************************************************************************
@@ -35,6 +39,8 @@
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
+static esp_err_t i2cTransmit(const uint8_t *pData, size_t size);
+static esp_err_t i2cReceive(uint8_t *pData, size_t size);
 
 
 /******************************************************************************
@@ -46,6 +52,7 @@
 *   Private Variables
 *******************************************************************************/
 static SemaphoreHandle_t aht10_mutex_handle = NULL;
+static StaticSemaphore_t aht10_mutex_buffer;
 
 static int16_t current_temp = AHT10_INVALID_TEMPERATURE;
 static uint16_t current_humidity = AHT10_INVALID_HUMIDITY;
@@ -60,6 +67,53 @@ static const char * TAG = "AHT10";
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief I2C transmit.
+*
+*   Send data to the AHT10. The chip is kept awake for the transfer only.
+*   
+*   Preconditions: I2C device is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Data to send.
+*   \param[in]  size                Data size.
+*
+*   \return     ESP error code
+*
+*******************************************************************************/
+static esp_err_t i2cTransmit(const uint8_t *pData, size_t size){
+
+    PWR_AcquireLock(PWR_LOCK_SENSOR_I2C);
+    esp_err_t err = i2c_master_transmit(i2c_dev_handle, pData, size, I2C_COM_TIMEOUT_MS);
+    PWR_ReleaseLock(PWR_LOCK_SENSOR_I2C);
+
+    return err;
+}
+
+/***************************************************************************//*!
+*  \brief I2C receive.
+*
+*   Read data from the AHT10. The chip is kept awake for the transfer only.
+*   
+*   Preconditions: I2C device is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[out] pData               Received data.
+*   \param[in]  size                Data size.
+*
+*   \return     ESP error code
+*
+*******************************************************************************/
+static esp_err_t i2cReceive(uint8_t *pData, size_t size){
+
+    PWR_AcquireLock(PWR_LOCK_SENSOR_I2C);
+    esp_err_t err = i2c_master_receive(i2c_dev_handle, pData, size, I2C_COM_TIMEOUT_MS);
+    PWR_ReleaseLock(PWR_LOCK_SENSOR_I2C);
+
+    return err;
+}
 
 
 /******************************************************************************
@@ -87,7 +141,7 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
                        WaitMsFunction_t wait_function){
 
     //Create mutex
-    aht10_mutex_handle = xSemaphoreCreateMutex();
+    aht10_mutex_handle = xSemaphoreCreateMutexStatic(&aht10_mutex_buffer);
     if(aht10_mutex_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create aht10 mutex");
@@ -128,10 +182,7 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
     wait_ms_function = wait_function;
 
     uint8_t cmd_to_send[] = {AHT10_CMD_INIT, 0x08, 0x00};
-    if(ESP_OK != i2c_master_transmit(i2c_dev_handle, 
-                                     cmd_to_send, 
-                                     sizeof(cmd_to_send), 
-                                     I2C_COM_TIMEOUT_MS)){
+    if(ESP_OK != i2cTransmit(cmd_to_send, sizeof(cmd_to_send))){
 
         ESP_LOGI(TAG, "Failed to send init cmd");
         return AHT10_STATUS_ERROR;
@@ -145,6 +196,7 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
 *
 *   Start measurement process and read back the temperature/humidity values
 *   from the AHT10 sensor.
+*   The result is discarded if the sensor reports busy or not calibrated.
 *   
 *   Preconditions: None.
 *
@@ -155,37 +207,80 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
 *******************************************************************************/
 AHT10_Ret_t AHT10_StartMeasurement(void){
 
-    uint8_t cmd_to_send[] = {AHT10_CMD_MEAS, 0x33, 0x00};
-    uint8_t recv_buffer[6] = {0};
-
-    //Send measurement cmd
-    if(ESP_OK != i2c_master_transmit(i2c_dev_handle, 
-                                     cmd_to_send, 
-                                     sizeof(cmd_to_send), 
-                                     I2C_COM_TIMEOUT_MS)){
-        
-        ESP_LOGI(TAG, "Failed to send measurement cmd");
+    if(AHT10_STATUS_OK != AHT10_TriggerMeasurement()){
         return AHT10_STATUS_ERROR;
     }
 
     //Wait for sensor to sample temp/humidity
     if(wait_ms_function != NULL){
-        wait_ms_function(100);//wait 100ms
+        wait_ms_function(AHT10_MEAS_TIME_MS);
     }
     else{
         return AHT10_STATUS_ERROR;
     }
 
+    return AHT10_ReadMeasurement();
+}
+
+/***************************************************************************//*!
+*  \brief Trigger AHT10 measurement.
+*
+*   Send the measurement command. The result must be read with
+*   AHT10_ReadMeasurement at least AHT10_MEAS_TIME_MS later.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+AHT10_Ret_t AHT10_TriggerMeasurement(void){
+
+    uint8_t cmd_to_send[] = {AHT10_CMD_MEAS, 0x33, 0x00};
+
+    //Send measurement cmd
+    if(ESP_OK != i2cTransmit(cmd_to_send, sizeof(cmd_to_send))){
+        
+        ESP_LOGI(TAG, "Failed to send measurement cmd");
+        return AHT10_STATUS_ERROR;
+    }
+
+    return AHT10_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Read AHT10 measurement.
+*
+*   Read back the temperature/humidity values of a triggered measurement.
+*   The result is discarded if the sensor reports busy or not calibrated.
+*   
+*   Preconditions: Measurement triggered AHT10_MEAS_TIME_MS ago.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+AHT10_Ret_t AHT10_ReadMeasurement(void){
+
+    uint8_t recv_buffer[6] = {0};
+
     //Read result
-    if(ESP_OK != i2c_master_receive(i2c_dev_handle, 
-                                    recv_buffer, 
-                                    sizeof(recv_buffer), 
-                                    I2C_COM_TIMEOUT_MS)){
+    if(ESP_OK != i2cReceive(recv_buffer, sizeof(recv_buffer))){
 
         ESP_LOGI(TAG, "Failed to read sensor");
         return AHT10_STATUS_ERROR;
     }
 
+    //Check measurement is complete and sensor is calibrated
+    if((recv_buffer[0] & AHT10_STATUS_BUSY) || 
+       ((recv_buffer[0] & AHT10_STATUS_CALIBRATED) == 0)){
+
+        ESP_LOGI(TAG, "Invalid sensor status: 0x%02x", recv_buffer[0]);
+        return AHT10_STATUS_ERROR;
+    }
+
     //Process recv buffer
     xSemaphoreTake(aht10_mutex_handle, portMAX_DELAY);
 
@@ -8,6 +8,7 @@
 *******************************************************************************/
 #define AHT10_INVALID_TEMPERATURE               (0x8000)
 #define AHT10_INVALID_HUMIDITY                  (0xFFFF)
+#define AHT10_MEAS_TIME_MS                      (100)//Trigger to read delay
 
 /******************************************************************************
 *   Public Macros
@@ -63,6 +64,7 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
 *
 *   Start measurement process and read back the temperature/humidity values
 *   from the AHT10 sensor.
+*   The result is discarded if the sensor reports busy or not calibrated.
 *   
 *   Preconditions: None.
 *
@@ -73,6 +75,36 @@ AHT10_Ret_t AHT10_Init(uint8_t scl_gpio,
 *******************************************************************************/
 AHT10_Ret_t AHT10_StartMeasurement(void);
 
+/***************************************************************************//*!
+*  \brief Trigger AHT10 measurement.
+*
+*   Send the measurement command. The result must be read with
+*   AHT10_ReadMeasurement at least AHT10_MEAS_TIME_MS later.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+AHT10_Ret_t AHT10_TriggerMeasurement(void);
+
+/***************************************************************************//*!
+*  \brief Read AHT10 measurement.
+*
+*   Read back the temperature/humidity values of a triggered measurement.
+*   The result is discarded if the sensor reports busy or not calibrated.
+*   
+*   Preconditions: Measurement triggered AHT10_MEAS_TIME_MS ago.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+AHT10_Ret_t AHT10_ReadMeasurement(void);
+
 /***************************************************************************//*!
 *  \brief Get the last temperature measurement.
 *
@@ -0,0 +1,261 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+
+#include "sampleHistory.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define SHIST_NB_INDEX                  (SHIST_CAPACITY / SHIST_INDEX_STRIDE)
+
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint32_t getOldestSeq(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static SHIST_Record_t record_table[SHIST_CAPACITY];
+static uint32_t index_table[SHIST_NB_INDEX];//Timestamp of the first record of each block
+static uint32_t write_seq = 0;//Sequence number of the next record
+
+static SemaphoreHandle_t shist_mutex_handle = NULL;
+static StaticSemaphore_t shist_mutex_buffer;
+
+static const char * TAG = "SHIST";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Get oldest record sequence number.
+*
+*   Preconditions: Mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \return     Sequence number of the oldest record still in the history
+*
+*******************************************************************************/
+static uint32_t getOldestSeq(void){
+    return (write_seq > SHIST_CAPACITY) ? (write_seq - SHIST_CAPACITY) : 0;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Sample history initialization.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Init(void){
+
+    shist_mutex_handle = xSemaphoreCreateMutexStatic(&shist_mutex_buffer);
+    if(shist_mutex_handle == NULL){
+        ESP_LOGI(TAG, "Failed to create history mutex");
+        return SHIST_STATUS_ERROR;
+    }
+
+    write_seq = 0;
+    memset(record_table, 0, sizeof(record_table));
+    memset(index_table, 0, sizeof(index_table));
+
+    return SHIST_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Add a record to the history.
+*
+*   Append a record to the history ring. The oldest record is overwritten
+*   when the history is full. Timestamps must be non-decreasing.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pRecord             Record to add.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Add(const SHIST_Record_t *pRecord){
+
+    if((pRecord == NULL) || (shist_mutex_handle == NULL)){
+        return SHIST_STATUS_ERROR;
+    }
+
+    xSemaphoreTake(shist_mutex_handle, portMAX_DELAY);
+
+    if((write_seq > 0) &&
+       (pRecord->timestamp < record_table[(write_seq - 1) % SHIST_CAPACITY].timestamp)){
+
+        xSemaphoreGive(shist_mutex_handle);
+        ESP_LOGI(TAG, "Record timestamp goes backward");
+        return SHIST_STATUS_ERROR;
+    }
+
+    record_table[write_seq % SHIST_CAPACITY] = *pRecord;
+    if((write_seq % SHIST_INDEX_STRIDE) == 0){
+        index_table[(write_seq / SHIST_INDEX_STRIDE) % SHIST_NB_INDEX] = pRecord->timestamp;
+    }
+    write_seq++;
+
+    xSemaphoreGive(shist_mutex_handle);
+
+    return SHIST_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Seek the first record at or after a time.
+*
+*   Binary search on the sparse time index, then linear scan of at most
+*   SHIST_INDEX_STRIDE records.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timestamp           Start time.
+*   \param[out] pSeq                Sequence number of the first record.
+*
+*   \return     Operation status (error if no record matches)
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Seek(uint32_t timestamp, uint32_t *pSeq){
+
+    if((pSeq == NULL) || (shist_mutex_handle == NULL)){
+        return SHIST_STATUS_ERROR;
+    }
+
+    xSemaphoreTake(shist_mutex_handle, portMAX_DELAY);
+
+    if(write_seq == 0){
+        xSemaphoreGive(shist_mutex_handle);
+        return SHIST_STATUS_ERROR;
+    }
+
+    uint32_t oldest_seq = getOldestSeq();
+
+    //The first block may be partially overwritten -> its index entry is not used
+    uint32_t low = (oldest_seq / SHIST_INDEX_STRIDE) + 1;
+    uint32_t high = (write_seq - 1) / SHIST_INDEX_STRIDE;
+    uint32_t seq = oldest_seq;
+
+    //Last block starting strictly before timestamp
+    while(low <= high){
+        uint32_t mid = low + ((high - low) / 2);
+        if(index_table[mid % SHIST_NB_INDEX] < timestamp){
+            seq = mid * SHIST_INDEX_STRIDE;
+            low = mid + 1;
+        }
+        else{
+            high = mid - 1;
+        }
+    }
+
+    while((seq < write_seq) && (record_table[seq % SHIST_CAPACITY].timestamp < timestamp)){
+        seq++;
+    }
+
+    xSemaphoreGive(shist_mutex_handle);
+
+    if(seq >= write_seq){
+        return SHIST_STATUS_ERROR;
+    }
+
+    *pSeq = seq;
+
+    return SHIST_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Read a record.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  seq                 Record sequence number.
+*   \param[out] pRecord             Record.
+*
+*   \return     Operation status (error if the record was overwritten or
+*               does not exist yet)
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Read(uint32_t seq, SHIST_Record_t *pRecord){
+
+    if((pRecord == NULL) || (shist_mutex_handle == NULL)){
+        return SHIST_STATUS_ERROR;
+    }
+
+    SHIST_Ret_t ret = SHIST_STATUS_ERROR;
+
+    xSemaphoreTake(shist_mutex_handle, portMAX_DELAY);
+
+    if((seq >= getOldestSeq()) && (seq < write_seq)){
+        *pRecord = record_table[seq % SHIST_CAPACITY];
+        ret = SHIST_STATUS_OK;
+    }
+
+    xSemaphoreGive(shist_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Get number of records.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Number of records in the history
+*
+*******************************************************************************/
+uint16_t SHIST_GetCount(void){
+
+    uint16_t count = 0;
+
+    if(shist_mutex_handle != NULL){
+        xSemaphoreTake(shist_mutex_handle, portMAX_DELAY);
+        count = (uint16_t)(write_seq - getOldestSeq());
+        xSemaphoreGive(shist_mutex_handle);
+    }
+
+    return count;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
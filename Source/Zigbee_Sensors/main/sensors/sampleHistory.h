@@ -0,0 +1,122 @@
+#ifndef _SAMPLE_HISTORY_H
+#define _SAMPLE_HISTORY_H
+
+#include <stdint.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define SHIST_SAMPLE_PERIOD_S           (60)//One record per minute
+#define SHIST_CAPACITY                  (24 * 60)//One day of records
+#define SHIST_INDEX_STRIDE              (16)//Records per sparse index entry
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct SHIST_Record_s{
+    uint32_t timestamp;//UTC seconds since 2000-01-01
+    int16_t temperature;//0.01*C
+    uint16_t humidity;//0.01%
+}SHIST_Record_t;
+
+typedef enum SHIST_Ret_e{
+    SHIST_STATUS_ERROR,
+    SHIST_STATUS_OK,
+}SHIST_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (SHIST_CAPACITY % SHIST_INDEX_STRIDE) != 0
+#error "SHIST_CAPACITY must be a multiple of SHIST_INDEX_STRIDE"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Sample history initialization.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Init(void);
+
+/***************************************************************************//*!
+*  \brief Add a record to the history.
+*
+*   Append a record to the history ring. The oldest record is overwritten
+*   when the history is full. Timestamps must be non-decreasing.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pRecord             Record to add.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Add(const SHIST_Record_t *pRecord);
+
+/***************************************************************************//*!
+*  \brief Seek the first record at or after a time.
+*
+*   Binary search on the sparse time index, then linear scan of at most
+*   SHIST_INDEX_STRIDE records.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timestamp           Start time.
+*   \param[out] pSeq                Sequence number of the first record.
+*
+*   \return     Operation status (error if no record matches)
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Seek(uint32_t timestamp, uint32_t *pSeq);
+
+/***************************************************************************//*!
+*  \brief Read a record.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: None.
+*
+*   \param[in]  seq                 Record sequence number.
+*   \param[out] pRecord             Record.
+*
+*   \return     Operation status (error if the record was overwritten or
+*               does not exist yet)
+*
+*******************************************************************************/
+SHIST_Ret_t SHIST_Read(uint32_t seq, SHIST_Record_t *pRecord);
+
+/***************************************************************************//*!
+*  \brief Get number of records.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     Number of records in the history
+*
+*******************************************************************************/
+uint16_t SHIST_GetCount(void);
+
+#endif//_SAMPLE_HISTORY_H
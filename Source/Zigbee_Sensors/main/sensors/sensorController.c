@@ -2,18 +2,24 @@
 *   Includes
 *******************************************************************************/
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "sensorController.h"
 #include "aht10.h"
 #include "zigbeeManager.h"
 #include "tempMeasCluster.h"
 #include "humidityMeasCluster.h"
+#include "sampleHistory.h"
+#include "timeCluster.h"
+#include "bootTrace.h"
+#include "eventLoop.h"
+#include "healthMonitor.h"
 #include "main.h"
 
 /******************************************************************************
@@ -24,6 +30,7 @@
 #define SENSOR_LOOP_PERIOD_MS           (250)
 #define NB_TEMPERATURE_SAMPLE           (8)
 #define NB_HUMIDITY_SAMPLE              (8)
+#define SENSOR_TASK_STACK_SIZE          (2048)
 
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
@@ -47,9 +54,23 @@ typedef enum SENSOR_Step_e{
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
+#if EVLOOP_ENABLE
+static void sensorTimerHandler(void *pArg);
+static void connectedHandler(void *pArg);
+#else
 static void tSensorTask(void *pvParameters);
+#endif
+
+static uint32_t sensorStep(void);
 
 static void wait_ms(uint32_t wait_time_ms);
+static void updateSample(void);
+static bool readFastSample(void);
+static bool takeFastSample(void);
+static void publishFastSample(void);
+#if !EVLOOP_ENABLE
+static void publishFirstSample(void);
+#endif
 
 /******************************************************************************
 *   Public Variables
@@ -59,10 +80,32 @@ static void wait_ms(uint32_t wait_time_ms);
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+#if EVLOOP_ENABLE
+static EVLOOP_EventId_t sensor_event_id = EVLOOP_EVENT_ID_INVALID;
+static EVLOOP_Timer_t sensor_timer;
+static bool fast_sample_pending = false;//Publish the next stepped measurement unfiltered
+#else
 static TaskHandle_t sensor_task_handle = NULL;
-static SemaphoreHandle_t sensor_mutex_handle = NULL;
+static StaticTask_t sensor_task_buffer;
+static StackType_t sensor_task_stack[SENSOR_TASK_STACK_SIZE];
+#endif
 
 static SENSOR_Step_t sensor_step = SENSOR_STEP_IDLE;
+static bool meas_triggered = false;
+static uint32_t sensor_caps = 0;
+
+static int16_t last_temperature = AHT10_INVALID_TEMPERATURE;
+static uint16_t last_humidity = AHT10_INVALID_HUMIDITY;
+static bool sample_published = false;
+
+static bool sensor_started = false;//Initial delay is over
+static bool first_sample_sent = false;//Sample published on the first connection
+
+//Sample taken at init, published as soon as the network is connected
+static bool fast_sample_valid = false;
+static int16_t fast_temperature = AHT10_INVALID_TEMPERATURE;
+static uint16_t fast_humidity = AHT10_INVALID_HUMIDITY;
+static uint32_t next_history_time = 0;
 
 static const char * TAG = "SENSOR";
 
@@ -70,18 +113,19 @@ static const char * TAG = "SENSOR";
 *   Private Functions Definitions
 *******************************************************************************/
 /***************************************************************************//*!
-*  \brief Sensor Task.
+*  \brief Sensor step.
 *
-*   Sensor controller task. It perform sensor management and sampling sequentially.
+*   Run one step of the sensor state machine: trigger a measurement, then
+*   read and filter the temperature and the humidity.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
+*   \return     Delay before the next step in ms
+*
 *******************************************************************************/
-static void tSensorTask(void *pvParameters){
-
-    ESP_LOGI(TAG, "Starting Sensor task");
+static uint32_t sensorStep(void){
 
     static uint8_t temp_avg_cptr = 0;
     static uint8_t temp_invalid_cptr = 0;
@@ -91,173 +135,292 @@ static void tSensorTask(void *pvParameters){
     static uint8_t rh_invalid_cptr = 0;
     static uint32_t rh_cumul = 0;
 
-    vTaskDelay(INITIAL_DELAY_MS/portTICK_PERIOD_MS);
+    uint32_t delay_ms = INTER_STEP_DELAY_MS;
 
-    for(;;){
+    switch(sensor_step){
 
-        switch(sensor_step){
+        case SENSOR_STEP_IDLE:
+        {
+            //Set next step
+            sensor_step = SENSOR_STEP_MEAS;
+        }
+        break;
 
-            case SENSOR_STEP_IDLE:
-            {
-                //Set next step
-                sensor_step = SENSOR_STEP_MEAS;
-                vTaskDelay(INTER_STEP_DELAY_MS/portTICK_PERIOD_MS);
-            }
-            break;
+        case SENSOR_STEP_MEAS:
+        {
+            meas_triggered = (AHT10_STATUS_OK == AHT10_TriggerMeasurement());
 
-            case SENSOR_STEP_MEAS:
-            {
-                AHT10_StartMeasurement();
+            //Read once the conversion is done
+            delay_ms += AHT10_MEAS_TIME_MS;
 
-                //Set next step
-                sensor_step = SENSOR_STEP_PROCESS_TEMP;
-                vTaskDelay(INTER_STEP_DELAY_MS/portTICK_PERIOD_MS);
+            //Set next step
+            sensor_step = SENSOR_STEP_PROCESS_TEMP;
+        }
+        break;
+
+        case SENSOR_STEP_PROCESS_TEMP:
+        {
+            //Read the measurement triggered by the previous step
+            if(meas_triggered){
+                meas_triggered = false;
+                AHT10_ReadMeasurement();
             }
-            break;
-
-            case SENSOR_STEP_PROCESS_TEMP:
-            {
-                int16_t temperature = AHT10_INVALID_TEMPERATURE;
-                if(AHT10_STATUS_OK != AHT10_GetLastTemperature(&temperature)){
-                    ESP_LOGI(TAG, "Failed to get last temperature");
-                    temperature = AHT10_INVALID_TEMPERATURE;
-                }
 
-                if(temperature != (int16_t)AHT10_INVALID_TEMPERATURE){
-                    //Reset invalid temp cptr
-                    temp_invalid_cptr = 0;
+            int16_t temperature = AHT10_INVALID_TEMPERATURE;
+            if(AHT10_STATUS_OK != AHT10_GetLastTemperature(&temperature)){
+                ESP_LOGI(TAG, "Failed to get last temperature");
+                temperature = AHT10_INVALID_TEMPERATURE;
+            }
 
-                    //Check if we need to update zigbee attrib
-                    if(temp_avg_cptr >= NB_TEMPERATURE_SAMPLE){
-                        //Calculate the average
-                        temp_cumul /= NB_TEMPERATURE_SAMPLE;
-                        temperature = (int16_t)temp_cumul;
+            if(temperature != (int16_t)AHT10_INVALID_TEMPERATURE){
+                //Reset invalid temp cptr
+                temp_invalid_cptr = 0;
 
-                        //Reset average temperature
-                        temp_cumul = 0;
-                        temp_avg_cptr = 0;
+                //Check if we need to update zigbee attrib
+                if(temp_avg_cptr >= NB_TEMPERATURE_SAMPLE){
+                    //Calculate the average
+                    temp_cumul /= NB_TEMPERATURE_SAMPLE;
+                    temperature = (int16_t)temp_cumul;
 
-                        ESP_LOGI(TAG, "Temperature: %d *C", temperature);
+                    //Reset average temperature
+                    temp_cumul = 0;
+                    temp_avg_cptr = 0;
 
-                        //Update zigbee attrib with new value
-                        if(TEMP_CLUSTER_STATUS_OK != TEMP_SetTemperature(temperature)){
-                            ESP_LOGI(TAG, "Failed to update zigbee attrib");
-                        }
-                    }
-                    else{
-                        //Increment avg temp cptr
-                        temp_avg_cptr++;
-                        temp_cumul += temperature;
+                    ESP_LOGI(TAG, "Temperature: %d *C", temperature);
+
+                    last_temperature = temperature;
+                    sample_published = true;
+
+                    //Update zigbee attrib with new value
+                    if(TEMP_CLUSTER_STATUS_OK != TEMP_SetTemperature(temperature)){
+                        ESP_LOGI(TAG, "Failed to update zigbee attrib");
                     }
                 }
                 else{
-                    //Reset avg temp cptr
-                    temp_avg_cptr = 0;
-                    //Reset avg temp value
-                    temp_cumul = 0;
+                    //Increment avg temp cptr
+                    temp_avg_cptr++;
+                    temp_cumul += temperature;
+                }
+            }
+            else{
+                //Reset avg temp cptr
+                temp_avg_cptr = 0;
+                //Reset avg temp value
+                temp_cumul = 0;
+
+                //Check if we need to update zigbee attrib
+                if(temp_invalid_cptr >= NB_TEMPERATURE_SAMPLE){
+                    //Reset invalid temp cptr
+                    temp_invalid_cptr = 0;
+
+                    ESP_LOGI(TAG, "Temperature: %d *C", temperature);
 
-                    //Check if we need to update zigbee attrib
-                    if(temp_invalid_cptr >= NB_TEMPERATURE_SAMPLE){
-                        //Reset invalid temp cptr
-                        temp_invalid_cptr = 0;
-
-                        ESP_LOGI(TAG, "Temperature: %d *C", temperature);
-
-                        //Update zigbee attrib with invalid value
-                        if(TEMP_CLUSTER_STATUS_OK != TEMP_SetTemperature(temperature)){
-                            ESP_LOGI(TAG, "Failed to update zigbee attrib");
-                        }                    
-                        else{
-                        //Increment invalid temp cptr
-                        temp_invalid_cptr++;
-                        }
+                    last_temperature = temperature;
+                    sample_published = true;
+
+                    //Update zigbee attrib with invalid value
+                    if(TEMP_CLUSTER_STATUS_OK != TEMP_SetTemperature(temperature)){
+                        ESP_LOGI(TAG, "Failed to update zigbee attrib");
+                    }                    
+                    else{
+                    //Increment invalid temp cptr
+                    temp_invalid_cptr++;
                     }
                 }
+            }
 
-                //Set next step
-                sensor_step = SENSOR_STEP_PROCESS_HUMIDITY;
-                vTaskDelay(INTER_STEP_DELAY_MS/portTICK_PERIOD_MS);
+            //Set next step
+            sensor_step = SENSOR_STEP_PROCESS_HUMIDITY;
+        }
+        break;
+
+        case SENSOR_STEP_PROCESS_HUMIDITY:
+        {
+            uint16_t humidity = AHT10_INVALID_HUMIDITY;
+            if(AHT10_STATUS_OK != AHT10_GetLastHumidity(&humidity)){
+                ESP_LOGI(TAG, "Failed to get last humidity");
+                humidity = AHT10_INVALID_HUMIDITY;
             }
-            break;
-
-            case SENSOR_STEP_PROCESS_HUMIDITY:
-            {
-                uint16_t humidity = AHT10_INVALID_HUMIDITY;
-                if(AHT10_STATUS_OK != AHT10_GetLastHumidity(&humidity)){
-                    ESP_LOGI(TAG, "Failed to get last humidity");
-                    humidity = AHT10_INVALID_HUMIDITY;
-                }
 
-                if(humidity != AHT10_INVALID_HUMIDITY){
-                    //Reset invalid humidity cptr
-                    rh_invalid_cptr = 0;
+            if(humidity != AHT10_INVALID_HUMIDITY){
+                //Reset invalid humidity cptr
+                rh_invalid_cptr = 0;
 
-                    //Check if we need to update zigbee attrib
-                    if(rh_avg_cptr >= NB_HUMIDITY_SAMPLE){
-                        //Calculate te average
-                        rh_cumul /= NB_HUMIDITY_SAMPLE;
-                        humidity = (uint16_t)rh_cumul;
+                //Check if we need to update zigbee attrib
+                if(rh_avg_cptr >= NB_HUMIDITY_SAMPLE){
+                    //Calculate te average
+                    rh_cumul /= NB_HUMIDITY_SAMPLE;
+                    humidity = (uint16_t)rh_cumul;
 
-                        //Reset average rh
-                        rh_cumul = 0;
-                        rh_avg_cptr = 0;
+                    //Reset average rh
+                    rh_cumul = 0;
+                    rh_avg_cptr = 0;
 
-                        ESP_LOGI(TAG, "Humidity: %d", humidity);
+                    ESP_LOGI(TAG, "Humidity: %d", humidity);
 
-                        //Update zigbee attrib with new value
-                        if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetRelHumidity(humidity)){
-                            ESP_LOGI(TAG, "Failed to update zigbee attrib");
-                        }
-                    }
-                    else{
-                        //Increment avg cptr
-                        rh_avg_cptr++;
-                        rh_cumul += humidity;
+                    last_humidity = humidity;
+                    sample_published = true;
+
+                    //Update zigbee attrib with new value
+                    if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetRelHumidity(humidity)){
+                        ESP_LOGI(TAG, "Failed to update zigbee attrib");
                     }
                 }
                 else{
-                    //Reset avg rh cptr
-                    rh_avg_cptr = 0;
-                    //Reset cumul value
-                    rh_avg_cptr = 0;
+                    //Increment avg cptr
+                    rh_avg_cptr++;
+                    rh_cumul += humidity;
+                }
+            }
+            else{
+                //Reset avg rh cptr
+                rh_avg_cptr = 0;
+                //Reset cumul value
+                rh_avg_cptr = 0;
+
+                //Check if we need to update zigbee attrib
+                if(rh_invalid_cptr >= NB_HUMIDITY_SAMPLE){
+                    //Reset invalid rh cptr
+                    rh_invalid_cptr = 0;
 
-                    //Check if we need to update zigbee attrib
-                    if(rh_invalid_cptr >= NB_HUMIDITY_SAMPLE){
-                        //Reset invalid rh cptr
-                        rh_invalid_cptr = 0;
+                    //Update zigbee attrib with invalid value
+                    ESP_LOGI(TAG, "Humidity: %d", humidity);
 
-                        //Update zigbee attrib with invalid value
-                        ESP_LOGI(TAG, "Humidity: %d", humidity);
+                    last_humidity = humidity;
+                    sample_published = true;
 
-                        //Update zigbee attrib with new value
-                        if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetRelHumidity(humidity)){
-                            ESP_LOGI(TAG, "Failed to update zigbee attrib");
-                        }
-                    }
-                    else{
-                        //Increment invalid rh cptr
-                        rh_invalid_cptr++;
+                    //Update zigbee attrib with new value
+                    if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetRelHumidity(humidity)){
+                        ESP_LOGI(TAG, "Failed to update zigbee attrib");
                     }
                 }
-
-                //Set next step
-                sensor_step = SENSOR_STEP_IDLE;
-                vTaskDelay(INTER_STEP_DELAY_MS/portTICK_PERIOD_MS);
+                else{
+                    //Increment invalid rh cptr
+                    rh_invalid_cptr++;
+                }
             }
-            break;
 
-            case SENSOR_STEP_INVALID:
-            default:
-            {
-                //Do nothing...
-            }
-            break;
+            //Timestamp the published values
+            updateSample();
+
+            //Wait for the next sampling loop
+            delay_ms += SENSOR_LOOP_PERIOD_MS;
+
+            //Set next step
+            sensor_step = SENSOR_STEP_IDLE;
         }
+        break;
 
-        vTaskDelay(SENSOR_LOOP_PERIOD_MS/portTICK_PERIOD_MS);
+        case SENSOR_STEP_INVALID:
+        default:
+        {
+            //Do nothing...
+        }
+        break;
+    }
+
+    return delay_ms;
+}
+
+#if EVLOOP_ENABLE
+/***************************************************************************//*!
+*  \brief Sensor timer handler.
+*
+*   Called from the event loop at the end of the initial delay, then at
+*   every step. The first sample is published as soon as a stepped
+*   measurement was read, when requested by the connected handler.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void sensorTimerHandler(void *pArg){
+
+    sensor_started = true;
+    uint32_t delay_ms = sensorStep();
+
+    //Measurement read by the temperature step
+    if(fast_sample_pending && (sensor_step == SENSOR_STEP_PROCESS_HUMIDITY)){
+        fast_sample_pending = false;
+
+        if(readFastSample()){
+            publishFastSample();
+        }
+        else{
+            ESP_LOGI(TAG, "Failed to take first sample");
+        }
+    }
+
+    EVLOOP_StartTimer(&sensor_timer, delay_ms);
+}
+
+/***************************************************************************//*!
+*  \brief Network connected handler.
+*
+*   Called from the event loop when the network is connected. Publish a
+*   sample on the first connection, and end the initial delay if it is not
+*   over yet. The sample taken at init is used during the initial delay,
+*   otherwise the next stepped measurement is published: the loop is not
+*   blocked by the measurement time.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void connectedHandler(void *pArg){
+
+    if(first_sample_sent){
+        return;
+    }
+    first_sample_sent = true;
+
+    if((!sensor_started) && fast_sample_valid){
+        publishFastSample();
+    }
+    else{
+        fast_sample_pending = true;
+    }
+
+    if(!sensor_started){
+        EVLOOP_StartTimer(&sensor_timer, 0);
+    }
+}
+#else
+/***************************************************************************//*!
+*  \brief Sensor Task.
+*
+*   Sensor controller task. It perform sensor management and sampling sequentially.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void tSensorTask(void *pvParameters){
+
+    ESP_LOGI(TAG, "Starting Sensor task");
+
+    //Fast start: the first connection ends the initial delay
+    if(ulTaskNotifyTake(pdTRUE, INITIAL_DELAY_MS/portTICK_PERIOD_MS) > 0){
+        publishFirstSample();
+    }
+    sensor_started = true;
+
+    for(;;){
+        //A connection during a step delay publishes the first sample right away
+        if((ulTaskNotifyTake(pdTRUE, sensorStep()/portTICK_PERIOD_MS) > 0) && (!first_sample_sent)){
+            publishFirstSample();
+        }
     }
     vTaskDelete(NULL);
 }
+#endif
 
 /***************************************************************************//*!
 *  \brief Wait milli-seconds
@@ -276,6 +439,155 @@ static void wait_ms(uint32_t wait_time_ms){
     if(wait_time_ms > 0)    vTaskDelay(wait_time_ms/portTICK_PERIOD_MS);
 }
 
+/***************************************************************************//*!
+*  \brief Update last sample.
+*
+*   Timestamp the newly published values with the network time and add them
+*   to the sample history once every SHIST_SAMPLE_PERIOD_S seconds. Invalid
+*   values and samples taken before the first time sync are not recorded.
+*
+*   Preconditions: Sample history is initialized.
+*
+*   Side Effects: Marks the first report boot milestone when connected.
+*
+*******************************************************************************/
+static void updateSample(void){
+
+    if(!sample_published){
+        return;
+    }
+    sample_published = false;
+
+    //Attributes are only reported once joined
+    if(ZIGBEE_NWK_CONNECTED == ZIGBEE_GetNwkState()){
+        BOOT_TRACE_Mark(BOOT_TRACE_FIRST_REPORT);
+    }
+
+    SHIST_Record_t record = {
+        .timestamp = SENSOR_TIMESTAMP_INVALID,
+        .temperature = last_temperature,
+        .humidity = last_humidity,
+    };
+
+    if(TIME_CLUSTER_STATUS_OK != TIME_GetUtc(&record.timestamp)){
+        record.timestamp = SENSOR_TIMESTAMP_INVALID;
+    }
+
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    if((now < next_history_time) ||
+       (record.timestamp == SENSOR_TIMESTAMP_INVALID) ||
+       (record.temperature == (int16_t)AHT10_INVALID_TEMPERATURE) ||
+       (record.humidity == AHT10_INVALID_HUMIDITY)){
+        return;
+    }
+
+    if(SHIST_STATUS_OK != SHIST_Add(&record)){
+        ESP_LOGI(TAG, "Failed to add history record");
+    }
+
+    next_history_time = now + SHIST_SAMPLE_PERIOD_S;
+}
+
+/***************************************************************************//*!
+*  \brief Read fast start sample.
+*
+*   Validate the last AHT10 measurement as fast start sample, without the
+*   averaging filter.
+*
+*   Preconditions: AHT10 measurement was read.
+*
+*   Side Effects: None.
+*
+*   \return     true if the sample is valid
+*
+*******************************************************************************/
+static bool readFastSample(void){
+
+    fast_sample_valid = (AHT10_STATUS_OK == AHT10_GetLastTemperature(&fast_temperature)) &&
+                        (AHT10_STATUS_OK == AHT10_GetLastHumidity(&fast_humidity)) &&
+                        (fast_temperature != (int16_t)AHT10_INVALID_TEMPERATURE) &&
+                        (fast_humidity != AHT10_INVALID_HUMIDITY);
+
+    return fast_sample_valid;
+}
+
+/***************************************************************************//*!
+*  \brief Take fast start sample.
+*
+*   Take a validated sample right away, without the averaging filter.
+*
+*   Preconditions: AHT10 is initialized.
+*
+*   Side Effects: Blocks for the AHT10 measurement time.
+*
+*   \return     true if the sample is valid
+*
+*******************************************************************************/
+static bool takeFastSample(void){
+
+    fast_sample_valid = (AHT10_STATUS_OK == AHT10_StartMeasurement()) && readFastSample();
+
+    return fast_sample_valid;
+}
+
+/***************************************************************************//*!
+*  \brief Publish fast start sample.
+*
+*   Publish the sample taken at init without waiting for the averaging
+*   filter. The steady-state filtering takes over after it.
+*
+*   Preconditions: Network is connected.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void publishFastSample(void){
+
+    ESP_LOGI(TAG, "Fast start sample: %d *C, %d", fast_temperature, fast_humidity);
+
+    last_temperature = fast_temperature;
+    last_humidity = fast_humidity;
+    sample_published = true;
+
+    if(TEMP_CLUSTER_STATUS_OK != TEMP_SetTemperature(fast_temperature)){
+        ESP_LOGI(TAG, "Failed to update zigbee attrib");
+    }
+
+    if(HUMIDITY_CLUSTER_STATUS_OK != HUMIDITY_SetRelHumidity(fast_humidity)){
+        ESP_LOGI(TAG, "Failed to update zigbee attrib");
+    }
+
+    updateSample();
+    fast_sample_valid = false;
+}
+
+#if !EVLOOP_ENABLE
+/***************************************************************************//*!
+*  \brief Publish first sample.
+*
+*   Publish a sample on the first connection, whenever it happens. The
+*   sample taken at init is used during the initial delay, a new one is
+*   taken after it.
+*
+*   Preconditions: Network is connected.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void publishFirstSample(void){
+
+    first_sample_sent = true;
+
+    if((sensor_started || (!fast_sample_valid)) && (!takeFastSample())){
+        ESP_LOGI(TAG, "Failed to take first sample");
+        return;
+    }
+
+    publishFastSample();
+}
+#endif
+
 /******************************************************************************
 *   Public Functions Definitions
 *******************************************************************************/
@@ -293,10 +605,9 @@ static void wait_ms(uint32_t wait_time_ms){
 *******************************************************************************/
 SENSOR_Ret_t SENSOR_InitController(void){
 
-    //Create sensor mutex
-    sensor_mutex_handle = xSemaphoreCreateMutex();
-    if(sensor_mutex_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create sensor mutex");
+    //Init sample history
+    if(SHIST_STATUS_OK != SHIST_Init()){
+        ESP_LOGI(TAG, "Failed to init sample history");
         return SENSOR_STATUS_ERROR;
     }
 
@@ -308,22 +619,79 @@ SENSOR_Ret_t SENSOR_InitController(void){
         ESP_LOGI(TAG, "Failed to init AHT10");
         return SENSOR_STATUS_ERROR;
     }
+    sensor_caps = SENSOR_CAP_TEMPERATURE | SENSOR_CAP_HUMIDITY;
 
+    //Fast start: take a first validated sample right away
+    if(!takeFastSample()){
+        ESP_LOGI(TAG, "Failed to take fast start sample");
+    }
+
+#if EVLOOP_ENABLE
+    //Sample from the event loop, after the initial delay
+    EVLOOP_InitTimer(&sensor_timer, sensorTimerHandler, NULL);
+    if(EVLOOP_STATUS_OK != EVLOOP_RegisterEvent(connectedHandler, NULL, &sensor_event_id)){
+        ESP_LOGI(TAG, "Failed to register sensor event");
+        return SENSOR_STATUS_ERROR;
+    }
+    EVLOOP_StartTimer(&sensor_timer, INITIAL_DELAY_MS);
+#else
     //Create sensor task
-    if(pdTRUE != xTaskCreate(tSensorTask,
-                             "Sensor Task",
-                             2048,
-                             NULL,
-                             6,
-                             &sensor_task_handle)){
+    sensor_task_handle = xTaskCreateStatic(tSensorTask,
+                                           "Sensor Task",
+                                           SENSOR_TASK_STACK_SIZE,
+                                           NULL,
+                                           6,
+                                           sensor_task_stack,
+                                           &sensor_task_buffer);
+    if(sensor_task_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create sensor task");
         return SENSOR_STATUS_ERROR;
     }
+    HEALTH_RegisterTask(HEALTH_TASK_SENSOR, sensor_task_handle, SENSOR_TASK_STACK_SIZE);
+#endif
 
     return SENSOR_STATUS_OK;
 }
 
+/***************************************************************************//*!
+*  \brief Get sensor capabilities.
+*
+*   Return the measurements provided by the sensors detected at boot.
+*
+*   Preconditions: Sensor controller is initialized.
+*
+*   Side Effects: None.
+*
+*   \return     SENSOR_CAP_* bit mask
+*
+*******************************************************************************/
+uint32_t SENSOR_GetCapabilities(void){
+    return sensor_caps;
+}
+
+/***************************************************************************//*!
+*  \brief Notify network connected.
+*
+*   Publish a sample on the first connection: the sample taken at init
+*   during the initial delay, a new one after it.
+*
+*   Preconditions: Zigbee stack is started.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void SENSOR_NotifyConnected(void){
+
+#if EVLOOP_ENABLE
+    EVLOOP_PostEvent(sensor_event_id);
+#else
+    if(sensor_task_handle != NULL){
+        xTaskNotifyGive(sensor_task_handle);
+    }
+#endif
+}
+
 /******************************************************************************
 *   Interrupts
-*******************************************************************************/
\ No newline at end of file
+*******************************************************************************/
@@ -1,9 +1,16 @@
 #ifndef _SENSOR_CONTROLLER_H
 #define _SENSOR_CONTROLLER_H
 
+#include <stdint.h>
+
 /******************************************************************************
 *   Public Definitions
 *******************************************************************************/
+#define SENSOR_TIMESTAMP_INVALID        (0xFFFFFFFF)
+
+//Sensor capabilities
+#define SENSOR_CAP_TEMPERATURE          (1 << 0)
+#define SENSOR_CAP_HUMIDITY             (1 << 1)
 
 
 /******************************************************************************
@@ -46,4 +53,31 @@ typedef enum SENSOR_Ret_e{
 *******************************************************************************/
 SENSOR_Ret_t SENSOR_InitController(void);
 
+/***************************************************************************//*!
+*  \brief Get sensor capabilities.
+*
+*   Return the measurements provided by the sensors detected at boot.
+*
+*   Preconditions: Sensor controller is initialized.
+*
+*   Side Effects: None.
+*
+*   \return     SENSOR_CAP_* bit mask
+*
+*******************************************************************************/
+uint32_t SENSOR_GetCapabilities(void);
+
+/***************************************************************************//*!
+*  \brief Notify network connected.
+*
+*   Publish a sample on the first connection: the sample taken at init
+*   during the initial delay, a new one after it.
+*
+*   Preconditions: Zigbee stack is started.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void SENSOR_NotifyConnected(void);
+
 #endif//_SENSOR_CONTROLLER_H
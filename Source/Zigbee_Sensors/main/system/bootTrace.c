@@ -0,0 +1,154 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "esp_timer.h"
+#include "esp_app_desc.h"
+
+#include "bootTrace.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static int64_t milestone_time_us[BOOT_TRACE_NB] = {0};//0: not reached
+
+static const char * milestone_name[BOOT_TRACE_NB] = {
+    [BOOT_TRACE_APP_MAIN]           = "app_main",
+    [BOOT_TRACE_MAIN_TASK]          = "Main task",
+    [BOOT_TRACE_UI_INIT]            = "UI init",
+    [BOOT_TRACE_SENSOR_INIT]        = "Sensor init",
+    [BOOT_TRACE_ZB_INIT_START]      = "Zigbee init start",
+    [BOOT_TRACE_ZB_DEVICE_REGISTER] = "Device register",
+    [BOOT_TRACE_ZB_INIT_DONE]       = "Zigbee init done",
+    [BOOT_TRACE_ZB_STACK_START]     = "Zigbee stack start",
+    [BOOT_TRACE_ZB_NWK_JOINED]      = "Network joined",
+    [BOOT_TRACE_FIRST_REPORT]       = "First report",
+};
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Mark boot milestone.
+*
+*   Record the current time for a milestone. Only the first call for each
+*   milestone is kept.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  milestone           Boot milestone.
+*
+*******************************************************************************/
+void BOOT_TRACE_Mark(BOOT_TRACE_Milestone_t milestone){
+
+    if((milestone < BOOT_TRACE_NB) && (milestone_time_us[milestone] == 0)){
+        milestone_time_us[milestone] = esp_timer_get_time();
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Get boot milestone time.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  milestone           Boot milestone.
+*
+*   \return     Milestone time in ms since power-on (BOOT_TRACE_NOT_REACHED
+*               if not reached yet)
+*
+*******************************************************************************/
+uint32_t BOOT_TRACE_GetMs(BOOT_TRACE_Milestone_t milestone){
+
+    if((milestone >= BOOT_TRACE_NB) || (milestone_time_us[milestone] == 0)){
+        return BOOT_TRACE_NOT_REACHED;
+    }
+
+    return (uint32_t)(milestone_time_us[milestone] / 1000);
+}
+
+/***************************************************************************//*!
+*  \brief Check if boot is complete.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     true once the last milestone is reached or the trace timed out
+*
+*******************************************************************************/
+bool BOOT_TRACE_IsComplete(void){
+
+    return ((milestone_time_us[BOOT_TRACE_NB - 1] != 0) ||
+            (esp_timer_get_time() >= ((int64_t)BOOT_TRACE_TIMEOUT_MS * 1000)));
+}
+
+/***************************************************************************//*!
+*  \brief Dump boot trace.
+*
+*   Print the boot timeline as a table on the console.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void BOOT_TRACE_Dump(void){
+
+    int64_t prev_us = 0;
+
+    printf("Boot trace (fw %s)\n", esp_app_get_description()->version);
+    printf("  %-20s %10s %10s\n", "Milestone", "Time ms", "Delta ms");
+
+    for(uint8_t i = 0; i < BOOT_TRACE_NB; i++){
+        if(milestone_time_us[i] == 0){
+            printf("  %-20s %10s %10s\n", milestone_name[i], "-", "-");
+        }
+        else{
+            printf("  %-20s %10" PRId64 " %10" PRId64 "\n",
+                   milestone_name[i],
+                   milestone_time_us[i] / 1000,
+                   (milestone_time_us[i] - prev_us) / 1000);
+            prev_us = milestone_time_us[i];
+        }
+    }
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,104 @@
+#ifndef _BOOT_TRACE_H
+#define _BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define BOOT_TRACE_ZIGBEE_ATTR          (1)//Expose milestones in the Diagnostic cluster
+#define BOOT_TRACE_TIMEOUT_MS           (60 * 1000)//Dump incomplete trace after this time
+#define BOOT_TRACE_NOT_REACHED          (0xFFFFFFFF)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum BOOT_TRACE_Milestone_e{
+    BOOT_TRACE_APP_MAIN,
+    BOOT_TRACE_MAIN_TASK,
+    BOOT_TRACE_UI_INIT,
+    BOOT_TRACE_SENSOR_INIT,
+    BOOT_TRACE_ZB_INIT_START,
+    BOOT_TRACE_ZB_DEVICE_REGISTER,
+    BOOT_TRACE_ZB_INIT_DONE,
+    BOOT_TRACE_ZB_STACK_START,
+    BOOT_TRACE_ZB_NWK_JOINED,
+    BOOT_TRACE_FIRST_REPORT,
+
+    BOOT_TRACE_NB,
+}BOOT_TRACE_Milestone_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Mark boot milestone.
+*
+*   Record the current time for a milestone. Only the first call for each
+*   milestone is kept.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  milestone           Boot milestone.
+*
+*******************************************************************************/
+void BOOT_TRACE_Mark(BOOT_TRACE_Milestone_t milestone);
+
+/***************************************************************************//*!
+*  \brief Get boot milestone time.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  milestone           Boot milestone.
+*
+*   \return     Milestone time in ms since power-on (BOOT_TRACE_NOT_REACHED
+*               if not reached yet)
+*
+*******************************************************************************/
+uint32_t BOOT_TRACE_GetMs(BOOT_TRACE_Milestone_t milestone);
+
+/***************************************************************************//*!
+*  \brief Check if boot is complete.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     true once the last milestone is reached or the trace timed out
+*
+*******************************************************************************/
+bool BOOT_TRACE_IsComplete(void);
+
+/***************************************************************************//*!
+*  \brief Dump boot trace.
+*
+*   Print the boot timeline as a table on the console.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void BOOT_TRACE_Dump(void);
+
+#endif//_BOOT_TRACE_H
@@ -0,0 +1,288 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "eventLoop.h"
+#include "healthMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct EVLOOP_Event_s{
+    EVLOOP_Handler_t handler;
+    void *pArg;
+}EVLOOP_Event_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void runExpiredTimers(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static EVLOOP_Event_t event_table[EVLOOP_MAX_NB_EVENT];
+static uint8_t nb_event = 0;
+static atomic_uint_fast32_t pending_mask = 0;
+
+static EVLOOP_Timer_t *pTimer_list = NULL;//Armed timers, earliest deadline first
+
+static TaskHandle_t evloop_task_handle = NULL;//Task running the loop, borrowed from the caller
+
+static const char * TAG = "EVLOOP";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Run expired timers.
+*
+*   This function calls the handler of every expired timer, earliest
+*   deadline first. A timer is disarmed before its handler runs so the
+*   handler can restart it.
+*
+*   Preconditions: Called from the event loop.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void runExpiredTimers(void){
+
+    while((pTimer_list != NULL) && 
+          ((int32_t)(xTaskGetTickCount() - pTimer_list->deadline_tick) >= 0)){
+
+        EVLOOP_Timer_t *pTimer = pTimer_list;
+        pTimer_list = pTimer->pNext;
+        pTimer->pNext = NULL;
+        pTimer->armed = false;
+
+        pTimer->handler(pTimer->pArg);
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Register an event handler.
+*
+*   This function registers a handler called from the event loop each time
+*   its event is posted. Several posts before the handler runs are merged.
+*
+*   Preconditions: Event loop is not started yet (init time).
+*
+*   Side Effects: None.
+*
+*   \param[in]  handler             Event handler.
+*   \param[in]  pArg                Handler argument.
+*   \param[out] pEvent_id           Event ID to post.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+EVLOOP_Ret_t EVLOOP_RegisterEvent(EVLOOP_Handler_t handler, void *pArg, EVLOOP_EventId_t *pEvent_id){
+
+    if((handler == NULL) || (pEvent_id == NULL)){
+        return EVLOOP_STATUS_ERROR;
+    }
+
+    if(nb_event >= EVLOOP_MAX_NB_EVENT){
+        ESP_LOGI(TAG, "Failed to register event: table full");
+        return EVLOOP_STATUS_ERROR;
+    }
+
+    event_table[nb_event].handler = handler;
+    event_table[nb_event].pArg = pArg;
+    *pEvent_id = nb_event;
+    nb_event++;
+
+    return EVLOOP_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Post an event.
+*
+*   This function marks an event pending and wakes the event loop up. It can
+*   be called from any task or ISR, and before the loop is started.
+*
+*   Preconditions: Event is registered.
+*
+*   Side Effects: None.
+*
+*   \param[in]  event_id            Event ID.
+*
+*******************************************************************************/
+void EVLOOP_PostEvent(EVLOOP_EventId_t event_id){
+
+    if(event_id >= nb_event){
+        return;
+    }
+
+    atomic_fetch_or(&pending_mask, (1UL << event_id));
+
+    if(evloop_task_handle != NULL){
+        if(xPortInIsrContext()){
+            BaseType_t higher_prio_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(evloop_task_handle, &higher_prio_woken);
+            portYIELD_FROM_ISR(higher_prio_woken);
+        }
+        else{
+            xTaskNotifyGive(evloop_task_handle);
+        }
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Initialize a timer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pTimer              Timer to initialize (caller owned).
+*   \param[in]  handler             Handler called when the timer expires.
+*   \param[in]  pArg                Handler argument.
+*
+*******************************************************************************/
+void EVLOOP_InitTimer(EVLOOP_Timer_t *pTimer, EVLOOP_Handler_t handler, void *pArg){
+
+    pTimer->handler = handler;
+    pTimer->pArg = pArg;
+    pTimer->deadline_tick = 0;
+    pTimer->armed = false;
+    pTimer->pNext = NULL;
+}
+
+/***************************************************************************//*!
+*  \brief Start a timer.
+*
+*   This function (re)arms a one-shot timer. A handler can restart its own
+*   timer to run periodically.
+*
+*   Preconditions: Called from the event loop, or before it is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTimer              Timer.
+*   \param[in]  delay_ms            Delay before expiry.
+*
+*******************************************************************************/
+void EVLOOP_StartTimer(EVLOOP_Timer_t *pTimer, uint32_t delay_ms){
+
+    EVLOOP_StopTimer(pTimer);
+
+    pTimer->deadline_tick = xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms);
+    pTimer->armed = true;
+
+    //Insert after the timers expiring at or before this one
+    EVLOOP_Timer_t **ppLink = &pTimer_list;
+    while((*ppLink != NULL) && 
+          ((int32_t)(pTimer->deadline_tick - (*ppLink)->deadline_tick) >= 0)){
+
+        ppLink = &(*ppLink)->pNext;
+    }
+    pTimer->pNext = *ppLink;
+    *ppLink = pTimer;
+}
+
+/***************************************************************************//*!
+*  \brief Stop a timer.
+*
+*   Preconditions: Called from the event loop, or before it is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTimer              Timer.
+*
+*******************************************************************************/
+void EVLOOP_StopTimer(EVLOOP_Timer_t *pTimer){
+
+    if(!pTimer->armed){
+        return;
+    }
+
+    EVLOOP_Timer_t **ppLink = &pTimer_list;
+    while((*ppLink != NULL) && (*ppLink != pTimer)){
+        ppLink = &(*ppLink)->pNext;
+    }
+    if(*ppLink != NULL){
+        *ppLink = pTimer->pNext;
+    }
+
+    pTimer->pNext = NULL;
+    pTimer->armed = false;
+}
+
+/***************************************************************************//*!
+*  \brief Run the event loop.
+*
+*   This function runs the event loop on the calling task and never returns.
+*   It dispatches the posted events and the expired timers, then sleeps
+*   until the next timer deadline or the next post. Events posted before are
+*   handled right away.
+*
+*   Preconditions: All modules using the event loop are initialized.
+*
+*   Side Effects: Raise the calling task to EVLOOP_TASK_PRIORITY.
+*
+*   \param[in]  stack_size          Calling task stack size in bytes (health report).
+*
+*******************************************************************************/
+void EVLOOP_Run(uint32_t stack_size){
+
+    TickType_t wait_ticks = portMAX_DELAY;
+
+    ESP_LOGI(TAG, "Starting Event loop");
+
+    evloop_task_handle = xTaskGetCurrentTaskHandle();
+    vTaskPrioritySet(NULL, EVLOOP_TASK_PRIORITY);
+    HEALTH_RegisterTask(HEALTH_TASK_EVLOOP, evloop_task_handle, stack_size);
+
+    for(;;){
+
+        uint32_t mask = (uint32_t)atomic_exchange(&pending_mask, 0);
+        while(mask != 0){
+            uint8_t event_id = (uint8_t)__builtin_ctz(mask);
+            mask &= (mask - 1);
+
+            event_table[event_id].handler(event_table[event_id].pArg);
+        }
+
+        runExpiredTimers();
+
+        //Sleep until the next deadline, or until an event is posted
+        if(pTimer_list == NULL){
+            wait_ticks = portMAX_DELAY;
+        }
+        else{
+            int32_t remaining = (int32_t)(pTimer_list->deadline_tick - xTaskGetTickCount());
+            wait_ticks = (remaining > 0) ? (TickType_t)remaining : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait_ticks);
+    }
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
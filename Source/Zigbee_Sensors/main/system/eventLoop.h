@@ -0,0 +1,152 @@
+#ifndef _EVENT_LOOP_H
+#define _EVENT_LOOP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#ifdef CONFIG_ZB_SENSORS_EVENT_LOOP
+#define EVLOOP_ENABLE                   (1)//Run UI, LED, sequencer and sensor on one task (menuconfig)
+#else
+#define EVLOOP_ENABLE                   (0)
+#endif
+#define EVLOOP_MAX_NB_EVENT             (8)
+#define EVLOOP_TASK_PRIORITY            (6)//Priority of the task running the loop
+
+#define EVLOOP_EVENT_ID_INVALID         (0xFF)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef void (*EVLOOP_Handler_t)(void *pArg);
+
+typedef uint8_t EVLOOP_EventId_t;
+
+typedef struct EVLOOP_Timer_s{
+    EVLOOP_Handler_t handler;
+    void *pArg;
+    TickType_t deadline_tick;
+    bool armed;
+    struct EVLOOP_Timer_s *pNext;       //Next armed timer, by deadline
+}EVLOOP_Timer_t;
+
+typedef enum EVLOOP_Ret_e{
+    EVLOOP_STATUS_ERROR,
+    EVLOOP_STATUS_OK,
+}EVLOOP_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+_Static_assert(EVLOOP_MAX_NB_EVENT <= 32, "Events are posted in a 32 bits mask");
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Register an event handler.
+*
+*   This function registers a handler called from the event loop each time
+*   its event is posted. Several posts before the handler runs are merged.
+*
+*   Preconditions: Event loop is not started yet (init time).
+*
+*   Side Effects: None.
+*
+*   \param[in]  handler             Event handler.
+*   \param[in]  pArg                Handler argument.
+*   \param[out] pEvent_id           Event ID to post.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+EVLOOP_Ret_t EVLOOP_RegisterEvent(EVLOOP_Handler_t handler, void *pArg, EVLOOP_EventId_t *pEvent_id);
+
+/***************************************************************************//*!
+*  \brief Post an event.
+*
+*   This function marks an event pending and wakes the event loop up. It can
+*   be called from any task or ISR, and before the loop is started.
+*
+*   Preconditions: Event is registered.
+*
+*   Side Effects: None.
+*
+*   \param[in]  event_id            Event ID.
+*
+*******************************************************************************/
+void EVLOOP_PostEvent(EVLOOP_EventId_t event_id);
+
+/***************************************************************************//*!
+*  \brief Initialize a timer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pTimer              Timer to initialize (caller owned).
+*   \param[in]  handler             Handler called when the timer expires.
+*   \param[in]  pArg                Handler argument.
+*
+*******************************************************************************/
+void EVLOOP_InitTimer(EVLOOP_Timer_t *pTimer, EVLOOP_Handler_t handler, void *pArg);
+
+/***************************************************************************//*!
+*  \brief Start a timer.
+*
+*   This function (re)arms a one-shot timer. A handler can restart its own
+*   timer to run periodically.
+*
+*   Preconditions: Called from the event loop, or before it is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTimer              Timer.
+*   \param[in]  delay_ms            Delay before expiry.
+*
+*******************************************************************************/
+void EVLOOP_StartTimer(EVLOOP_Timer_t *pTimer, uint32_t delay_ms);
+
+/***************************************************************************//*!
+*  \brief Stop a timer.
+*
+*   Preconditions: Called from the event loop, or before it is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTimer              Timer.
+*
+*******************************************************************************/
+void EVLOOP_StopTimer(EVLOOP_Timer_t *pTimer);
+
+/***************************************************************************//*!
+*  \brief Run the event loop.
+*
+*   This function runs the event loop on the calling task and never returns.
+*   Events posted before are handled right away.
+*
+*   Preconditions: All modules using the event loop are initialized.
+*
+*   Side Effects: Raise the calling task to EVLOOP_TASK_PRIORITY.
+*
+*   \param[in]  stack_size          Calling task stack size in bytes (health report).
+*
+*******************************************************************************/
+void EVLOOP_Run(uint32_t stack_size);
+
+#endif//_EVENT_LOOP_H
@@ -0,0 +1,350 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "healthMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct HEALTH_Task_Info_s{
+    TaskHandle_t handle;                //NULL if not registered or exited
+    uint32_t stack_size;
+    uint32_t min_free;
+    bool low_water_logged;
+}HEALTH_Task_Info_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void sampleTask(HEALTH_Task_Id_t task_id);
+static uint32_t suggestStackSize(const HEALTH_Task_Info_t *pTask);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const char * task_name[HEALTH_TASK_NB] = {
+    [HEALTH_TASK_MAIN]      = "Main",
+    [HEALTH_TASK_EVLOOP]    = "Event loop",
+    [HEALTH_TASK_UI]        = "UI",
+    [HEALTH_TASK_LED]       = "Led",
+    [HEALTH_TASK_SEQUENCER] = "Sequencer",
+    [HEALTH_TASK_SENSOR]    = "Sensor",
+    [HEALTH_TASK_ZIGBEE]    = "Zigbee",
+};
+
+static HEALTH_Task_Info_t task_info_table[HEALTH_TASK_NB];
+static HEALTH_Heap_Stats_t heap_stats = {0};
+
+static SemaphoreHandle_t health_mutex_handle = NULL;
+static StaticSemaphore_t health_mutex_buffer;
+
+static const char * TAG = "HEALTH";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Sample task.
+*
+*   Update the lowest free stack of a task, log once when it crosses the low
+*   water threshold.
+*
+*   Preconditions: Health mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*
+*******************************************************************************/
+static void sampleTask(HEALTH_Task_Id_t task_id){
+
+    HEALTH_Task_Info_t *pTask = &task_info_table[task_id];
+
+    if(pTask->handle == NULL){
+        return;
+    }
+
+    //High-water mark is in bytes (StackType_t is 8 bits)
+    uint32_t free = (uint32_t)uxTaskGetStackHighWaterMark(pTask->handle);
+    if(free < pTask->min_free){
+        pTask->min_free = free;
+    }
+
+    if((!pTask->low_water_logged) && (pTask->min_free < HEALTH_STACK_LOW_WATER)){
+        pTask->low_water_logged = true;
+        ESP_LOGI(TAG, "%s task stack low: %" PRIu32 " bytes free", task_name[task_id], pTask->min_free);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Suggest stack size.
+*
+*   Preconditions: Health mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTask               Task info.
+*
+*   \return     Peak stack usage plus HEALTH_STACK_MARGIN_PCT, rounded up to
+*               HEALTH_STACK_ROUNDING (0 if not sampled)
+*
+*******************************************************************************/
+static uint32_t suggestStackSize(const HEALTH_Task_Info_t *pTask){
+
+    if((pTask->stack_size == 0) || (pTask->min_free > pTask->stack_size)){
+        return 0;
+    }
+
+    uint32_t used = pTask->stack_size - pTask->min_free;
+    uint32_t size = (used * (100 + HEALTH_STACK_MARGIN_PCT)) / 100;
+
+    return ((size + HEALTH_STACK_ROUNDING - 1) / HEALTH_STACK_ROUNDING) * HEALTH_STACK_ROUNDING;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Health monitor initialization.
+*
+*   Preconditions: Called in app_main, before any task is registered.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_Init(void){
+
+    health_mutex_handle = xSemaphoreCreateMutexStatic(&health_mutex_buffer);
+    if(health_mutex_handle == NULL){
+        ESP_LOGI(TAG, "Failed to create health mutex");
+        return HEALTH_STATUS_ERROR;
+    }
+
+    for(uint8_t i = 0; i < HEALTH_TASK_NB; i++){
+        task_info_table[i].handle = NULL;
+        task_info_table[i].stack_size = 0;
+        task_info_table[i].min_free = UINT32_MAX;
+        task_info_table[i].low_water_logged = false;
+    }
+
+    heap_stats.min_largest_block = UINT32_MAX;
+
+    return HEALTH_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Register a task.
+*
+*   Add a task to the stack monitoring.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*   \param[in]  handle              Task handle.
+*   \param[in]  stack_size          Configured stack size in bytes.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_RegisterTask(HEALTH_Task_Id_t task_id, TaskHandle_t handle, uint32_t stack_size){
+
+    if((task_id >= HEALTH_TASK_NB) || (handle == NULL) || (health_mutex_handle == NULL)){
+        return HEALTH_STATUS_ERROR;
+    }
+
+    xSemaphoreTake(health_mutex_handle, portMAX_DELAY);
+    task_info_table[task_id].handle = handle;
+    task_info_table[task_id].stack_size = stack_size;
+    xSemaphoreGive(health_mutex_handle);
+
+    return HEALTH_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Unregister a task.
+*
+*   Take a last sample of a task about to delete itself. Its statistics are
+*   kept in the report.
+*
+*   Preconditions: Called from the task itself, before vTaskDelete.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*
+*******************************************************************************/
+void HEALTH_UnregisterTask(HEALTH_Task_Id_t task_id){
+
+    if((task_id >= HEALTH_TASK_NB) || (health_mutex_handle == NULL)){
+        return;
+    }
+
+    xSemaphoreTake(health_mutex_handle, portMAX_DELAY);
+    sampleTask(task_id);
+    task_info_table[task_id].handle = NULL;
+    xSemaphoreGive(health_mutex_handle);
+}
+
+/***************************************************************************//*!
+*  \brief Sample health.
+*
+*   Sample the stack high-water mark of every registered task, the free heap
+*   and the largest free block.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void HEALTH_Sample(void){
+
+    if(health_mutex_handle == NULL){
+        return;
+    }
+
+    xSemaphoreTake(health_mutex_handle, portMAX_DELAY);
+
+    for(uint8_t i = 0; i < HEALTH_TASK_NB; i++){
+        sampleTask((HEALTH_Task_Id_t)i);
+    }
+
+    //Minimum free heap is tracked by the allocator, the largest block is sampled
+    heap_stats.free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_stats.min_free = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    heap_stats.largest_block = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    if(heap_stats.largest_block < heap_stats.min_largest_block){
+        heap_stats.min_largest_block = heap_stats.largest_block;
+    }
+
+    xSemaphoreGive(health_mutex_handle);
+}
+
+/***************************************************************************//*!
+*  \brief Get task statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*   \param[out] pStats              Task statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_GetTaskStats(HEALTH_Task_Id_t task_id, HEALTH_Task_Stats_t *pStats){
+
+    if((task_id >= HEALTH_TASK_NB) || (pStats == NULL) || (health_mutex_handle == NULL)){
+        return HEALTH_STATUS_ERROR;
+    }
+
+    HEALTH_Task_Info_t *pTask = &task_info_table[task_id];
+
+    xSemaphoreTake(health_mutex_handle, portMAX_DELAY);
+    pStats->stack_size = pTask->stack_size;
+    pStats->min_free = pTask->min_free;
+    pStats->suggested_size = suggestStackSize(pTask);
+    pStats->running = (pTask->handle != NULL);
+    xSemaphoreGive(health_mutex_handle);
+
+    return HEALTH_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Get heap statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Heap statistics.
+*
+*******************************************************************************/
+void HEALTH_GetHeapStats(HEALTH_Heap_Stats_t *pStats){
+
+    if((pStats == NULL) || (health_mutex_handle == NULL)){
+        return;
+    }
+
+    xSemaphoreTake(health_mutex_handle, portMAX_DELAY);
+    *pStats = heap_stats;
+    xSemaphoreGive(health_mutex_handle);
+}
+
+/***************************************************************************//*!
+*  \brief Dump health report.
+*
+*   Print the stack usage of every task with a suggested stack size, and the
+*   heap statistics on the console.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void HEALTH_DumpReport(void){
+
+    printf("Task stacks (margin %d%%)\n", HEALTH_STACK_MARGIN_PCT);
+    printf("  %-12s %6s %6s %5s %9s %7s\n", "Task", "Size", "Peak", "Peak%", "Suggested", "Running");
+
+    for(uint8_t i = 0; i < HEALTH_TASK_NB; i++){
+        HEALTH_Task_Stats_t stats;
+        if((HEALTH_STATUS_OK != HEALTH_GetTaskStats((HEALTH_Task_Id_t)i, &stats)) ||
+           (stats.suggested_size == 0)){
+
+            continue;//Not registered or not sampled yet
+        }
+
+        uint32_t peak = stats.stack_size - stats.min_free;
+
+        printf("  %-12s %6" PRIu32 " %6" PRIu32 " %4" PRIu32 "%% %9" PRIu32 " %7s\n",
+               task_name[i],
+               stats.stack_size,
+               peak,
+               (peak * 100) / stats.stack_size,
+               stats.suggested_size,
+               stats.running ? "yes" : "no");
+    }
+
+    HEALTH_Heap_Stats_t heap;
+    HEALTH_GetHeapStats(&heap);
+
+    printf("Heap: free %" PRIu32 ", min free %" PRIu32 ", largest block %" PRIu32 " (min %" PRIu32 ")\n",
+           heap.free,
+           heap.min_free,
+           heap.largest_block,
+           heap.min_largest_block);
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,169 @@
+#ifndef _HEALTH_MONITOR_H
+#define _HEALTH_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define HEALTH_ZIGBEE_ATTR              (1)//Expose stack and heap margins in the Diagnostic cluster
+#define HEALTH_STACK_MARGIN_PCT         (25)//Safety margin over the peak stack usage
+#define HEALTH_STACK_ROUNDING           (256)//Suggested stack size granularity in bytes
+#define HEALTH_STACK_LOW_WATER          (256)//Warn when less free stack remains (bytes)
+#define HEALTH_NOT_SAMPLED              (0xFFFF)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum HEALTH_Task_Id_e{
+    HEALTH_TASK_MAIN,
+    HEALTH_TASK_EVLOOP,
+    HEALTH_TASK_UI,
+    HEALTH_TASK_LED,
+    HEALTH_TASK_SEQUENCER,
+    HEALTH_TASK_SENSOR,
+    HEALTH_TASK_ZIGBEE,
+
+    HEALTH_TASK_NB,
+}HEALTH_Task_Id_t;
+
+typedef struct HEALTH_Task_Stats_s{
+    uint32_t stack_size;                //Configured stack size in bytes, 0 if not registered
+    uint32_t min_free;                  //Lowest free stack seen in bytes
+    uint32_t suggested_size;            //Peak usage plus margin, 0 if not sampled
+    bool running;                       //false once the task exited
+}HEALTH_Task_Stats_t;
+
+typedef struct HEALTH_Heap_Stats_s{
+    uint32_t free;                      //Free heap at the last sample
+    uint32_t min_free;                  //Lowest free heap since boot
+    uint32_t largest_block;             //Largest free block at the last sample
+    uint32_t min_largest_block;         //Lowest largest free block seen
+}HEALTH_Heap_Stats_t;
+
+typedef enum HEALTH_Ret_e{
+    HEALTH_STATUS_ERROR,
+    HEALTH_STATUS_OK,
+}HEALTH_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Health monitor initialization.
+*
+*   Preconditions: Called in app_main, before any task is registered.
+*
+*   Side Effects: None.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_Init(void);
+
+/***************************************************************************//*!
+*  \brief Register a task.
+*
+*   Add a task to the stack monitoring.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*   \param[in]  handle              Task handle.
+*   \param[in]  stack_size          Configured stack size in bytes.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_RegisterTask(HEALTH_Task_Id_t task_id, TaskHandle_t handle, uint32_t stack_size);
+
+/***************************************************************************//*!
+*  \brief Unregister a task.
+*
+*   Take a last sample of a task about to delete itself. Its statistics are
+*   kept in the report.
+*
+*   Preconditions: Called from the task itself, before vTaskDelete.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*
+*******************************************************************************/
+void HEALTH_UnregisterTask(HEALTH_Task_Id_t task_id);
+
+/***************************************************************************//*!
+*  \brief Sample health.
+*
+*   Sample the stack high-water mark of every registered task, the free heap
+*   and the largest free block.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void HEALTH_Sample(void);
+
+/***************************************************************************//*!
+*  \brief Get task statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_id             Task ID.
+*   \param[out] pStats              Task statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+HEALTH_Ret_t HEALTH_GetTaskStats(HEALTH_Task_Id_t task_id, HEALTH_Task_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Get heap statistics.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Heap statistics.
+*
+*******************************************************************************/
+void HEALTH_GetHeapStats(HEALTH_Heap_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Dump health report.
+*
+*   Print the stack usage of every task with a suggested stack size, and the
+*   heap statistics on the console.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void HEALTH_DumpReport(void);
+
+#endif//_HEALTH_MONITOR_H
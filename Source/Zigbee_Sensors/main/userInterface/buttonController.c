@@ -1,8 +1,12 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
-#include "iot_button.h"
-#include "button_gpio.h"
+#include <stdbool.h>
+
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 
 #include "buttonController.h"
@@ -10,8 +14,9 @@
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
-#define BUTTON_TASK_PERIOD_MS           (10)
-#define BUTTON_LONGPRESS_DELAY_MS       (5 * 1000)
+#define BUTTON_POLL_PERIOD_MS           (10)
+#define BUTTON_DEBOUNCE_NB_SAMPLE       (2)
+#define BUTTON_MAX_NB_CLICK             (3)
 
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
@@ -23,12 +28,33 @@
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
+typedef enum BUTTON_State_e{
+    BUTTON_STATE_IDLE,                  //Released, no gesture in progress
+    BUTTON_STATE_PRESSED,               //Pressed, hold not reached yet
+    BUTTON_STATE_RELEASED,              //Released, waiting for another click
+    BUTTON_STATE_HELD,                  //Hold reported, waiting for release
+}BUTTON_State_t;
 
+typedef struct BUTTON_Info_s{
+    BUTTON_Config_t config;
+    esp_timer_handle_t poll_timer_handle;
+    BUTTON_State_t state;
+    bool pressed;                       //Debounced button level
+    uint8_t debounce_cptr;
+    uint8_t nb_click;
+    int64_t state_time_us;              //Time of the last state change
+}BUTTON_Info_t;
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
+static bool readPressed(void);
+static bool debounce(void);
+static void reportClicks(void);
+static void stopPolling(void);
 
+static void pollTimerCallback(void *arg);
+static void buttonIsrHandler(void *arg);
 
 /******************************************************************************
 *   Public Variables
@@ -38,12 +64,201 @@
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+static BUTTON_Info_t button_info;
+
+static const BUTTON_Gesture_t click_gesture_table[BUTTON_MAX_NB_CLICK + 1] = {
+    [0] = BUTTON_GESTURE_INVALID,
+    [1] = BUTTON_GESTURE_SINGLE_CLICK,
+    [2] = BUTTON_GESTURE_DOUBLE_CLICK,
+    [3] = BUTTON_GESTURE_TRIPLE_CLICK,
+};
+
 static const char * TAG = "BUTTON";
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief Read button level.
+*
+*   This function reads the raw button GPIO.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     True if the button is pressed
+*
+*******************************************************************************/
+static bool readPressed(void){
+
+    int level = gpio_get_level(button_info.config.gpio);
 
+    return (button_info.config.active_level == BUTTON_ACTIVE_HIGH) ? (level != 0) : (level == 0);
+}
+
+/***************************************************************************//*!
+*  \brief Debounce button level.
+*
+*   This function updates the debounced level. A new level is accepted after
+*   BUTTON_DEBOUNCE_NB_SAMPLE consecutive identical samples.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     True if the debounced level has changed
+*
+*******************************************************************************/
+static bool debounce(void){
+
+    if(readPressed() == button_info.pressed){
+        button_info.debounce_cptr = 0;
+        return false;
+    }
+
+    button_info.debounce_cptr++;
+    if(button_info.debounce_cptr < BUTTON_DEBOUNCE_NB_SAMPLE){
+        return false;
+    }
+
+    button_info.debounce_cptr = 0;
+    button_info.pressed = !button_info.pressed;
+    return true;
+}
+
+/***************************************************************************//*!
+*  \brief Report click gesture.
+*
+*   This function reports the click gesture matching the number of clicks
+*   and ends the gesture.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void reportClicks(void){
+
+    BUTTON_Gesture_t gesture = click_gesture_table[button_info.nb_click];
+
+    button_info.nb_click = 0;
+    button_info.state = BUTTON_STATE_IDLE;
+
+    if((gesture != BUTTON_GESTURE_INVALID) && (button_info.config.gesture_callback != NULL)){
+        button_info.config.gesture_callback(gesture, button_info.config.pArg);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Stop button polling.
+*
+*   This function stops the poll timer and re-arms the GPIO interrupt, so
+*   nothing runs while the button is idle.
+*   
+*   Preconditions: Button is idle and released.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void stopPolling(void){
+
+    esp_timer_stop(button_info.poll_timer_handle);
+    gpio_intr_enable(button_info.config.gpio);
+}
+
+/******************************************************************************
+*   CallBack Functions implementation
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Poll timer callback.
+*
+*   Called every BUTTON_POLL_PERIOD_MS while a gesture is in progress. It
+*   debounces the button and runs the gesture state machine.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: Gesture callback can be called.
+*
+*   \param[in]  arg                 Unused
+*
+*******************************************************************************/
+static void pollTimerCallback(void *arg){
+
+    bool edge = debounce();
+    int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us = now_us - button_info.state_time_us;
+
+    switch(button_info.state){
+
+        case BUTTON_STATE_IDLE:
+        {
+            if(edge && button_info.pressed){
+                button_info.nb_click = 1;
+                button_info.state = BUTTON_STATE_PRESSED;
+                button_info.state_time_us = now_us;
+            }
+        }
+        break;
+
+        case BUTTON_STATE_PRESSED:
+        {
+            if(edge){
+                if(button_info.nb_click >= BUTTON_MAX_NB_CLICK){
+                    //No longer gesture exists, do not wait for the click gap
+                    reportClicks();
+                }
+                else{
+                    button_info.state = BUTTON_STATE_RELEASED;
+                    button_info.state_time_us = now_us;
+                }
+            }
+            else if(elapsed_us >= ((int64_t)button_info.config.hold_ms * 1000)){
+                button_info.nb_click = 0;
+                button_info.state = BUTTON_STATE_HELD;
+                button_info.state_time_us = now_us;
+                if(button_info.config.gesture_callback != NULL){
+                    button_info.config.gesture_callback(BUTTON_GESTURE_HOLD, button_info.config.pArg);
+                }
+            }
+        }
+        break;
+
+        case BUTTON_STATE_RELEASED:
+        {
+            if(edge){
+                button_info.nb_click++;
+                button_info.state = BUTTON_STATE_PRESSED;
+                button_info.state_time_us = now_us;
+            }
+            else if(elapsed_us >= ((int64_t)button_info.config.click_gap_ms * 1000)){
+                reportClicks();
+            }
+        }
+        break;
+
+        case BUTTON_STATE_HELD:
+        {
+            if(edge){
+                button_info.state = BUTTON_STATE_IDLE;
+            }
+        }
+        break;
+
+        default:
+        {
+            button_info.state = BUTTON_STATE_IDLE;
+        }
+        break;
+    }
+
+    if((button_info.state == BUTTON_STATE_IDLE) && 
+       (!button_info.pressed) && 
+       (button_info.debounce_cptr == 0)){
+
+        stopPolling();
+    }
+}
 
 /******************************************************************************
 *   Public Functions Definitions
@@ -66,49 +281,64 @@ BUTTON_Ret_t BUTTON_InitController(BUTTON_Config_t const *pConfig){
 
     ESP_LOGI(TAG, "Controller initialization");
 
-    if(pConfig == NULL){
+    if((pConfig == NULL) || (pConfig->gpio >= GPIO_NUM_MAX) || 
+       (pConfig->click_gap_ms == 0) || (pConfig->hold_ms == 0)){
+
         ESP_LOGI(TAG, "Failed to init controller: invalid params");
         return BUTTON_STATUS_ERROR;
     }
 
-    button_handle_t btn_handle;
-    button_config_t btn_cfg = {0};
-    button_gpio_config_t gpio_cfg = {
-        .gpio_num = pConfig->gpio,
-        .active_level = ((pConfig->active_level == BUTTON_ACTIVE_HIGH) ? 1 : 0),
+    button_info.config = *pConfig;
+    button_info.state = BUTTON_STATE_IDLE;
+    button_info.pressed = false;
+    button_info.debounce_cptr = 0;
+    button_info.nb_click = 0;
+
+    esp_timer_create_args_t timer_args = {
+        .callback = pollTimerCallback,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "button",
+        .skip_unhandled_events = true,
     };
+    if(ESP_OK != esp_timer_create(&timer_args, &button_info.poll_timer_handle)){
+        ESP_LOGI(TAG, "Failed to create poll timer");
+        return BUTTON_STATUS_ERROR;
+    }
 
-    //Init new button
-    if(ESP_OK != iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &btn_handle)){
-        ESP_LOGI(TAG, "Failed to init button");
+    //Level interrupt on the active level, it is disabled while polling
+    gpio_int_type_t intr_type = (pConfig->active_level == BUTTON_ACTIVE_HIGH) ? 
+                                GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL;
+    gpio_config_t gpio_cfg = {
+        .pin_bit_mask = (1ULL << pConfig->gpio),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = (pConfig->active_level == BUTTON_ACTIVE_LOW) ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = (pConfig->active_level == BUTTON_ACTIVE_HIGH) ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+        .intr_type = intr_type,
+    };
+    if(ESP_OK != gpio_config(&gpio_cfg)){
+        ESP_LOGI(TAG, "Failed to config button gpio");
         return BUTTON_STATUS_ERROR;
     }
 
-    //Config callback
-    if(pConfig->shortpress_callback != NULL){
-        if(ESP_OK != iot_button_register_cb(btn_handle, 
-                                            BUTTON_SINGLE_CLICK, 
-                                            NULL, 
-                                            pConfig->shortpress_callback, 
-                                            NULL)){
+    //The service may already be installed by another module
+    esp_err_t ret = gpio_install_isr_service(0);
+    if((ret != ESP_OK) && (ret != ESP_ERR_INVALID_STATE)){
+        ESP_LOGI(TAG, "Failed to install gpio isr service");
+        return BUTTON_STATUS_ERROR;
+    }
 
-            ESP_LOGI(TAG, "Failed to register shortpress callback");
-            return BUTTON_STATUS_ERROR;
-        }
+    if(ESP_OK != gpio_isr_handler_add(pConfig->gpio, buttonIsrHandler, NULL)){
+        ESP_LOGI(TAG, "Failed to add button isr");
+        return BUTTON_STATUS_ERROR;
     }
 
-    if(pConfig->longpress_callback != NULL){
-        button_event_args_t args;
-        args.long_press.press_time = 5 * 1000;
-        if(ESP_OK != iot_button_register_cb(btn_handle, 
-                                            BUTTON_LONG_PRESS_START, 
-                                            &args, 
-                                            pConfig->longpress_callback, 
-                                            NULL)){
-
-            ESP_LOGI(TAG, "Failed to register longpress callback");
-            return BUTTON_STATUS_ERROR;
-        }
+    //Wake up from light sleep on button press
+    if((ESP_OK != gpio_wakeup_enable(pConfig->gpio, intr_type)) || 
+       (ESP_OK != esp_sleep_enable_gpio_wakeup())){
+
+        ESP_LOGI(TAG, "Failed to enable gpio wakeup");
+        return BUTTON_STATUS_ERROR;
     }
 
     return BUTTON_STATUS_OK;
@@ -116,4 +346,22 @@ BUTTON_Ret_t BUTTON_InitController(BUTTON_Config_t const *pConfig){
 
 /******************************************************************************
 *   Interrupts
-*******************************************************************************/
\ No newline at end of file
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Button interrupt handler.
+*
+*   Called when the button reaches its active level. Masks the level
+*   interrupt and starts the gesture polling.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  arg                 Unused
+*
+*******************************************************************************/
+static void IRAM_ATTR buttonIsrHandler(void *arg){
+
+    gpio_intr_disable(button_info.config.gpio);
+    esp_timer_start_periodic(button_info.poll_timer_handle, BUTTON_POLL_PERIOD_MS * 1000);
+}
\ No newline at end of file
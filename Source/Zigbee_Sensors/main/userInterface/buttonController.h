@@ -16,8 +16,16 @@
 /******************************************************************************
 *   Public Data Types
 *******************************************************************************/
-typedef void(*ShortpressCallback_t)(void *args, void *user_data);
-typedef void(*LongpressCallback_t)(void *args, void *user_data);
+typedef enum BUTTON_Gesture_e{
+    BUTTON_GESTURE_SINGLE_CLICK,
+    BUTTON_GESTURE_DOUBLE_CLICK,
+    BUTTON_GESTURE_TRIPLE_CLICK,
+    BUTTON_GESTURE_HOLD,
+
+    BUTTON_GESTURE_INVALID,
+}BUTTON_Gesture_t;
+
+typedef void(*BUTTON_Gesture_Cb_t)(BUTTON_Gesture_t gesture, void *pArg);
 
 typedef enum BUTTON_Active_Level_e{
     BUTTON_ACTIVE_LOW,
@@ -27,8 +35,10 @@ typedef enum BUTTON_Active_Level_e{
 typedef struct BUTTON_Config_s{
     uint8_t gpio;
     BUTTON_Active_Level_t active_level;
-    ShortpressCallback_t shortpress_callback;
-    LongpressCallback_t longpress_callback;
+    uint16_t click_gap_ms;              //Max release time between two clicks
+    uint16_t hold_ms;                   //Press time to report a hold
+    BUTTON_Gesture_Cb_t gesture_callback;
+    void *pArg;                         //Gesture callback argument
 }BUTTON_Config_t;
 
 typedef enum BUTTON_Ret_e{
@@ -53,10 +63,13 @@ typedef enum BUTTON_Ret_e{
 *  \brief Button controller initialization.
 *
 *   This function perform the Button Controller module initialization.
+*   The button is edge driven: a GPIO interrupt (also used as light sleep
+*   wakeup source) starts the gesture polling, which stops once the button
+*   is idle. Gestures are reported from the esp_timer task.
 *   
 *   Preconditions: None.
 *
-*   Side Effects: None.
+*   Side Effects: Installs the GPIO ISR service and enables GPIO wakeup.
 *
 *   \param[in]  pConfig             Pointer to button configuration.
 *
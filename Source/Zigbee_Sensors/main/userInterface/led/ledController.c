@@ -2,6 +2,7 @@
 *   Includes
 *******************************************************************************/
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -12,6 +13,10 @@
 
 #include "ledController.h"
 #include "sequencer.h"
+#include "ledSequence_cfg.h"
+#include "powerManager.h"
+#include "eventLoop.h"
+#include "healthMonitor.h"
 #include "main.h"
 
 /******************************************************************************
@@ -19,32 +24,79 @@
 *******************************************************************************/
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
+#define LED_NB_LED                      (LED_CTRL_ID_INVALID)
+
+#define LED_PRIO_DEFAULT                (0)//Lowest priority, always active
+#define LED_PRIO_NONE                   (0xFF)//Pattern not displayed by the led
+#define LED_PRIO_MAX_NB                 (32)//Priority bitmask width
+
+//Led task notification bits
+#define LED_NOTIFY_TIMEOUT_SHIFT        (16)
+#define LED_NOTIFY_ALL                  (0xFFFFFFFF)
+
+#define LED_SEQ_TASK_STACK_SIZE         (2048)
+#define LED_TASK_STACK_SIZE             (2048)
+
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
+//Led task notification bits, one update and one timeout bit per led
+#define LED_NOTIFY_UPDATE(led_id)       (1UL << (led_id))
+#define LED_NOTIFY_TIMEOUT(led_id)      (1UL << (LED_NOTIFY_TIMEOUT_SHIFT + (led_id)))
+
+#define LED_PRIO_BIT(prio)              (1UL << (prio))
+
+//Highest active priority (mask is never 0, LED_PRIO_DEFAULT is always active)
+#define LED_HIGHEST_PRIO(mask)          ((uint8_t)(31 - __builtin_clz(mask)))
 
 
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
-typedef enum LED_Pattern_Flag_e{
-    LED_FLAG_SCANNING = 0x0001,
-    LED_FLAG_CONNECTED = 0x0002,
-    LED_FLAG_NO_COORDO = 0x0004,
-    LED_FLAG_IDENTIFY = 0x0008,
-}LED_Pattern_Flag_t;
+typedef struct LED_Priority_Entry_s{
+    LED_Pattern_t pattern;//LED_PATTERN_INVALID for the default entry
+    SEQUENCE_t const *pSequence;
+}LED_Priority_Entry_t;
+
+typedef struct LED_Ctrl_Cfg_s{
+    LDRV_CFG_Single_Pwm_Config_t pwm_config;
+    LED_Priority_Entry_t const *pPriority_table;//Lowest to highest priority
+    uint8_t nb_priority;
+}LED_Ctrl_Cfg_t;
+
+typedef struct LED_Ctrl_State_s{
+    LED_Handle_t handle;
+    SEQUENCE_OutputId_t output_id;
+    uint32_t active_mask;//LED_PRIO_BIT() of the active patterns
+    uint8_t applied_prio;//Priority of the sequence being played
+    uint8_t timed_prio;//Priority of the finite sequence being played
+    TickType_t timed_end_tick;//End of the finite sequence being played
+    uint8_t pattern_prio[LED_PATTERN_INVALID];//Pattern to priority lookup
+    TimerHandle_t timer_handle;
+    StaticTimer_t timer_buffer;
+}LED_Ctrl_State_t;
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
+#if EVLOOP_ENABLE
+static void sequencerHandler(void *pArg);
+static void ledHandler(void *pArg);
+#else
 static void tSequencerTask(void *pvParameters);
 static void tLedTask(void *pvParameters);
+#endif
 
-static void redLedTimerCallback(TimerHandle_t xTimer);
-static void greenLedTimerCallback(TimerHandle_t xTimer);
+static void ledTimerCallback(TimerHandle_t xTimer);
+static SEQUENCER_Ret_t setOutputCallback(void *pArg, uint8_t level, uint32_t fade_time_ms);
+static SEQUENCER_Ret_t playCurveCallback(void *pArg, SEQUENCE_Keyframe_t const *pKeyframes, uint8_t nb_keyframe);
 
-static void processRedLedEvent(void);
-static void processGreenLedEvent(void);
+static void processLedEvents(uint32_t notify_bits);
+static void processLedEvent(LED_Ctrl_Id_t led_id, bool timeout);
+
+static void startSequence(SEQUENCE_OutputId_t output_id, const SEQUENCE_t *pSequence);
+static void notifyLedTask(uint32_t notify_bits);
+static void updatePwmLock(LED_Ctrl_Id_t led_id, bool lit);
 
 /******************************************************************************
 *   Public Variables
@@ -54,114 +106,233 @@ static void processGreenLedEvent(void);
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
-//Boot led sequence
-const SEQUENCE_t seq_boot = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(500),
-    .time_on = SEQUENCER_MS_TO_TIC(5000),
-    .time_off = SEQUENCER_MS_TO_TIC(100),
-    .nb_repeat = 0,
+//Red led patterns, from lowest to highest priority
+static const LED_Priority_Entry_t red_priority_table[] = {
+    {.pattern = LED_PATTERN_INVALID,        .pSequence = &seq_always_off},
+    {.pattern = LED_PATTERN_NO_COORDO,      .pSequence = &seq_status},
+    {.pattern = LED_PATTERN_IDENTIFY,       .pSequence = &seq_identify},
+    {.pattern = LED_PATTERN_BOOT,           .pSequence = &seq_boot},
+    {.pattern = LED_PATTERN_FACTORY_RESET,  .pSequence = &seq_factory_reset},
 };
 
-//Identify led sequence
-const SEQUENCE_t seq_identify = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(250),
-    .time_on = SEQUENCER_MS_TO_TIC(500),
-    .time_off = SEQUENCER_MS_TO_TIC(500),
-    .nb_repeat = SEQUENCE_REPEAT_FOREVER,
+//Green led patterns, from lowest to highest priority
+static const LED_Priority_Entry_t green_priority_table[] = {
+    {.pattern = LED_PATTERN_INVALID,        .pSequence = &seq_always_off},
+    {.pattern = LED_PATTERN_CONNECTED,      .pSequence = &seq_status},
+    {.pattern = LED_PATTERN_SCANNING,       .pSequence = &seq_scanning},
+    {.pattern = LED_PATTERN_IDENTIFY,       .pSequence = &seq_identify},
+    {.pattern = LED_PATTERN_BOOT,           .pSequence = &seq_boot},
 };
 
-//Factory reset led sequence
-const SEQUENCE_t seq_factory_reset = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(250),
-    .time_on = SEQUENCER_MS_TO_TIC(500),
-    .time_off = SEQUENCER_MS_TO_TIC(500),
-    .nb_repeat = 5,
+static const LED_Ctrl_Cfg_t led_cfg_table[LED_NB_LED] = {
+    [LED_CTRL_ID_RED] = {
+        .pwm_config = {
+            .active_level = LDRV_CFG_ACTIVE_HIGH,
+            .gpio_num = HWI_RED_LED_GPIO,
+            .led_channel = LEDC_CHANNEL_0,
+            .led_timer = LEDC_TIMER_0,
+        },
+        .pPriority_table = red_priority_table,
+        .nb_priority = sizeof(red_priority_table) / sizeof(red_priority_table[0]),
+    },
+    [LED_CTRL_ID_GREEN] = {
+        .pwm_config = {
+            .active_level = LDRV_CFG_ACTIVE_HIGH,
+            .gpio_num = HWI_GREEN_LED_GPIO,
+            .led_channel = LEDC_CHANNEL_1,
+            .led_timer = LEDC_TIMER_1,
+        },
+        .pPriority_table = green_priority_table,
+        .nb_priority = sizeof(green_priority_table) / sizeof(green_priority_table[0]),
+    },
 };
 
-//Scanning led sequence
-const SEQUENCE_t seq_scanning = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(250),
-    .time_on = SEQUENCER_MS_TO_TIC(500),
-    .time_off = SEQUENCER_MS_TO_TIC(500),
-    .nb_repeat = SEQUENCE_REPEAT_FOREVER,
+static const char * pattern_name[LED_PATTERN_INVALID] = {
+    [LED_PATTERN_BOOT] = "Boot",
+    [LED_PATTERN_FACTORY_RESET] = "Factory Reset",
+    [LED_PATTERN_IDENTIFY] = "Identify",
+    [LED_PATTERN_CONNECTED] = "Connected",
+    [LED_PATTERN_NO_COORDO] = "No-Coordo",
+    [LED_PATTERN_SCANNING] = "Scanning",
 };
 
-//Always ON led sequence
-const SEQUENCE_t seq_always_on = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(250),
-    .time_on = SEQUENCE_ACTIVE_FOREVER,
-    .time_off = 0,
-};
-
-//Always OFF led sequence
-const SEQUENCE_t seq_always_off = {
-    .init_time_off = SEQUENCER_MS_TO_TIC(250),
-    .time_on = 0,
-    .time_off = SEQUENCE_ACTIVE_FOREVER,
-};
+static LED_Ctrl_State_t led_state_table[LED_NB_LED];
 
 static SemaphoreHandle_t led_mutex_handle = NULL;
+static StaticSemaphore_t led_mutex_buffer;
+#if EVLOOP_ENABLE
+static EVLOOP_EventId_t seq_event_id = EVLOOP_EVENT_ID_INVALID;
+static EVLOOP_EventId_t led_event_id = EVLOOP_EVENT_ID_INVALID;
+static EVLOOP_Timer_t seq_timer;//Next sequencer deadline
+static atomic_uint_fast32_t led_notify_mask = 0;//LED_NOTIFY_xxx bits to process
+#else
 static TaskHandle_t seq_task_handle = NULL;
+static StaticTask_t seq_task_buffer;
+static StackType_t seq_task_stack[LED_SEQ_TASK_STACK_SIZE];
 static TaskHandle_t led_task_handle = NULL;
+static StaticTask_t led_task_buffer;
+static StackType_t led_task_stack[LED_TASK_STACK_SIZE];
+#endif
 
-//Red led related variables
-static LED_Handle_t red_led_handle = LED_DRIVER_HANDLE_INVALID;
-static LED_Pattern_Flag_t red_led_flag = 0;
-static LED_Pattern_t red_led_current_pattern = LED_PATTERN_INVALID;
-static LED_Pattern_t red_led_buffered_pattern = LED_PATTERN_INVALID;
-static TimerHandle_t red_led_timer_handle = NULL;
-static SemaphoreHandle_t red_led_semph_handle = NULL;
-
-//Green led related variables
-static LED_Handle_t green_led_handle = LED_DRIVER_HANDLE_INVALID;
-static LED_Pattern_Flag_t green_led_flag = 0;
-static LED_Pattern_t green_led_current_pattern = LED_PATTERN_INVALID;
-static LED_Pattern_t green_led_buffered_pattern = LED_PATTERN_INVALID;
-static TimerHandle_t green_led_timer_handle = NULL;
-static SemaphoreHandle_t green_led_semph_handle = NULL;
+static uint32_t lit_led_mask = 0;//Leds showing a pattern, PWM lock held if not 0
 
 static const char * TAG = "LED";
 
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+_Static_assert(LED_NB_LED <= LDRV_CFG_MAX_NB_LED, "More leds than the led driver can handle");
+_Static_assert(LED_NB_LED <= LED_NOTIFY_TIMEOUT_SHIFT, "Not enough led task notification bits");
+_Static_assert(LED_NB_LED <= SEQUENCER_CFG_MAX_NB_OUTPUT, "Each led needs a sequencer output");
+_Static_assert((SEQUENCE_LEVEL_OFF == LDRV_CFG_MIN_LEVEL) && (SEQUENCE_LEVEL_ON == LDRV_CFG_MAX_LEVEL),
+               "Sequence levels are passed unscaled to the led driver");
+_Static_assert(SEQUENCER_CFG_MAX_CURVE_KEYFRAME <= LDRV_CFG_MAX_FADE_POINT, "Curve longer than the led driver can play");
+_Static_assert(sizeof(red_priority_table) / sizeof(red_priority_table[0]) <= LED_PRIO_MAX_NB, "Too many red led patterns");
+_Static_assert(sizeof(green_priority_table) / sizeof(green_priority_table[0]) <= LED_PRIO_MAX_NB, "Too many green led patterns");
+
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
 /***************************************************************************//*!
-*  \brief Red led timer callback
+*  \brief Led timer callback
+*
+*   This function is called when the finite sequence of a led ends.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  xTimer          timer handle (timer ID is the led ID)
+*
+*******************************************************************************/
+static void ledTimerCallback(TimerHandle_t xTimer){
+
+    LED_Ctrl_Id_t led_id = (LED_Ctrl_Id_t)(uintptr_t)pvTimerGetTimerID(xTimer);
+
+    notifyLedTask(LED_NOTIFY_TIMEOUT(led_id));
+}
+
+/***************************************************************************//*!
+*  \brief Set output callback
+*
+*   This function is called by the sequencer to set the level of a led, 
+*   immediately or with a linear fade.
 *
-*   This function is called after the red led timeout occur.
-*   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  xTimer          timer handle
+*   \param[in]  pArg                Led state.
+*   \param[in]  level               Led level (SEQUENCE_LEVEL_OFF to SEQUENCE_LEVEL_ON).
+*   \param[in]  fade_time_ms        Fade time in ms (0 -> no fade).
+*
+*   \return     Operation status
 *
 *******************************************************************************/
-static void redLedTimerCallback(TimerHandle_t xTimer){
-    xSemaphoreGive(red_led_semph_handle);
+static SEQUENCER_Ret_t setOutputCallback(void *pArg, uint8_t level, uint32_t fade_time_ms){
+
+    const LED_Ctrl_State_t *pState = (const LED_Ctrl_State_t *)pArg;
+
+    if(fade_time_ms == 0){
+        if(LDRV_STATUS_OK != LDRV_SetLedSinglePwmDuty(level, pState->handle)){
+            return SEQUENCER_STATUS_ERROR;
+        }
+    }
+    else{
+        if(LDRV_STATUS_OK != LDRV_FadeLedSinglePwmDuty(level, fade_time_ms, pState->handle)){
+            return SEQUENCER_STATUS_ERROR;
+        }
+    }
+
+    return SEQUENCER_STATUS_OK;
 }
 
 /***************************************************************************//*!
-*  \brief Green led timer callback
+*  \brief Play curve callback
+*
+*   This function is called by the sequencer to play consecutive linear 
+*   keyframes as a single led fade curve.
 *
-*   This function is called after the green led timeout occur.
-*   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  xTimer          timer handle
+*   \param[in]  pArg                Led state.
+*   \param[in]  pKeyframes          Keyframes to play (linear, finite duration).
+*   \param[in]  nb_keyframe         Number of keyframes.
+*
+*   \return     Operation status (error if the curve can't be played)
 *
 *******************************************************************************/
-static void greenLedTimerCallback(TimerHandle_t xTimer){
-    xSemaphoreGive(green_led_semph_handle);
+static SEQUENCER_Ret_t playCurveCallback(void *pArg, SEQUENCE_Keyframe_t const *pKeyframes, uint8_t nb_keyframe){
+
+    const LED_Ctrl_State_t *pState = (const LED_Ctrl_State_t *)pArg;
+    LDRV_CFG_Fade_Point_t curve[SEQUENCER_CFG_MAX_CURVE_KEYFRAME];
+
+    if(nb_keyframe > SEQUENCER_CFG_MAX_CURVE_KEYFRAME){
+        return SEQUENCER_STATUS_ERROR;
+    }
+
+    for(uint8_t i=0; i<nb_keyframe; i++){
+        curve[i].level = pKeyframes[i].level;
+        curve[i].time_ms = pKeyframes[i].duration_ms;
+    }
+
+    if(LDRV_STATUS_OK != LDRV_PlayFadeCurve(curve, nb_keyframe, pState->handle)){
+        return SEQUENCER_STATUS_ERROR;
+    }
+
+    return SEQUENCER_STATUS_OK;
 }
 
+#if EVLOOP_ENABLE
+/***************************************************************************//*!
+*  \brief Sequencer handler
+*
+*   This function runs the sequencer from the event loop, when a sequence is
+*   posted or when its next deadline expires, and re-arms the deadline timer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void sequencerHandler(void *pArg){
+
+    uint32_t next_deadline = SEQUENCER_Process();
+
+    if(next_deadline == SEQUENCER_NO_DEADLINE){
+        EVLOOP_StopTimer(&seq_timer);
+    }
+    else{
+        EVLOOP_StartTimer(&seq_timer, next_deadline * SEQUENCER_TIC_PERIOD_MS);
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Led handler
+*
+*   This function processes the led events from the event loop.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void ledHandler(void *pArg){
+
+    processLedEvents((uint32_t)atomic_exchange(&led_notify_mask, 0));
+}
+#else
 /***************************************************************************//*!
 *  \brief Sequencer task
 *
 *   This function is the sequencer task.
-*   
+*
 *   Preconditions: None.
 *
 *   Side Effects: None.
@@ -171,11 +342,22 @@ static void greenLedTimerCallback(TimerHandle_t xTimer){
 *******************************************************************************/
 static void tSequencerTask(void *pvParameters){
 
+    uint32_t next_deadline = SEQUENCER_NO_DEADLINE;
+    TickType_t wait_ticks = portMAX_DELAY;
+
     ESP_LOGI(TAG, "Starting Sequencer task");
 
     for(;;){
-        vTaskDelay(SEQUENCER_TIC_PERIOD_MS/portTICK_PERIOD_MS);
-        SEQUENCER_Tic();
+        next_deadline = SEQUENCER_Process();
+
+        //Sleep until the next edge, or until a new sequence is started
+        if(next_deadline == SEQUENCER_NO_DEADLINE){
+            wait_ticks = portMAX_DELAY;
+        }
+        else{
+            wait_ticks = pdMS_TO_TICKS(next_deadline * SEQUENCER_TIC_PERIOD_MS);
+        }
+        ulTaskNotifyTake(pdTRUE, wait_ticks);
     }
     vTaskDelete(NULL);
 }
@@ -184,7 +366,7 @@ static void tSequencerTask(void *pvParameters){
 *  \brief Led task
 *
 *   This function is the Led task. It managed all led patterns and transitions.
-*   
+*
 *   Preconditions: None.
 *
 *   Side Effects: None.
@@ -194,186 +376,193 @@ static void tSequencerTask(void *pvParameters){
 *******************************************************************************/
 static void tLedTask(void *pvParameters){
 
+    uint32_t notify_bits = 0;
+
     ESP_LOGI(TAG, "Starting Leds task");
 
     for(;;){
-        
-        //Check if there is red led event to process
-        if(pdPASS == xSemaphoreTake(red_led_semph_handle, 0)){
-            processRedLedEvent();
-        }
-
-        //Check if there is green led event to process
-        if(pdPASS == xSemaphoreTake(green_led_semph_handle, 0)){
-            processGreenLedEvent();
-        }
 
-        vTaskDelay(10/portTICK_PERIOD_MS);
+        //Wait for led events
+        xTaskNotifyWait(0, LED_NOTIFY_ALL, &notify_bits, portMAX_DELAY);
+        processLedEvents(notify_bits);
     }
     vTaskDelete(NULL);
 }
+#endif
 
 /***************************************************************************//*!
-*  \brief Process red led event
+*  \brief Process led events
 *
-*   This function is used to process red led events.
-*   
-*   Preconditions: None.
+*   This function processes the led events notified to the led task.
+*
+*   Preconditions: Called from the led task (or the event loop).
 *
 *   Side Effects: None.
 *
+*   \param[in]  notify_bits         Led events (LED_NOTIFY_xxx).
+*
 *******************************************************************************/
-static void processRedLedEvent(void){
+static void processLedEvents(uint32_t notify_bits){
 
-    LED_Pattern_t pattern = LED_PATTERN_INVALID;
-    static LED_Pattern_Flag_t prev_flag = 0;
+    for(uint8_t led_id=0; led_id<LED_NB_LED; led_id++){
 
-    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-    pattern = red_led_current_pattern;
-    xSemaphoreGive(led_mutex_handle);
-
-    switch(pattern){
-        case LED_PATTERN_BOOT:
-        {
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_current_pattern = LED_PATTERN_INVALID;
-            xSemaphoreGive(led_mutex_handle);
-
-            //Start sequence
-            prev_flag = 0;
-            SEQUENCER_DoSequence(SEQUENCE_ID_RED_LED, &seq_boot);
-
-            //Schedule led update after the sequence
-            xTimerStop(red_led_timer_handle, 10/portTICK_PERIOD_MS);
-            xTimerChangePeriod(red_led_timer_handle, (5000+500)/portTICK_PERIOD_MS, 10/portTICK_PERIOD_MS);
-            xTimerStart(red_led_timer_handle, 10/portTICK_PERIOD_MS);
-        }
-        break;
-
-        case LED_PATTERN_FACTORY_RESET:
-        {
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_current_pattern = LED_PATTERN_INVALID;
-            xSemaphoreGive(led_mutex_handle);
-
-            //Start sequence
-            prev_flag = 0;
-            SEQUENCER_DoSequence(SEQUENCE_ID_RED_LED, &seq_factory_reset);
-
-            //Schedule led update after the sequence
-            xTimerStop(red_led_timer_handle, 10/portTICK_PERIOD_MS);
-            xTimerChangePeriod(red_led_timer_handle, (5000+500)/portTICK_PERIOD_MS, 10/portTICK_PERIOD_MS);
-            xTimerStart(red_led_timer_handle, 10/portTICK_PERIOD_MS);
+        if((notify_bits & (LED_NOTIFY_UPDATE(led_id) | LED_NOTIFY_TIMEOUT(led_id))) != 0){
+            processLedEvent(led_id, ((notify_bits & LED_NOTIFY_TIMEOUT(led_id)) != 0));
         }
-        break;
+    }
+}
 
-        case LED_PATTERN_INVALID:
-        default:
-        {
-            LED_Pattern_Flag_t led_flag = 0;
+/***************************************************************************//*!
+*  \brief Start sequence
+*
+*   This function posts a sequence to the sequencer and wakes the sequencer
+*   task up so it starts it and recomputes its next deadline.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  output_id           Sequence Output ID.
+*   \param[in]  pSequence           Pointer to sequence to apply.
+*
+*******************************************************************************/
+static void startSequence(SEQUENCE_OutputId_t output_id, const SEQUENCE_t *pSequence){
 
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_buffered_pattern = LED_PATTERN_INVALID;
-            led_flag = red_led_flag;
-            xSemaphoreGive(led_mutex_handle);
+    SEQUENCER_DoSequence(output_id, pSequence);
 
-            if((led_flag & LED_FLAG_IDENTIFY) == LED_FLAG_IDENTIFY){
+#if EVLOOP_ENABLE
+    EVLOOP_PostEvent(seq_event_id);
+#else
+    xTaskNotifyGive(seq_task_handle);
+#endif
+}
 
-                if((prev_flag & LED_FLAG_IDENTIFY) != LED_FLAG_IDENTIFY){
-                    prev_flag = LED_FLAG_IDENTIFY;
-                    SEQUENCER_DoSequence(SEQUENCE_ID_RED_LED, &seq_identify);
-                }
-            }
-            else if((led_flag & LED_FLAG_NO_COORDO) == LED_FLAG_NO_COORDO){
+/***************************************************************************//*!
+*  \brief Notify led task
+*
+*   This function sets led event bits of the led task notification.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  notify_bits         Led events to notify (LED_NOTIFY_xxx).
+*
+*******************************************************************************/
+static void notifyLedTask(uint32_t notify_bits){
+
+#if EVLOOP_ENABLE
+    atomic_fetch_or(&led_notify_mask, notify_bits);
+    EVLOOP_PostEvent(led_event_id);
+#else
+    if(led_task_handle != NULL){
+        xTaskNotify(led_task_handle, notify_bits, eSetBits);
+    }
+#endif
+}
 
-                if((prev_flag & LED_FLAG_NO_COORDO) != LED_FLAG_NO_COORDO){
-                    prev_flag = LED_FLAG_NO_COORDO;
-                    SEQUENCER_DoSequence(SEQUENCE_ID_RED_LED, &seq_always_on);
-                }
-            }
-            else{
-                prev_flag = 0;
-                SEQUENCER_DoSequence(SEQUENCE_ID_RED_LED, &seq_always_off);
-            }
-        }
-        break;
+/***************************************************************************//*!
+*  \brief Update PWM lock
+*
+*   This function holds the PWM power management lock while at least one
+*   led shows a pattern, LEDC stops in light sleep.
+*
+*   Preconditions: Called from the led task (or the event loop).
+*
+*   Side Effects: None.
+*
+*   \param[in]  led_id              Led ID.
+*   \param[in]  lit                 Led shows a pattern (not the default one).
+*
+*******************************************************************************/
+static void updatePwmLock(LED_Ctrl_Id_t led_id, bool lit){
+
+    uint32_t prev_mask = lit_led_mask;
+
+    if(lit){
+        lit_led_mask |= (1UL << led_id);
+    }
+    else{
+        lit_led_mask &= ~(1UL << led_id);
+    }
+
+    if((prev_mask == 0) && (lit_led_mask != 0)){
+        PWR_AcquireLock(PWR_LOCK_LED_PWM);
+    }
+    else if((prev_mask != 0) && (lit_led_mask == 0)){
+        PWR_ReleaseLock(PWR_LOCK_LED_PWM);
     }
 }
 
 /***************************************************************************//*!
-*  \brief Process green led event
+*  \brief Process led event
+*
+*   This function applies the highest priority active pattern of a led. A
+*   finite pattern (boot, factory reset, ...) is removed when its timer
+*   expires or when a higher priority pattern preempts it, it is never
+*   resumed.
 *
-*   This function is used to process green led events.
-*   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
+*   \param[in]  led_id              Led ID.
+*   \param[in]  timeout             Led finite pattern timer expired.
+*
 *******************************************************************************/
-static void processGreenLedEvent(void){
+static void processLedEvent(LED_Ctrl_Id_t led_id, bool timeout){
 
-    LED_Pattern_t pattern = LED_PATTERN_INVALID;
-    static LED_Pattern_Flag_t prev_flag = 0;
+    LED_Ctrl_State_t *pState = &led_state_table[led_id];
+    const LED_Ctrl_Cfg_t *pCfg = &led_cfg_table[led_id];
+    const SEQUENCE_t *pSequence = NULL;
+    bool timed = false;
 
     xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-    pattern = green_led_current_pattern;
-    xSemaphoreGive(led_mutex_handle);
 
-    switch(pattern){
-        case LED_PATTERN_BOOT:
-        {
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_current_pattern = LED_PATTERN_INVALID;
-            xSemaphoreGive(led_mutex_handle);
-
-            //Start sequence
-            prev_flag = 0;
-            SEQUENCER_DoSequence(SEQUENCE_ID_GREEN_LED, &seq_boot);
-
-            //Schedule led update after the sequence
-            xTimerStop(green_led_timer_handle, 10/portTICK_PERIOD_MS);
-            xTimerChangePeriod(green_led_timer_handle, (5000+500)/portTICK_PERIOD_MS, 10/portTICK_PERIOD_MS);
-            xTimerStart(green_led_timer_handle, 10/portTICK_PERIOD_MS);
+    //Finite pattern is over (ignore a late timeout of a restarted sequence)
+    if(timeout &&
+       (pState->timed_prio != LED_PRIO_NONE) &&
+       ((int32_t)(xTaskGetTickCount() - pState->timed_end_tick) >= 0)){
+
+        pState->active_mask &= ~LED_PRIO_BIT(pState->timed_prio);
+        pState->timed_prio = LED_PRIO_NONE;
+    }
+
+    uint8_t prio = LED_HIGHEST_PRIO(pState->active_mask);
+
+    if(prio != pState->applied_prio){
+
+        //A preempted finite pattern is dropped
+        if((pState->timed_prio != LED_PRIO_NONE) && (pState->timed_prio != prio)){
+            pState->active_mask &= ~LED_PRIO_BIT(pState->timed_prio);
+            pState->timed_prio = LED_PRIO_NONE;
         }
-        break;
 
-        case LED_PATTERN_INVALID:
-        default:
-        {
-            LED_Pattern_Flag_t led_flag = 0;
+        pSequence = pCfg->pPriority_table[prio].pSequence;
+        timed = (pSequence->duration_ms != SEQUENCE_ACTIVE_FOREVER);
 
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_buffered_pattern = LED_PATTERN_INVALID;
-            led_flag = green_led_flag;
-            xSemaphoreGive(led_mutex_handle);
+        pState->applied_prio = prio;
+        if(timed){
+            pState->timed_prio = prio;
+            pState->timed_end_tick = xTaskGetTickCount() + (pSequence->duration_ms/portTICK_PERIOD_MS);
+        }
+    }
 
-            if((led_flag & LED_FLAG_IDENTIFY) == LED_FLAG_IDENTIFY){
+    xSemaphoreGive(led_mutex_handle);
 
-                if((prev_flag & LED_FLAG_IDENTIFY) != LED_FLAG_IDENTIFY){
-                    prev_flag = LED_FLAG_IDENTIFY;
-                    SEQUENCER_DoSequence(SEQUENCE_ID_GREEN_LED, &seq_identify);
-                }
-            }
-            else if((led_flag & LED_FLAG_SCANNING) == LED_FLAG_SCANNING){
+    if(pSequence != NULL){
 
-                if((prev_flag & LED_FLAG_SCANNING) != LED_FLAG_SCANNING){
-                    prev_flag = LED_FLAG_SCANNING;
-                    SEQUENCER_DoSequence(SEQUENCE_ID_GREEN_LED, &seq_scanning);
-                }
-            }
-            else if((led_flag & LED_FLAG_CONNECTED) == LED_FLAG_CONNECTED){
+        updatePwmLock(led_id, (prio != LED_PRIO_DEFAULT));
 
-                if((prev_flag & LED_FLAG_CONNECTED) != LED_FLAG_CONNECTED){
-                    prev_flag = LED_FLAG_CONNECTED;
-                    SEQUENCER_DoSequence(SEQUENCE_ID_GREEN_LED, &seq_always_on);
-                }
-            }
-            else{
-                prev_flag = 0;
-                SEQUENCER_DoSequence(SEQUENCE_ID_GREEN_LED, &seq_always_off);
-            }
+        xTimerStop(pState->timer_handle, 10/portTICK_PERIOD_MS);
+
+        startSequence(pState->output_id, pSequence);
+
+        //Schedule led update after a finite sequence
+        if(timed){
+            xTimerChangePeriod(pState->timer_handle, pSequence->duration_ms/portTICK_PERIOD_MS, 10/portTICK_PERIOD_MS);
+            xTimerStart(pState->timer_handle, 10/portTICK_PERIOD_MS);
         }
-        break;
     }
 }
 
@@ -388,116 +577,125 @@ static void processGreenLedEvent(void){
 *   Preconditions: None.
 *
 *   Side Effects: None.
-*   
+*
 *   \return operation status
 *
 *******************************************************************************/
 LED_Ret_t LED_InitController(void){
-    
+
     ESP_LOGI(TAG, "LED controller initialization");
 
     //Create led mutex
-    led_mutex_handle = xSemaphoreCreateMutex();
+    led_mutex_handle = xSemaphoreCreateMutexStatic(&led_mutex_buffer);
     if(led_mutex_handle == NULL){
         ESP_LOGI(TAG, "Failed to create led mutex");
         return LED_STATUS_ERROR;
     }
 
-    //create leds binary semaphores
-    red_led_semph_handle = xSemaphoreCreateBinary();
-    if(red_led_semph_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create red led semaphore");
+    //init led driver
+    if(LDRV_STATUS_OK != LDRV_InitDriver()){
+        ESP_LOGI(TAG, "Failed to init led driver");
         return LED_STATUS_ERROR;
     }
 
-    green_led_semph_handle = xSemaphoreCreateBinary();
-    if(green_led_semph_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create green led semaphore");
-        return LED_STATUS_ERROR;
-    }
+    for(uint8_t led_id=0; led_id<LED_NB_LED; led_id++){
 
-    //create leds timers
-    red_led_timer_handle = xTimerCreate("Red Led timer",
-                                        1000/portTICK_PERIOD_MS,
-                                        pdFALSE,
-                                        (void*)0,
-                                        redLedTimerCallback);
+        LED_Ctrl_State_t *pState = &led_state_table[led_id];
+        const LED_Ctrl_Cfg_t *pCfg = &led_cfg_table[led_id];
 
-    if(red_led_timer_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create red led timer");
-        return LED_STATUS_ERROR;
-    }
+        //create led timer
+        pState->timer_handle = xTimerCreateStatic("Led timer",
+                                                  1000/portTICK_PERIOD_MS,
+                                                  pdFALSE,
+                                                  (void*)(uintptr_t)led_id,
+                                                  ledTimerCallback,
+                                                  &pState->timer_buffer);
 
-    green_led_timer_handle = xTimerCreate("Green Led timer",
-                                          1000/portTICK_PERIOD_MS,
-                                          pdFALSE,
-                                          (void*)0,
-                                          greenLedTimerCallback);
+        if(pState->timer_handle == NULL){
+            ESP_LOGI(TAG, "Failed to create led %d timer", led_id);
+            return LED_STATUS_ERROR;
+        }
 
-    if(green_led_timer_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create green led timer");
-        return LED_STATUS_ERROR;
-    }
+        //add led to the driver
+        if(LDRV_STATUS_OK != LDRV_AddLedSinglePwm(pCfg->pwm_config, &pState->handle)){
+            ESP_LOGI(TAG, "Failed to add led %d", led_id);
+            return LED_STATUS_ERROR;
+        }
 
-    //init led driver and add leds
-    if(LDRV_STATUS_OK != LDRV_InitDriver()){
-        ESP_LOGI(TAG, "Failed to init led driver");
-        return LED_STATUS_ERROR;
-    }
+        //drive the led from a sequencer output
+        SEQUENCE_Output_t output = {
+            .set_output_cb = setOutputCallback,
+            .play_curve_cb = playCurveCallback,
+            .pArg = pState,
+        };
 
-    LDRV_CFG_Single_Pwm_Config_t red_led_cfg = {
-        .active_level = LDRV_CFG_ACTIVE_HIGH,
-        .gpio_num = HWI_RED_LED_GPIO,
-        .led_channel = LEDC_CHANNEL_0,
-        .led_timer = LEDC_TIMER_0,
-    };
-    if(LDRV_STATUS_OK != LDRV_AddLedSinglePwm(red_led_cfg, &red_led_handle)){
-        ESP_LOGI(TAG, "Failed to add red led");
-        return LED_STATUS_ERROR;
+        if(SEQUENCER_STATUS_OK != SEQUENCER_RegisterOutput(&output, &pState->output_id)){
+            ESP_LOGI(TAG, "Failed to register led %d sequencer output", led_id);
+            return LED_STATUS_ERROR;
+        }
+
+        //Build pattern to priority lookup
+        for(uint8_t pattern=0; pattern<LED_PATTERN_INVALID; pattern++){
+            pState->pattern_prio[pattern] = LED_PRIO_NONE;
+        }
+
+        for(uint8_t prio=0; prio<pCfg->nb_priority; prio++){
+            if(pCfg->pPriority_table[prio].pattern < LED_PATTERN_INVALID){
+                pState->pattern_prio[pCfg->pPriority_table[prio].pattern] = prio;
+            }
+        }
+
+        pState->active_mask = LED_PRIO_BIT(LED_PRIO_DEFAULT);
+        pState->applied_prio = LED_PRIO_NONE;
+        pState->timed_prio = LED_PRIO_NONE;
     }
 
-    LDRV_CFG_Single_Pwm_Config_t green_led_cfg = {
-        .active_level = LDRV_CFG_ACTIVE_HIGH,
-        .gpio_num = HWI_GREEN_LED_GPIO,
-        .led_channel = LEDC_CHANNEL_1,
-        .led_timer = LEDC_TIMER_1,
-    };
-    if(LDRV_STATUS_OK != LDRV_AddLedSinglePwm(green_led_cfg, &green_led_handle)){
-        ESP_LOGI(TAG, "Failed to add green led");
+    //Fade service must be started after all leds are added
+    if(LDRV_STATUS_OK != LDRV_StartFadeService()){
+        ESP_LOGI(TAG, "Failed to start led fade service");
         return LED_STATUS_ERROR;
     }
 
-    red_led_current_pattern = LED_PATTERN_INVALID;
-    red_led_buffered_pattern = LED_PATTERN_INVALID;
-    red_led_flag = 0;
-
-    green_led_current_pattern = LED_PATTERN_INVALID;
-    green_led_buffered_pattern = LED_PATTERN_INVALID;
-    green_led_flag = 0;
+#if EVLOOP_ENABLE
+    //Run the sequencer and the leds from the event loop
+    EVLOOP_InitTimer(&seq_timer, sequencerHandler, NULL);
+    if((EVLOOP_STATUS_OK != EVLOOP_RegisterEvent(sequencerHandler, NULL, &seq_event_id)) ||
+       (EVLOOP_STATUS_OK != EVLOOP_RegisterEvent(ledHandler, NULL, &led_event_id))){
 
+        ESP_LOGI(TAG, "Failed to register led events");
+        return LED_STATUS_ERROR;
+    }
+#else
     //create sequencer task
-    if(pdTRUE != xTaskCreate(tSequencerTask,
-                             "Seq Task",
-                             2048,
-                             NULL,
-                             5,
-                             &seq_task_handle)){
-        
+    seq_task_handle = xTaskCreateStatic(tSequencerTask,
+                                        "Seq Task",
+                                        LED_SEQ_TASK_STACK_SIZE,
+                                        NULL,
+                                        5,
+                                        seq_task_stack,
+                                        &seq_task_buffer);
+    if(seq_task_handle == NULL){
+
         ESP_LOGI(TAG, "Failed to create sequencer task");
         return LED_STATUS_ERROR;
     }
+    HEALTH_RegisterTask(HEALTH_TASK_SEQUENCER, seq_task_handle, LED_SEQ_TASK_STACK_SIZE);
 
     //create leds task
-    if(pdTRUE != xTaskCreate(tLedTask,
-                             "Led task",
-                             2048,
-                             NULL,
-                             6,
-                             &led_task_handle)){
+    led_task_handle = xTaskCreateStatic(tLedTask,
+                                        "Led task",
+                                        LED_TASK_STACK_SIZE,
+                                        NULL,
+                                        6,
+                                        led_task_stack,
+                                        &led_task_buffer);
+    if(led_task_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create leds task");
         return LED_STATUS_ERROR;
     }
+    HEALTH_RegisterTask(HEALTH_TASK_LED, led_task_handle, LED_TASK_STACK_SIZE);
+#endif
 
     return LED_STATUS_OK;
 }
@@ -505,13 +703,14 @@ LED_Ret_t LED_InitController(void){
 /***************************************************************************/ /*!
 *  \brief Start Led pattern
 *
-*   Function used to start a Led pattern.
+*   Function used to start a Led pattern. Each led displays its highest
+*   priority active pattern. Starting a finite pattern again restarts it.
 *
 *   Preconditions: None.
 *
 *   Side Effects: None.
-*   
-*   \param[in]  pattern         Led pattern to start   
+*
+*   \param[in]  pattern         Led pattern to start
 *
 *   \return operation status
 *
@@ -522,135 +721,35 @@ LED_Ret_t LED_StartPattern(LED_Pattern_t pattern){
         return LED_STATUS_ERROR;
     }
 
-    switch(pattern){
-
-        case LED_PATTERN_BOOT:
-        {
-            ESP_LOGI(TAG, "Starting Boot pattern");
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_current_pattern = LED_PATTERN_BOOT;
-            red_led_buffered_pattern = LED_PATTERN_BOOT;
-
-            green_led_current_pattern = LED_PATTERN_BOOT;
-            green_led_buffered_pattern = LED_PATTERN_BOOT;
-            xSemaphoreGive(led_mutex_handle);
+    ESP_LOGI(TAG, "Starting %s pattern", pattern_name[pattern]);
 
-            //Stop any running timer
-            xTimerStop(red_led_timer_handle, 10/portTICK_PERIOD_MS);
-            xTimerStop(green_led_timer_handle, 10/portTICK_PERIOD_MS);
+    uint32_t notify_bits = 0;
 
-            //Notify the task to apply new pattern
-            xSemaphoreGive(red_led_semph_handle);
-            xSemaphoreGive(green_led_semph_handle);
-        }
-        break;
-
-        case LED_PATTERN_FACTORY_RESET:
-        {
-            ESP_LOGI(TAG, "Starting Factory Reset pattern");
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_current_pattern = LED_PATTERN_FACTORY_RESET;
-            red_led_buffered_pattern = LED_PATTERN_FACTORY_RESET;
-            xSemaphoreGive(led_mutex_handle);
-
-            //Stop any running timer
-            xTimerStop(red_led_timer_handle, 10/portTICK_PERIOD_MS);
-
-            //Notify the task to apply new pattern
-            xSemaphoreGive(red_led_semph_handle);
-        }
-        break;
-
-        case LED_PATTERN_IDENTIFY:
-        {
-            ESP_LOGI(TAG, "Starting Identify pattern");
-
-            LED_Pattern_t red_buffered_pattern = LED_PATTERN_INVALID;
-            LED_Pattern_t green_buffered_pattern = LED_PATTERN_INVALID;
-
-            xSemaphoreTake(led_mutex_handle, portTICK_PERIOD_MS);
-            red_led_flag |= LED_FLAG_IDENTIFY;
-            red_buffered_pattern = red_led_buffered_pattern;
+    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
 
-            green_led_flag |= LED_FLAG_IDENTIFY;
-            green_buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
+    for(uint8_t led_id=0; led_id<LED_NB_LED; led_id++){
 
-            if(red_buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(red_led_semph_handle);
-            }
+        LED_Ctrl_State_t *pState = &led_state_table[led_id];
+        uint8_t prio = pState->pattern_prio[pattern];
 
-            if(green_buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
+        if(prio == LED_PRIO_NONE){
+            continue;
         }
-        break;
 
-        case LED_PATTERN_CONNECTED:
-        {
-            ESP_LOGI(TAG, "Starting Connected pattern");
+        pState->active_mask |= LED_PRIO_BIT(prio);
 
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_flag |= LED_FLAG_CONNECTED;
-            buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
-
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
+        //Force a finite pattern to play again
+        if(prio == pState->timed_prio){
+            pState->applied_prio = LED_PRIO_NONE;
         }
-        break;
-
-        case LED_PATTERN_NO_COORDO:
-        {
-            ESP_LOGI(TAG, "Starting No-Coordo pattern");
-
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_flag |= LED_FLAG_NO_COORDO;
-            buffered_pattern = red_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
-        
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(red_led_semph_handle);
-            }
-        }
-        break;
 
-        case LED_PATTERN_SCANNING:
-        {
-            ESP_LOGI(TAG, "Starting Scanning pattern");
-
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
+        notify_bits |= LED_NOTIFY_UPDATE(led_id);
+    }
 
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_flag |= LED_FLAG_SCANNING;
-            buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
+    xSemaphoreGive(led_mutex_handle);
 
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
-        }
-        break;
-
-        case LED_PATTERN_INVALID:
-        default:
-        {
-            ESP_LOGI(TAG, "Starting Invalid pattern");
-        }
-        break;
-    }
+    //Notify the task to apply new pattern
+    notifyLedTask(notify_bits);
 
     return LED_STATUS_OK;
 }
@@ -663,8 +762,8 @@ LED_Ret_t LED_StartPattern(LED_Pattern_t pattern){
 *   Preconditions: None.
 *
 *   Side Effects: None.
-*   
-*   \param[in]  pattern         Led pattern to stop  
+*
+*   \param[in]  pattern         Led pattern to stop
 *
 *   \return operation status
 *
@@ -675,96 +774,29 @@ LED_Ret_t LED_StopPattern(LED_Pattern_t pattern){
         return LED_STATUS_ERROR;
     }
 
-    switch(pattern){
-
-        case LED_PATTERN_IDENTIFY:
-        {
-            ESP_LOGI(TAG, "Stopping Identify pattern");
+    ESP_LOGI(TAG, "Stopping %s pattern", pattern_name[pattern]);
 
-            LED_Pattern_t red_buffered_pattern = LED_PATTERN_INVALID;
-            LED_Pattern_t green_buffered_pattern = LED_PATTERN_INVALID;
+    uint32_t notify_bits = 0;
 
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_flag &= ~LED_FLAG_IDENTIFY;
-            red_buffered_pattern = red_led_buffered_pattern;
-
-            green_led_flag &= ~LED_FLAG_IDENTIFY;
-            green_buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
-
-            if(red_buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(red_led_semph_handle);
-            }
-
-            if(green_buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
-        }
-        break;
-
-        case LED_PATTERN_CONNECTED:
-        {
-            ESP_LOGI(TAG, "Stopping Connected pattern");
-
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_flag &= ~LED_FLAG_CONNECTED;
-            buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
-
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
-        }
-        break;
-
-        case LED_PATTERN_NO_COORDO:
-        {
-            ESP_LOGI(TAG, "Stopping No-Coordo pattern");
+    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
 
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
+    for(uint8_t led_id=0; led_id<LED_NB_LED; led_id++){
 
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            red_led_flag &= ~LED_FLAG_NO_COORDO;
-            buffered_pattern = red_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
+        LED_Ctrl_State_t *pState = &led_state_table[led_id];
+        uint8_t prio = pState->pattern_prio[pattern];
 
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(red_led_semph_handle);
-            }
+        if((prio == LED_PRIO_NONE) || (prio == LED_PRIO_DEFAULT)){
+            continue;
         }
-        break;
 
-        case LED_PATTERN_SCANNING:
-        {
-            ESP_LOGI(TAG, "Stopping Scanning pattern");
-
-            LED_Pattern_t buffered_pattern = LED_PATTERN_INVALID;
-
-            xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-            green_led_flag &= ~LED_FLAG_SCANNING;
-            buffered_pattern = green_led_buffered_pattern;
-            xSemaphoreGive(led_mutex_handle);
+        pState->active_mask &= ~LED_PRIO_BIT(prio);
+        notify_bits |= LED_NOTIFY_UPDATE(led_id);
+    }
 
-            if(buffered_pattern == LED_PATTERN_INVALID){
-                //Re-apply invalid pattern
-                xSemaphoreGive(green_led_semph_handle);
-            }
-        }
-        break;
+    xSemaphoreGive(led_mutex_handle);
 
-        case LED_PATTERN_INVALID:
-        default:
-        {
-            ESP_LOGI(TAG, "Stopping Invalid pattern");
-        }
-        break;
-    }
+    //Notify the task to re-apply the remaining patterns
+    notifyLedTask(notify_bits);
 
     return LED_STATUS_OK;
 }
@@ -791,33 +823,12 @@ LED_Ret_t LED_GetLedHandle(LED_Ctrl_Id_t led_id, LED_Handle_t *pHandle){
         return LED_STATUS_ERROR;
     }
 
-    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
-    
-    switch(led_id){
-        case LED_CTRL_ID_RED:
-        {
-            *pHandle = red_led_handle;
-        }
-        break;
-
-        case LED_CTRL_ID_GREEN:
-        {
-            *pHandle = green_led_handle;
-        }
-        break;
-
-        default:
-        {
-            //Do nothing...
-        }
-        break;
-    }
-    
-    xSemaphoreGive(led_mutex_handle);
+    //Handles are only written during initialization, no lock needed
+    *pHandle = led_state_table[led_id].handle;
 
     return LED_STATUS_OK;
 }
 
 /******************************************************************************
 *   Interrupts
-*******************************************************************************/
\ No newline at end of file
+*******************************************************************************/
@@ -2,16 +2,20 @@
 *   Includes
 *******************************************************************************/
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
 #include "ledDriver.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define NO_AVAILABLE_INDEX                  (0xFF)
+#define LDRV_ALL_LED_MASK                   ((uint32_t)(((uint64_t)1 << LDRV_CFG_MAX_NB_LED) - 1))
 
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
+#define LDRV_LED_BIT(index)                 (1UL << (index))
 
 
 /******************************************************************************
@@ -19,19 +23,20 @@
 *******************************************************************************/
 typedef struct LDRV_LED_Info_s{
     LDRV_Led_Type_t led_type;
-    bool active_flag;
     union {
         LDRV_CFG_Single_Config_t single_config;
         LDRV_CFG_Single_Pwm_Config_t single_pwm_config;
         LDRV_CFG_Rgb_Config_t rgb_config;
+        LDRV_CFG_Addressable_Config_t addressable_config;
     }config;
 }LDRV_LED_Info_t;
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-static bool isTableFull(void);
 static uint8_t getFirstAvailableIndex(void);
+static void publishLed(uint8_t index);
+static const LDRV_LED_Info_t * getLedInfo(LED_Handle_t led_handle);
 
 /******************************************************************************
 *   Public Variables
@@ -43,58 +48,86 @@ static uint8_t getFirstAvailableIndex(void);
 *******************************************************************************/
 static LDRV_LED_Info_t led_table[LDRV_CFG_MAX_NB_LED];
 
+//LDRV_LED_BIT() of the registered leds. A led info is written once before its
+//bit is set and never modified after, so it can be read without the mutex.
+static atomic_uint_fast32_t active_mask = 0;
+
 /******************************************************************************
 *   Error Check
 *******************************************************************************/
+_Static_assert(LDRV_CFG_MAX_NB_LED <= 32, "Led bitmap is limited to 32 leds");
 
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
 /***************************************************************************//*!
-*  \brief Is led table full
+*  \brief Get first available index
 *
-*   This function return True if the led table is full. Else it return False.
+*   This function return the first available index in the led table.
 *   
-*   Preconditions: None.
+*   Preconditions: Mutex is taken.
 *
 *   Side Effects: None.
 *
-*   \return     (True -> Table full / False -> Table not full)
+*   \return     Available index (NO_AVAILABLE_INDEX if table is full)
 *
 *******************************************************************************/
-static bool isTableFull(void){
+static uint8_t getFirstAvailableIndex(void){
+
+    uint32_t free_mask = ~(uint32_t)atomic_load_explicit(&active_mask, memory_order_relaxed) & LDRV_ALL_LED_MASK;
 
-    uint8_t index = 0;
-    for(index = 0; index<LDRV_CFG_MAX_NB_LED; index++){
-        if(led_table[index].active_flag == false)   break;
+    if(free_mask == 0){
+        return NO_AVAILABLE_INDEX;
     }
 
-    return (index >= LDRV_CFG_MAX_NB_LED);
+    return (uint8_t)__builtin_ctz(free_mask);
 }
 
 /***************************************************************************//*!
-*  \brief Get first available index
+*  \brief Publish led
 *
-*   This function return the first available index in the led table.
+*   This function marks a led as registered. Its led info must be completely
+*   written before, it is never modified after.
+*   
+*   Preconditions: Mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               Led table index
+*
+*******************************************************************************/
+static void publishLed(uint8_t index){
+
+    atomic_fetch_or_explicit(&active_mask, LDRV_LED_BIT(index), memory_order_release);
+}
+
+/***************************************************************************//*!
+*  \brief Get led info
+*
+*   This function return the led info of a registered led, without taking
+*   the mutex nor copying it.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \return     Available index
+*   \param[in]  led_handle          Led handle
+*
+*   \return     Led info (NULL if the led is not registered)
 *
 *******************************************************************************/
-static uint8_t getFirstAvailableIndex(void){
+static const LDRV_LED_Info_t * getLedInfo(LED_Handle_t led_handle){
 
-    uint8_t index = 0;
-    for(index = 0; index<LDRV_CFG_MAX_NB_LED; index++){
-        if(led_table[index].active_flag == false)   break;
+    if(led_handle >= LDRV_CFG_MAX_NB_LED){
+        return NULL;
     }
 
-    if(index >= LDRV_CFG_MAX_NB_LED)    index = NO_AVAILABLE_INDEX;
+    if((atomic_load_explicit(&active_mask, memory_order_acquire) & LDRV_LED_BIT(led_handle)) == 0){
+        return NULL;
+    }
 
-    return index;
+    return &led_table[led_handle];
 }
 
 /******************************************************************************
@@ -124,11 +157,7 @@ LDRV_Ret_t LDRV_InitDriver(void){
     }
 
     LDRV_CFG_TakeMutex();
-
-    for(uint8_t i=0; i<LDRV_CFG_MAX_NB_LED; i++){
-        led_table[i].active_flag = false;
-    }
-
+    atomic_store_explicit(&active_mask, 0, memory_order_release);
     LDRV_CFG_GiveMutex();
 
     return LDRV_STATUS_OK;
@@ -179,12 +208,6 @@ LDRV_Ret_t LDRV_AddLedSingle(LDRV_CFG_Single_Config_t single_config,
 
     LDRV_CFG_TakeMutex();
 
-    //Check if led table is full
-    if(isTableFull()){
-        LDRV_CFG_GiveMutex();
-    return LDRV_STATUS_ERROR;
-    }
-
     //Get first available table index
     uint8_t index = getFirstAvailableIndex();
     if(index == NO_AVAILABLE_INDEX){
@@ -201,7 +224,7 @@ LDRV_Ret_t LDRV_AddLedSingle(LDRV_CFG_Single_Config_t single_config,
     //Store led infos in table
     led_table[index].led_type = LDRV_LED_TYPE_SINGLE;
     led_table[index].config.single_config = single_config;
-    led_table[index].active_flag = true;
+    publishLed(index);
     *pLed_handle = index;
 
     LDRV_CFG_GiveMutex();
@@ -232,12 +255,6 @@ LDRV_Ret_t LDRV_AddLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t single_pwm_config,
 
     LDRV_CFG_TakeMutex();
 
-    //Check if led table is full
-    if(isTableFull()){
-        LDRV_CFG_GiveMutex();
-        return LDRV_STATUS_ERROR;
-    }
-
     //Get first available table index
     uint8_t index = getFirstAvailableIndex();
     if(index == NO_AVAILABLE_INDEX){
@@ -254,7 +271,7 @@ LDRV_Ret_t LDRV_AddLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t single_pwm_config,
     //Store led infos in table
     led_table[index].led_type = LDRV_LED_TYPE_SINGLE_PWM;
     led_table[index].config.single_pwm_config = single_pwm_config;
-    led_table[index].active_flag = true;
+    publishLed(index);
     *pLed_handle = index;
 
     LDRV_CFG_GiveMutex();
@@ -285,12 +302,6 @@ LDRV_Ret_t LDRV_AddLedRgb(LDRV_CFG_Rgb_Config_t rgb_config, LED_Handle_t *pLed_h
 
     LDRV_CFG_TakeMutex();
 
-    //Check if led table is full
-    if(isTableFull()){
-        LDRV_CFG_GiveMutex();
-        return LDRV_STATUS_ERROR;
-    }
-
     //Get first available table index
     uint8_t index = getFirstAvailableIndex();
     if(index == NO_AVAILABLE_INDEX){
@@ -307,7 +318,54 @@ LDRV_Ret_t LDRV_AddLedRgb(LDRV_CFG_Rgb_Config_t rgb_config, LED_Handle_t *pLed_h
     //Store led infos in table
     led_table[index].led_type = LDRV_LED_TYPE_RGB;
     led_table[index].config.rgb_config = rgb_config;
-    led_table[index].active_flag = true;
+    publishLed(index);
+    *pLed_handle = index;
+
+    LDRV_CFG_GiveMutex();
+
+    return LDRV_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Add addressable led 
+*
+*   Add an addressable type led to the driver. Addressable leds are pixels of
+*   a WS2812 strip driven by a RMT channel, the leds sharing a data line share
+*   the strip. They are controlled like RGB leds. The function return a handle
+*   for the new led.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      addressable_config      Led configuration
+*   \param[out]     pLed_handle             Pointer to led handle
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_AddLedAddressable(LDRV_CFG_Addressable_Config_t addressable_config, 
+                                  LED_Handle_t *pLed_handle){
+
+    LDRV_CFG_TakeMutex();
+
+    //Get first available table index
+    uint8_t index = getFirstAvailableIndex();
+    if(index == NO_AVAILABLE_INDEX){
+        LDRV_CFG_GiveMutex();
+        return LDRV_STATUS_ERROR;
+    }
+
+    //Setup peripherals for the led (strip shared with other leds)
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetupLedAddressable(&addressable_config)){
+        LDRV_CFG_GiveMutex();
+        return LDRV_STATUS_ERROR;
+    }
+
+    //Store led infos in table
+    led_table[index].led_type = LDRV_LED_TYPE_ADDRESSABLE;
+    led_table[index].config.addressable_config = addressable_config;
+    publishLed(index);
     *pLed_handle = index;
 
     LDRV_CFG_GiveMutex();
@@ -333,24 +391,18 @@ LDRV_Ret_t LDRV_AddLedRgb(LDRV_CFG_Rgb_Config_t rgb_config, LED_Handle_t *pLed_h
 *******************************************************************************/
 LDRV_Ret_t LDRV_SetLedSingleState(uint8_t state, LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
-        return LDRV_STATUS_ERROR;
-    }
-
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-    if(led_info.active_flag == false){
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type != LDRV_LED_TYPE_SINGLE){    
+    if(pLed_info->led_type != LDRV_LED_TYPE_SINGLE){    
         return LDRV_STATUS_ERROR;
     }
 
     if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedSingleState(state, 
-                                                        &led_info.config.single_config)){
+                                                        &pLed_info->config.single_config)){
         return LDRV_STATUS_ERROR;
     }
 
@@ -361,55 +413,32 @@ LDRV_Ret_t LDRV_SetLedSingleState(uint8_t state, LED_Handle_t led_handle){
 *  \brief Set single pwm led duty-cycle.
 *
 *   This function is used to change the duty-cycle of a single pwm led.
-*   The duty-cyle must be equal or smaller than LED_DRIVER_MAX_DUTY_CYCLE 
+*   The perceptual brightness level is gamma corrected to the PWM duty-cycle.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]      duty_cycle              led duty-cycle
+*   \param[in]      level                   led brightness level
 *   \param[in]      led_handle              led handle
 *
 *   \return         Operation status
 *
 *******************************************************************************/
-LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint32_t duty_cycle, LED_Handle_t led_handle){
+LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint8_t level, LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
-        return LDRV_STATUS_ERROR;
-    }
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
-
-    if(led_info.active_flag == false){
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type != LDRV_LED_TYPE_SINGLE_PWM){  
+    if(pLed_info->led_type != LDRV_LED_TYPE_SINGLE_PWM){  
         return LDRV_STATUS_ERROR;
     }
 
-    //Clip duty-cycle
-    if(duty_cycle >= LDRV_CFG_MAX_PWM_DUTY)     duty_cycle = LDRV_CFG_MAX_PWM_DUTY;
-    if(duty_cycle <= LDRV_CFG_MIN_PWM_DUTY)     duty_cycle = LDRV_CFG_MIN_PWM_DUTY;
-
-    //Invserse duty-cycle if active low
-    if(led_info.config.single_pwm_config.active_level == LDRV_CFG_ACTIVE_LOW){
-        if(duty_cycle == LDRV_CFG_MAX_PWM_DUTY){
-            duty_cycle = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(duty_cycle == LDRV_CFG_MIN_PWM_DUTY){
-            duty_cycle = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }
-        else{
-            duty_cycle = LDRV_CFG_MAX_PWM_DUTY - duty_cycle;
-        }
-    }
-
-    if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedSinglePwmDuty(duty_cycle, 
-                                                          &led_info.config.single_pwm_config)){
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedSinglePwmDuty(level, 
+                                                          &pLed_info->config.single_pwm_config)){
         return LDRV_STATUS_ERROR;
     }
 
@@ -426,53 +455,30 @@ LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint32_t duty_cycle, LED_Handle_t led_handle
 *
 *   Side Effects: None.
 *
-*   \param[in]      target_duty             Final fade duty-cycle
+*   \param[in]      target_level            Final fade brightness level
 *   \param[in]      fade_timer_ms           Fade time (in ms)
 *   \param[in]      led_handle              led handle
 *
 *   \return         Operation status
 *
 *******************************************************************************/
-LDRV_Ret_t LDRV_FadeLedSinglePwmDuty(uint32_t target_duty, 
+LDRV_Ret_t LDRV_FadeLedSinglePwmDuty(uint8_t target_level, 
                                      uint32_t fade_time_ms, 
                                      LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
-        return LDRV_STATUS_ERROR;
-    }
-
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-    if(led_info.active_flag == false){
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type != LDRV_LED_TYPE_SINGLE_PWM){
+    if(pLed_info->led_type != LDRV_LED_TYPE_SINGLE_PWM){
         return LDRV_STATUS_ERROR;
     }
 
-    //clip duty-cycle
-    if(target_duty >= LDRV_CFG_MAX_PWM_DUTY)     target_duty = LDRV_CFG_MAX_PWM_DUTY;
-    if(target_duty <= LDRV_CFG_MIN_PWM_DUTY)     target_duty = LDRV_CFG_MIN_PWM_DUTY;
-
-    //Invserse duty-cycle if active low
-    if(led_info.config.single_pwm_config.active_level == LDRV_CFG_ACTIVE_LOW){
-        if(target_duty == LDRV_CFG_MAX_PWM_DUTY){
-            target_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(target_duty == LDRV_CFG_MIN_PWM_DUTY){
-            target_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }
-        else{
-            target_duty = LDRV_CFG_MAX_PWM_DUTY - target_duty;
-        }
-    }
-
-    if(LDRV_CFG_STATUS_OK != LDRV_CFG_FadeLedSinglePwmDuty(target_duty, 
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_FadeLedSinglePwmDuty(target_level, 
                                                            fade_time_ms, 
-                                                           &led_info.config.single_pwm_config)){
+                                                           &pLed_info->config.single_pwm_config)){
         return LDRV_STATUS_ERROR;
     }
 
@@ -480,92 +486,90 @@ LDRV_Ret_t LDRV_FadeLedSinglePwmDuty(uint32_t target_duty,
 }
 
 /***************************************************************************//*!
-*  \brief Set RGB led color
+*  \brief Play fade curve on single pwm led.
 *
-*   This function is used to change the color/brigthness of a RGB type led.
-*   Each color (red/green/blue) pwm duty-cyle must be equal or smaller than
-*   LED_DRIVER_MAX_DUTY_CYCLE.
+*   This function is used to fade the single led pwm through a brightness
+*   curve. Each point is reached at the end of its segment, starting from 
+*   the current brightness. The whole curve is handled by the peripheral
+*   when it supports gradient fades, so no CPU wake-up is needed until the
+*   end of the curve.
 *   
-*   Preconditions: None.
+*   Preconditions: Fade service is started.
 *
 *   Side Effects: None.
 *
-*   \param[in]      color                   RGB color
+*   \param[in]      pCurve                  Fade curve points
+*   \param[in]      nb_point                Number of points (<= LDRV_CFG_MAX_FADE_POINT)
 *   \param[in]      led_handle              led handle
 *
 *   \return         Operation status
 *
 *******************************************************************************/
-LDRV_Ret_t LDRV_SetLedRgbColor(LDRV_Color_t color, LED_Handle_t led_handle){
+LDRV_Ret_t LDRV_PlayFadeCurve(const LDRV_CFG_Fade_Point_t *pCurve, 
+                              uint8_t nb_point, 
+                              LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
+
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
-
-    if(led_info.active_flag == false){
+    if(pLed_info->led_type != LDRV_LED_TYPE_SINGLE_PWM){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type != LDRV_LED_TYPE_RGB){
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_PlayFadeCurveSinglePwm(pCurve, 
+                                                             nb_point, 
+                                                             &pLed_info->config.single_pwm_config)){
         return LDRV_STATUS_ERROR;
     }
 
-    //clip red duty-cycle
-    if(color.red_duty >= LDRV_CFG_MAX_PWM_DUTY)     color.red_duty = LDRV_CFG_MAX_PWM_DUTY;
-    if(color.red_duty <= LDRV_CFG_MIN_PWM_DUTY)     color.red_duty = LDRV_CFG_MIN_PWM_DUTY;
-
-    //clip green duty-cycle
-    if(color.green_duty >= LDRV_CFG_MAX_PWM_DUTY)     color.green_duty = LDRV_CFG_MAX_PWM_DUTY;
-    if(color.green_duty <= LDRV_CFG_MIN_PWM_DUTY)     color.green_duty = LDRV_CFG_MIN_PWM_DUTY;
+    return LDRV_STATUS_OK;
+}
 
-    //clip blue duty-cycle
-    if(color.blue_duty >= LDRV_CFG_MAX_PWM_DUTY)     color.blue_duty = LDRV_CFG_MAX_PWM_DUTY;
-    if(color.blue_duty <= LDRV_CFG_MIN_PWM_DUTY)     color.blue_duty = LDRV_CFG_MIN_PWM_DUTY;
+/***************************************************************************//*!
+*  \brief Set RGB led color
+*
+*   This function is used to change the color/brigthness of a RGB or 
+*   addressable type led. Each color (red/green/blue) brightness level is 
+*   gamma corrected to the PWM duty-cycle.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      color                   RGB color
+*   \param[in]      led_handle              led handle
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_SetLedRgbColor(LDRV_Color_t color, LED_Handle_t led_handle){
 
-    //Inverse duty-cycle if active low
-    if(led_info.config.rgb_config.active_level == LDRV_CFG_ACTIVE_LOW){
-        //Inverse red duty-cycle
-        if(color.red_duty == LDRV_CFG_MAX_PWM_DUTY){
-            color.red_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(color.red_duty == LDRV_CFG_MIN_PWM_DUTY){
-            color.red_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }   
-        else{
-            color.red_duty = LDRV_CFG_MAX_PWM_DUTY - color.red_duty;
-        }
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-        //Inverse green duty-cycle
-        if(color.green_duty == LDRV_CFG_MAX_PWM_DUTY){
-            color.green_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(color.green_duty == LDRV_CFG_MIN_PWM_DUTY){
-            color.green_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }
-        else{
-            color.green_duty = LDRV_CFG_MAX_PWM_DUTY - color.green_duty;
-        }
+    if(pLed_info == NULL){
+        return LDRV_STATUS_ERROR;
+    }
 
-        //Inverse blue duty-cycle
-        if(color.blue_duty == LDRV_CFG_MAX_PWM_DUTY){
-            color.blue_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(color.blue_duty == LDRV_CFG_MIN_PWM_DUTY){
-            color.blue_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
+    if(pLed_info->led_type == LDRV_LED_TYPE_RGB){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedRgbColor(color.red_level, 
+                                                         color.green_level, 
+                                                         color.blue_level, 
+                                                         &pLed_info->config.rgb_config)){
+            return LDRV_STATUS_ERROR;
         }
-        else{
-            color.blue_duty = LDRV_CFG_MAX_PWM_DUTY - color.blue_duty;
+    }
+    else if(pLed_info->led_type == LDRV_LED_TYPE_ADDRESSABLE){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedAddressableColor(color.red_level, 
+                                                                 color.green_level, 
+                                                                 color.blue_level, 
+                                                                 &pLed_info->config.addressable_config)){
+            return LDRV_STATUS_ERROR;
         }
     }
-
-    if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedRgbColor(color.red_duty, 
-                                                     color.green_duty, 
-                                                     color.blue_duty, 
-                                                     &led_info.config.rgb_config)){
+    else{
         return LDRV_STATUS_ERROR;
     }
 
@@ -575,8 +579,8 @@ LDRV_Ret_t LDRV_SetLedRgbColor(LDRV_Color_t color, LED_Handle_t led_handle){
 /***************************************************************************//*!
 *  \brief Fade RGB led.
 *
-*   This function is used to fade RGB led to a specified color within 
-*   a certain amount of time (in ms).
+*   This function is used to fade RGB or addressable led to a specified 
+*   color within a certain amount of time (in ms).
 *   
 *   Preconditions: None.
 *
@@ -593,67 +597,127 @@ LDRV_Ret_t LDRV_FadeLedRgbColor(LDRV_Color_t target_color,
                                 uint32_t fade_time_ms, 
                                 LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
+
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
-
-    if(led_info.active_flag == false){
+    if(pLed_info->led_type == LDRV_LED_TYPE_RGB){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_FadeLedRgbColor(target_color.red_level, 
+                                                          target_color.green_level, 
+                                                          target_color.blue_level, 
+                                                          fade_time_ms, 
+                                                          &pLed_info->config.rgb_config)){
+            return LDRV_STATUS_ERROR;
+        }
+    }
+    else if(pLed_info->led_type == LDRV_LED_TYPE_ADDRESSABLE){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_FadeLedAddressableColor(target_color.red_level, 
+                                                                  target_color.green_level, 
+                                                                  target_color.blue_level, 
+                                                                  fade_time_ms, 
+                                                                  &pLed_info->config.addressable_config)){
+            return LDRV_STATUS_ERROR;
+        }
+    }
+    else{
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type != LDRV_LED_TYPE_RGB){
+    return LDRV_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Set several leds.
+*
+*   This function is used to change several leds at once. All the PWM 
+*   outputs are latched together, each led strip is pushed once, and the 
+*   outputs already at the requested level are not written again.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      pEntry_list             List of leds to set
+*   \param[in]      nb_entry                Number of entries in the list
+*
+*   \return         Operation status (error if any entry failed)
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_SetMany(const LDRV_Set_Entry_t *pEntry_list, uint8_t nb_entry){
+
+    if(pEntry_list == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    //Inverse duty-cycle if active low
-    if(led_info.config.rgb_config.active_level == LDRV_CFG_ACTIVE_LOW){
-        //Inverse red duty-cycle
-        if(target_color.red_duty == LDRV_CFG_MAX_PWM_DUTY){
-            target_color.red_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(target_color.red_duty == LDRV_CFG_MIN_PWM_DUTY){
-            target_color.red_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }   
-        else{
-            target_color.red_duty = LDRV_CFG_MAX_PWM_DUTY - target_color.red_duty;
-        }
+    LDRV_Ret_t ret = LDRV_STATUS_OK;
+    LDRV_CFG_Batch_t batch = {0};
 
-        //Inverse green duty-cycle
-        if(target_color.green_duty == LDRV_CFG_MAX_PWM_DUTY){
-            target_color.green_duty = LDRV_CFG_MIN_PWM_DUTY;
-        }
-        else if(target_color.green_duty == LDRV_CFG_MIN_PWM_DUTY){
-            target_color.green_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
-        }
-        else{
-            target_color.green_duty = LDRV_CFG_MAX_PWM_DUTY - target_color.green_duty;
-        }
+    for(uint8_t i=0; i<nb_entry; i++){
+        const LDRV_Set_Entry_t *pEntry = &pEntry_list[i];
+        const LDRV_LED_Info_t *pLed_info = getLedInfo(pEntry->led_handle);
+        LDRV_CFG_Ret_t cfg_ret = LDRV_CFG_STATUS_ERROR;
 
-        //Inverse blue duty-cycle
-        if(target_color.blue_duty == LDRV_CFG_MAX_PWM_DUTY){
-            target_color.blue_duty = LDRV_CFG_MIN_PWM_DUTY;
+        if(pLed_info == NULL){
+            ret = LDRV_STATUS_ERROR;
+            continue;
         }
-        else if(target_color.blue_duty == LDRV_CFG_MIN_PWM_DUTY){
-            target_color.blue_duty = LDRV_CFG_MAX_PWM_DUTY + 1;
+
+        switch(pLed_info->led_type){
+            case LDRV_LED_TYPE_SINGLE:
+            {
+                cfg_ret = LDRV_CFG_SetLedSingleState(pEntry->level != LDRV_CFG_MIN_LEVEL,
+                                                     &pLed_info->config.single_config);
+            }
+            break;
+
+            case LDRV_LED_TYPE_SINGLE_PWM:
+            {
+                cfg_ret = LDRV_CFG_StageLedSinglePwmDuty(pEntry->level, 
+                                                         &pLed_info->config.single_pwm_config,
+                                                         &batch);
+            }
+            break;
+
+            case LDRV_LED_TYPE_RGB:
+            {
+                cfg_ret = LDRV_CFG_StageLedRgbColor(pEntry->color.red_level, 
+                                                    pEntry->color.green_level, 
+                                                    pEntry->color.blue_level, 
+                                                    &pLed_info->config.rgb_config,
+                                                    &batch);
+            }
+            break;
+
+            case LDRV_LED_TYPE_ADDRESSABLE:
+            {
+                cfg_ret = LDRV_CFG_StageLedAddressableColor(pEntry->color.red_level, 
+                                                            pEntry->color.green_level, 
+                                                            pEntry->color.blue_level, 
+                                                            &pLed_info->config.addressable_config,
+                                                            &batch);
+            }
+            break;
+
+            default:
+            {
+                //Do nothing...
+            }
+            break;
         }
-        else{
-            target_color.blue_duty = LDRV_CFG_MAX_PWM_DUTY - target_color.blue_duty;
+
+        if(cfg_ret != LDRV_CFG_STATUS_OK){
+            ret = LDRV_STATUS_ERROR;
         }
     }
 
-    if(LDRV_CFG_STATUS_OK != LDRV_CFG_FadeLedRgbColor(target_color.red_duty, 
-                                                      target_color.green_duty, 
-                                                      target_color.blue_duty, 
-                                                      fade_time_ms, 
-                                                      &led_info.config.rgb_config)){
-        return LDRV_STATUS_ERROR;
+    //Apply every staged output in one go
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_CommitBatch(&batch)){
+        ret = LDRV_STATUS_ERROR;
     }
 
-    return LDRV_STATUS_OK;
+    return ret;
 }
 
 /***************************************************************************//*!
@@ -673,25 +737,19 @@ LDRV_Ret_t LDRV_FadeLedRgbColor(LDRV_Color_t target_color,
 *******************************************************************************/
 LDRV_Ret_t LDRV_SetLedPwmFreq(uint32_t freq_hz, LED_Handle_t led_handle){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
-        return LDRV_STATUS_ERROR;
-    }
-
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-    if(led_info.active_flag == false){
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type == LDRV_LED_TYPE_SINGLE_PWM){
-        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedSinglePwmFreq(freq_hz, &led_info.config.single_pwm_config)){
+    if(pLed_info->led_type == LDRV_LED_TYPE_SINGLE_PWM){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedSinglePwmFreq(freq_hz, &pLed_info->config.single_pwm_config)){
             return LDRV_STATUS_ERROR;
         }
     }
-    else if(led_info.led_type == LDRV_LED_TYPE_RGB){
-        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedRgbFreq(freq_hz, &led_info.config.rgb_config)){
+    else if(pLed_info->led_type == LDRV_LED_TYPE_RGB){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_SetLedRgbFreq(freq_hz, &pLed_info->config.rgb_config)){
             return LDRV_STATUS_ERROR;
         }
     }
@@ -719,25 +777,19 @@ LDRV_Ret_t LDRV_SetLedPwmFreq(uint32_t freq_hz, LED_Handle_t led_handle){
 *******************************************************************************/
 LDRV_Ret_t LDRV_GetLedPwmFreq(LED_Handle_t led_handle, uint32_t *pFreq_hz){
 
-    if(led_handle >= LDRV_CFG_MAX_NB_LED){
-        return LDRV_STATUS_ERROR;
-    }
-
-    LDRV_CFG_TakeMutex();
-    LDRV_LED_Info_t led_info = led_table[led_handle]; 
-    LDRV_CFG_GiveMutex();
+    const LDRV_LED_Info_t *pLed_info = getLedInfo(led_handle);
 
-    if(led_info.active_flag == false){
+    if(pLed_info == NULL){
         return LDRV_STATUS_ERROR;
     }
 
-    if(led_info.led_type == LDRV_LED_TYPE_SINGLE_PWM){
-        if(LDRV_CFG_STATUS_OK != LDRV_CFG_GetLedSinglePwmFreq(pFreq_hz, &led_info.config.single_pwm_config)){
+    if(pLed_info->led_type == LDRV_LED_TYPE_SINGLE_PWM){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_GetLedSinglePwmFreq(pFreq_hz, &pLed_info->config.single_pwm_config)){
             return LDRV_STATUS_ERROR;
         }
     }
-    else if(led_info.led_type == LDRV_LED_TYPE_RGB){
-        if(LDRV_CFG_STATUS_OK != LDRV_CFG_GetLedRgbFreq(pFreq_hz, &led_info.config.rgb_config)){
+    else if(pLed_info->led_type == LDRV_LED_TYPE_RGB){
+        if(LDRV_CFG_STATUS_OK != LDRV_CFG_GetLedRgbFreq(pFreq_hz, &pLed_info->config.rgb_config)){
             return LDRV_STATUS_ERROR;
         }
     }
@@ -748,6 +800,32 @@ LDRV_Ret_t LDRV_GetLedPwmFreq(LED_Handle_t led_handle, uint32_t *pFreq_hz){
     return LDRV_STATUS_OK;
 }
 
+/***************************************************************************//*!
+*  \brief Get write statistics.
+*
+*   This function is used to get the number of PWM duty-cycle writes issued
+*   and skipped (output unchanged) since startup.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out]     pStats                  Statistics return pointer
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_GetWriteStats(LDRV_CFG_Write_Stats_t *pStats){
+
+    if(pStats == NULL){
+        return LDRV_STATUS_ERROR;
+    }
+
+    LDRV_CFG_GetWriteStats(pStats);
+
+    return LDRV_STATUS_OK;
+}
+
 /******************************************************************************
 *   Interrupts
 *******************************************************************************/
@@ -9,15 +9,15 @@
 *******************************************************************************/
 #define LED_DRIVER_HANDLE_INVALID           (0xFF);
 
-#define LDRV_RGB_RED            (LDRV_Color_t){.red_duty = LDRV_CFG_MAX_PWM_DUTY, .green_duty = LDRV_CFG_MIN_PWM_DUTY, .blue_duty = LDRV_CFG_MIN_PWM_DUTY}
-#define LDRV_RGB_GREEN          (LDRV_Color_t){.red_duty = LDRV_CFG_MIN_PWM_DUTY, .green_duty = LDRV_CFG_MAX_PWM_DUTY, .blue_duty = LDRV_CFG_MIN_PWM_DUTY}
-#define LDRV_RGB_BLUE           (LDRV_Color_t){.red_duty = LDRV_CFG_MIN_PWM_DUTY, .green_duty = LDRV_CFG_MIN_PWM_DUTY, .blue_duty = LDRV_CFG_MAX_PWM_DUTY}
-#define LDRV_RGB_WHITE          (LDRV_Color_t){.red_duty = LDRV_CFG_MAX_PWM_DUTY, .green_duty = LDRV_CFG_MAX_PWM_DUTY, .blue_duty = LDRV_CFG_MAX_PWM_DUTY}
-#define LDRV_RGB_AQUA           (LDRV_Color_t){.red_duty = LDRV_CFG_MIN_PWM_DUTY, .green_duty = LDRV_CFG_MAX_PWM_DUTY, .blue_duty = LDRV_CFG_MAX_PWM_DUTY}
-#define LDRV_RGB_PURPLE         (LDRV_Color_t){.red_duty = LDRV_CFG_MAX_PWM_DUTY, .green_duty = LDRV_CFG_MIN_PWM_DUTY, .blue_duty = LDRV_CFG_MAX_PWM_DUTY}
-#define LDRV_RGB_YELLOW         (LDRV_Color_t){.red_duty = LDRV_CFG_MAX_PWM_DUTY, .green_duty = LDRV_CFG_MAX_PWM_DUTY, .blue_duty = LDRV_CFG_MIN_PWM_DUTY}
-#define LDRV_RGB_ORANGE         (LDRV_Color_t){.red_duty = LDRV_CFG_MAX_PWM_DUTY, .green_duty = LDRV_CFG_MAX_PWM_DUTY/2, .blue_duty = LDRV_CFG_MIN_PWM_DUTY}
-#define LDRV_RGB_BLACK          (LDRV_Color_t){.red_duty = LDRV_CFG_MIN_PWM_DUTY, .green_duty = LDRV_CFG_MIN_PWM_DUTY, .blue_duty = LDRV_CFG_MIN_PWM_DUTY}
+#define LDRV_RGB_RED            (LDRV_Color_t){.red_level = LDRV_CFG_MAX_LEVEL, .green_level = LDRV_CFG_MIN_LEVEL, .blue_level = LDRV_CFG_MIN_LEVEL}
+#define LDRV_RGB_GREEN          (LDRV_Color_t){.red_level = LDRV_CFG_MIN_LEVEL, .green_level = LDRV_CFG_MAX_LEVEL, .blue_level = LDRV_CFG_MIN_LEVEL}
+#define LDRV_RGB_BLUE           (LDRV_Color_t){.red_level = LDRV_CFG_MIN_LEVEL, .green_level = LDRV_CFG_MIN_LEVEL, .blue_level = LDRV_CFG_MAX_LEVEL}
+#define LDRV_RGB_WHITE          (LDRV_Color_t){.red_level = LDRV_CFG_MAX_LEVEL, .green_level = LDRV_CFG_MAX_LEVEL, .blue_level = LDRV_CFG_MAX_LEVEL}
+#define LDRV_RGB_AQUA           (LDRV_Color_t){.red_level = LDRV_CFG_MIN_LEVEL, .green_level = LDRV_CFG_MAX_LEVEL, .blue_level = LDRV_CFG_MAX_LEVEL}
+#define LDRV_RGB_PURPLE         (LDRV_Color_t){.red_level = LDRV_CFG_MAX_LEVEL, .green_level = LDRV_CFG_MIN_LEVEL, .blue_level = LDRV_CFG_MAX_LEVEL}
+#define LDRV_RGB_YELLOW         (LDRV_Color_t){.red_level = LDRV_CFG_MAX_LEVEL, .green_level = LDRV_CFG_MAX_LEVEL, .blue_level = LDRV_CFG_MIN_LEVEL}
+#define LDRV_RGB_ORANGE         (LDRV_Color_t){.red_level = LDRV_CFG_MAX_LEVEL, .green_level = LDRV_CFG_MAX_LEVEL/2, .blue_level = LDRV_CFG_MIN_LEVEL}
+#define LDRV_RGB_BLACK          (LDRV_Color_t){.red_level = LDRV_CFG_MIN_LEVEL, .green_level = LDRV_CFG_MIN_LEVEL, .blue_level = LDRV_CFG_MIN_LEVEL}
 
 /******************************************************************************
 *   Public Macros
@@ -31,16 +31,23 @@ typedef enum LDRV_Led_Type_e{
     LDRV_LED_TYPE_SINGLE,
     LDRV_LED_TYPE_SINGLE_PWM,
     LDRV_LED_TYPE_RGB,
+    LDRV_LED_TYPE_ADDRESSABLE,
 
     LDRV_LED_TYPE_INVALID,
 }LDRV_Led_Type_t;
 
 typedef struct LDRV_Color_s{
-    uint32_t red_duty;
-    uint32_t green_duty;
-    uint32_t blue_duty;
+    uint8_t red_level;
+    uint8_t green_level;
+    uint8_t blue_level;
 }LDRV_Color_t;
 
+typedef struct LDRV_Set_Entry_s{
+    LED_Handle_t led_handle;
+    uint8_t level;              //Single and single pwm leds
+    LDRV_Color_t color;         //RGB and addressable leds
+}LDRV_Set_Entry_t;
+
 typedef enum LDRV_Ret_e{
     LDRV_STATUS_ERROR,
     LDRV_STATUS_OK,
@@ -152,6 +159,27 @@ LDRV_Ret_t LDRV_AddLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t single_pwm_config,
 LDRV_Ret_t LDRV_AddLedRgb(LDRV_CFG_Rgb_Config_t rgb_config, 
                           LED_Handle_t *pLed_handle);
 
+/***************************************************************************//*!
+*  \brief Add addressable led 
+*
+*   Add an addressable type led to the driver. Addressable leds are pixels of
+*   a WS2812 strip driven by a RMT channel, the leds sharing a data line share
+*   the strip. They are controlled like RGB leds. The function return a handle
+*   for the new led.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      addressable_config      Led configuration
+*   \param[out]     pLed_handle             Pointer to led handle
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_AddLedAddressable(LDRV_CFG_Addressable_Config_t addressable_config, 
+                                  LED_Handle_t *pLed_handle);
+
 /***************************************************************************//*!
 *  \brief Set single led state.
 *
@@ -174,19 +202,19 @@ LDRV_Ret_t LDRV_SetLedSingleState(uint8_t state, LED_Handle_t led_handle);
 *  \brief Set single pwm led duty-cycle.
 *
 *   This function is used to change the duty-cycle of a single pwm led.
-*   The duty-cyle must be equal or smaller than LED_DRIVER_MAX_DUTY_CYCLE 
+*   The perceptual brightness level is gamma corrected to the PWM duty-cycle.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]      duty_cycle              led duty-cycle
+*   \param[in]      level                   led brightness level
 *   \param[in]      led_handle              led handle
 *
 *   \return         Operation status
 *
 *******************************************************************************/
-LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint32_t duty_cycle, LED_Handle_t led_handle);
+LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint8_t level, LED_Handle_t led_handle);
 
 /***************************************************************************//*!
 *  \brief Fade single pwm led.
@@ -198,23 +226,47 @@ LDRV_Ret_t LDRV_SetLedSinglePwmDuty(uint32_t duty_cycle, LED_Handle_t led_handle
 *
 *   Side Effects: None.
 *
-*   \param[in]      target_duty             Final fade duty-cycle
+*   \param[in]      target_level            Final fade brightness level
 *   \param[in]      fade_timer_ms           Fade time (in ms)
 *   \param[in]      led_handle              led handle
 *
 *   \return         Operation status
 *
 *******************************************************************************/
-LDRV_Ret_t LDRV_FadeLedSinglePwmDuty(uint32_t target_duty, 
+LDRV_Ret_t LDRV_FadeLedSinglePwmDuty(uint8_t target_level, 
                                      uint32_t fade_time_ms, 
                                      LED_Handle_t led_handle);
 
+/***************************************************************************//*!
+*  \brief Play fade curve on single pwm led.
+*
+*   This function is used to fade the single led pwm through a brightness
+*   curve. Each point is reached at the end of its segment, starting from 
+*   the current brightness. The whole curve is handled by the peripheral
+*   when it supports gradient fades, so no CPU wake-up is needed until the
+*   end of the curve.
+*   
+*   Preconditions: Fade service is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]      pCurve                  Fade curve points
+*   \param[in]      nb_point                Number of points (<= LDRV_CFG_MAX_FADE_POINT)
+*   \param[in]      led_handle              led handle
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_PlayFadeCurve(const LDRV_CFG_Fade_Point_t *pCurve, 
+                              uint8_t nb_point, 
+                              LED_Handle_t led_handle);
+
 /***************************************************************************//*!
 *  \brief Set RGB led color
 *
-*   This function is used to change the color/brigthness of a RGB type led.
-*   Each color (red/green/blue) pwm duty-cyle must be equal or smaller than
-*   LED_DRIVER_MAX_DUTY_CYCLE.
+*   This function is used to change the color/brigthness of a RGB or 
+*   addressable type led. Each color (red/green/blue) brightness level is 
+*   gamma corrected to the PWM duty-cycle.
 *   
 *   Preconditions: None.
 *
@@ -231,8 +283,8 @@ LDRV_Ret_t LDRV_SetLedRgbColor(LDRV_Color_t color, LED_Handle_t led_handle);
 /***************************************************************************//*!
 *  \brief Fade RGB led.
 *
-*   This function is used to fade RGB led to a specified color within 
-*   a certain amount of time (in ms).
+*   This function is used to fade RGB or addressable led to a specified 
+*   color within a certain amount of time (in ms).
 *   
 *   Preconditions: None.
 *
@@ -249,6 +301,25 @@ LDRV_Ret_t LDRV_FadeLedRgbColor(LDRV_Color_t target_color,
                                 uint32_t fade_time_ms, 
                                 LED_Handle_t led_handle);
 
+/***************************************************************************//*!
+*  \brief Set several leds.
+*
+*   This function is used to change several leds at once. All the PWM 
+*   outputs are latched together, each led strip is pushed once, and the 
+*   outputs already at the requested level are not written again.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      pEntry_list             List of leds to set
+*   \param[in]      nb_entry                Number of entries in the list
+*
+*   \return         Operation status (error if any entry failed)
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_SetMany(const LDRV_Set_Entry_t *pEntry_list, uint8_t nb_entry);
+
 /***************************************************************************//*!
 *  \brief Set led frequency.
 *
@@ -283,4 +354,21 @@ LDRV_Ret_t LDRV_SetLedPwmFreq(uint32_t freq_hz, LED_Handle_t led_handle);
 *******************************************************************************/
 LDRV_Ret_t LDRV_GetLedPwmFreq(LED_Handle_t led_handle, uint32_t *pFreq_hz);
 
+/***************************************************************************//*!
+*  \brief Get write statistics.
+*
+*   This function is used to get the number of PWM duty-cycle writes issued
+*   and skipped (output unchanged) since startup.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out]     pStats                  Statistics return pointer
+*
+*   \return         Operation status
+*
+*******************************************************************************/
+LDRV_Ret_t LDRV_GetWriteStats(LDRV_CFG_Write_Stats_t *pStats);
+
 #endif//_LED_DRIVER_H
\ No newline at end of file
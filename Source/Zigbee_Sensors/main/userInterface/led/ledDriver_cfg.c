@@ -1,33 +1,129 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
+#include <stdbool.h>
+#include <stdatomic.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
 #include "driver/gpio.h"
+#include "led_strip.h"
 #include "ledDriver_cfg.h"
 
+#include <string.h>
+
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define LDRV_TIMER_MODE                     (LEDC_LOW_SPEED_MODE)
-#define LDRV_DEFAULT_FREQ_HZ                (1000)
-#define LDRV_DEFAULT_DUTY_RES               (LEDC_TIMER_8_BIT)
+#define LDRV_TIMER_CLK_HZ                   (40000000)//XTAL_CLK
+#define LDRV_FULL_DUTY                      (1ULL << LDRV_CFG_PWM_DUTY_RES_BITS)
+#define LDRV_DUTY_UNKNOWN                   (0xFFFFFFFF)//Output fading
+
+//CIE 1931 lightness, computed with level scaled by 255 (L* = 100 -> 116 * 255)
+#define LDRV_CIE_SCALE                      (116ULL * 255ULL)
+#define LDRV_CIE_LINEAR_MAX_LEVEL           (20)//L* <= 8
+
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+#define LDRV_FADE_RANGE_MAX                 (SOC_LEDC_GAMMA_CURVE_FADE_RANGE_MAX)
+#define LDRV_FADE_PARAM_MAX                 ((1UL << SOC_LEDC_FADE_PARAMS_BIT_WIDTH) - 1)
+#define LDRV_FADE_RANGE_PER_POINT           (3)
+#endif
 
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
+//Perceptual level to duty-cycle: Y = L* / 903.3 or Y = ((L* + 16) / 116)^3
+#define LDRV_CIE_CUBE(level)                (((level) * 100ULL) + (16ULL * 255ULL))
+#define LDRV_CIE_DUTY(level)                (((level) <= LDRV_CIE_LINEAR_MAX_LEVEL) ?                                   \
+                                             ((((level) * 1000ULL * LDRV_FULL_DUTY) + (255ULL * 9033ULL / 2)) /         \
+                                              (255ULL * 9033ULL)) :                                                     \
+                                             ((((LDRV_CIE_CUBE(level) * LDRV_CIE_CUBE(level) * LDRV_CIE_CUBE(level)) /  \
+                                                LDRV_CIE_SCALE) * LDRV_FULL_DUTY + (LDRV_CIE_SCALE * LDRV_CIE_SCALE / 2)) / \
+                                              (LDRV_CIE_SCALE * LDRV_CIE_SCALE)))
+
+#define LDRV_DUTY_ACTIVE_HIGH(level)        ((uint32_t)LDRV_CIE_DUTY(level))
+#define LDRV_DUTY_ACTIVE_LOW(level)         ((uint32_t)(LDRV_FULL_DUTY - LDRV_CIE_DUTY(level)))
+#define LDRV_DUTY_STRIP(level)              ((uint8_t)(((LDRV_CIE_DUTY(level) * 255ULL) + (LDRV_FULL_DUTY / 2)) / LDRV_FULL_DUTY))
+
+#define DIV_CEIL(a, b)                      (((a) + (b) - 1) / (b))
+
+//Addressable strip pixel components (8-bit PWM in the led)
+#define LDRV_RED                            (0)
+#define LDRV_GREEN                          (1)
+#define LDRV_BLUE                           (2)
+#define LDRV_NB_COLOR                       (3)
+
+//The pixel buffer is DMA fed where the RMT supports it
+#if SOC_RMT_SUPPORT_DMA
+#define LDRV_STRIP_WITH_DMA                 (1)
+#define LDRV_STRIP_MEM_SYMBOLS              (1024)
+#else
+#define LDRV_STRIP_WITH_DMA                 (0)
+#define LDRV_STRIP_MEM_SYMBOLS              (0)//Driver default
+#endif
+
+//Expand a duty macro over the whole level range
+#define LDRV_LUT_4(duty, level)             duty(level), duty((level) + 1), duty((level) + 2), duty((level) + 3)
+#define LDRV_LUT_16(duty, level)            LDRV_LUT_4(duty, level), LDRV_LUT_4(duty, (level) + 4),         \
+                                            LDRV_LUT_4(duty, (level) + 8), LDRV_LUT_4(duty, (level) + 12)
+#define LDRV_LUT_64(duty, level)            LDRV_LUT_16(duty, level), LDRV_LUT_16(duty, (level) + 16),      \
+                                            LDRV_LUT_16(duty, (level) + 32), LDRV_LUT_16(duty, (level) + 48)
+#define LDRV_LUT_256(duty)                  LDRV_LUT_64(duty, 0ULL), LDRV_LUT_64(duty, 64ULL),              \
+                                            LDRV_LUT_64(duty, 128ULL), LDRV_LUT_64(duty, 192ULL)
 
 
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
-
+typedef struct LDRV_Pixel_Fade_s{
+    uint8_t start_level[LDRV_NB_COLOR];
+    uint8_t target_level[LDRV_NB_COLOR];
+    int64_t start_time_us;
+    uint32_t fade_time_us;
+}LDRV_Pixel_Fade_t;
+
+typedef struct LDRV_Strip_Info_s{
+    led_strip_handle_t strip_handle;
+    esp_timer_handle_t fade_timer_handle;
+    uint8_t gpio_num;
+    uint8_t nb_pixel;
+    bool dirty;//Frame changed since the last push
+    uint32_t fade_mask;//Pixels fading
+    uint8_t frame[LDRV_CFG_MAX_STRIP_PIXEL][LDRV_NB_COLOR];//Pixel levels
+    LDRV_Pixel_Fade_t fade_table[LDRV_CFG_MAX_STRIP_PIXEL];
+}LDRV_Strip_Info_t;
+
+#if !SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+typedef struct LDRV_Curve_Info_s{
+    LDRV_CFG_Fade_Point_t curve[LDRV_CFG_MAX_FADE_POINT];
+    uint8_t nb_point;
+    uint8_t point_index;//Next point to play
+    const LDRV_CFG_Single_Pwm_Config_t *pConfig;
+    esp_timer_handle_t timer_handle;
+}LDRV_Curve_Info_t;
+#endif
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-
+static void stopFadeCurve(ledc_channel_t channel);
+static LDRV_CFG_Ret_t stageDuty(ledc_channel_t channel, uint32_t duty, LDRV_CFG_Batch_t *pBatch);
+static LDRV_CFG_Ret_t writePixel(LDRV_Strip_Info_t *pStrip, uint8_t pixel, const uint8_t *pLevel);
+static LDRV_CFG_Ret_t pushStrip(LDRV_Strip_Info_t *pStrip);
+static void stripFadeTimerCallback(void *arg);
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+static uint32_t fillFadeRanges(uint32_t start_duty, 
+                               uint32_t end_duty, 
+                               uint32_t nb_cycle, 
+                               ledc_fade_param_config_t *pRange_list);
+#else
+static void playCurvePoint(LDRV_Curve_Info_t *pCurve_info);
+static void curveTimerCallback(void *arg);
+#endif
 
 /******************************************************************************
 *   Public Variables
@@ -38,21 +134,425 @@
 *   Private Variables
 *******************************************************************************/
 static SemaphoreHandle_t ldrv_mutex_handle = NULL;
+static StaticSemaphore_t ldrv_mutex_buffer;
+
+//Level to duty-cycle table, built at compile time. Active low inversion is
+//folded in so the runtime path is a single lookup.
+static const uint32_t duty_lut[LDRV_CFG_ACTIVE_INVALID][LDRV_CFG_NB_LEVEL] = {
+    [LDRV_CFG_ACTIVE_LOW] = {LDRV_LUT_256(LDRV_DUTY_ACTIVE_LOW)},
+    [LDRV_CFG_ACTIVE_HIGH] = {LDRV_LUT_256(LDRV_DUTY_ACTIVE_HIGH)},
+};
+
+//Last duty-cycle written to each channel, used to drop redundant writes
+static uint32_t shadow_duty_table[LEDC_CHANNEL_MAX] = {0};
+static atomic_uint_fast32_t write_issued_cptr = 0;
+static atomic_uint_fast32_t write_skipped_cptr = 0;
+
+static portMUX_TYPE batch_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+//Led strip level to 8-bit pixel component
+static const uint8_t strip_lut[LDRV_CFG_NB_LEVEL] = {
+    LDRV_LUT_256(LDRV_DUTY_STRIP),
+};
+
+static LDRV_Strip_Info_t strip_table[LDRV_CFG_MAX_NB_STRIP] = {0};
+static uint8_t nb_strip = 0;
+static SemaphoreHandle_t strip_mutex_handle = NULL;
+static StaticSemaphore_t strip_mutex_buffer;
+
+#if !SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+static LDRV_Curve_Info_t curve_info_table[LEDC_CHANNEL_MAX] = {0};
+static SemaphoreHandle_t curve_mutex_handle = NULL;
+static StaticSemaphore_t curve_mutex_buffer;
+#endif
 
 /******************************************************************************
 *   Error Check
 *******************************************************************************/
+_Static_assert(LDRV_CFG_NB_LEVEL == 256, "Duty-cycle table expects 8-bit levels");
+_Static_assert(LEDC_CHANNEL_MAX <= 32, "Batch channel mask is limited to 32 channels");
+_Static_assert(LDRV_CFG_MAX_NB_STRIP <= 32, "Batch strip mask is limited to 32 strips");
+_Static_assert(LDRV_CFG_MAX_STRIP_PIXEL <= 32, "Strip fade mask is limited to 32 pixels");
+_Static_assert(LDRV_CFG_PWM_DUTY_RES_BITS < LEDC_TIMER_BIT_MAX, "PWM resolution not supported by LEDC");
+_Static_assert(((uint64_t)LDRV_CFG_PWM_FREQ_HZ << LDRV_CFG_PWM_DUTY_RES_BITS) <= LDRV_TIMER_CLK_HZ,
+               "PWM resolution too high for the selected frequency");
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+_Static_assert((LDRV_FADE_RANGE_PER_POINT * LDRV_CFG_MAX_FADE_POINT) <= LDRV_FADE_RANGE_MAX,
+               "Fade curve does not fit in the fade ranges");
+_Static_assert(LDRV_FULL_DUTY <= ((uint64_t)LDRV_FADE_PARAM_MAX * LDRV_FADE_PARAM_MAX),
+               "Full scale fade does not fit in the fade ranges");
+#endif
 
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief Stop fade curve.
+*
+*   Stop the curve or fade running on a channel so a new duty-cycle is 
+*   applied immediately instead of waiting for the end of the fade.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  channel             Led channel
+*
+*******************************************************************************/
+static void stopFadeCurve(ledc_channel_t channel){
+
+#if !SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+    LDRV_Curve_Info_t *pCurve_info = &curve_info_table[channel];
+
+    xSemaphoreTake(curve_mutex_handle, portMAX_DELAY);
+    pCurve_info->nb_point = 0;
+    if(pCurve_info->timer_handle != NULL){
+        esp_timer_stop(pCurve_info->timer_handle);
+    }
+    xSemaphoreGive(curve_mutex_handle);
+#endif
+
+#if SOC_LEDC_SUPPORT_FADE_STOP
+    //No fade running (or fade service not started) is not an error
+    ledc_fade_stop(LDRV_TIMER_MODE, channel);
+#endif
+}
+
+/***************************************************************************//*!
+*  \brief Stage duty-cycle.
+*
+*   Write a channel duty-cycle without applying it, unless the channel is
+*   already at this duty-cycle. A channel left fading is stopped first.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]      channel         Led channel
+*   \param[in]      duty            Duty-cycle
+*   \param[in,out]  pBatch          Batch to add the channel to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static LDRV_CFG_Ret_t stageDuty(ledc_channel_t channel, uint32_t duty, LDRV_CFG_Batch_t *pBatch){
+
+    if(shadow_duty_table[channel] == duty){
+        atomic_fetch_add_explicit(&write_skipped_cptr, 1, memory_order_relaxed);
+        return LDRV_CFG_STATUS_OK;
+    }
+
+    if(shadow_duty_table[channel] == LDRV_DUTY_UNKNOWN){
+        stopFadeCurve(channel);
+    }
+
+    if(ESP_OK != ledc_set_duty(LDRV_TIMER_MODE, channel, duty)){
+        shadow_duty_table[channel] = LDRV_DUTY_UNKNOWN;
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    shadow_duty_table[channel] = duty;
+    pBatch->channel_mask |= (1UL << channel);
+    atomic_fetch_add_explicit(&write_issued_cptr, 1, memory_order_relaxed);
+
+    return LDRV_CFG_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Write pixel.
+*
+*   Write a pixel of the strip frame, unless it is already at these levels.
+*   The frame is marked dirty, it is sent to the strip by pushStrip().
+*   
+*   Preconditions: Strip mutex is taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pStrip              Strip infos
+*   \param[in]  pixel               Pixel index
+*   \param[in]  pLevel              Red, green and blue brightness levels
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static LDRV_CFG_Ret_t writePixel(LDRV_Strip_Info_t *pStrip, uint8_t pixel, const uint8_t *pLevel){
+
+    uint8_t *pFrame_level = pStrip->frame[pixel];
+
+    if((pFrame_level[LDRV_RED] == pLevel[LDRV_RED]) &&
+       (pFrame_level[LDRV_GREEN] == pLevel[LDRV_GREEN]) &&
+       (pFrame_level[LDRV_BLUE] == pLevel[LDRV_BLUE])){
+
+        atomic_fetch_add_explicit(&write_skipped_cptr, 1, memory_order_relaxed);
+        return LDRV_CFG_STATUS_OK;
+    }
+
+    //Encoded in the strip pixel buffer, nothing is sent yet
+    if(ESP_OK != led_strip_set_pixel(pStrip->strip_handle, 
+                                     pixel, 
+                                     strip_lut[pLevel[LDRV_RED]], 
+                                     strip_lut[pLevel[LDRV_GREEN]], 
+                                     strip_lut[pLevel[LDRV_BLUE]])){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    pFrame_level[LDRV_RED] = pLevel[LDRV_RED];
+    pFrame_level[LDRV_GREEN] = pLevel[LDRV_GREEN];
+    pFrame_level[LDRV_BLUE] = pLevel[LDRV_BLUE];
+    pStrip->dirty = true;
+    atomic_fetch_add_explicit(&write_issued_cptr, 1, memory_order_relaxed);
+
+    return LDRV_CFG_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Push strip.
+*
+*   Send the strip frame to the leds, only if it changed since the last push.
+*   
+*   Preconditions: Strip mutex is taken.
+*
+*   Side Effects: Wait for the end of the previous transmission.
+*
+*   \param[in]  pStrip              Strip infos
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+static LDRV_CFG_Ret_t pushStrip(LDRV_Strip_Info_t *pStrip){
+
+    if(!pStrip->dirty){
+        return LDRV_CFG_STATUS_OK;
+    }
+
+    if(ESP_OK != led_strip_refresh(pStrip->strip_handle)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    pStrip->dirty = false;
+
+    return LDRV_CFG_STATUS_OK;
+}
+
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+/***************************************************************************//*!
+*  \brief Fill fade ranges.
+*
+*   Convert a curve segment into hardware fade ranges (duty-cycle changes by
+*   "scale" every "cycle_num" PWM periods, "step_num" times). The division
+*   remainders are spread over the first steps (one more duty unit and/or 
+*   one more period), so the segment reaches its target duty-cycle exactly
+*   and lasts the requested number of periods. Segments too short for the
+*   maximal scale are stretched.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  start_duty          Segment start duty-cycle
+*   \param[in]  end_duty            Segment target duty-cycle
+*   \param[in]  nb_cycle            Segment duration in PWM periods
+*   \param[out] pRange_list         Ranges to fill (room for LDRV_FADE_RANGE_PER_POINT ranges)
+*
+*   \return     Number of ranges filled
+*
+*******************************************************************************/
+static uint32_t fillFadeRanges(uint32_t start_duty, 
+                               uint32_t end_duty, 
+                               uint32_t nb_cycle, 
+                               ledc_fade_param_config_t *pRange_list){
+
+    uint32_t dir = (end_duty >= start_duty) ? 1 : 0;
+    uint32_t delta = dir ? (end_duty - start_duty) : (start_duty - end_duty);
+    uint32_t nb_range = 0;
+
+    if(nb_cycle == 0){
+        nb_cycle = 1;
+    }
+
+    //One duty unit and one period per step at best, within the fields width
+    uint32_t step_num = (delta < nb_cycle) ? delta : nb_cycle;
+    if(step_num < DIV_CEIL(delta, LDRV_FADE_PARAM_MAX))     step_num = DIV_CEIL(delta, LDRV_FADE_PARAM_MAX);
+    if(step_num < DIV_CEIL(nb_cycle, LDRV_FADE_PARAM_MAX))  step_num = DIV_CEIL(nb_cycle, LDRV_FADE_PARAM_MAX);
+    if(step_num > LDRV_FADE_PARAM_MAX)                      step_num = LDRV_FADE_PARAM_MAX;
+
+    uint32_t scale = delta / step_num;
+    uint32_t scale_rem = delta % step_num;
+    uint32_t cycle_num = nb_cycle / step_num;
+    uint32_t cycle_rem = nb_cycle % step_num;
+
+    if(cycle_num >= LDRV_FADE_PARAM_MAX){
+        //Longest segment reached
+        cycle_num = LDRV_FADE_PARAM_MAX;
+        cycle_rem = 0;
+    }
+    else if(cycle_num == 0){
+        //Stretched segment
+        cycle_num = 1;
+        cycle_rem = 0;
+    }
+
+    //Steps with both remainders, then with the largest one only, then none
+    uint32_t split_1 = (scale_rem < cycle_rem) ? scale_rem : cycle_rem;
+    uint32_t split_2 = (scale_rem < cycle_rem) ? cycle_rem : scale_rem;
+
+    const ledc_fade_param_config_t group_list[LDRV_FADE_RANGE_PER_POINT] = {
+        {
+            .dir = dir,
+            .cycle_num = cycle_num + 1,
+            .scale = scale + 1,
+            .step_num = split_1,
+        },
+        {
+            .dir = dir,
+            .cycle_num = (cycle_rem > scale_rem) ? (cycle_num + 1) : cycle_num,
+            .scale = (scale_rem > cycle_rem) ? (scale + 1) : scale,
+            .step_num = split_2 - split_1,
+        },
+        {
+            .dir = dir,
+            .cycle_num = cycle_num,
+            .scale = scale,
+            .step_num = step_num - split_2,
+        },
+    };
+
+    for(uint8_t i=0; i<LDRV_FADE_RANGE_PER_POINT; i++){
+        if(group_list[i].step_num != 0){
+            pRange_list[nb_range++] = group_list[i];
+        }
+    }
+
+    return nb_range;
+}
+#else
+/***************************************************************************//*!
+*  \brief Play curve point.
+*
+*   Start the fade of the next curve segment and arm the timer for the 
+*   following one.
+*   
+*   Preconditions: Curve mutex is taken. A point remains to be played.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pCurve_info         Curve infos
+*
+*******************************************************************************/
+static void playCurvePoint(LDRV_Curve_Info_t *pCurve_info){
+
+    const LDRV_CFG_Fade_Point_t *pPoint = &pCurve_info->curve[pCurve_info->point_index];
+    const LDRV_CFG_Single_Pwm_Config_t *pConfig = pCurve_info->pConfig;
+    uint32_t duty = duty_lut[pConfig->active_level][pPoint->level];
+
+    if(pPoint->time_ms == 0){
+        ledc_set_duty(LDRV_TIMER_MODE, pConfig->led_channel, duty);
+        ledc_update_duty(LDRV_TIMER_MODE, pConfig->led_channel);
+    }
+    else{
+        ledc_set_fade_time_and_start(LDRV_TIMER_MODE, 
+                                     pConfig->led_channel, 
+                                     duty, 
+                                     pPoint->time_ms, 
+                                     LEDC_FADE_NO_WAIT);
+    }
+
+    pCurve_info->point_index++;
 
+    if(pCurve_info->point_index < pCurve_info->nb_point){
+        esp_timer_start_once(pCurve_info->timer_handle, (uint64_t)pPoint->time_ms * 1000);
+    }
+    else{
+        //Last segment started, curve done
+        pCurve_info->nb_point = 0;
+    }
+}
+#endif
 
 /******************************************************************************
 *   CallBack Functions implementation
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief Strip fade timer callback.
+*
+*   Called periodically while a led of the strip is fading. Compute the
+*   levels of the fading pixels and push the frame.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: The timer is stopped when all the fades are done.
+*
+*   \param[in]  arg                 Strip infos
+*
+*******************************************************************************/
+static void stripFadeTimerCallback(void *arg){
+
+    LDRV_Strip_Info_t *pStrip = (LDRV_Strip_Info_t *)arg;
+
+    xSemaphoreTake(strip_mutex_handle, portMAX_DELAY);
+
+    int64_t now_us = esp_timer_get_time();
+    uint32_t fade_mask = pStrip->fade_mask;
+
+    while(fade_mask != 0){
+        uint8_t pixel = (uint8_t)__builtin_ctz(fade_mask);
+        fade_mask &= (fade_mask - 1);
 
+        LDRV_Pixel_Fade_t *pFade = &pStrip->fade_table[pixel];
+        int64_t elapsed_us = now_us - pFade->start_time_us;
+        uint8_t level[LDRV_NB_COLOR];
+
+        if(elapsed_us >= pFade->fade_time_us){
+            memcpy(level, pFade->target_level, sizeof(level));
+            pStrip->fade_mask &= ~(1UL << pixel);
+        }
+        else{
+            for(uint8_t i=0; i<LDRV_NB_COLOR; i++){
+                int32_t delta = (int32_t)pFade->target_level[i] - (int32_t)pFade->start_level[i];
+                level[i] = (uint8_t)(pFade->start_level[i] + ((delta * elapsed_us) / pFade->fade_time_us));
+            }
+        }
+
+        writePixel(pStrip, pixel, level);
+    }
+
+    pushStrip(pStrip);
+
+    if(pStrip->fade_mask == 0){
+        esp_timer_stop(pStrip->fade_timer_handle);
+    }
+
+    xSemaphoreGive(strip_mutex_handle);
+}
+
+#if !SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+/***************************************************************************//*!
+*  \brief Curve timer callback.
+*
+*   Called at the end of a curve segment to play the next one.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  arg                 Curve infos
+*
+*******************************************************************************/
+static void curveTimerCallback(void *arg){
+
+    LDRV_Curve_Info_t *pCurve_info = (LDRV_Curve_Info_t *)arg;
+
+    xSemaphoreTake(curve_mutex_handle, portMAX_DELAY);
+
+    //The curve may have been stopped while the timer was expiring
+    if(pCurve_info->point_index < pCurve_info->nb_point){
+        playCurvePoint(pCurve_info);
+    }
+
+    xSemaphoreGive(curve_mutex_handle);
+}
+#endif
 
 /******************************************************************************
 *   Public Functions Definitions
@@ -71,11 +571,23 @@ static SemaphoreHandle_t ldrv_mutex_handle = NULL;
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_InitDriver(void){
 
-    ldrv_mutex_handle = xSemaphoreCreateMutex();
+    ldrv_mutex_handle = xSemaphoreCreateMutexStatic(&ldrv_mutex_buffer);
     if(ldrv_mutex_handle == NULL){
         return LDRV_CFG_STATUS_ERROR;
     }
 
+    strip_mutex_handle = xSemaphoreCreateMutexStatic(&strip_mutex_buffer);
+    if(strip_mutex_handle == NULL){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+#if !SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+    curve_mutex_handle = xSemaphoreCreateMutexStatic(&curve_mutex_buffer);
+    if(curve_mutex_handle == NULL){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+#endif
+
     return LDRV_CFG_STATUS_OK;
 }
 
@@ -149,15 +661,22 @@ LDRV_CFG_Ret_t LDRV_CFG_SetuptLedSingle(LDRV_CFG_Single_Config_t *pConfig){
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetupLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t *pConfig){
 
+    //Active level is used as duty-cycle table index
+    if(pConfig->active_level >= LDRV_CFG_ACTIVE_INVALID){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
     //Config ledc 
     ledc_timer_config_t ledc_timer = {
         .speed_mode = LDRV_TIMER_MODE,
-        .duty_resolution = LDRV_DEFAULT_DUTY_RES,
+        .duty_resolution = (ledc_timer_bit_t)LDRV_CFG_PWM_DUTY_RES_BITS,
         .timer_num = pConfig->led_timer,
-        .freq_hz = LDRV_DEFAULT_FREQ_HZ,
+        .freq_hz = LDRV_CFG_PWM_FREQ_HZ,
         .clk_cfg = LEDC_USE_XTAL_CLK,
     };
-    ledc_timer_config(&ledc_timer);
+    if(ESP_OK != ledc_timer_config(&ledc_timer)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
 
     ledc_channel_config_t ledc_channel = {
         .speed_mode = LDRV_TIMER_MODE,
@@ -165,13 +684,11 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t *pConfig)
         .timer_sel = pConfig->led_timer,
         .intr_type = LEDC_INTR_DISABLE,
         .gpio_num = pConfig->gpio_num,
-        .duty = LDRV_CFG_MIN_PWM_DUTY,
+        .duty = duty_lut[pConfig->active_level][LDRV_CFG_MIN_LEVEL],
         .hpoint = 0,
     };
-    ///Inverse duty cycle min value if active low
-    if(pConfig->active_level == LDRV_CFG_ACTIVE_LOW)   ledc_channel.duty = LDRV_CFG_MAX_PWM_DUTY;
-
     ledc_channel_config(&ledc_channel);
+    shadow_duty_table[pConfig->led_channel] = ledc_channel.duty;
 
     return LDRV_CFG_STATUS_OK;
 }
@@ -192,15 +709,22 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t *pConfig)
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig){
 
+    //Active level is used as duty-cycle table index
+    if(pConfig->active_level >= LDRV_CFG_ACTIVE_INVALID){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
     //config ledc timer 
     ledc_timer_config_t ledc_timer = {
         .speed_mode = LDRV_TIMER_MODE,
-        .duty_resolution = LDRV_DEFAULT_DUTY_RES,
+        .duty_resolution = (ledc_timer_bit_t)LDRV_CFG_PWM_DUTY_RES_BITS,
         .timer_num = pConfig->led_timer,
-        .freq_hz = LDRV_DEFAULT_FREQ_HZ,
+        .freq_hz = LDRV_CFG_PWM_FREQ_HZ,
         .clk_cfg = LEDC_USE_XTAL_CLK,
     };
-    ledc_timer_config(&ledc_timer);
+    if(ESP_OK != ledc_timer_config(&ledc_timer)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
 
     //config ledc channels
     ledc_channel_config_t rgb_channel = {
@@ -209,11 +733,9 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig){
         .timer_sel = pConfig->led_timer,
         .intr_type = LEDC_INTR_DISABLE,
         .gpio_num = pConfig->red_gpio_num,
-        .duty = LDRV_CFG_MIN_PWM_DUTY,
+        .duty = duty_lut[pConfig->active_level][LDRV_CFG_MIN_LEVEL],
         .hpoint = 0,
     };
-    //Inverse duty cycle min value if active low
-    if(pConfig->active_level == LDRV_CFG_ACTIVE_LOW)  rgb_channel.duty = LDRV_CFG_MAX_PWM_DUTY;
     ledc_channel_config(&rgb_channel);
 
     rgb_channel.channel = pConfig->green_channel;
@@ -224,6 +746,95 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig){
     rgb_channel.gpio_num = pConfig->blue_gpio_num;
     ledc_channel_config(&rgb_channel);
 
+    shadow_duty_table[pConfig->red_channel] = rgb_channel.duty;
+    shadow_duty_table[pConfig->green_channel] = rgb_channel.duty;
+    shadow_duty_table[pConfig->blue_channel] = rgb_channel.duty;
+
+    return LDRV_CFG_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Setup addressable led.
+*
+*   Setup the RMT channel of the led strip on first use, leds sharing the
+*   data line share the strip. The strip is cleared on creation.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in,out]  pConfig         Pointer to led configuration (strip index set)
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_SetupLedAddressable(LDRV_CFG_Addressable_Config_t *pConfig){
+
+    if((pConfig->nb_pixel == 0) || 
+       (pConfig->nb_pixel > LDRV_CFG_MAX_STRIP_PIXEL) || 
+       (pConfig->pixel_index >= pConfig->nb_pixel)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    //Led on an existing strip
+    for(uint8_t i=0; i<nb_strip; i++){
+        if(strip_table[i].gpio_num == pConfig->gpio_num){
+            if(strip_table[i].nb_pixel != pConfig->nb_pixel){
+                return LDRV_CFG_STATUS_ERROR;
+            }
+
+            pConfig->strip_index = i;
+            return LDRV_CFG_STATUS_OK;
+        }
+    }
+
+    if(nb_strip >= LDRV_CFG_MAX_NB_STRIP){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    LDRV_Strip_Info_t *pStrip = &strip_table[nb_strip];
+
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = pConfig->gpio_num,
+        .max_leds = pConfig->nb_pixel,
+        .led_model = LED_MODEL_WS2812,
+        .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
+        .flags.invert_out = false,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = LDRV_CFG_STRIP_RMT_RES_HZ,
+        .mem_block_symbols = LDRV_STRIP_MEM_SYMBOLS,
+        .flags.with_dma = LDRV_STRIP_WITH_DMA,
+    };
+    if(ESP_OK != led_strip_new_rmt_device(&strip_config, &rmt_config, &pStrip->strip_handle)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = stripFadeTimerCallback,
+        .arg = pStrip,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ldrv_strip",
+        .skip_unhandled_events = true,
+    };
+    if(ESP_OK != esp_timer_create(&timer_args, &pStrip->fade_timer_handle)){
+        led_strip_del(pStrip->strip_handle);
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    //Set leds OFF after setup
+    led_strip_clear(pStrip->strip_handle);
+
+    pStrip->gpio_num = pConfig->gpio_num;
+    pStrip->nb_pixel = pConfig->nb_pixel;
+    pStrip->dirty = false;
+    pStrip->fade_mask = 0;
+    memset(pStrip->frame, LDRV_CFG_MIN_LEVEL, sizeof(pStrip->frame));
+
+    pConfig->strip_index = nb_strip;
+    nb_strip++;
+
     return LDRV_CFG_STATUS_OK;
 }
 
@@ -243,7 +854,7 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig){
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedSingleState(uint8_t state, 
-                                          LDRV_CFG_Single_Config_t *pConfig){
+                                          const LDRV_CFG_Single_Config_t *pConfig){
 
     if(((state >= 1) && (pConfig->active_level == LDRV_CFG_ACTIVE_HIGH)) || 
       ((state == 0) && (pConfig->active_level == LDRV_CFG_ACTIVE_LOW))){
@@ -262,57 +873,81 @@ LDRV_CFG_Ret_t LDRV_CFG_SetLedSingleState(uint8_t state,
 /***************************************************************************//*!
 *  \brief Set single led pwm duty-cycle.
 *
-*   Set the duty-cycle of a single led.
+*   Set the duty-cycle of a single led from a perceptual brightness level.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  duty                Led duty-cycle
+*   \param[in]  level               Led brightness level
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmDuty(uint32_t duty, 
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig){
+LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmDuty(uint8_t level, 
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig){
+
+    LDRV_CFG_Batch_t batch = {0};
 
-    if(ESP_OK != ledc_set_duty(LDRV_TIMER_MODE, pConfig->led_channel, duty)){
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_StageLedSinglePwmDuty(level, pConfig, &batch)){
         return LDRV_CFG_STATUS_ERROR;
     }
-    else{
 
-        if(ESP_OK != ledc_update_duty(LDRV_TIMER_MODE, pConfig->led_channel)){
-            return LDRV_CFG_STATUS_ERROR;
-        }
-    }
+    return LDRV_CFG_CommitBatch(&batch);
+}
 
-    return LDRV_CFG_STATUS_OK;
+/***************************************************************************//*!
+*  \brief Stage single led pwm duty-cycle.
+*
+*   Write the duty-cycle of a single led without applying it. The write is
+*   skipped if the output is already at this duty-cycle.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      level           Led brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedSinglePwmDuty(uint8_t level, 
+                                              const LDRV_CFG_Single_Pwm_Config_t *pConfig,
+                                              LDRV_CFG_Batch_t *pBatch){
+
+    return stageDuty(pConfig->led_channel, duty_lut[pConfig->active_level][level], pBatch);
 }
 
 /***************************************************************************//*!
 *  \brief Fade the duty-cycle of a single led.
 *
-*   Fade the duty-cycle to a target value over an amount of time (in ms).
+*   Fade the duty-cycle to a target brightness level over an amount of time
+*   (in ms).
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  target_duty         Final duty-cycle
+*   \param[in]  target_level        Final brightness level
 *   \param[in]  fade_time_ms        Fade time in ms
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_FadeLedSinglePwmDuty(uint32_t target_duty, 
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedSinglePwmDuty(uint8_t target_level, 
                                              uint32_t fade_time_ms, 
-                                             LDRV_CFG_Single_Pwm_Config_t *pConfig){
+                                             const LDRV_CFG_Single_Pwm_Config_t *pConfig){
+
+    stopFadeCurve(pConfig->led_channel);
+    shadow_duty_table[pConfig->led_channel] = LDRV_DUTY_UNKNOWN;
 
     if(ESP_OK != ledc_set_fade_time_and_start(LDRV_TIMER_MODE, 
                                               pConfig->led_channel, 
-                                              target_duty, 
+                                              duty_lut[pConfig->active_level][target_level], 
                                               fade_time_ms, 
                                               LEDC_FADE_NO_WAIT)){
 
@@ -323,88 +958,260 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedSinglePwmDuty(uint32_t target_duty,
 }
 
 /***************************************************************************//*!
-*  \brief Set RGB led pwm duty-cycles.
+*  \brief Play a fade curve on a single led.
 *
-*   Set the duty-cycles of a RGB led.
+*   Fade the duty-cycle through all the curve points, starting from the
+*   current output. The curve is played by the LEDC gradient fade hardware
+*   when available, otherwise the segments are chained by a software timer.
 *   
-*   Preconditions: None.
+*   Preconditions: Fade service is started.
 *
 *   Side Effects: None.
 *
-*   \param[in]  red_duty            RGB red duty-cycle
-*   \param[in]  green_duty          RGB green duty-cycle
-*   \param[in]  blue_duty           RGB blue duty-cycle
+*   \param[in]  pCurve              Fade curve points
+*   \param[in]  nb_point            Number of points (<= LDRV_CFG_MAX_FADE_POINT)
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbColor(uint32_t red_duty, 
-                                       uint32_t green_duty, 
-                                       uint32_t blue_duty, 
-                                       LDRV_CFG_Rgb_Config_t *pConfig){
+LDRV_CFG_Ret_t LDRV_CFG_PlayFadeCurveSinglePwm(const LDRV_CFG_Fade_Point_t *pCurve,
+                                               uint8_t nb_point,
+                                               const LDRV_CFG_Single_Pwm_Config_t *pConfig){
 
-    //set and update red rgb duty-cycle
-    if(ESP_OK != ledc_set_duty(LDRV_TIMER_MODE, pConfig->red_channel, red_duty)){
+    if((pCurve == NULL) || (nb_point == 0) || (nb_point > LDRV_CFG_MAX_FADE_POINT)){
         return LDRV_CFG_STATUS_ERROR;
     }
-    else{
-        if(ESP_OK != ledc_update_duty(LDRV_TIMER_MODE, pConfig->red_channel)){
-            return LDRV_CFG_STATUS_ERROR;
-        }
+
+    stopFadeCurve(pConfig->led_channel);
+    shadow_duty_table[pConfig->led_channel] = LDRV_DUTY_UNKNOWN;
+
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+    ledc_fade_param_config_t range_list[LDRV_FADE_RANGE_MAX];
+    uint32_t nb_range = 0;
+    uint32_t freq_hz = ledc_get_freq(LDRV_TIMER_MODE, pConfig->led_timer);
+    uint32_t start_duty = ledc_get_duty(LDRV_TIMER_MODE, pConfig->led_channel);
+    uint32_t duty = start_duty;
+
+    //The whole curve is uploaded, the peripheral plays it alone
+    for(uint8_t i=0; i<nb_point; i++){
+        uint32_t end_duty = duty_lut[pConfig->active_level][pCurve[i].level];
+        uint32_t nb_cycle = (uint32_t)(((uint64_t)pCurve[i].time_ms * freq_hz) / 1000);
+
+        nb_range += fillFadeRanges(duty, end_duty, nb_cycle, &range_list[nb_range]);
+        duty = end_duty;
     }
 
-    //set and update green duty-cycle
-    if(ESP_OK != ledc_set_duty(LDRV_TIMER_MODE, pConfig->green_channel, green_duty)){
+    if(ESP_OK != ledc_set_multi_fade_and_start(LDRV_TIMER_MODE, 
+                                               pConfig->led_channel, 
+                                               start_duty, 
+                                               range_list, 
+                                               nb_range, 
+                                               LEDC_FADE_NO_WAIT)){
+
         return LDRV_CFG_STATUS_ERROR;
-    }   
-    else{
-        if(ESP_OK != ledc_update_duty(LDRV_TIMER_MODE, pConfig->green_channel)){
-            return LDRV_CFG_STATUS_ERROR;
+    }
+#else
+    LDRV_Curve_Info_t *pCurve_info = &curve_info_table[pConfig->led_channel];
+    LDRV_CFG_Ret_t ret = LDRV_CFG_STATUS_OK;
+
+    xSemaphoreTake(curve_mutex_handle, portMAX_DELAY);
+
+    if(pCurve_info->timer_handle == NULL){
+        esp_timer_create_args_t timer_args = {
+            .callback = curveTimerCallback,
+            .arg = pCurve_info,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "ldrv_curve",
+        };
+
+        if(ESP_OK != esp_timer_create(&timer_args, &pCurve_info->timer_handle)){
+            ret = LDRV_CFG_STATUS_ERROR;
         }
-    } 
+    }
+
+    if(ret == LDRV_CFG_STATUS_OK){
+        memcpy(pCurve_info->curve, pCurve, nb_point * sizeof(LDRV_CFG_Fade_Point_t));
+        pCurve_info->nb_point = nb_point;
+        pCurve_info->point_index = 0;
+        pCurve_info->pConfig = pConfig;
+
+        playCurvePoint(pCurve_info);
+    }
+
+    xSemaphoreGive(curve_mutex_handle);
+
+    if(ret != LDRV_CFG_STATUS_OK){
+        return ret;
+    }
+#endif
+
+    return LDRV_CFG_STATUS_OK;
+}
+
+/***************************************************************************//*!
+*  \brief Set RGB led pwm duty-cycles.
+*
+*   Set the duty-cycles of a RGB led from perceptual brightness levels.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  red_level           RGB red brightness level
+*   \param[in]  green_level         RGB green brightness level
+*   \param[in]  blue_level          RGB blue brightness level
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbColor(uint8_t red_level, 
+                                       uint8_t green_level, 
+                                       uint8_t blue_level, 
+                                       const LDRV_CFG_Rgb_Config_t *pConfig){
+
+    LDRV_CFG_Batch_t batch = {0};
 
-    //set and update blue duty-cycle
-    if(ESP_OK != ledc_set_duty(LDRV_TIMER_MODE, pConfig->blue_channel, blue_duty)){
+    //All channels are latched together so the color does not tear
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_StageLedRgbColor(red_level, green_level, blue_level, pConfig, &batch)){
         return LDRV_CFG_STATUS_ERROR;
     }
-    else{
-        if(ESP_OK != ledc_update_duty(LDRV_TIMER_MODE, pConfig->blue_channel)){
-            return LDRV_CFG_STATUS_ERROR;
-        }
+
+    return LDRV_CFG_CommitBatch(&batch);
+}
+
+/***************************************************************************//*!
+*  \brief Stage RGB led pwm duty-cycles.
+*
+*   Write the duty-cycles of a RGB led without applying them. The writes are
+*   skipped for the channels already at the requested duty-cycle.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      red_level       RGB red brightness level
+*   \param[in]      green_level     RGB green brightness level
+*   \param[in]      blue_level      RGB blue brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedRgbColor(uint8_t red_level, 
+                                         uint8_t green_level, 
+                                         uint8_t blue_level, 
+                                         const LDRV_CFG_Rgb_Config_t *pConfig,
+                                         LDRV_CFG_Batch_t *pBatch){
+
+    const uint32_t *pLut = duty_lut[pConfig->active_level];
+
+    if((LDRV_CFG_STATUS_OK != stageDuty(pConfig->red_channel, pLut[red_level], pBatch)) ||
+       (LDRV_CFG_STATUS_OK != stageDuty(pConfig->green_channel, pLut[green_level], pBatch)) ||
+       (LDRV_CFG_STATUS_OK != stageDuty(pConfig->blue_channel, pLut[blue_level], pBatch))){
+
+        return LDRV_CFG_STATUS_ERROR;
     }
 
     return LDRV_CFG_STATUS_OK;
 }
 
+/***************************************************************************//*!
+*  \brief Commit batch.
+*
+*   Apply all the staged duty-cycles of a batch back to back, so channels 
+*   sharing a timer switch on the same PWM period, then push the staged
+*   strip frames.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: The batch is emptied.
+*
+*   \param[in,out]  pBatch          Batch to apply
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_CommitBatch(LDRV_CFG_Batch_t *pBatch){
+
+    LDRV_CFG_Ret_t ret = LDRV_CFG_STATUS_OK;
+    uint32_t channel_mask = pBatch->channel_mask;
+
+    //No preemption between the updates, they must land on the same period
+    portENTER_CRITICAL(&batch_spinlock);
+
+    while(channel_mask != 0){
+        ledc_channel_t channel = (ledc_channel_t)__builtin_ctz(channel_mask);
+        channel_mask &= (channel_mask - 1);
+
+        if(ESP_OK != ledc_update_duty(LDRV_TIMER_MODE, channel)){
+            shadow_duty_table[channel] = LDRV_DUTY_UNKNOWN;
+            ret = LDRV_CFG_STATUS_ERROR;
+        }
+    }
+
+    portEXIT_CRITICAL(&batch_spinlock);
+
+    uint32_t strip_mask = pBatch->strip_mask;
+
+    if(strip_mask != 0){
+        xSemaphoreTake(strip_mutex_handle, portMAX_DELAY);
+
+        while(strip_mask != 0){
+            uint8_t strip_index = (uint8_t)__builtin_ctz(strip_mask);
+            strip_mask &= (strip_mask - 1);
+
+            if(LDRV_CFG_STATUS_OK != pushStrip(&strip_table[strip_index])){
+                ret = LDRV_CFG_STATUS_ERROR;
+            }
+        }
+
+        xSemaphoreGive(strip_mutex_handle);
+    }
+
+    pBatch->channel_mask = 0;
+    pBatch->strip_mask = 0;
+
+    return ret;
+}
+
 /***************************************************************************//*!
 *  \brief Fade the duty-cycles of a RGB led.
 *
-*   Fade the duty-cycles to target values over an amount of time (in ms).
+*   Fade the duty-cycles to target brightness levels over an amount of time
+*   (in ms).
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  target_red_duty         Final RGB red duty-cycle
-*   \param[in]  target_green_duty       Final RGB green duty-cycle 
-*   \param[in]  target_blue_duty        Final RGB blue duty-cycle
+*   \param[in]  target_red_level        Final RGB red brightness level
+*   \param[in]  target_green_level      Final RGB green brightness level
+*   \param[in]  target_blue_level       Final RGB blue brightness level
 *   \param[in]  fade_time_ms            Fade time in ms
 *   \param[in]  pConfig                 Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
-                                        uint32_t target_green_duty,
-                                        uint32_t target_blue_duty,
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint8_t target_red_level,
+                                        uint8_t target_green_level,
+                                        uint8_t target_blue_level,
                                         uint32_t fade_time_ms,
-                                        LDRV_CFG_Rgb_Config_t *pConfig){
+                                        const LDRV_CFG_Rgb_Config_t *pConfig){
+
+    const uint32_t *pLut = duty_lut[pConfig->active_level];
+
+    shadow_duty_table[pConfig->red_channel] = LDRV_DUTY_UNKNOWN;
+    shadow_duty_table[pConfig->green_channel] = LDRV_DUTY_UNKNOWN;
+    shadow_duty_table[pConfig->blue_channel] = LDRV_DUTY_UNKNOWN;
 
     //Start red rgb fade
     if(ESP_OK != ledc_set_fade_time_and_start(LDRV_TIMER_MODE, 
                                               pConfig->red_channel, 
-                                              target_red_duty, 
+                                              pLut[target_red_level], 
                                               fade_time_ms, 
                                               LEDC_FADE_NO_WAIT)){
 
@@ -414,7 +1221,7 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
     //Start green rgb fade
     if(ESP_OK != ledc_set_fade_time_and_start(LDRV_TIMER_MODE, 
                                               pConfig->green_channel, 
-                                              target_green_duty, 
+                                              pLut[target_green_level], 
                                               fade_time_ms, 
                                               LEDC_FADE_NO_WAIT)){
 
@@ -424,7 +1231,7 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
     //Start blue rgb fade
     if(ESP_OK != ledc_set_fade_time_and_start(LDRV_TIMER_MODE, 
                                               pConfig->blue_channel, 
-                                              target_blue_duty, 
+                                              pLut[target_blue_level], 
                                               fade_time_ms, 
                                               LEDC_FADE_NO_WAIT)){
 
@@ -434,6 +1241,142 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
     return LDRV_CFG_STATUS_OK;
 }
 
+/***************************************************************************//*!
+*  \brief Set addressable led color.
+*
+*   Set the color of an addressable led from perceptual brightness levels
+*   and push the strip frame if it changed.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  red_level           Red brightness level
+*   \param[in]  green_level         Green brightness level
+*   \param[in]  blue_level          Blue brightness level
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_SetLedAddressableColor(uint8_t red_level, 
+                                               uint8_t green_level, 
+                                               uint8_t blue_level, 
+                                               const LDRV_CFG_Addressable_Config_t *pConfig){
+
+    LDRV_CFG_Batch_t batch = {0};
+
+    if(LDRV_CFG_STATUS_OK != LDRV_CFG_StageLedAddressableColor(red_level, green_level, blue_level, pConfig, &batch)){
+        return LDRV_CFG_STATUS_ERROR;
+    }
+
+    return LDRV_CFG_CommitBatch(&batch);
+}
+
+/***************************************************************************//*!
+*  \brief Stage addressable led color.
+*
+*   Write the color of an addressable led in the strip frame without pushing
+*   it. The write is skipped if the led is already at this color.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      red_level       Red brightness level
+*   \param[in]      green_level     Green brightness level
+*   \param[in]      blue_level      Blue brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedAddressableColor(uint8_t red_level, 
+                                                 uint8_t green_level, 
+                                                 uint8_t blue_level, 
+                                                 const LDRV_CFG_Addressable_Config_t *pConfig,
+                                                 LDRV_CFG_Batch_t *pBatch){
+
+    const uint8_t level[LDRV_NB_COLOR] = {red_level, green_level, blue_level};
+    LDRV_Strip_Info_t *pStrip = &strip_table[pConfig->strip_index];
+    LDRV_CFG_Ret_t ret;
+
+    xSemaphoreTake(strip_mutex_handle, portMAX_DELAY);
+
+    //Cancel a running fade of the led
+    pStrip->fade_mask &= ~(1UL << pConfig->pixel_index);
+
+    ret = writePixel(pStrip, pConfig->pixel_index, level);
+    pBatch->strip_mask |= (1UL << pConfig->strip_index);
+
+    xSemaphoreGive(strip_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Fade addressable led color.
+*
+*   Fade an addressable led to target brightness levels over an amount of 
+*   time (in ms). The strip frames are computed and pushed by a software 
+*   timer while a led of the strip is fading.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  target_red_level    Final red brightness level
+*   \param[in]  target_green_level  Final green brightness level
+*   \param[in]  target_blue_level   Final blue brightness level
+*   \param[in]  fade_time_ms        Fade time in ms
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedAddressableColor(uint8_t target_red_level,
+                                                uint8_t target_green_level,
+                                                uint8_t target_blue_level,
+                                                uint32_t fade_time_ms,
+                                                const LDRV_CFG_Addressable_Config_t *pConfig){
+
+    if(fade_time_ms == 0){
+        return LDRV_CFG_SetLedAddressableColor(target_red_level, 
+                                               target_green_level, 
+                                               target_blue_level, 
+                                               pConfig);
+    }
+
+    LDRV_Strip_Info_t *pStrip = &strip_table[pConfig->strip_index];
+    LDRV_Pixel_Fade_t *pFade = &pStrip->fade_table[pConfig->pixel_index];
+    LDRV_CFG_Ret_t ret = LDRV_CFG_STATUS_OK;
+
+    xSemaphoreTake(strip_mutex_handle, portMAX_DELAY);
+
+    //Start from the current output, even in the middle of a fade
+    memcpy(pFade->start_level, pStrip->frame[pConfig->pixel_index], sizeof(pFade->start_level));
+    pFade->target_level[LDRV_RED] = target_red_level;
+    pFade->target_level[LDRV_GREEN] = target_green_level;
+    pFade->target_level[LDRV_BLUE] = target_blue_level;
+    pFade->start_time_us = esp_timer_get_time();
+    pFade->fade_time_us = fade_time_ms * 1000;
+    pStrip->fade_mask |= (1UL << pConfig->pixel_index);
+
+    if(!esp_timer_is_active(pStrip->fade_timer_handle)){
+        if(ESP_OK != esp_timer_start_periodic(pStrip->fade_timer_handle, 
+                                              LDRV_CFG_STRIP_FADE_PERIOD_MS * 1000)){
+
+            pStrip->fade_mask &= ~(1UL << pConfig->pixel_index);
+            ret = LDRV_CFG_STATUS_ERROR;
+        }
+    }
+
+    xSemaphoreGive(strip_mutex_handle);
+
+    return ret;
+}
+
 /***************************************************************************//*!
 *  \brief Set single led pwm frequency
 *
@@ -450,7 +1393,7 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmFreq(uint32_t freq_hz, 
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig){
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig){
 
     if(ESP_OK != ledc_set_freq(LDRV_TIMER_MODE, pConfig->led_timer, freq_hz)){
         return LDRV_CFG_STATUS_ERROR;
@@ -475,7 +1418,7 @@ LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmFreq(uint32_t freq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbFreq(uint32_t freq_hz, 
-                                      LDRV_CFG_Rgb_Config_t *pConfig){
+                                      const LDRV_CFG_Rgb_Config_t *pConfig){
 
     if(ESP_OK != ledc_set_freq(LDRV_TIMER_MODE, pConfig->led_timer, freq_hz)){
         return LDRV_CFG_STATUS_ERROR;
@@ -500,7 +1443,7 @@ LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbFreq(uint32_t freq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_GetLedSinglePwmFreq(uint32_t *pFreq_hz,
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig){
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig){
 
     *pFreq_hz = ledc_get_freq(LDRV_TIMER_MODE, pConfig->led_timer);
 
@@ -523,13 +1466,32 @@ LDRV_CFG_Ret_t LDRV_CFG_GetLedSinglePwmFreq(uint32_t *pFreq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_GetLedRgbFreq(uint32_t *pFreq_hz,
-                                      LDRV_CFG_Rgb_Config_t *pConfig){
+                                      const LDRV_CFG_Rgb_Config_t *pConfig){
 
     *pFreq_hz = ledc_get_freq(LDRV_TIMER_MODE, pConfig->led_timer);
 
     return LDRV_CFG_STATUS_OK;
 }
 
+/***************************************************************************//*!
+*  \brief Get duty-cycle write statistics
+*
+*   Get the number of duty-cycle writes issued to the peripheral and the
+*   number of writes skipped because the output was unchanged.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out]  pStats             Pointer to store the statistics
+*
+*******************************************************************************/
+void LDRV_CFG_GetWriteStats(LDRV_CFG_Write_Stats_t *pStats){
+
+    pStats->issued = (uint32_t)atomic_load_explicit(&write_issued_cptr, memory_order_relaxed);
+    pStats->skipped = (uint32_t)atomic_load_explicit(&write_skipped_cptr, memory_order_relaxed);
+}
+
 /***************************************************************************//*!
 *  \brief Take led driver mutex
 *
@@ -8,8 +8,24 @@
 *   Public Definitions
 *******************************************************************************/
 #define LDRV_CFG_MAX_NB_LED                 (2)
-#define LDRV_CFG_MAX_PWM_DUTY               (255)
-#define LDRV_CFG_MIN_PWM_DUTY               (0)
+
+//Perceptual brightness levels (gamma corrected to duty-cycle)
+#define LDRV_CFG_MAX_LEVEL                  (255)
+#define LDRV_CFG_MIN_LEVEL                  (0)
+#define LDRV_CFG_NB_LEVEL                   (LDRV_CFG_MAX_LEVEL + 1)
+
+//PWM timer setup (resolution limited to XTAL_CLK / frequency)
+#define LDRV_CFG_PWM_FREQ_HZ                (1000)
+#define LDRV_CFG_PWM_DUTY_RES_BITS          (15)
+
+//Fade curve length (up to 3 hardware fade ranges per point)
+#define LDRV_CFG_MAX_FADE_POINT             (5)
+
+//Addressable led strips (WS2812 driven by RMT)
+#define LDRV_CFG_MAX_NB_STRIP               (1)
+#define LDRV_CFG_MAX_STRIP_PIXEL            (16)
+#define LDRV_CFG_STRIP_RMT_RES_HZ           (10000000)//0.1us per RMT tick
+#define LDRV_CFG_STRIP_FADE_PERIOD_MS       (20)//Frame rate while fading
 
 /******************************************************************************
 *   Public Macros
@@ -50,6 +66,28 @@ typedef struct LDRV_CFG_Rgb_Config_s{
     ledc_channel_t blue_channel;
 }LDRV_CFG_Rgb_Config_t;
 
+typedef struct LDRV_CFG_Addressable_Config_s{
+    uint8_t gpio_num;//Strip data line
+    uint8_t nb_pixel;//Strip length, same for all the leds of a strip
+    uint8_t pixel_index;//Led position on the strip
+    uint8_t strip_index;//Set on setup
+}LDRV_CFG_Addressable_Config_t;
+
+typedef struct LDRV_CFG_Fade_Point_s{
+    uint8_t level;//Brightness level reached at the end of the segment
+    uint32_t time_ms;//Segment duration
+}LDRV_CFG_Fade_Point_t;
+
+typedef struct LDRV_CFG_Batch_s{
+    uint32_t channel_mask;//Channels with a staged duty-cycle
+    uint32_t strip_mask;//Strips with a staged frame
+}LDRV_CFG_Batch_t;
+
+typedef struct LDRV_CFG_Write_Stats_s{
+    uint32_t issued;//Duty-cycle and pixel writes sent to the peripheral
+    uint32_t skipped;//Duty-cycle and pixel writes dropped (output unchanged)
+}LDRV_CFG_Write_Stats_t;
+
 typedef enum LDRV_CFG_Ret_e{
     LDRV_CFG_STATUS_ERROR,
     LDRV_CFG_STATUS_OK,
@@ -146,6 +184,23 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedSinglePwm(LDRV_CFG_Single_Pwm_Config_t *pConfig)
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig);
 
+/***************************************************************************//*!
+*  \brief Setup addressable led.
+*
+*   Setup the RMT channel of the led strip on first use, leds sharing the
+*   data line share the strip. The strip is cleared on creation.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in,out]  pConfig         Pointer to led configuration (strip index set)
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_SetupLedAddressable(LDRV_CFG_Addressable_Config_t *pConfig);
+
 /***************************************************************************//*!
 *  \brief Set single led state.
 *
@@ -162,91 +217,253 @@ LDRV_CFG_Ret_t LDRV_CFG_SetupLedRgb(LDRV_CFG_Rgb_Config_t *pConfig);
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedSingleState(uint8_t state, 
-                                          LDRV_CFG_Single_Config_t *pConfig);
+                                          const LDRV_CFG_Single_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Set single led pwm duty-cycle.
 *
-*   Set the duty-cycle of a single led.
+*   Set the duty-cycle of a single led from a perceptual brightness level.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  duty                Led duty-cycle
+*   \param[in]  level               Led brightness level
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmDuty(uint32_t duty, 
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig);
+LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmDuty(uint8_t level, 
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Stage single led pwm duty-cycle.
+*
+*   Write the duty-cycle of a single led without applying it. The write is
+*   skipped if the output is already at this duty-cycle.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      level           Led brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedSinglePwmDuty(uint8_t level, 
+                                              const LDRV_CFG_Single_Pwm_Config_t *pConfig,
+                                              LDRV_CFG_Batch_t *pBatch);
 
 /***************************************************************************//*!
 *  \brief Fade the duty-cycle of a single led.
 *
-*   Fade the duty-cycle to a target value over an amount of time (in ms).
+*   Fade the duty-cycle to a target brightness level over an amount of time
+*   (in ms).
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  target_duty         Final duty-cycle
+*   \param[in]  target_level        Final brightness level
 *   \param[in]  fade_time_ms        Fade time in ms
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_FadeLedSinglePwmDuty(uint32_t target_duty, 
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedSinglePwmDuty(uint8_t target_level, 
                                              uint32_t fade_time_ms, 
-                                             LDRV_CFG_Single_Pwm_Config_t *pConfig);
+                                             const LDRV_CFG_Single_Pwm_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Play a fade curve on a single led.
+*
+*   Fade the duty-cycle through all the curve points, starting from the
+*   current output. The curve is played by the LEDC gradient fade hardware
+*   when available, otherwise the segments are chained by a software timer.
+*   
+*   Preconditions: Fade service is started.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pCurve              Fade curve points
+*   \param[in]  nb_point            Number of points (<= LDRV_CFG_MAX_FADE_POINT)
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_PlayFadeCurveSinglePwm(const LDRV_CFG_Fade_Point_t *pCurve,
+                                               uint8_t nb_point,
+                                               const LDRV_CFG_Single_Pwm_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Set RGB led pwm duty-cycles.
 *
-*   Set the duty-cycles of a RGB led.
+*   Set the duty-cycles of a RGB led from perceptual brightness levels.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  red_duty            RGB red duty-cycle
-*   \param[in]  green_duty          RGB green duty-cycle
-*   \param[in]  blue_duty           RGB blue duty-cycle
+*   \param[in]  red_level           RGB red brightness level
+*   \param[in]  green_level         RGB green brightness level
+*   \param[in]  blue_level          RGB blue brightness level
 *   \param[in]  pConfig             Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbColor(uint32_t red_duty, 
-                                       uint32_t green_duty, 
-                                       uint32_t blue_duty, 
-                                       LDRV_CFG_Rgb_Config_t *pConfig);
+LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbColor(uint8_t red_level, 
+                                       uint8_t green_level, 
+                                       uint8_t blue_level, 
+                                       const LDRV_CFG_Rgb_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Stage RGB led pwm duty-cycles.
+*
+*   Write the duty-cycles of a RGB led without applying them. The writes are
+*   skipped for the channels already at the requested duty-cycle.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      red_level       RGB red brightness level
+*   \param[in]      green_level     RGB green brightness level
+*   \param[in]      blue_level      RGB blue brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedRgbColor(uint8_t red_level, 
+                                         uint8_t green_level, 
+                                         uint8_t blue_level, 
+                                         const LDRV_CFG_Rgb_Config_t *pConfig,
+                                         LDRV_CFG_Batch_t *pBatch);
+
+/***************************************************************************//*!
+*  \brief Commit batch.
+*
+*   Apply all the staged duty-cycles of a batch back to back, so channels 
+*   sharing a timer switch on the same PWM period, then push the staged
+*   strip frames.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: The batch is emptied.
+*
+*   \param[in,out]  pBatch          Batch to apply
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_CommitBatch(LDRV_CFG_Batch_t *pBatch);
 
 /***************************************************************************//*!
 *  \brief Fade the duty-cycles of a RGB led.
 *
-*   Fade the duty-cycles to target values over an amount of time (in ms).
+*   Fade the duty-cycles to target brightness levels over an amount of time
+*   (in ms).
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  target_red_duty         Final RGB red duty-cycle
-*   \param[in]  target_green_duty       Final RGB green duty-cycle 
-*   \param[in]  target_blue_duty        Final RGB blue duty-cycle
+*   \param[in]  target_red_level        Final RGB red brightness level
+*   \param[in]  target_green_level      Final RGB green brightness level
+*   \param[in]  target_blue_level       Final RGB blue brightness level
 *   \param[in]  fade_time_ms            Fade time in ms
 *   \param[in]  pConfig                 Pointer to led configuration
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
-                                        uint32_t target_green_duty,
-                                        uint32_t target_blue_duty,
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint8_t target_red_level,
+                                        uint8_t target_green_level,
+                                        uint8_t target_blue_level,
                                         uint32_t fade_time_ms,
-                                        LDRV_CFG_Rgb_Config_t *pConfig);
+                                        const LDRV_CFG_Rgb_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Set addressable led color.
+*
+*   Set the color of an addressable led from perceptual brightness levels
+*   and push the strip frame if it changed.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  red_level           Red brightness level
+*   \param[in]  green_level         Green brightness level
+*   \param[in]  blue_level          Blue brightness level
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_SetLedAddressableColor(uint8_t red_level, 
+                                               uint8_t green_level, 
+                                               uint8_t blue_level, 
+                                               const LDRV_CFG_Addressable_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Stage addressable led color.
+*
+*   Write the color of an addressable led in the strip frame without pushing
+*   it. The write is skipped if the led is already at this color.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: LDRV_CFG_CommitBatch() must be called to apply the batch.
+*
+*   \param[in]      red_level       Red brightness level
+*   \param[in]      green_level     Green brightness level
+*   \param[in]      blue_level      Blue brightness level
+*   \param[in]      pConfig         Pointer to led configuration
+*   \param[in,out]  pBatch          Batch to add the led to
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_StageLedAddressableColor(uint8_t red_level, 
+                                                 uint8_t green_level, 
+                                                 uint8_t blue_level, 
+                                                 const LDRV_CFG_Addressable_Config_t *pConfig,
+                                                 LDRV_CFG_Batch_t *pBatch);
+
+/***************************************************************************//*!
+*  \brief Fade addressable led color.
+*
+*   Fade an addressable led to target brightness levels over an amount of 
+*   time (in ms). The strip frames are computed and pushed by a software 
+*   timer while a led of the strip is fading.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  target_red_level    Final red brightness level
+*   \param[in]  target_green_level  Final green brightness level
+*   \param[in]  target_blue_level   Final blue brightness level
+*   \param[in]  fade_time_ms        Fade time in ms
+*   \param[in]  pConfig             Pointer to led configuration
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+LDRV_CFG_Ret_t LDRV_CFG_FadeLedAddressableColor(uint8_t target_red_level,
+                                                uint8_t target_green_level,
+                                                uint8_t target_blue_level,
+                                                uint32_t fade_time_ms,
+                                                const LDRV_CFG_Addressable_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Set single led pwm frequency
@@ -264,7 +481,7 @@ LDRV_CFG_Ret_t LDRV_CFG_FadeLedRgbColor(uint32_t target_red_duty,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmFreq(uint32_t freq_hz, 
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig);
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Set RGB led pwms frequency
@@ -282,7 +499,7 @@ LDRV_CFG_Ret_t LDRV_CFG_SetLedSinglePwmFreq(uint32_t freq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbFreq(uint32_t freq_hz, 
-                                      LDRV_CFG_Rgb_Config_t *pConfig);
+                                      const LDRV_CFG_Rgb_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Get single led pwm frequency
@@ -300,7 +517,7 @@ LDRV_CFG_Ret_t LDRV_CFG_SetLedRgbFreq(uint32_t freq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_GetLedSinglePwmFreq(uint32_t *pFreq_hz,
-                                            LDRV_CFG_Single_Pwm_Config_t *pConfig);
+                                            const LDRV_CFG_Single_Pwm_Config_t *pConfig);
 
 /***************************************************************************//*!
 *  \brief Get RGB led pwms frequency
@@ -318,7 +535,22 @@ LDRV_CFG_Ret_t LDRV_CFG_GetLedSinglePwmFreq(uint32_t *pFreq_hz,
 *
 *******************************************************************************/
 LDRV_CFG_Ret_t LDRV_CFG_GetLedRgbFreq(uint32_t *pFreq_hz,
-                                      LDRV_CFG_Rgb_Config_t *pConfig);
+                                      const LDRV_CFG_Rgb_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Get duty-cycle write statistics
+*
+*   Get the number of duty-cycle writes issued to the peripheral and the
+*   number of writes skipped because the output was unchanged.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out]  pStats             Pointer to store the statistics
+*
+*******************************************************************************/
+void LDRV_CFG_GetWriteStats(LDRV_CFG_Write_Stats_t *pStats);
 
 /***************************************************************************//*!
 *  \brief Take led driver mutex
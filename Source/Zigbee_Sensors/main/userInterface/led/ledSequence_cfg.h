@@ -0,0 +1,81 @@
+#ifndef _LED_SEQUENCE_CFG_H
+#define _LED_SEQUENCE_CFG_H
+
+#include <stdint.h>
+#include "sequencer.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define LED_SEQ_FACTORY_RESET_NB_BLINK      (5)
+#define LED_SEQ_STATUS_ON_MS                (5000)//Network status shown, then the led is off
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+//Blink ON/OFF steps last one tic more than their time, like the original tic counter
+#define LED_SEQ_BLINK_MS(ms)                ((ms) + SEQUENCER_TIC_PERIOD_MS)
+
+//Led sequences keyframes: KF(level, easing, duration_ms)
+#define SEQ_BOOT_INTRO(KF)                  KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 500)                   \
+                                            KF(SEQUENCE_LEVEL_ON, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(5000)) \
+                                            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 0)
+#define SEQ_BOOT_LOOP(KF)
+
+#define SEQ_IDENTIFY_INTRO(KF)              KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 250)
+#define SEQ_IDENTIFY_LOOP(KF)               KF(SEQUENCE_LEVEL_ON, SEQUENCE_EASE_LINEAR, 500)                  \
+                                            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_LINEAR, 500)
+
+#define SEQ_FACTORY_RESET_INTRO(KF)         KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 250)
+#define SEQ_FACTORY_RESET_LOOP(KF)          KF(SEQUENCE_LEVEL_ON, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(500))  \
+                                            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(500))
+
+#define SEQ_SCANNING_INTRO(KF)              KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 250)
+#define SEQ_SCANNING_LOOP(KF)               KF(SEQUENCE_LEVEL_ON, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(500))  \
+                                            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(500))
+
+#define SEQ_STATUS_INTRO(KF)                KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 250)                                   \
+                                            KF(SEQUENCE_LEVEL_ON, SEQUENCE_EASE_STEP, LED_SEQ_BLINK_MS(LED_SEQ_STATUS_ON_MS)) \
+                                            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, 0)
+#define SEQ_STATUS_LOOP(KF)
+
+#define SEQ_ALWAYS_OFF_INTRO(KF)            KF(SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, SEQUENCE_ACTIVE_FOREVER)
+#define SEQ_ALWAYS_OFF_LOOP(KF)
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+//Boot led sequence
+SEQUENCE_DEFINE(seq_boot, SEQ_BOOT_INTRO, SEQ_BOOT_LOOP, 1);
+
+//Identify led sequence
+SEQUENCE_DEFINE(seq_identify, SEQ_IDENTIFY_INTRO, SEQ_IDENTIFY_LOOP, SEQUENCE_REPEAT_FOREVER);
+
+//Factory reset led sequence
+SEQUENCE_DEFINE(seq_factory_reset, SEQ_FACTORY_RESET_INTRO, SEQ_FACTORY_RESET_LOOP, LED_SEQ_FACTORY_RESET_NB_BLINK);
+
+//Scanning led sequence
+SEQUENCE_DEFINE(seq_scanning, SEQ_SCANNING_INTRO, SEQ_SCANNING_LOOP, SEQUENCE_REPEAT_FOREVER);
+
+//Network status led sequence, finite so the led PWM does not prevent light sleep
+SEQUENCE_DEFINE(seq_status, SEQ_STATUS_INTRO, SEQ_STATUS_LOOP, 1);
+
+//Always OFF led sequence
+SEQUENCE_DEFINE(seq_always_off, SEQ_ALWAYS_OFF_INTRO, SEQ_ALWAYS_OFF_LOOP, 1);
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+
+
+#endif//_LED_SEQUENCE_CFG_H
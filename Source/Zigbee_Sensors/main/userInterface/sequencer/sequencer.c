@@ -1,43 +1,94 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
+#include <stdbool.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include "sequencer.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
+//Two level timer wheel, 64 tics per level 0 slot round, 64 rounds per level 1
+#define SEQUENCER_WHEEL_BITS                (6)
+#define SEQUENCER_WHEEL_SIZE                (1UL << SEQUENCER_WHEEL_BITS)
+#define SEQUENCER_WHEEL_MASK                (SEQUENCER_WHEEL_SIZE - 1)
 
+#define SEQUENCER_WHEEL_LEVEL_0             (0)//One tic per slot
+#define SEQUENCER_WHEEL_LEVEL_1             (1)//One level 0 round per slot
+#define SEQUENCER_WHEEL_NB_LEVEL            (2)
+
+#define SEQUENCER_MAILBOX_NB_WORD           ((SEQUENCER_CFG_MAX_NB_OUTPUT + 31) / 32)
 
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
+//Wrap around safe deadline check
+#define SEQUENCE_IS_DUE(deadline, now)      ((int32_t)((deadline) - (now)) <= 0)
+
+#define SEQUENCE_WHEEL_SLOT(tic)            ((uint8_t)((tic) & SEQUENCER_WHEEL_MASK))
+#define SEQUENCE_WHEEL_ROUND(tic)           ((tic) >> SEQUENCER_WHEEL_BITS)
+#define SEQUENCE_WHEEL_ROUND_DELTA(from, to) ((SEQUENCE_WHEEL_ROUND(to) - SEQUENCE_WHEEL_ROUND(from)) &      \
+                                              (UINT32_MAX >> SEQUENCER_WHEEL_BITS))
+#define SEQUENCE_WHEEL_BIT(slot)            (1ULL << (slot))
+
+#define SEQUENCE_MAILBOX_WORD(output_id)    ((output_id) / 32)
+#define SEQUENCE_MAILBOX_BIT(output_id)     (1UL << ((output_id) % 32))
 
+//Rotate a slot mask so "slot" becomes bit 0
+#define SEQUENCE_WHEEL_ROTATE(mask, slot)   (((slot) == 0) ? (mask) :                           \
+                                             (((mask) >> (slot)) | ((mask) << (SEQUENCER_WHEEL_SIZE - (slot)))))
 
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
 typedef enum SEQUENCE_State_e{
     SEQUENCE_STATE_IDLE,
-    SEQUENCE_STATE_START,
-    SEQUENCE_STATE_OUTPUT_ON,
-    SEQUENCE_STATE_OUTPUT_OFF,
+    SEQUENCE_STATE_PLAYING,
 
     SEQUENCE_STATE_INVALID,
 }SEQUENCE_State_t;
 
 typedef struct SEQUENCE_Info_s{
-    SEQUENCE_OutputId_t output_id;
+    SEQUENCE_Output_t output;
+    _Atomic(SEQUENCE_t const *) pPosted_sequence;//Mailbox, adopted by SEQUENCER_Process()
     SEQUENCE_State_t state;
     SEQUENCE_t const *pSequence;
-    uint32_t time_cptr;
-    uint32_t repeat_cptr;
+    uint32_t deadline;//Tic of the next keyframe
+    uint8_t keyframe_index;
+    uint32_t loop_cptr;
+
+    //Timer wheel slot list (valid while PLAYING)
+    struct SEQUENCE_Info_s *pNext;
+    struct SEQUENCE_Info_s *pPrev;
+    uint8_t wheel_level;
+    uint8_t wheel_slot;
 }SEQUENCE_Info_t;
 
+typedef struct SEQUENCE_Wheel_s{
+    SEQUENCE_Info_t *pSlot_list[SEQUENCER_WHEEL_NB_LEVEL][SEQUENCER_WHEEL_SIZE];
+    uint64_t slot_mask[SEQUENCER_WHEEL_NB_LEVEL];//SEQUENCE_WHEEL_BIT() of the non empty slots
+    uint32_t tic;//Next tic to process
+    uint32_t nb_pending;
+}SEQUENCE_Wheel_t;
+
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-
+static uint32_t getKeyframeTic(SEQUENCE_Keyframe_t const *pKeyframe);
+static uint8_t getCurveLength(SEQUENCE_Info_t const *pSequence_info);
+static void applyKeyframe(SEQUENCE_Info_t *pSequence_info);
+static void nextKeyframe(SEQUENCE_Info_t *pSequence_info);
+static void startSequence(SEQUENCE_Info_t *pSequence_info, SEQUENCE_t const *pSequence, uint32_t now);
+static void adoptPostedSequences(uint32_t now);
+
+static void wheelInsert(SEQUENCE_Info_t *pSequence_info);
+static void wheelRemove(SEQUENCE_Info_t *pSequence_info);
+static void wheelCascade(uint8_t slot);
+static void wheelExpire(uint8_t slot);
+static bool wheelGetNextSlotTic(uint8_t level, uint32_t *pSlot_tic);
+static bool wheelGetNextEvent(uint32_t *pEvent_tic);
+static uint32_t wheelGetNextDeadline(uint32_t now);
 
 /******************************************************************************
 *   Public Variables
@@ -47,186 +98,656 @@ typedef struct SEQUENCE_Info_s{
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
-static SEQUENCE_Info_t sequence_info_table[SEQUENCE_ID_NB] = {0};
+static SEQUENCE_Info_t sequence_info_table[SEQUENCER_CFG_MAX_NB_OUTPUT] = {0};
+static uint16_t nb_output = 0;
+
+static SEQUENCE_Wheel_t wheel = {0};
+
+//SEQUENCE_MAILBOX_BIT() of the outputs with a posted sequence
+static atomic_uint_fast32_t mailbox_mask[SEQUENCER_MAILBOX_NB_WORD] = {0};
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+_Static_assert(SEQUENCER_CFG_MAX_NB_OUTPUT < SEQUENCE_OUTPUT_ID_INVALID, "Output ID is limited to 16 bits");
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+/***************************************************************************/ /*!
+*  \brief Get keyframe tic.
+*
+*   Get the duration of a (finite) keyframe in tics.
+*
+*   Preconditions: Keyframe duration is not SEQUENCE_ACTIVE_FOREVER.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pKeyframe           Keyframe.
+*
+*   \return     Keyframe duration in tics
+*
+*******************************************************************************/
+static uint32_t getKeyframeTic(SEQUENCE_Keyframe_t const *pKeyframe){
+
+    uint32_t duration_tic = SEQUENCER_MS_TO_TIC(pKeyframe->duration_ms);
+
+    //At least one tic so a sequence always moves forward
+    if(duration_tic == 0){
+        duration_tic = 1;
+    }
+
+    return duration_tic;
+}
+
+/***************************************************************************/ /*!
+*  \brief Get curve length.
+*
+*   Count the consecutive linear keyframes starting at the current one, they
+*   can be played by the output as a single fade curve.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*
+*   \return     Number of keyframes of the curve
+*
+*******************************************************************************/
+static uint8_t getCurveLength(SEQUENCE_Info_t const *pSequence_info){
+
+    SEQUENCE_t const *pSequence = pSequence_info->pSequence;
+    uint8_t length = 0;
+
+    if(pSequence_info->output.play_curve_cb == NULL){
+        return 0;
+    }
+
+    for(uint8_t i=pSequence_info->keyframe_index; i<pSequence->nb_keyframe; i++){
+
+        if((length >= SEQUENCER_CFG_MAX_CURVE_KEYFRAME) ||
+           (pSequence->pKeyframes[i].easing != SEQUENCE_EASE_LINEAR) ||
+           (pSequence->pKeyframes[i].duration_ms == SEQUENCE_ACTIVE_FOREVER)){
+            break;
+        }
+
+        length++;
+    }
+
+    return length;
+}
+
+/***************************************************************************/ /*!
+*  \brief Apply keyframe.
+*
+*   Set the output to the current keyframe level (or start the fade to it)
+*   and schedule the next keyframe. Consecutive linear keyframes are handed
+*   to the output as one curve and only the end of the curve is scheduled.
+*   A keyframe held forever does not need any deadline and the sequence 
+*   goes IDLE.
+*
+*   Preconditions: Sequence is not in the timer wheel.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*
+*******************************************************************************/
+static void applyKeyframe(SEQUENCE_Info_t *pSequence_info){
+
+    SEQUENCE_Keyframe_t const *pKeyframe = &pSequence_info->pSequence->pKeyframes[pSequence_info->keyframe_index];
+    uint8_t curve_length = getCurveLength(pSequence_info);
+    uint32_t fade_time_ms = 0;
+
+    if((curve_length > 1) &&
+       (SEQUENCER_STATUS_OK == pSequence_info->output.play_curve_cb(pSequence_info->output.pArg, 
+                                                                    pKeyframe, 
+                                                                    curve_length))){
+
+        for(uint8_t i=0; i<curve_length; i++){
+            pSequence_info->deadline += getKeyframeTic(&pKeyframe[i]);
+        }
+
+        //Continue after the last keyframe of the curve
+        pSequence_info->keyframe_index += curve_length - 1;
+        pSequence_info->state = SEQUENCE_STATE_PLAYING;
+        wheelInsert(pSequence_info);
+        return;
+    }
+
+    if((pKeyframe->easing == SEQUENCE_EASE_LINEAR) && 
+       (pKeyframe->duration_ms != SEQUENCE_ACTIVE_FOREVER)){
+
+        fade_time_ms = pKeyframe->duration_ms;
+    }
+
+    pSequence_info->output.set_output_cb(pSequence_info->output.pArg, pKeyframe->level, fade_time_ms);
+
+    if(pKeyframe->duration_ms != SEQUENCE_ACTIVE_FOREVER){
+        pSequence_info->deadline += getKeyframeTic(pKeyframe);
+        pSequence_info->state = SEQUENCE_STATE_PLAYING;
+        wheelInsert(pSequence_info);
+    }
+    else{
+        //Hold forever... Go IDLE
+        pSequence_info->state = SEQUENCE_STATE_IDLE;
+    }
+}
+
+/***************************************************************************/ /*!
+*  \brief Next keyframe.
+*
+*   Move to the next keyframe, jumping back to the loop start after the last
+*   one until the number of loop is reached. The output keeps the last 
+*   keyframe level when the sequence ends.
+*
+*   Preconditions: Current keyframe deadline is reached, sequence is not in
+*                  the timer wheel.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*
+*******************************************************************************/
+static void nextKeyframe(SEQUENCE_Info_t *pSequence_info){
+
+    SEQUENCE_t const *pSequence = pSequence_info->pSequence;
+
+    pSequence_info->keyframe_index++;
+
+    if(pSequence_info->keyframe_index >= pSequence->nb_keyframe){
+
+        //check if there is a loop to play again
+        if(pSequence->loop_start >= pSequence->nb_keyframe){
+            pSequence_info->state = SEQUENCE_STATE_IDLE;
+            return;
+        }
+
+        if(pSequence->nb_loop != SEQUENCE_REPEAT_FOREVER){
+            pSequence_info->loop_cptr++;
+            if(pSequence_info->loop_cptr >= pSequence->nb_loop){
+                //Number of loop reached... Stop it!
+                pSequence_info->state = SEQUENCE_STATE_IDLE;
+                return;
+            }
+        }
+
+        pSequence_info->keyframe_index = pSequence->loop_start;
+    }
+
+    applyKeyframe(pSequence_info);
+}
+
+/***************************************************************************/ /*!
+*  \brief Start sequence.
+*
+*   Drop the sequence being played by an output and apply the first keyframe
+*   of the new one.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*   \param[in]  pSequence           Sequence to start.
+*   \param[in]  now                 Current tic.
+*
+*******************************************************************************/
+static void startSequence(SEQUENCE_Info_t *pSequence_info, SEQUENCE_t const *pSequence, uint32_t now){
+
+    //Drop the sequence being played
+    if(pSequence_info->state == SEQUENCE_STATE_PLAYING){
+        wheelRemove(pSequence_info);
+    }
+
+    //Empty wheel, resync it to the current time
+    if(wheel.nb_pending == 0){
+        wheel.tic = now;
+    }
+
+    pSequence_info->pSequence = pSequence;
+    pSequence_info->deadline = now;
+    pSequence_info->keyframe_index = 0;
+    pSequence_info->loop_cptr = 0;
+
+    applyKeyframe(pSequence_info);
+}
+
+/***************************************************************************/ /*!
+*  \brief Adopt posted sequences.
+*
+*   Start the sequences posted in the output mailboxes. Only the last 
+*   sequence posted to an output since the previous call is started.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  now                 Current tic.
+*
+*******************************************************************************/
+static void adoptPostedSequences(uint32_t now){
+
+    for(uint16_t word=0; word<SEQUENCER_MAILBOX_NB_WORD; word++){
+
+        uint32_t posted_mask = (uint32_t)atomic_exchange_explicit(&mailbox_mask[word], 0, memory_order_acquire);
+
+        while(posted_mask != 0){
+            SEQUENCE_OutputId_t output_id = (SEQUENCE_OutputId_t)((word * 32) + __builtin_ctz(posted_mask));
+            posted_mask &= (posted_mask - 1);
+
+            SEQUENCE_Info_t *pSequence_info = &sequence_info_table[output_id];
+            SEQUENCE_t const *pSequence = atomic_exchange_explicit(&pSequence_info->pPosted_sequence, 
+                                                                   NULL, 
+                                                                   memory_order_acquire);
+
+            //Already adopted with a previous bit
+            if(pSequence != NULL){
+                startSequence(pSequence_info, pSequence, now);
+            }
+        }
+    }
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel insert.
+*
+*   Add a playing sequence to the timer wheel slot of its deadline. Deadlines
+*   within 64 tics go to level 0 (one slot per tic), the others to level 1
+*   (one slot per 64 tics) and are moved down when their slot is reached. A
+*   deadline beyond level 1 goes in the slot reached last and is moved again.
+*
+*   Preconditions: Sequence is not in the timer wheel.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*
+*******************************************************************************/
+static void wheelInsert(SEQUENCE_Info_t *pSequence_info){
+
+    uint32_t delta = pSequence_info->deadline - wheel.tic;
+    uint32_t round_delta = SEQUENCE_WHEEL_ROUND_DELTA(wheel.tic, pSequence_info->deadline);
+    uint8_t level;
+    uint8_t slot;
 
+    if((int32_t)delta < 0){
+        //Already due, processed with the next tic
+        level = SEQUENCER_WHEEL_LEVEL_0;
+        slot = SEQUENCE_WHEEL_SLOT(wheel.tic);
+    }
+    else if(delta < SEQUENCER_WHEEL_SIZE){
+        level = SEQUENCER_WHEEL_LEVEL_0;
+        slot = SEQUENCE_WHEEL_SLOT(pSequence_info->deadline);
+    }
+    else if(round_delta <= SEQUENCER_WHEEL_SIZE){
+        level = SEQUENCER_WHEEL_LEVEL_1;
+        slot = SEQUENCE_WHEEL_SLOT(SEQUENCE_WHEEL_ROUND(pSequence_info->deadline));
+    }
+    else{
+        //Too far, parked in the last reached slot
+        level = SEQUENCER_WHEEL_LEVEL_1;
+        slot = SEQUENCE_WHEEL_SLOT(SEQUENCE_WHEEL_ROUND(wheel.tic));
+    }
+
+    SEQUENCE_Info_t **ppHead = &wheel.pSlot_list[level][slot];
+
+    pSequence_info->wheel_level = level;
+    pSequence_info->wheel_slot = slot;
+    pSequence_info->pPrev = NULL;
+    pSequence_info->pNext = *ppHead;
+    if(*ppHead != NULL){
+        (*ppHead)->pPrev = pSequence_info;
+    }
+    *ppHead = pSequence_info;
+
+    wheel.slot_mask[level] |= SEQUENCE_WHEEL_BIT(slot);
+    wheel.nb_pending++;
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel remove.
+*
+*   Remove a sequence from its timer wheel slot.
+*
+*   Preconditions: Sequence is in the timer wheel.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  pSequence_info      Sequence infos.
+*
+*******************************************************************************/
+static void wheelRemove(SEQUENCE_Info_t *pSequence_info){
+
+    uint8_t level = pSequence_info->wheel_level;
+    uint8_t slot = pSequence_info->wheel_slot;
+
+    if(pSequence_info->pPrev != NULL){
+        pSequence_info->pPrev->pNext = pSequence_info->pNext;
+    }
+    else{
+        wheel.pSlot_list[level][slot] = pSequence_info->pNext;
+    }
+
+    if(pSequence_info->pNext != NULL){
+        pSequence_info->pNext->pPrev = pSequence_info->pPrev;
+    }
+
+    if(wheel.pSlot_list[level][slot] == NULL){
+        wheel.slot_mask[level] &= ~SEQUENCE_WHEEL_BIT(slot);
+    }
+
+    pSequence_info->pNext = NULL;
+    pSequence_info->pPrev = NULL;
+    wheel.nb_pending--;
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel cascade.
+*
+*   Move the sequences of a level 1 slot down to level 0 (or back to level 1
+*   if they are still too far). Called when the wheel enters the slot round.
+*
+*   Preconditions: Wheel tic is the first tic of the slot round.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  slot                Level 1 slot.
+*
+*******************************************************************************/
+static void wheelCascade(uint8_t slot){
+
+    SEQUENCE_Info_t *pSequence_info = wheel.pSlot_list[SEQUENCER_WHEEL_LEVEL_1][slot];
+
+    //Detach the list first, a parked sequence may go back in the same slot
+    wheel.pSlot_list[SEQUENCER_WHEEL_LEVEL_1][slot] = NULL;
+    wheel.slot_mask[SEQUENCER_WHEEL_LEVEL_1] &= ~SEQUENCE_WHEEL_BIT(slot);
+
+    while(pSequence_info != NULL){
+        SEQUENCE_Info_t *pNext = pSequence_info->pNext;
+
+        wheel.nb_pending--;
+        wheelInsert(pSequence_info);
+
+        pSequence_info = pNext;
+    }
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel expire.
+*
+*   Apply the next keyframe of all the sequences of a level 0 slot. The 
+*   sequences still playing are inserted back at their new deadline.
+*
+*   Preconditions: Wheel tic is the slot tic.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  slot                Level 0 slot.
+*
+*******************************************************************************/
+static void wheelExpire(uint8_t slot){
+
+    SEQUENCE_Info_t *pSequence_info = NULL;
+
+    while((pSequence_info = wheel.pSlot_list[SEQUENCER_WHEEL_LEVEL_0][slot]) != NULL){
+        wheelRemove(pSequence_info);
+        nextKeyframe(pSequence_info);
+    }
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel get next slot tic.
+*
+*   Get the next tic a non empty slot of a level is reached: the deadline for
+*   level 0, the first tic of the round (cascade) for level 1.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  level               Wheel level.
+*   \param[out] pSlot_tic           Slot tic.
+*
+*   \return     true if the level is not empty
+*
+*******************************************************************************/
+static bool wheelGetNextSlotTic(uint8_t level, uint32_t *pSlot_tic){
+
+    uint8_t slot = SEQUENCE_WHEEL_SLOT(wheel.tic);
+    uint64_t mask = 0;
+
+    if(level == SEQUENCER_WHEEL_LEVEL_0){
+        mask = SEQUENCE_WHEEL_ROTATE(wheel.slot_mask[SEQUENCER_WHEEL_LEVEL_0], slot);
+        if(mask == 0){
+            return false;
+        }
+
+        *pSlot_tic = wheel.tic + (uint32_t)__builtin_ctzll(mask);
+    }
+    else{
+        //Current round already cascaded, unless the wheel is on its first tic
+        uint32_t round = SEQUENCE_WHEEL_ROUND(wheel.tic) + ((slot != 0) ? 1 : 0);
+
+        mask = SEQUENCE_WHEEL_ROTATE(wheel.slot_mask[SEQUENCER_WHEEL_LEVEL_1], SEQUENCE_WHEEL_SLOT(round));
+        if(mask == 0){
+            return false;
+        }
+
+        *pSlot_tic = (round + (uint32_t)__builtin_ctzll(mask)) << SEQUENCER_WHEEL_BITS;
+    }
+
+    return true;
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel get next event.
+*
+*   Get the next tic with something to do: a level 0 slot to expire or a 
+*   level 1 slot to cascade. The tics in between are skipped.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*   
+*   \param[out] pEvent_tic          Next event tic.
+*
+*   \return     true if there is a pending event
+*
+*******************************************************************************/
+static bool wheelGetNextEvent(uint32_t *pEvent_tic){
+
+    uint32_t expire_tic = 0;
+    uint32_t cascade_tic = 0;
+    bool expire_found = wheelGetNextSlotTic(SEQUENCER_WHEEL_LEVEL_0, &expire_tic);
+    bool cascade_found = wheelGetNextSlotTic(SEQUENCER_WHEEL_LEVEL_1, &cascade_tic);
+
+    if(expire_found && ((!cascade_found) || SEQUENCE_IS_DUE(expire_tic, cascade_tic))){
+        *pEvent_tic = expire_tic;
+        return true;
+    }
+
+    if(cascade_found){
+        *pEvent_tic = cascade_tic;
+        return true;
+    }
+
+    return false;
+}
+
+/***************************************************************************/ /*!
+*  \brief Wheel get next deadline.
+*
+*   Get the time until the earliest keyframe deadline. Only the first non 
+*   empty slot of each level is looked at. If the first level 1 slot only
+*   holds parked sequences, the time until its cascade is returned.
+*
+*   Preconditions: All the tics up to now are processed.
+*
+*   Side Effects: None.
+*   
+*   \param[in]  now                 Current tic.
+*
+*   \return     Time until the next keyframe in tics (SEQUENCER_NO_DEADLINE if none)
+*
+*******************************************************************************/
+static uint32_t wheelGetNextDeadline(uint32_t now){
+
+    uint32_t next_deadline = SEQUENCER_NO_DEADLINE;
+    uint32_t slot_tic = 0;
+
+    if(wheelGetNextSlotTic(SEQUENCER_WHEEL_LEVEL_0, &slot_tic)){
+        next_deadline = slot_tic - now;
+    }
+
+    //Earliest deadline of the first level 1 slot to cascade
+    if(wheelGetNextSlotTic(SEQUENCER_WHEEL_LEVEL_1, &slot_tic)){
+
+        SEQUENCE_Info_t *pSequence_info = wheel.pSlot_list[SEQUENCER_WHEEL_LEVEL_1][SEQUENCE_WHEEL_SLOT(SEQUENCE_WHEEL_ROUND(slot_tic))];
+        uint32_t slot_deadline = SEQUENCER_NO_DEADLINE;
+
+        while(pSequence_info != NULL){
+            uint32_t remaining = pSequence_info->deadline - now;
+            if(remaining < slot_deadline){
+                slot_deadline = remaining;
+            }
+            pSequence_info = pSequence_info->pNext;
+        }
+
+        //Only parked sequences in the slot, the other slots may be earlier.
+        //Wake up on the cascade (all level 1 deadlines are after it).
+        if(SEQUENCE_WHEEL_ROUND(now + slot_deadline) != SEQUENCE_WHEEL_ROUND(slot_tic)){
+            slot_deadline = slot_tic - now;
+        }
+
+        if(slot_deadline < next_deadline){
+            next_deadline = slot_deadline;
+        }
+    }
+
+    return next_deadline;
+}
 
 /******************************************************************************
 *   Public Functions Definitions
 *******************************************************************************/
 /***************************************************************************/ /*!
-*  \brief Start a sequence.
+*  \brief Register an output.
 *
-*   This function is used to start a sequence for a specific output.
+*   This function is used to add an output to the sequencer. The output is
+*   driven through its callbacks, from SEQUENCER_Process() context.
 *
-*   Preconditions: None.
+*   Preconditions: Sequencer is not running yet (init time).
 *
 *   Side Effects: None.
 *   
-*   \param[in]  output_id           Sequence Output ID.
-*   \param[in]  pSequence           Pointer to sequence to apply.
+*   \param[in]  pOutput             Output callbacks (copied).
+*   \param[out] pOutput_id          Sequence Output ID.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-SEQUENCER_Ret_t SEQUENCER_DoSequence(SEQUENCE_OutputId_t output_id, SEQUENCE_t *pSequence){
+SEQUENCER_Ret_t SEQUENCER_RegisterOutput(const SEQUENCE_Output_t *pOutput, SEQUENCE_OutputId_t *pOutput_id){
 
-    if(output_id >= SEQUENCE_ID_NB){
+    if((pOutput == NULL) || (pOutput->set_output_cb == NULL) || (pOutput_id == NULL)){
         return SEQUENCER_STATUS_ERROR;
     }
 
-    if(pSequence == NULL){
+    if(nb_output >= SEQUENCER_CFG_MAX_NB_OUTPUT){
         return SEQUENCER_STATUS_ERROR;
     }
 
-    //Store sequence infos in table
-    sequence_info_table[output_id].output_id = output_id;
-    sequence_info_table[output_id].pSequence = pSequence;
-    sequence_info_table[output_id].time_cptr = 0;
-    sequence_info_table[output_id].repeat_cptr = 0;
-    sequence_info_table[output_id].state = SEQUENCE_STATE_INVALID;
+    //Store output infos in table
+    sequence_info_table[nb_output].output = *pOutput;
+    sequence_info_table[nb_output].state = SEQUENCE_STATE_IDLE;
+    atomic_init(&sequence_info_table[nb_output].pPosted_sequence, NULL);
+    *pOutput_id = (SEQUENCE_OutputId_t)nb_output;
+    nb_output++;
 
-    //Set output initial state
-    if((sequence_info_table[output_id].pSequence->init_time_off == 0) && 
-       (sequence_info_table[output_id].pSequence->time_on)){
+    return SEQUENCER_STATUS_OK;
+}
 
-        SEQUENCER_CFG_TurnOn(sequence_info_table[output_id].output_id);
-        sequence_info_table[output_id].time_cptr = 0;
-        sequence_info_table[output_id].state = SEQUENCE_STATE_OUTPUT_ON;
+/***************************************************************************/ /*!
+*  \brief Start a sequence.
+*
+*   This function is used to start a sequence for a specific output. The 
+*   sequence is posted to the output mailbox and its first keyframe is 
+*   applied by the next SEQUENCER_Process() call. It can be called from 
+*   any task, the last sequence posted before the call is started.
+*
+*   Preconditions: Outputs are registered before the sequencer is used.
+*
+*   Side Effects: SEQUENCER_Process() must be called to start the sequence
+*                 and get the new deadline.
+*   
+*   \param[in]  output_id           Sequence Output ID.
+*   \param[in]  pSequence           Pointer to sequence to apply.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SEQUENCER_Ret_t SEQUENCER_DoSequence(SEQUENCE_OutputId_t output_id, const SEQUENCE_t *pSequence){
+
+    if(output_id >= nb_output){
+        return SEQUENCER_STATUS_ERROR;
     }
-    else{
-        sequence_info_table[output_id].state = SEQUENCE_STATE_START;
-        SEQUENCER_CFG_TurnOff(output_id);
+
+    if((pSequence == NULL) || (pSequence->pKeyframes == NULL) || (pSequence->nb_keyframe == 0)){
+        return SEQUENCER_STATUS_ERROR;
     }
 
+    //Sequence is published before the mailbox bit
+    atomic_store_explicit(&sequence_info_table[output_id].pPosted_sequence, pSequence, memory_order_release);
+    atomic_fetch_or_explicit(&mailbox_mask[SEQUENCE_MAILBOX_WORD(output_id)], 
+                             SEQUENCE_MAILBOX_BIT(output_id), 
+                             memory_order_release);
+
     return SEQUENCER_STATUS_OK;
 }
 
 /***************************************************************************/ /*!
-*  \brief Sequencer Tic.
+*  \brief Sequencer process.
 *
-*   This function must be called perdiodically at SEQUENCER_TIC_PERIOD_MS for 
-*   the sequences timmings to be applied correctly. 
+*   This function starts the posted sequences, applies the keyframes whose
+*   deadline is reached and returns the time until the next one. It must be
+*   called again when this time has elapsed or when a sequence is started.
+*   Nothing has to be done while no sequence is pending
+*   (SEQUENCER_NO_DEADLINE). The cost depends on the number of expiring
+*   keyframes, not on the number of outputs.
 *
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
+*   \return     Time until the next keyframe in tics (SEQUENCER_NO_DEADLINE if none)
+*
 *******************************************************************************/
-void SEQUENCER_Tic(void){
+uint32_t SEQUENCER_Process(void){
 
-    SEQUENCE_Info_t *pSequence_info = NULL;
+    uint32_t now = SEQUENCER_CFG_GetTic();
+    uint32_t event_tic = 0;
 
-    for(uint8_t i=0; i<SEQUENCE_ID_NB; i++){
-
-        pSequence_info = &sequence_info_table[i];
-
-        switch(pSequence_info->state){
-
-            case SEQUENCE_STATE_START:
-            {
-                pSequence_info->time_cptr++;
-                if(pSequence_info->time_cptr >= pSequence_info->pSequence->init_time_off){
-
-                    //check if the sequence has a ON time
-                    if(pSequence_info->pSequence->time_on != 0){
-                        SEQUENCER_CFG_TurnOn(pSequence_info->output_id);
-                        pSequence_info->time_cptr = 0;
-                        pSequence_info->state = SEQUENCE_STATE_OUTPUT_ON;
-                    }
-                    else if(pSequence_info->pSequence->time_off != 0){
-                        //Check if th sequence has OFF time
-                        SEQUENCER_CFG_TurnOff(pSequence_info->output_id);
-                        pSequence_info->time_cptr = 0;
-                        pSequence_info->state = SEQUENCE_STATE_OUTPUT_OFF;
-                    }
-                    else{
-                        //No ON/OFF time in the sequence... STOP it!
-                        SEQUENCER_CFG_TurnOff(pSequence_info->output_id);
-                        pSequence_info->state = SEQUENCE_STATE_IDLE;
-                    }
-                }
-            }
-            break;
+    adoptPostedSequences(now);
 
-            case SEQUENCE_STATE_OUTPUT_ON:
-            {
-                if(pSequence_info->pSequence->time_on != SEQUENCE_ACTIVE_FOREVER){
-                    //Check if ON time is reached
-                    if(pSequence_info->time_cptr >= pSequence_info->pSequence->time_on){
-
-                        //check if the seqeunce need to go OFF
-                        if(pSequence_info->pSequence->time_off != 0){
-                            SEQUENCER_CFG_TurnOff(pSequence_info->output_id);
-                            pSequence_info->time_cptr = 0;
-                            pSequence_info->state = SEQUENCE_STATE_OUTPUT_OFF;
-                        }
-                        else{
-                            //The sequence does not go OFF -> Stop it!
-                            SEQUENCER_CFG_TurnOff(pSequence_info->output_id);
-                            pSequence_info->state = SEQUENCE_STATE_IDLE;
-                        }
-                    }
-                    else{
-                        pSequence_info->time_cptr++;//Increment time cptr
-                    }
-                }
-                else{
-                    //Remain ON forever... Go IDLE
-                    pSequence_info->state = SEQUENCE_STATE_IDLE;
-                }
-            }
-            break;
+    //Jump from event to event, the tics without any deadline are skipped
+    while(wheelGetNextEvent(&event_tic) && SEQUENCE_IS_DUE(event_tic, now)){
 
-            case SEQUENCE_STATE_OUTPUT_OFF:
-            {
-                if(pSequence_info->pSequence->time_off != SEQUENCE_ACTIVE_FOREVER){
-                    //Check if OFF time is reached
-                    if(pSequence_info->time_cptr >= pSequence_info->pSequence->time_off){
-
-                        //check if we need to repeat the sequence forever
-                        if(pSequence_info->repeat_cptr == SEQUENCE_REPEAT_FOREVER){
-                            SEQUENCER_CFG_TurnOn(pSequence_info->output_id);
-                            pSequence_info->time_cptr = 0;
-                            pSequence_info->state = SEQUENCE_STATE_OUTPUT_ON;
-                        }
-                        else{
-                            pSequence_info->repeat_cptr++;
-                            if(pSequence_info->repeat_cptr >= pSequence_info->pSequence->nb_repeat){
-                                //Number of repeat reached... Stop it!
-                                SEQUENCER_CFG_TurnOff(pSequence_info->output_id);
-                                pSequence_info->state = SEQUENCE_STATE_IDLE;
-                            }
-                            else{
-                                SEQUENCER_CFG_TurnOn(pSequence_info->output_id);
-                                pSequence_info->time_cptr = 0;
-                                pSequence_info->state = SEQUENCE_STATE_OUTPUT_ON;
-                            }
-                        }
-                    }
-                    else{
-                        pSequence_info->time_cptr++;//Increment time cptr
-                    }
-                }
-                else{
-                    //Remain OFF forever... Go IDLE
-                    pSequence_info->state = SEQUENCE_STATE_IDLE;
-                }
-            }
-            break;
+        wheel.tic = event_tic;
 
-            case SEQUENCE_STATE_IDLE:
-            case SEQUENCE_STATE_INVALID:
-            default:
-            {
-                pSequence_info->state = SEQUENCE_STATE_IDLE;
-            }
-            break;
+        if(SEQUENCE_WHEEL_SLOT(wheel.tic) == 0){
+            wheelCascade(SEQUENCE_WHEEL_SLOT(SEQUENCE_WHEEL_ROUND(wheel.tic)));
         }
+
+        wheelExpire(SEQUENCE_WHEEL_SLOT(wheel.tic));
+
+        wheel.tic++;
     }
+
+    //All the tics up to now are processed
+    wheel.tic = now + 1;
+
+    return wheelGetNextDeadline(now);
 }
 
 /******************************************************************************
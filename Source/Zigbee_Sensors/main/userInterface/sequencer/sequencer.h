@@ -9,20 +9,73 @@
 *******************************************************************************/
 #define SEQUENCE_ACTIVE_FOREVER                 (0xFFFFFFFF)
 #define SEQUENCE_REPEAT_FOREVER                 (0xFFFFFFFF)
+#define SEQUENCER_NO_DEADLINE                   (0xFFFFFFFF)
+
+#define SEQUENCE_LEVEL_OFF                      (0)
+#define SEQUENCE_LEVEL_ON                       (255)
+
+#define SEQUENCE_OUTPUT_ID_INVALID              (0xFFFF)
 
 /******************************************************************************
 *   Public Macros
 *******************************************************************************/
+//Keyframe list helpers. A keyframe list is a macro taking a KF(level, easing, 
+//duration_ms) macro as parameter, so it can be expanded both as a table and
+//as a duration sum.
+#define SEQUENCE_KEYFRAME(lvl, ease, time_ms)               {.level = (lvl), .easing = (ease), .duration_ms = (time_ms)},
+#define SEQUENCE_KEYFRAME_COUNT(lvl, ease, time_ms)         + 1
+#define SEQUENCE_KEYFRAME_DURATION(lvl, ease, time_ms)      + (uint64_t)(time_ms)
+
+#define SEQUENCE_CLIP_DURATION(duration)        \
+    (((duration) >= SEQUENCE_ACTIVE_FOREVER) ? SEQUENCE_ACTIVE_FOREVER : (uint32_t)(duration))
 
+/*!
+ * Define a const sequence named "name". The INTRO keyframes are played once,
+ * then the LOOP keyframes are played "loops" times (or forever). The total
+ * duration is computed at compile time (SEQUENCE_ACTIVE_FOREVER if infinite).
+ */
+#define SEQUENCE_DEFINE(name, INTRO, LOOP, loops)                                       \
+    static const SEQUENCE_Keyframe_t name##_keyframes[] = {                             \
+        INTRO(SEQUENCE_KEYFRAME)                                                        \
+        LOOP(SEQUENCE_KEYFRAME)                                                         \
+    };                                                                                  \
+    static const SEQUENCE_t name = {                                                    \
+        .pKeyframes = name##_keyframes,                                                 \
+        .nb_keyframe = (0 INTRO(SEQUENCE_KEYFRAME_COUNT) LOOP(SEQUENCE_KEYFRAME_COUNT)),\
+        .loop_start = (0 INTRO(SEQUENCE_KEYFRAME_COUNT)),                               \
+        .nb_loop = (loops),                                                             \
+        .duration_ms = (((loops) == SEQUENCE_REPEAT_FOREVER) &&                         \
+                        ((0 LOOP(SEQUENCE_KEYFRAME_COUNT)) != 0)) ?                     \
+                       SEQUENCE_ACTIVE_FOREVER :                                        \
+                       SEQUENCE_CLIP_DURATION((0 INTRO(SEQUENCE_KEYFRAME_DURATION)) +   \
+                                              ((uint64_t)(loops) *                      \
+                                               (0 LOOP(SEQUENCE_KEYFRAME_DURATION)))),  \
+    }
 
 /******************************************************************************
 *   Public Data Types
 *******************************************************************************/
+typedef uint16_t (SEQUENCE_OutputId_t);
+
+typedef enum SEQUENCE_Easing_e{
+    SEQUENCE_EASE_STEP,//Jump to the keyframe level
+    SEQUENCE_EASE_LINEAR,//Fade to the keyframe level over the keyframe duration
+
+    SEQUENCE_EASE_INVALID,
+}SEQUENCE_Easing_t;
+
+typedef struct SEQUENCE_Keyframe_s{
+    uint8_t level;//Brightness (SEQUENCE_LEVEL_OFF to SEQUENCE_LEVEL_ON)
+    SEQUENCE_Easing_t easing;
+    uint32_t duration_ms;//Keyframe duration (SEQUENCE_ACTIVE_FOREVER to hold it)
+}SEQUENCE_Keyframe_t;
+
 typedef struct SEQUENCE_s{
-    uint32_t init_time_off;
-    uint32_t time_on;
-    uint32_t time_off;
-    uint32_t nb_repeat;
+    SEQUENCE_Keyframe_t const *pKeyframes;
+    uint8_t nb_keyframe;
+    uint8_t loop_start;//First keyframe replayed after the last one
+    uint32_t nb_loop;//Number of loop plays (SEQUENCE_REPEAT_FOREVER)
+    uint32_t duration_ms;//Total duration (SEQUENCE_ACTIVE_FOREVER if infinite)
 }SEQUENCE_t;
 
 typedef enum SEQUENCER_Ret_e{
@@ -30,6 +83,20 @@ typedef enum SEQUENCER_Ret_e{
     SEQUENCER_STATUS_OK,
 }SEQUENCER_Ret_t;
 
+//Set the output level, immediately or with a linear fade (fade_time_ms = 0 -> no fade)
+typedef SEQUENCER_Ret_t (*SEQUENCE_SetOutput_Cb_t)(void *pArg, uint8_t level, uint32_t fade_time_ms);
+
+//Play linear keyframes (finite duration) as one fade curve, error if it can't be played
+typedef SEQUENCER_Ret_t (*SEQUENCE_PlayCurve_Cb_t)(void *pArg, 
+                                                   SEQUENCE_Keyframe_t const *pKeyframes, 
+                                                   uint8_t nb_keyframe);
+
+typedef struct SEQUENCE_Output_s{
+    SEQUENCE_SetOutput_Cb_t set_output_cb;
+    SEQUENCE_PlayCurve_Cb_t play_curve_cb;//NULL if the output can't play curves
+    void *pArg;//Passed to the callbacks
+}SEQUENCE_Output_t;
+
 /******************************************************************************
 *   Public Variables
 *******************************************************************************/
@@ -44,33 +111,61 @@ typedef enum SEQUENCER_Ret_e{
 *   Public Functions
 *******************************************************************************/
 /***************************************************************************/ /*!
-*  \brief Start a sequence.
+*  \brief Register an output.
 *
-*   This function is used to start a sequence for a specific output.
+*   This function is used to add an output to the sequencer. The output is
+*   driven through its callbacks, from SEQUENCER_Process() context.
 *
-*   Preconditions: None.
+*   Preconditions: Sequencer is not running yet (init time).
 *
 *   Side Effects: None.
 *   
+*   \param[in]  pOutput             Output callbacks (copied).
+*   \param[out] pOutput_id          Sequence Output ID.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+SEQUENCER_Ret_t SEQUENCER_RegisterOutput(const SEQUENCE_Output_t *pOutput, SEQUENCE_OutputId_t *pOutput_id);
+
+/***************************************************************************/ /*!
+*  \brief Start a sequence.
+*
+*   This function is used to start a sequence for a specific output. The 
+*   sequence is posted to the output mailbox and its first keyframe is 
+*   applied by the next SEQUENCER_Process() call. It can be called from 
+*   any task, the last sequence posted before the call is started.
+*
+*   Preconditions: Outputs are registered before the sequencer is used.
+*
+*   Side Effects: SEQUENCER_Process() must be called to start the sequence
+*                 and get the new deadline.
+*   
 *   \param[in]  output_id           Sequence Output ID.
 *   \param[in]  pSequence           Pointer to sequence to apply.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-SEQUENCER_Ret_t SEQUENCER_DoSequence(SEQUENCE_OutputId_t output_id, SEQUENCE_t *pSequence);
+SEQUENCER_Ret_t SEQUENCER_DoSequence(SEQUENCE_OutputId_t output_id, const SEQUENCE_t *pSequence);
 
 /***************************************************************************/ /*!
-*  \brief Sequencer Tic.
+*  \brief Sequencer process.
 *
-*   This function must be called perdiodically at SEQUENCER_TIC_PERIOD_MS for 
-*   the sequences timmings to be applied correctly. 
+*   This function starts the posted sequences, applies the keyframes whose
+*   deadline is reached and returns the time until the next one. It must be
+*   called again when this time has elapsed or when a sequence is started.
+*   Nothing has to be done while no sequence is pending
+*   (SEQUENCER_NO_DEADLINE). The cost depends on the number of expiring
+*   keyframes, not on the number of outputs.
 *
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
+*   \return     Time until the next keyframe in tics (SEQUENCER_NO_DEADLINE if none)
+*
 *******************************************************************************/
-void SEQUENCER_Tic(void);
+uint32_t SEQUENCER_Process(void);
 
 #endif//_SEQUENCER_H
\ No newline at end of file
@@ -1,11 +1,17 @@
 #ifndef _SEQUENCER_CFG_H
 #define _SEQUENCER_CFG_H
 
+#include <stdint.h>
+
 /******************************************************************************
 *   Public Definitions
 *******************************************************************************/
 #define SEQUENCER_TIC_PERIOD_MS             (10)
-#define SEQUENCER_MS_TO_TIC(ms)             (ms/SEQUENCER_TIC_PERIOD_MS)
+#define SEQUENCER_MS_TO_TIC(ms)             ((ms)/SEQUENCER_TIC_PERIOD_MS)
+#define SEQUENCER_CFG_MAX_CURVE_KEYFRAME    (5)
+#ifndef SEQUENCER_CFG_MAX_NB_OUTPUT
+#define SEQUENCER_CFG_MAX_NB_OUTPUT         (4)//Set by the build for the host benchmark
+#endif
 
 /******************************************************************************
 *   Public Macros
@@ -15,13 +21,6 @@
 /******************************************************************************
 *   Public Data Types
 *******************************************************************************/
-typedef enum SEQUENCE_OutputId_e{
-    SEQUENCE_ID_RED_LED,
-    SEQUENCE_ID_GREEN_LED,
-
-    SEQUENCE_ID_NB,
-}SEQUENCE_OutputId_t;
-
 typedef enum SEQUENCER_CFG_Ret_e{
     SEQUENCER_CFG_STATUS_ERROR,
     SEQUENCER_CFG_STATUS_OK,
@@ -41,37 +40,18 @@ typedef enum SEQUENCER_CFG_Ret_e{
 *   Public Functions
 *******************************************************************************/
 /***************************************************************************/ /*!
-*  \brief Sequencer turn output ON.
-*
-*   This function is used to interface the sequencer module with the outputs.
-*   It turn an Output ON.
-*
-*   Preconditions: None.
-*
-*   Side Effects: None.
-*   
-*   \param[in]  seq_id                  Sequence Output ID.
-*
-*   \return     Operation status
-*
-*******************************************************************************/
-SEQUENCER_CFG_Ret_t SEQUENCER_CFG_TurnOn(SEQUENCE_OutputId_t seq_id);
-
-/***************************************************************************/ /*!
-*  \brief Sequencer turn output OFF.
+*  \brief Sequencer get time.
 *
-*   This function is used to interface the sequencer module with the outputs.
-*   It turn an Output OFF.
+*   This function is used to interface the sequencer module with the system
+*   time. It returns a free running tic counter (wraps around).
 *
 *   Preconditions: None.
 *
 *   Side Effects: None.
-*   
-*   \param[in]  seq_id                  Sequence Output ID.
 *
-*   \return     Operation status
+*   \return     Current time in tics
 *
 *******************************************************************************/
-SEQUENCER_CFG_Ret_t SEQUENCER_CFG_TurnOff(SEQUENCE_OutputId_t seq_id);
+uint32_t SEQUENCER_CFG_GetTic(void);
 
 #endif//_SEQUENCER_CFG_H
\ No newline at end of file
@@ -5,7 +5,6 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/timers.h"
 
 #include "esp_log.h"
@@ -15,12 +14,20 @@
 #include "ledController.h"
 #include "buttonController.h"
 #include "zigbeeManager.h"
+#include "eventLoop.h"
+#include "healthMonitor.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
-#define UI_QUEUE_RECV_TIMEOUT_MS        (1000)
-#define UI_QUEUE_LENGTH                 (8)
+#define UI_MAILBOX_RECV_TIMEOUT_MS      (1000)
+#define UI_INPUT_RING_LENGTH            (8)
+#define UI_STATUS_RING_LENGTH           (8)
+
+#define UI_BUTTON_CLICK_GAP_MS          (300)
+#define UI_BUTTON_HOLD_MS               (5 * 1000)
+
+#define UI_TASK_STACK_SIZE              (2048)
 
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
@@ -32,16 +39,38 @@
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
+typedef enum UI_Event_Group_e{
+    UI_EVENT_GROUP_NONE,                //Status event, not coalesced
+    UI_EVENT_GROUP_INPUT,               //User input, never coalesced
+    UI_EVENT_GROUP_NETWORK,             //Network state, last one wins
+    UI_EVENT_GROUP_IDENTIFY,            //Identify start/stop, last one wins
+}UI_Event_Group_t;
+
+typedef struct UI_Event_Ring_s{
+    UI_Event_t *pEvent;
+    uint8_t length;
+    uint8_t head;
+    uint8_t count;
+    uint8_t high_water;
+}UI_Event_Ring_t;
 
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-static void shortpressCallback(void *args, void *user_data);
-static void longpressCallback(void *args, void *user_data);
+static void buttonGestureCallback(BUTTON_Gesture_t gesture, void *pArg);
 static void buttonTimerCallback(TimerHandle_t xTimer);
 
+static bool ringPush(UI_Event_Ring_t *pRing, UI_Event_t event);
+static bool ringPop(UI_Event_Ring_t *pRing, UI_Event_t *pEvent);
+static bool ringCoalesce(UI_Event_Ring_t *pRing, UI_Event_t event);
+static bool popEvent(UI_Event_t *pEvent);
+static void processEvent(UI_Event_t ui_event);
+static void processMailbox(void *pArg);
+
+#if !EVLOOP_ENABLE
 static void tUiTask(void *pvParameters);
+#endif
 
 /******************************************************************************
 *   Public Variables
@@ -51,51 +80,205 @@ static void tUiTask(void *pvParameters);
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+#if EVLOOP_ENABLE
+static EVLOOP_EventId_t ui_event_id = EVLOOP_EVENT_ID_INVALID;
+#else
 static TaskHandle_t ui_task_handle = NULL;
-static QueueHandle_t ui_event_queue_handle = NULL;
+static StaticTask_t ui_task_buffer;
+static StackType_t ui_task_stack[UI_TASK_STACK_SIZE];
+#endif
 static TimerHandle_t ui_button_timer_handle = NULL;
+static StaticTimer_t ui_button_timer_buffer;
 
 static bool button_enabled = false;
 
+static const UI_Event_Group_t event_group_table[UI_EVENT_INVALID] = {
+    [UI_EVENT_BOOT] = UI_EVENT_GROUP_NONE,
+    [UI_EVENT_FACTORY_RESET] = UI_EVENT_GROUP_NONE,
+    [UI_EVENT_START_IDENTIFY] = UI_EVENT_GROUP_IDENTIFY,
+    [UI_EVENT_STOP_IDENTIFY] = UI_EVENT_GROUP_IDENTIFY,
+    [UI_EVENT_SCANNING] = UI_EVENT_GROUP_NETWORK,
+    [UI_EVENT_CONNECTED] = UI_EVENT_GROUP_NETWORK,
+    [UI_EVENT_NOT_CONNECTED] = UI_EVENT_GROUP_NETWORK,
+    [UI_EVENT_NO_COORDO] = UI_EVENT_GROUP_NETWORK,
+    [UI_EVENT_BTN_SHORTPRESS] = UI_EVENT_GROUP_INPUT,
+    [UI_EVENT_BTN_LONGPRESS] = UI_EVENT_GROUP_INPUT,
+};
+
+//Gestures without action are mapped to UI_EVENT_INVALID
+static const UI_Event_t button_action_table[BUTTON_GESTURE_INVALID] = {
+    [BUTTON_GESTURE_SINGLE_CLICK] = UI_EVENT_BTN_SHORTPRESS,
+    [BUTTON_GESTURE_DOUBLE_CLICK] = UI_EVENT_INVALID,
+    [BUTTON_GESTURE_TRIPLE_CLICK] = UI_EVENT_INVALID,
+    [BUTTON_GESTURE_HOLD] = UI_EVENT_BTN_LONGPRESS,
+};
+
+static UI_Event_t input_event_table[UI_INPUT_RING_LENGTH];
+static UI_Event_t status_event_table[UI_STATUS_RING_LENGTH];
+static UI_Event_Ring_t input_ring = {
+    .pEvent = input_event_table,
+    .length = UI_INPUT_RING_LENGTH,
+};
+static UI_Event_Ring_t status_ring = {
+    .pEvent = status_event_table,
+    .length = UI_STATUS_RING_LENGTH,
+};
+static UI_Event_Stats_t event_stats;
+static uint32_t nb_reported_drop = 0;
+static portMUX_TYPE mailbox_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
 static const char * TAG = "UI";
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
 /***************************************************************************//*!
-*  \brief Shortpress callback.
+*  \brief Push an event in a ring.
+*
+*   This function appends an event at the tail of a ring and updates its
+*   high-water mark.
+*   
+*   Preconditions: Mailbox spinlock is held.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pRing               Event ring.
+*   \param[in]  event               UI event.
+*
+*   \return     True if pushed, false if the ring is full
+*
+*******************************************************************************/
+static bool ringPush(UI_Event_Ring_t *pRing, UI_Event_t event){
+
+    if(pRing->count >= pRing->length){
+        return false;
+    }
+
+    pRing->pEvent[(pRing->head + pRing->count) % pRing->length] = event;
+    pRing->count++;
+    if(pRing->count > pRing->high_water){
+        pRing->high_water = pRing->count;
+    }
+
+    return true;
+}
+
+/***************************************************************************//*!
+*  \brief Pop an event from a ring.
 *
-*   Function called when button shortpress is detected.
+*   This function removes the oldest event of a ring.
+*   
+*   Preconditions: Mailbox spinlock is held.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pRing               Event ring.
+*   \param[out] pEvent              Oldest event.
+*
+*   \return     True if an event was popped, false if the ring is empty
+*
+*******************************************************************************/
+static bool ringPop(UI_Event_Ring_t *pRing, UI_Event_t *pEvent){
+
+    if(pRing->count == 0){
+        return false;
+    }
+
+    *pEvent = pRing->pEvent[pRing->head];
+    pRing->head = (pRing->head + 1) % pRing->length;
+    pRing->count--;
+
+    return true;
+}
+
+/***************************************************************************//*!
+*  \brief Coalesce an event in a ring.
+*
+*   This function looks for a pending event of the same group and replaces
+*   it in place, so the newest state is played at the position of the
+*   superseded one. Events of the NONE group are never coalesced.
+*   
+*   Preconditions: Mailbox spinlock is held.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pRing               Event ring.
+*   \param[in]  event               UI event.
+*
+*   \return     True if a pending event was replaced
+*
+*******************************************************************************/
+static bool ringCoalesce(UI_Event_Ring_t *pRing, UI_Event_t event){
+
+    UI_Event_Group_t group = event_group_table[event];
+    if(group == UI_EVENT_GROUP_NONE){
+        return false;
+    }
+
+    for(uint8_t i = 0; i < pRing->count; i++){
+        UI_Event_t *pPending = &pRing->pEvent[(pRing->head + i) % pRing->length];
+        if(event_group_table[*pPending] == group){
+            *pPending = event;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/***************************************************************************//*!
+*  \brief Pop the next event to process.
+*
+*   This function returns the next event of the mailbox. User input events
+*   are served before status events.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  args
-*   \param[in]  user_data
+*   \param[out] pEvent              Next event.
+*
+*   \return     True if an event was popped, false if the mailbox is empty
 *
 *******************************************************************************/
-static void shortpressCallback(void *args, void *user_data){
+static bool popEvent(UI_Event_t *pEvent){
+
+    bool popped;
 
-    UI_PostEvent(UI_EVENT_BTN_SHORTPRESS, 0);
+    portENTER_CRITICAL(&mailbox_spinlock);
+    popped = ringPop(&input_ring, pEvent);
+    if(!popped){
+        popped = ringPop(&status_ring, pEvent);
+    }
+    portEXIT_CRITICAL(&mailbox_spinlock);
+
+    return popped;
 }
 
 /***************************************************************************//*!
-*  \brief Longpress callback.
+*  \brief Button gesture callback.
 *
-*   Function called when button longpress is detected.
+*   Function called when a button gesture is recognized. The gesture is
+*   translated to a UI event through the button action table.
 *   
 *   Preconditions: None.
 *
 *   Side Effects: None.
 *
-*   \param[in]  args
-*   \param[in]  user_data
+*   \param[in]  gesture             Button gesture
+*   \param[in]  pArg                Unused
 *
 *******************************************************************************/
-static void longpressCallback(void *args, void *user_data){
+static void buttonGestureCallback(BUTTON_Gesture_t gesture, void *pArg){
+
+    if(gesture >= BUTTON_GESTURE_INVALID){
+        return;
+    }
 
-    UI_PostEvent(UI_EVENT_BTN_LONGPRESS, 0);
+    UI_Event_t event = button_action_table[gesture];
+    if(event != UI_EVENT_INVALID){
+        UI_PostEvent(event);
+    }
 }
 
 /***************************************************************************//*!
@@ -117,6 +300,168 @@ static void buttonTimerCallback(TimerHandle_t xTimer){
     button_enabled = true;
 }
 
+/***************************************************************************//*!
+*  \brief Process a user interface event.
+*
+*   This function plays the LED patterns and network actions of an event.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  ui_event            UI event.
+*
+*******************************************************************************/
+static void processEvent(UI_Event_t ui_event){
+
+    switch(ui_event){
+
+        case UI_EVENT_BOOT:
+        {
+            ESP_LOGI(TAG, "Processing BOOT event");
+            LED_StartPattern(LED_PATTERN_BOOT);
+        }
+        break;
+
+        case UI_EVENT_FACTORY_RESET:
+        {
+            ESP_LOGI(TAG, "Processing FACTORY_RESET event");
+            LED_StartPattern(LED_PATTERN_FACTORY_RESET);
+        }
+        break;
+
+        case UI_EVENT_START_IDENTIFY:
+        {
+            ESP_LOGI(TAG, "Processing START_IDENTIFY event");
+            LED_StartPattern(LED_PATTERN_IDENTIFY);
+        }
+        break;
+
+        case UI_EVENT_STOP_IDENTIFY:
+        {
+            ESP_LOGI(TAG, "Processing STOP_IDENITFY event");
+            LED_StopPattern(LED_PATTERN_IDENTIFY);
+        }
+        break;
+
+        case UI_EVENT_BTN_SHORTPRESS:
+        {
+            if(button_enabled){
+
+                ESP_LOGI(TAG, "Processing SHORTPRESS event");
+                //Check zigbee network status
+                ZIGBEE_Nwk_State_t nwk_state = ZIGBEE_GetNwkState();
+                if(nwk_state == ZIGBEE_NWK_NOT_CONNECTED){
+                    ZIGBEE_StartScanning();
+                }
+            }
+            else{
+                ESP_LOGI(TAG, "Button disabled");
+            }
+        }
+        break;
+
+        case UI_EVENT_BTN_LONGPRESS:
+        {
+            if(button_enabled){
+                
+                ESP_LOGI(TAG, "Processing LONGPRESS event");
+                
+                //Disable the button to prevent interference with factory reset
+                button_enabled = false;
+
+                LED_StopPattern(LED_PATTERN_CONNECTED);
+                LED_StopPattern(LED_PATTERN_SCANNING);
+                LED_StopPattern(LED_PATTERN_IDENTIFY);
+                LED_StopPattern(LED_PATTERN_NO_COORDO);
+                LED_StartPattern(LED_PATTERN_FACTORY_RESET);
+
+                ZIGBEE_LeaveNetwork();
+            }
+            else{
+                ESP_LOGI(TAG, "Button disabled");
+            }
+        }
+        break;
+
+        case UI_EVENT_CONNECTED:
+        {
+            ESP_LOGI(TAG, "Processing CONNECTED event");
+            LED_StopPattern(LED_PATTERN_SCANNING);
+            LED_StopPattern(LED_PATTERN_NO_COORDO);
+            LED_StartPattern(LED_PATTERN_CONNECTED);
+        }
+        break;
+
+        case UI_EVENT_NOT_CONNECTED:
+        {
+            ESP_LOGI(TAG, "Processing NOT_CONNECTED event");
+            LED_StopPattern(LED_PATTERN_CONNECTED);
+            LED_StopPattern(LED_PATTERN_SCANNING);
+            LED_StopPattern(LED_PATTERN_NO_COORDO);
+        }
+        break;
+
+        case UI_EVENT_NO_COORDO:
+        {
+            ESP_LOGI(TAG, "Processing NO_COORDO event");
+            LED_StopPattern(LED_PATTERN_CONNECTED);
+            LED_StopPattern(LED_PATTERN_SCANNING);
+            LED_StartPattern(LED_PATTERN_NO_COORDO);
+        }
+        break;
+
+        case UI_EVENT_SCANNING:
+        {
+            ESP_LOGI(TAG, "Processing SCANNING event");
+            LED_StopPattern(LED_PATTERN_CONNECTED);
+            LED_StopPattern(LED_PATTERN_NO_COORDO);
+            LED_StartPattern(LED_PATTERN_SCANNING);
+        }
+        break;
+
+        case UI_EVENT_INVALID:
+        default:
+        {
+            //Do nothing...
+        }
+        break;
+    }
+}
+
+/***************************************************************************//*!
+*  \brief Process the event mailbox.
+*
+*   This function reports the dropped events and processes all the pending
+*   events of the mailbox.
+*   
+*   Preconditions: Called from the UI task (or the event loop).
+*
+*   Side Effects: None.
+*
+*   \param[in]  pArg                Unused
+*
+*******************************************************************************/
+static void processMailbox(void *pArg){
+
+    UI_Event_t ui_event; 
+
+    //Drops can happen in ISR context, report them from here
+    UI_Event_Stats_t stats;
+    UI_GetEventStats(&stats);
+    if((stats.nb_input_dropped + stats.nb_status_dropped) != nb_reported_drop){
+        nb_reported_drop = stats.nb_input_dropped + stats.nb_status_dropped;
+        ESP_LOGI(TAG, "Events dropped (input %lu, status %lu)",
+                 (unsigned long)stats.nb_input_dropped,
+                 (unsigned long)stats.nb_status_dropped);
+    }
+
+    while(popEvent(&ui_event)){
+        processEvent(ui_event);
+    }
+}
+
+#if !EVLOOP_ENABLE
 /***************************************************************************//*!
 *  \brief User Interface main task.
 *
@@ -131,137 +476,21 @@ static void buttonTimerCallback(TimerHandle_t xTimer){
 *******************************************************************************/
 static void tUiTask(void *pvParameters){
 
-    UI_Event_t ui_event; 
     ESP_LOGI(TAG, "Starting UI task");
 
-    UI_PostEvent(UI_EVENT_BOOT, 0);
+    UI_PostEvent(UI_EVENT_BOOT);
     //Start timer for button enabling
     xTimerStart(ui_button_timer_handle, 10/portTICK_PERIOD_MS);
 
     for(;;){
 
-        if(pdTRUE == xQueueReceive(ui_event_queue_handle, 
-                                   &ui_event, 
-                                   (UI_QUEUE_RECV_TIMEOUT_MS/portTICK_PERIOD_MS))){
-
-            switch(ui_event){
-
-                case UI_EVENT_BOOT:
-                {
-                    ESP_LOGI(TAG, "Processing BOOT event");
-                    LED_StartPattern(LED_PATTERN_BOOT);
-                }
-                break;
-
-                case UI_EVENT_FACTORY_RESET:
-                {
-                    ESP_LOGI(TAG, "Processing FACTORY_RESET event");
-                    LED_StartPattern(LED_PATTERN_FACTORY_RESET);
-                }
-                break;
-
-                case UI_EVENT_START_IDENTIFY:
-                {
-                    ESP_LOGI(TAG, "Processing START_IDENTIFY event");
-                    LED_StartPattern(LED_PATTERN_IDENTIFY);
-                }
-                break;
-
-                case UI_EVENT_STOP_IDENTIFY:
-                {
-                    ESP_LOGI(TAG, "Processing STOP_IDENITFY event");
-                    LED_StopPattern(LED_PATTERN_IDENTIFY);
-                }
-                break;
-
-                case UI_EVENT_BTN_SHORTPRESS:
-                {
-                    if(button_enabled){
-
-                        ESP_LOGI(TAG, "Processing SHORTPRESS event");
-                        //Check zigbee network status
-                        ZIGBEE_Nwk_State_t nwk_state = ZIGBEE_GetNwkState();
-                        if(nwk_state == ZIGBEE_NWK_NOT_CONNECTED){
-                            ZIGBEE_StartScanning();
-                        }
-                    }
-                    else{
-                        ESP_LOGI(TAG, "Button disabled");
-                    }
-                }
-                break;
-
-                case UI_EVENT_BTN_LONGPRESS:
-                {
-                    if(button_enabled){
-                        
-                        ESP_LOGI(TAG, "Processing LONGPRESS event");
-                        
-                        //Disable the button to prevent interference with factory reset
-                        button_enabled = false;
-
-                        LED_StopPattern(LED_PATTERN_CONNECTED);
-                        LED_StopPattern(LED_PATTERN_SCANNING);
-                        LED_StopPattern(LED_PATTERN_IDENTIFY);
-                        LED_StopPattern(LED_PATTERN_NO_COORDO);
-                        LED_StartPattern(LED_PATTERN_FACTORY_RESET);
-
-                        ZIGBEE_LeaveNetwork();
-                    }
-                    else{
-                        ESP_LOGI(TAG, "Button disabled");
-                    }
-                }
-                break;
-
-                case UI_EVENT_CONNECTED:
-                {
-                    ESP_LOGI(TAG, "Processing CONNECTED event");
-                    LED_StopPattern(LED_PATTERN_SCANNING);
-                    LED_StopPattern(LED_PATTERN_NO_COORDO);
-                    LED_StartPattern(LED_PATTERN_CONNECTED);
-                }
-                break;
-
-                case UI_EVENT_NOT_CONNECTED:
-                {
-                    ESP_LOGI(TAG, "Processing NOT_CONNECTED event");
-                    LED_StopPattern(LED_PATTERN_CONNECTED);
-                    LED_StopPattern(LED_PATTERN_SCANNING);
-                    LED_StopPattern(LED_PATTERN_NO_COORDO);
-                }
-                break;
-
-                case UI_EVENT_NO_COORDO:
-                {
-                    ESP_LOGI(TAG, "Processing NO_COORDO event");
-                    LED_StopPattern(LED_PATTERN_CONNECTED);
-                    LED_StopPattern(LED_PATTERN_SCANNING);
-                    LED_StartPattern(LED_PATTERN_NO_COORDO);
-                }
-                break;
-
-                case UI_EVENT_SCANNING:
-                {
-                    ESP_LOGI(TAG, "Processing SCANNING event");
-                    LED_StopPattern(LED_PATTERN_CONNECTED);
-                    LED_StopPattern(LED_PATTERN_NO_COORDO);
-                    LED_StartPattern(LED_PATTERN_SCANNING);
-                }
-                break;
-
-                case UI_EVENT_INVALID:
-                default:
-                {
-                    //Do nothing...
-                }
-                break;
-            }
-        }
+        ulTaskNotifyTake(pdTRUE, UI_MAILBOX_RECV_TIMEOUT_MS/portTICK_PERIOD_MS);
+        processMailbox(NULL);
     }
 
     vTaskDelete(NULL);
 }
+#endif
 
 /******************************************************************************
 *   Public Functions Definitions
@@ -282,19 +511,14 @@ UI_Ret_t UI_Init(void){
 
     ESP_LOGI(TAG, "Initialization");
 
-    //Create UI queue
-    ui_event_queue_handle = xQueueCreate(UI_QUEUE_LENGTH, sizeof(UI_Event_t));
-    if(ui_event_queue_handle == NULL){
-        ESP_LOGI(TAG, "Failed to create UI queue");
-        return UI_STATUS_ERROR;
-    }
-
     //Init button controller
     BUTTON_Config_t btn_cfg = {
         .active_level = BUTTON_ACTIVE_LOW,
         .gpio = HWI_USER_BUTTON_GPIO,
-        .shortpress_callback = shortpressCallback,
-        .longpress_callback = longpressCallback,
+        .click_gap_ms = UI_BUTTON_CLICK_GAP_MS,
+        .hold_ms = UI_BUTTON_HOLD_MS,
+        .gesture_callback = buttonGestureCallback,
+        .pArg = NULL,
     };
     if(BUTTON_STATUS_OK != BUTTON_InitController(&btn_cfg)){
         ESP_LOGI(TAG, "Failed to init button controller");
@@ -311,28 +535,44 @@ UI_Ret_t UI_Init(void){
     button_enabled = false;
 
     //Create button enable timer
-    ui_button_timer_handle = xTimerCreate("Btn timer",
-                                          5000/portTICK_PERIOD_MS,
-                                          pdFALSE,
-                                          NULL,
-                                          buttonTimerCallback);
+    ui_button_timer_handle = xTimerCreateStatic("Btn timer",
+                                                5000/portTICK_PERIOD_MS,
+                                                pdFALSE,
+                                                NULL,
+                                                buttonTimerCallback,
+                                                &ui_button_timer_buffer);
 
     if(ui_button_timer_handle == NULL){
         ESP_LOGI(TAG, "Failed to create button timer");
         return UI_STATUS_ERROR;
     }
 
+#if EVLOOP_ENABLE
+    //Process the mailbox from the event loop
+    if(EVLOOP_STATUS_OK != EVLOOP_RegisterEvent(processMailbox, NULL, &ui_event_id)){
+        ESP_LOGI(TAG, "Failed to register UI event");
+        return UI_STATUS_ERROR;
+    }
+
+    UI_PostEvent(UI_EVENT_BOOT);
+    //Start timer for button enabling
+    xTimerStart(ui_button_timer_handle, 10/portTICK_PERIOD_MS);
+#else
     //Create UI task
-    if(pdTRUE != xTaskCreate(tUiTask,
-                             "UI task",
-                             2048,
-                             NULL,
-                             7,
-                             &ui_task_handle)){
+    ui_task_handle = xTaskCreateStatic(tUiTask,
+                                       "UI task",
+                                       UI_TASK_STACK_SIZE,
+                                       NULL,
+                                       7,
+                                       ui_task_stack,
+                                       &ui_task_buffer);
+    if(ui_task_handle == NULL){
 
         ESP_LOGI(TAG, "Failed to create UI task");
         return UI_STATUS_ERROR;
     }
+    HEALTH_RegisterTask(HEALTH_TASK_UI, ui_task_handle, UI_TASK_STACK_SIZE);
+#endif
 
     return UI_STATUS_OK;
 }
@@ -340,34 +580,96 @@ UI_Ret_t UI_Init(void){
 /***************************************************************************//*!
 *  \brief Post user interface event.
 *
-*   This function post a user interface event. You can specify a timeout to
-*   post the event. If no timeout is needed, set wait_ms to zero.
+*   This function post a user interface event. It never blocks: user input
+*   events go to a priority ring and status events go to a ring where a
+*   pending network state or identify event is replaced by the newer one.
+*   It can be called from any task, the Zigbee stack context or an ISR.
 *   
 *   Preconditions: None.
 *
-*   Side Effects: None.
+*   Side Effects: Wakes up the UI task.
 *
 *   \param[in]  event               UI event.
-*   \param[in]  wait_ms             Post timeout in ms.
 *
-*   \return     Operation status
+*   \return     Operation status (error when the event is dropped)
 *
 *******************************************************************************/
-UI_Ret_t UI_PostEvent(UI_Event_t event, uint32_t wait_ms){
+UI_Ret_t UI_PostEvent(UI_Event_t event){
 
-    if(ui_event_queue_handle == NULL){
-        return UI_STATUS_ERROR;
-    }
+    bool queued;
 
     if(event >= UI_EVENT_INVALID){
         return UI_STATUS_ERROR;
     }
 
-    if(pdTRUE != xQueueSend(ui_event_queue_handle, &event, wait_ms/portTICK_PERIOD_MS)){
-        ESP_LOGI(TAG, "Failed to queue the event.");
+    portENTER_CRITICAL_SAFE(&mailbox_spinlock);
+    if(event_group_table[event] == UI_EVENT_GROUP_INPUT){
+        queued = ringPush(&input_ring, event);
+        if(!queued){
+            event_stats.nb_input_dropped++;
+        }
+    }
+    else if(ringCoalesce(&status_ring, event)){
+        queued = true;
+        event_stats.nb_coalesced++;
+    }
+    else{
+        queued = ringPush(&status_ring, event);
+        if(!queued){
+            event_stats.nb_status_dropped++;
+        }
+    }
+    if(queued){
+        event_stats.nb_posted++;
+    }
+    portEXIT_CRITICAL_SAFE(&mailbox_spinlock);
+
+    //Events posted before the task exists are drained at its start
+#if EVLOOP_ENABLE
+    EVLOOP_PostEvent(ui_event_id);
+#else
+    if(ui_task_handle != NULL){
+        if(xPortInIsrContext()){
+            BaseType_t higher_prio_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(ui_task_handle, &higher_prio_woken);
+            portYIELD_FROM_ISR(higher_prio_woken);
+        }
+        else{
+            xTaskNotifyGive(ui_task_handle);
+        }
+    }
+#endif
+
+    return queued ? UI_STATUS_OK : UI_STATUS_ERROR;
+}
+
+/***************************************************************************//*!
+*  \brief Get user interface event statistics.
+*
+*   This function returns the event mailbox counters (posted, coalesced and
+*   dropped events) and the ring high-water marks since boot.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Event statistics.
+*
+*   \return     Operation status
+*
+*******************************************************************************/
+UI_Ret_t UI_GetEventStats(UI_Event_Stats_t *pStats){
+
+    if(pStats == NULL){
         return UI_STATUS_ERROR;
     }
 
+    portENTER_CRITICAL(&mailbox_spinlock);
+    *pStats = event_stats;
+    pStats->input_high_water = input_ring.high_water;
+    pStats->status_high_water = status_ring.high_water;
+    portEXIT_CRITICAL(&mailbox_spinlock);
+
     return UI_STATUS_OK;
 }
 
@@ -33,6 +33,15 @@ typedef enum UI_Event_e{
     UI_EVENT_INVALID,
 }UI_Event_t;
 
+typedef struct UI_Event_Stats_s{
+    uint32_t nb_posted;                 //Events accepted in the mailbox
+    uint32_t nb_coalesced;              //Status events superseded by a newer one
+    uint32_t nb_input_dropped;          //User input events lost on overflow
+    uint32_t nb_status_dropped;         //Status events lost on overflow
+    uint8_t input_high_water;           //Highest input ring fill level
+    uint8_t status_high_water;          //Highest status ring fill level
+}UI_Event_Stats_t;
+
 typedef enum UI_Ret_e{
     UI_STATUS_ERROR,
     UI_STATUS_OK,
@@ -68,19 +77,37 @@ UI_Ret_t UI_Init(void);
 /***************************************************************************//*!
 *  \brief Post user interface event.
 *
-*   This function post a user interface event. You can specify a timeout to
-*   post the event. If no timeout is needed, set wait_ms to zero.
+*   This function post a user interface event. It never blocks: user input
+*   events go to a priority ring and status events go to a ring where a
+*   pending network state or identify event is replaced by the newer one.
+*   It can be called from any task, the Zigbee stack context or an ISR.
 *   
 *   Preconditions: None.
 *
-*   Side Effects: None.
+*   Side Effects: Wakes up the UI task.
 *
 *   \param[in]  event               UI event.
-*   \param[in]  wait_ms             Post timeout in ms.
+*
+*   \return     Operation status (error when the event is dropped)
+*
+*******************************************************************************/
+UI_Ret_t UI_PostEvent(UI_Event_t event);
+
+/***************************************************************************//*!
+*  \brief Get user interface event statistics.
+*
+*   This function returns the event mailbox counters (posted, coalesced and
+*   dropped events) and the ring high-water marks since boot.
+*   
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Event statistics.
 *
 *   \return     Operation status
 *
 *******************************************************************************/
-UI_Ret_t UI_PostEvent(UI_Event_t event, uint32_t wait_ms);
+UI_Ret_t UI_GetEventStats(UI_Event_Stats_t *pStats);
 
 #endif//_USER_INTERFACE_H
\ No newline at end of file
@@ -0,0 +1,469 @@
+/******************************************************************************
+*   OTA fetch engine host test.
+*
+*   Run the pipelined block fetch engine against an OTA Upgrade server
+*   simulator. The server decodes the client commands with the ZCL OTA
+*   Upgrade cluster frame formats (Query Next Image, Image Block, Upgrade
+*   End requests) and answers like a standard server: responses echo the
+*   request TSN, blocks are cut to the server payload limit, it can ask the
+*   client to wait for data and responses can be lost. The download is also
+*   interrupted by a parent loss followed by a reboot and must resume from
+*   the NVS checkpoint. The written partition is compared with the original
+*   application binary.
+*
+*   Usage: otaFetchTest <application.bin> <image.ota> [-v]
+*******************************************************************************/
+
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_zigbee_core.h"
+
+#include "otaFetch.h"
+#include "otaCluster.h"
+#include "zigbeeManager.h"
+#include "hostTest.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define CLIENT_ENDPOINT                 (1)
+#define SERVER_ADDR                     (0x0000)
+#define SERVER_ENDPOINT                 (1)
+#define SERVER_FILE_VERSION             (2)//Matches the image built by CMake
+
+#define SIM_STEP_MS                     (5)
+#define SIM_LATENCY_MS                  (20)//Request to response delay
+#define SIM_TIMEOUT_MS                  (30 * 60 * 1000)
+#define SIM_MAX_PENDING                 (32)
+
+//OTA Upgrade cluster commands (ZCL spec)
+#define CMD_QUERY_NEXT_IMAGE_REQ        (0x01)
+#define CMD_QUERY_NEXT_IMAGE_RSP        (0x02)
+#define CMD_IMAGE_BLOCK_REQ             (0x03)
+#define CMD_IMAGE_BLOCK_RSP             (0x05)
+#define CMD_UPGRADE_END_REQ             (0x06)
+#define CMD_UPGRADE_END_RSP             (0x07)
+
+#define STATUS_SUCCESS                  (0x00)
+#define STATUS_WAIT_FOR_DATA            (0x97)
+
+#define IMAGE_STATUS_WAITING_TO_UPGRADE (3)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define GET_U16_LE(p)                   ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define GET_U32_LE(p)                   ((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+#define PUT_U16_LE(p, v)                do{ (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); }while(0)
+#define PUT_U32_LE(p, v)                do{ PUT_U16_LE((p), (v)); PUT_U16_LE(&(p)[2], (v) >> 16); }while(0)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct Test_File_s{
+    uint8_t *pData;
+    size_t size;
+}Test_File_t;
+
+typedef struct Server_Cfg_s{
+    uint8_t max_data_size;              //Server block payload limit
+    uint32_t drop_period;               //Drop one block response out of N (0: none)
+    uint32_t wait_offset;               //Ask to wait once for this offset (0: never)
+    uint32_t disconnect_offset;         //Lose the parent and reboot past this offset (0: never)
+}Server_Cfg_t;
+
+typedef struct Server_Rsp_s{
+    int64_t due_ms;
+    uint8_t cmd_id;
+    uint8_t tsn;
+    uint16_t size;
+    uint8_t payload[ESP_ZB_STUB_MAX_PAYLOAD];
+}Server_Rsp_t;
+
+typedef struct Server_Stats_s{
+    uint32_t nb_block_req;
+    uint32_t nb_block_served;
+    uint32_t bytes_served;
+    uint32_t max_in_flight;
+    uint32_t resume_offset;             //Checkpoint offset at reboot
+    uint32_t first_offset_after_reboot;
+    bool upgrade_end;
+}Server_Stats_t;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static Test_File_t app_file;
+static Test_File_t ota_file;
+
+static int64_t now_ms = 0;
+static bool connected = true;
+static bool restarted = false;
+static bool rebooted = false;
+
+static Server_Cfg_t server_cfg;
+static Server_Stats_t stats;
+static Server_Rsp_t pending[SIM_MAX_PENDING];
+static uint32_t nb_pending = 0;
+static bool wait_sent = false;
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static bool readFile(const char *pPath, Test_File_t *pFile){
+
+    FILE *pStream = fopen(pPath, "rb");
+    if(pStream == NULL){
+        printf("Cannot open %s\n", pPath);
+        return false;
+    }
+
+    fseek(pStream, 0, SEEK_END);
+    pFile->size = (size_t)ftell(pStream);
+    fseek(pStream, 0, SEEK_SET);
+
+    pFile->pData = malloc(pFile->size);
+    bool ok = (pFile->pData != NULL) && (fread(pFile->pData, 1, pFile->size, pStream) == pFile->size);
+    fclose(pStream);
+
+    return ok;
+}
+
+static Server_Rsp_t *addResponse(uint8_t cmd_id, uint8_t tsn){
+
+    if(!HOST_TEST_CHECK(nb_pending < SIM_MAX_PENDING)){
+        return NULL;
+    }
+
+    Server_Rsp_t *pRsp = &pending[nb_pending++];
+    pRsp->due_ms = now_ms + SIM_LATENCY_MS;
+    pRsp->cmd_id = cmd_id;
+    pRsp->tsn = tsn;
+    pRsp->size = 0;
+
+    return pRsp;
+}
+
+static uint32_t countBlockResponses(void){
+
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < nb_pending; i++){
+        count += (pending[i].cmd_id == CMD_IMAGE_BLOCK_RSP);
+    }
+    return count;
+}
+
+//Query Next Image request: field control, manufacturer, image type, file version [, hardware version]
+static void serveQueryNextImage(ESP_ZB_Stub_Cmd_t const *pCmd){
+
+    uint8_t const *pReq = pCmd->payload;
+    uint16_t size = pCmd->req.data.size;
+
+    if(!HOST_TEST_CHECK((size >= 9) && (size == ((pReq[0] & 0x01) ? 11 : 9)))){
+        return;
+    }
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[1]) == ZIGBEE_MANUFACTURER_CODE);
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[3]) == OTA_IMAGE_TYPE);
+    HOST_TEST_CHECK(GET_U32_LE(&pReq[5]) == OTA_RUNNING_FILE_VERSION);
+
+    Server_Rsp_t *pRsp = addResponse(CMD_QUERY_NEXT_IMAGE_RSP, pCmd->tsn);
+    if(pRsp != NULL){
+        pRsp->payload[0] = STATUS_SUCCESS;
+        PUT_U16_LE(&pRsp->payload[1], ZIGBEE_MANUFACTURER_CODE);
+        PUT_U16_LE(&pRsp->payload[3], OTA_IMAGE_TYPE);
+        PUT_U32_LE(&pRsp->payload[5], SERVER_FILE_VERSION);
+        PUT_U32_LE(&pRsp->payload[9], ota_file.size);
+        pRsp->size = 13;
+    }
+}
+
+//Image Block request: field control, manufacturer, image type, file version, offset, max data size [, IEEE] [, block delay]
+static void serveImageBlock(ESP_ZB_Stub_Cmd_t const *pCmd){
+
+    uint8_t const *pReq = pCmd->payload;
+    uint16_t size = pCmd->req.data.size;
+
+    if(!HOST_TEST_CHECK((size >= 14) && (size == (14 + ((pReq[0] & 0x01) ? 8 : 0) + ((pReq[0] & 0x02) ? 2 : 0))))){
+        return;
+    }
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[1]) == ZIGBEE_MANUFACTURER_CODE);
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[3]) == OTA_IMAGE_TYPE);
+    HOST_TEST_CHECK(GET_U32_LE(&pReq[5]) == SERVER_FILE_VERSION);
+
+    uint32_t offset = GET_U32_LE(&pReq[9]);
+    uint8_t max_size = pReq[13];
+    if((!HOST_TEST_CHECK(offset < ota_file.size)) ||
+       (!HOST_TEST_CHECK((max_size > 0) && (max_size <= OTA_FETCH_BLOCK_SIZE_MAX)))){
+        return;
+    }
+
+    stats.nb_block_req++;
+    if(rebooted && (stats.first_offset_after_reboot == 0xFFFFFFFF)){
+        stats.first_offset_after_reboot = offset;
+    }
+
+    Server_Rsp_t *pRsp = addResponse(CMD_IMAGE_BLOCK_RSP, pCmd->tsn);
+    if(pRsp == NULL){
+        return;
+    }
+
+    if((server_cfg.wait_offset != 0) && (offset >= server_cfg.wait_offset) && (!wait_sent)){
+        wait_sent = true;
+        uint32_t current_time = (uint32_t)(now_ms / 1000);
+        pRsp->payload[0] = STATUS_WAIT_FOR_DATA;
+        PUT_U32_LE(&pRsp->payload[1], current_time);
+        PUT_U32_LE(&pRsp->payload[5], current_time + 2);
+        PUT_U16_LE(&pRsp->payload[9], 0);//Minimum block period
+        pRsp->size = 11;
+        return;
+    }
+
+    uint32_t data_size = max_size;
+    if(data_size > server_cfg.max_data_size){
+        data_size = server_cfg.max_data_size;
+    }
+    if(data_size > (ota_file.size - offset)){
+        data_size = ota_file.size - offset;
+    }
+
+    pRsp->payload[0] = STATUS_SUCCESS;
+    PUT_U16_LE(&pRsp->payload[1], ZIGBEE_MANUFACTURER_CODE);
+    PUT_U16_LE(&pRsp->payload[3], OTA_IMAGE_TYPE);
+    PUT_U32_LE(&pRsp->payload[5], SERVER_FILE_VERSION);
+    PUT_U32_LE(&pRsp->payload[9], offset);
+    pRsp->payload[13] = (uint8_t)data_size;
+    memcpy(&pRsp->payload[14], &ota_file.pData[offset], data_size);
+    pRsp->size = (uint16_t)(14 + data_size);
+
+    stats.nb_block_served++;
+    stats.bytes_served += data_size;
+    if((server_cfg.drop_period != 0) && ((stats.nb_block_served % server_cfg.drop_period) == 0)){
+        //Lost on the way back
+        nb_pending--;
+    }
+}
+
+//Upgrade End request: status, manufacturer, image type, file version
+static void serveUpgradeEnd(ESP_ZB_Stub_Cmd_t const *pCmd){
+
+    uint8_t const *pReq = pCmd->payload;
+
+    if(!HOST_TEST_CHECK(pCmd->req.data.size == 9)){
+        return;
+    }
+    HOST_TEST_CHECK(pReq[0] == STATUS_SUCCESS);
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[1]) == ZIGBEE_MANUFACTURER_CODE);
+    HOST_TEST_CHECK(GET_U16_LE(&pReq[3]) == OTA_IMAGE_TYPE);
+    HOST_TEST_CHECK(GET_U32_LE(&pReq[5]) == SERVER_FILE_VERSION);
+    stats.upgrade_end = true;
+
+    Server_Rsp_t *pRsp = addResponse(CMD_UPGRADE_END_RSP, pCmd->tsn);
+    if(pRsp != NULL){
+        uint32_t current_time = (uint32_t)(now_ms / 1000);
+        PUT_U16_LE(&pRsp->payload[0], ZIGBEE_MANUFACTURER_CODE);
+        PUT_U16_LE(&pRsp->payload[2], OTA_IMAGE_TYPE);
+        PUT_U32_LE(&pRsp->payload[4], SERVER_FILE_VERSION);
+        PUT_U32_LE(&pRsp->payload[8], current_time);
+        PUT_U32_LE(&pRsp->payload[12], current_time + 1);
+        pRsp->size = 16;
+    }
+}
+
+static void serveCommand(ESP_ZB_Stub_Cmd_t const *pCmd){
+
+    //Unicast client to server OTA Upgrade command, payload in ZCL frame format
+    HOST_TEST_CHECK(pCmd->req.cluster_id == ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE);
+    HOST_TEST_CHECK(pCmd->req.profile_id == ESP_ZB_AF_HA_PROFILE_ID);
+    HOST_TEST_CHECK(pCmd->req.direction == ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV);
+    HOST_TEST_CHECK(pCmd->req.address_mode == ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT);
+    HOST_TEST_CHECK(pCmd->req.zcl_basic_cmd.dst_addr_u.addr_short == SERVER_ADDR);
+    HOST_TEST_CHECK(pCmd->req.zcl_basic_cmd.dst_endpoint == SERVER_ENDPOINT);
+    HOST_TEST_CHECK(pCmd->req.zcl_basic_cmd.src_endpoint == CLIENT_ENDPOINT);
+    HOST_TEST_CHECK(pCmd->req.data.type == ESP_ZB_ZCL_ATTR_TYPE_SET);
+
+    switch(pCmd->req.custom_cmd_id){
+        case CMD_QUERY_NEXT_IMAGE_REQ:  serveQueryNextImage(pCmd);  break;
+        case CMD_IMAGE_BLOCK_REQ:       serveImageBlock(pCmd);      break;
+        case CMD_UPGRADE_END_REQ:       serveUpgradeEnd(pCmd);      break;
+        default:                        HOST_TEST_CHECK(false);     break;
+    }
+
+    uint32_t in_flight = countBlockResponses();
+    if(in_flight > stats.max_in_flight){
+        stats.max_in_flight = in_flight;
+    }
+}
+
+static void deliverResponses(void){
+
+    for(uint32_t i = 0; i < nb_pending;){
+
+        if(pending[i].due_ms > now_ms){
+            i++;
+            continue;
+        }
+
+        Server_Rsp_t rsp = pending[i];
+        memmove(&pending[i], &pending[i + 1], (nb_pending - i - 1) * sizeof(pending[0]));
+        nb_pending--;
+
+        esp_zb_zcl_custom_cluster_command_message_t message = {
+            .info = {
+                .status = 0,
+                .header.tsn = rsp.tsn,
+                .src_address.u.short_addr = SERVER_ADDR,
+                .src_endpoint = SERVER_ENDPOINT,
+                .dst_endpoint = CLIENT_ENDPOINT,
+                .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                .command = {.id = rsp.cmd_id, .direction = 1},
+            },
+            .data = {.size = rsp.size, .value = rsp.payload},
+        };
+        OTA_FETCH_ProcessCommand(&message);
+    }
+}
+
+//Parent lost for a while, then reboot: the fetch engine is initialized again
+static void loseParentAndReboot(void){
+
+    connected = false;
+    for(uint32_t i = 0; i < (5000 / SIM_STEP_MS); i++){
+        now_ms += SIM_STEP_MS;
+        espZbStubRunAlarm();
+    }
+
+    ESP_ZB_Stub_Cmd_t cmd;
+    while(espZbStubPopCommand(&cmd)){
+        //Sent before the parent loss was detected, never delivered
+    }
+    nb_pending = 0;
+
+    //Progress saved when the parent loss was detected
+    stats.resume_offset = espZbStubGetFileOffset();
+    stats.first_offset_after_reboot = 0xFFFFFFFF;
+    HOST_TEST_CHECK(stats.resume_offset > 0);
+    HOST_TEST_CHECK(OTA_FETCH_STATUS_OK == OTA_FETCH_Init(CLIENT_ENDPOINT));
+    rebooted = true;
+    connected = true;
+}
+
+static void runDownload(const char *pName, Server_Cfg_t const *pCfg){
+
+    server_cfg = *pCfg;
+    memset(&stats, 0, sizeof(stats));
+    nb_pending = 0;
+    wait_sent = false;
+    restarted = false;
+    rebooted = false;
+    uint32_t nb_resume = espOtaStubGetNbResume();
+
+    //Previous image must be overwritten
+    espOtaStubTornWrite(0, app_file.size);
+
+    HOST_TEST_CHECK(OTA_FETCH_STATUS_OK == OTA_FETCH_Init(CLIENT_ENDPOINT));
+    OTA_FETCH_Start();
+
+    int64_t end_ms = now_ms + SIM_TIMEOUT_MS;
+    while((!restarted) && (now_ms < end_ms)){
+
+        now_ms += SIM_STEP_MS;
+
+        espZbStubRunAlarm();
+        espZbStubAnswerMatch(ESP_ZB_ZDP_STATUS_SUCCESS, SERVER_ADDR, SERVER_ENDPOINT);
+        deliverResponses();
+
+        ESP_ZB_Stub_Cmd_t cmd;
+        while(espZbStubPopCommand(&cmd)){
+            serveCommand(&cmd);
+        }
+
+        if((server_cfg.disconnect_offset != 0) && (!rebooted) &&
+           (stats.bytes_served >= server_cfg.disconnect_offset)){
+
+            loseParentAndReboot();
+        }
+    }
+
+    size_t written = 0;
+    const uint8_t *pPartition = espOtaStubGetPartitionData(&written);
+
+    printf("%s: %lu block requests, %lu bytes served, %lu in flight, %.1f s\n",
+           pName,
+           (unsigned long)stats.nb_block_req,
+           (unsigned long)stats.bytes_served,
+           (unsigned long)stats.max_in_flight,
+           (double)(now_ms - (end_ms - SIM_TIMEOUT_MS)) / 1000);
+
+    HOST_TEST_CHECK(restarted);
+    HOST_TEST_CHECK(stats.upgrade_end);
+    HOST_TEST_CHECK(espZbStubGetImageStatus() == IMAGE_STATUS_WAITING_TO_UPGRADE);
+    HOST_TEST_CHECK(stats.max_in_flight == OTA_FETCH_PIPELINE_DEPTH);
+    HOST_TEST_CHECK(wait_sent == (server_cfg.wait_offset != 0));
+    HOST_TEST_CHECK(written == app_file.size);
+    HOST_TEST_CHECK(0 == memcmp(pPartition, app_file.pData, app_file.size));
+
+    if(server_cfg.disconnect_offset != 0){
+        //Download resumed from the checkpoint, only blocks in flight are fetched twice
+        HOST_TEST_CHECK(espOtaStubGetNbResume() == (nb_resume + 1));
+        HOST_TEST_CHECK(stats.first_offset_after_reboot == stats.resume_offset);
+        HOST_TEST_CHECK(stats.bytes_served <= (ota_file.size + (OTA_FETCH_PIPELINE_DEPTH * OTA_FETCH_BLOCK_SIZE_MAX)));
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+int64_t esp_timer_get_time(void){
+
+    return now_ms * 1000;
+}
+
+void esp_restart(void){
+
+    restarted = true;
+}
+
+ZIGBEE_Nwk_State_t ZIGBEE_GetNwkState(void){
+
+    return connected ? ZIGBEE_NWK_CONNECTED : ZIGBEE_NWK_NO_PARENT;
+}
+
+int main(int argc, char *argv[]){
+
+    if(argc < 3){
+        printf("usage: %s <application.bin> <image.ota> [-v]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    host_test_verbose = (argc > 3) && (0 == strcmp(argv[3], "-v"));
+
+    if((!readFile(argv[1], &app_file)) || (!readFile(argv[2], &ota_file))){
+        return EXIT_FAILURE;
+    }
+
+    Server_Cfg_t clean = {.max_data_size = OTA_FETCH_BLOCK_SIZE_MAX};
+    runDownload("clean", &clean);
+
+    Server_Cfg_t lossy = {
+        .max_data_size = 40,
+        .drop_period = 50,
+        .wait_offset = ota_file.size / 3,
+    };
+    runDownload("lossy", &lossy);
+
+    Server_Cfg_t parent_loss = {
+        .max_data_size = OTA_FETCH_BLOCK_SIZE_MAX,
+        .disconnect_offset = ota_file.size / 2,
+    };
+    runDownload("parent_loss", &parent_loss);
+
+    return hostTestResult();
+}
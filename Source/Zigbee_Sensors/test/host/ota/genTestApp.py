@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Generate a deterministic ESP-IDF like application binary for the OTA host test.
+
+The content mixes text, tables and pseudo-random data so that heatshrink
+literals, short and long back-references all show up in the compressed stream.
+"""
+
+import random
+import struct
+import sys
+
+ESP_IMAGE_HEADER_MAGIC = 0xE9
+
+
+def main():
+    if len(sys.argv) != 3:
+        print('usage: genTestApp.py <output> <size>')
+        return 1
+
+    size = int(sys.argv[2], 0)
+    rng = random.Random(0x5EED)
+    out = bytearray(struct.pack('<BBBB', ESP_IMAGE_HEADER_MAGIC, 4, 2, 0x20))
+
+    while len(out) < size:
+        kind = rng.randrange(4)
+        if kind == 0:
+            out += b'Zigbee_Sensors host test string %d\0' % rng.randrange(1000)
+        elif kind == 1:
+            out += struct.pack('<%dI' % 16, *[0x40800000 + 4 * rng.randrange(64) for _ in range(16)])
+        elif kind == 2:
+            out += bytes(rng.randrange(256) for _ in range(rng.randrange(1, 96)))
+        else:
+            back = rng.randrange(1, min(len(out), 4096))
+            start = len(out) - back
+            out += out[start:start + rng.randrange(3, 64)]
+
+    with open(sys.argv[1], 'wb') as f:
+        f.write(out[:size])
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
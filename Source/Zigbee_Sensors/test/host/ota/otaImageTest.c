@@ -0,0 +1,241 @@
+/******************************************************************************
+*   OTA image host test.
+*
+*   Replay a Zigbee OTA file (built by Tool/ota_image_tool.py) through the
+*   OTA image writer in blocks of the size used by the fetch engine, then
+*   compare the written partition with the original application binary.
+*   The download is also interrupted and resumed from a checkpoint stored
+*   in NVS, the way the fetch engine does after a reboot. Data written to
+*   flash after the checkpoint stays there across the reboot, the partition
+*   stub behaves like NOR flash.
+*
+*   Usage: otaImageTest <application.bin> <image.ota> [-v]
+*******************************************************************************/
+
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_ota_ops.h"
+#include "nvs.h"
+
+#include "otaImage.h"
+#include "otaFetch.h"
+#include "hostTest.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define OTA_FILE_HEADER_LEN_OFFSET      (6)//Header length field of the OTA file header
+#define CHECKPOINT_NVS_NAMESPACE        ("OtaFetch")
+#define CHECKPOINT_NVS_KEY              ("Checkpoint")
+#define NB_BLOCK_LOST                   (7)//Blocks received after the checkpoint, lost at reboot
+#define NB_TORN_BYTE                    (100)//Bytes partially programmed at reboot
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct Test_File_s{
+    uint8_t *pData;
+    size_t size;
+}Test_File_t;
+
+typedef struct Test_Checkpoint_s{
+    size_t payload_offset;              //Next payload byte to feed
+    OTA_IMAGE_Checkpoint_t image;
+}Test_Checkpoint_t;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static Test_File_t app_file;
+static Test_File_t ota_file;
+static const uint8_t *pPayload = NULL;
+static size_t payload_size = 0;
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static bool readFile(const char *pPath, Test_File_t *pFile){
+
+    FILE *pStream = fopen(pPath, "rb");
+    if(pStream == NULL){
+        printf("Cannot open %s\n", pPath);
+        return false;
+    }
+
+    fseek(pStream, 0, SEEK_END);
+    pFile->size = (size_t)ftell(pStream);
+    fseek(pStream, 0, SEEK_SET);
+
+    pFile->pData = malloc(pFile->size);
+    bool ok = (pFile->pData != NULL) && (fread(pFile->pData, 1, pFile->size, pStream) == pFile->size);
+    fclose(pStream);
+
+    return ok;
+}
+
+//Block sizes cycle through the fetch engine range, blocks split sub-element headers
+static size_t blockSize(uint32_t block_index){
+
+    uint32_t range = OTA_FETCH_BLOCK_SIZE_MAX - OTA_FETCH_BLOCK_SIZE_MIN + 1;
+    return OTA_FETCH_BLOCK_SIZE_MIN + ((block_index * 7) % range);
+}
+
+static bool feed(size_t *pOffset, uint32_t *pBlock_index, size_t end){
+
+    while(*pOffset < end){
+        size_t len = blockSize((*pBlock_index)++);
+        if(len > (end - *pOffset)){
+            len = end - *pOffset;
+        }
+
+        if(!HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Write(&pPayload[*pOffset], len))){
+            return false;
+        }
+        *pOffset += len;
+    }
+
+    return true;
+}
+
+static void checkPartition(void){
+
+    size_t written = 0;
+    const uint8_t *pPartition = espOtaStubGetPartitionData(&written);
+
+    HOST_TEST_CHECK(written == app_file.size);
+    HOST_TEST_CHECK(0 == memcmp(pPartition, app_file.pData, app_file.size));
+}
+
+static void saveCheckpoint(size_t payload_offset){
+
+    Test_Checkpoint_t checkpoint = {.payload_offset = payload_offset};
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_GetCheckpoint(&checkpoint.image));
+
+    nvs_handle_t nvs_handle;
+    HOST_TEST_CHECK(ESP_OK == nvs_open(CHECKPOINT_NVS_NAMESPACE, NVS_READWRITE, &nvs_handle));
+    HOST_TEST_CHECK(ESP_OK == nvs_set_blob(nvs_handle, CHECKPOINT_NVS_KEY, &checkpoint, sizeof(checkpoint)));
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+}
+
+static bool loadCheckpoint(Test_Checkpoint_t *pCheckpoint){
+
+    nvs_handle_t nvs_handle;
+    size_t length = sizeof(*pCheckpoint);
+
+    HOST_TEST_CHECK(ESP_OK == nvs_open(CHECKPOINT_NVS_NAMESPACE, NVS_READONLY, &nvs_handle));
+    bool ok = HOST_TEST_CHECK(ESP_OK == nvs_get_blob(nvs_handle, CHECKPOINT_NVS_KEY, pCheckpoint, &length)) &&
+              HOST_TEST_CHECK(length == sizeof(*pCheckpoint));
+    nvs_close(nvs_handle);
+
+    return ok;
+}
+
+static void testFullImage(void){
+
+    size_t offset = 0;
+    uint32_t block_index = 0;
+
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Begin());
+    if(feed(&offset, &block_index, payload_size)){
+        HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_End());
+        HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Apply());
+        checkPartition();
+    }
+}
+
+static void testResume(uint32_t checkpoint_pct){
+
+    size_t offset = 0;
+    uint32_t block_index = 0;
+    size_t checkpoint_offset = (payload_size * checkpoint_pct) / 100;
+    uint32_t nb_resume = espOtaStubGetNbResume();
+
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Begin());
+    if(!feed(&offset, &block_index, checkpoint_offset)){
+        return;
+    }
+    saveCheckpoint(offset);
+
+    //Keep downloading after the checkpoint, then reboot: this progress is lost
+    uint32_t lost_end = block_index + NB_BLOCK_LOST;
+    while((block_index < lost_end) && (offset < payload_size)){
+        size_t len = blockSize(block_index++);
+        len = (len > (payload_size - offset)) ? (payload_size - offset) : len;
+        OTA_IMAGE_Write(&pPayload[offset], len);
+        offset += len;
+    }
+
+    //The lost data reached the flash (next checkpoint flushed, not saved in NVS)
+    OTA_IMAGE_Checkpoint_t lost_checkpoint;
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_GetCheckpoint(&lost_checkpoint));
+
+    Test_Checkpoint_t checkpoint;
+    if(!loadCheckpoint(&checkpoint)){
+        return;
+    }
+
+    //Reboot while programming the data that follows
+    espOtaStubTornWrite(lost_checkpoint.image_offset, NB_TORN_BYTE);
+
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Resume(&checkpoint.image));
+    HOST_TEST_CHECK(espOtaStubGetNbResume() == (nb_resume + 1));
+
+    offset = checkpoint.payload_offset;
+    if(feed(&offset, &block_index, payload_size)){
+        HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_End());
+        checkPartition();
+    }
+}
+
+static void testTruncated(void){
+
+    size_t offset = 0;
+    uint32_t block_index = 0;
+
+    HOST_TEST_CHECK(OTA_IMAGE_STATUS_OK == OTA_IMAGE_Begin());
+    if(feed(&offset, &block_index, payload_size - 1)){
+        HOST_TEST_CHECK(OTA_IMAGE_STATUS_ERROR == OTA_IMAGE_End());
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+int main(int argc, char *argv[]){
+
+    if(argc < 3){
+        printf("usage: %s <application.bin> <image.ota> [-v]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    host_test_verbose = (argc > 3) && (0 == strcmp(argv[3], "-v"));
+
+    if((!readFile(argv[1], &app_file)) || (!readFile(argv[2], &ota_file))){
+        return EXIT_FAILURE;
+    }
+
+    //Sub-elements follow the OTA file header
+    uint16_t header_len = (uint16_t)(ota_file.pData[OTA_FILE_HEADER_LEN_OFFSET] |
+                                     (ota_file.pData[OTA_FILE_HEADER_LEN_OFFSET + 1] << 8));
+    if(!HOST_TEST_CHECK(header_len < ota_file.size)){
+        return hostTestResult();
+    }
+    pPayload = &ota_file.pData[header_len];
+    payload_size = ota_file.size - header_len;
+
+    printf("%s: %zu bytes image, %zu bytes payload\n", argv[2], app_file.size, payload_size);
+
+    testFullImage();
+    testResume(0);
+    testResume(10);
+    testResume(50);
+    testResume(99);
+    testTruncated();
+
+    return hostTestResult();
+}
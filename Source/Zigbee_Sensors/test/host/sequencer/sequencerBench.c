@@ -0,0 +1,381 @@
+/******************************************************************************
+*   Sequencer host benchmark.
+*
+*   Play random sequences on 1, 16 and 256 outputs with a simulated tic
+*   counter and compare the timer wheel sequencer with a naive reference
+*   that scans every output at every tic. Keyframe durations cover both
+*   wheel levels, their boundaries and the deadlines beyond them, and
+*   sequences are restarted at random times while others are playing. The
+*   tic counter wraps during the run.
+*
+*   The edges of each output must be the same for both, the processing time
+*   is printed for information.
+*
+*   Usage: sequencerBench [-v]
+*******************************************************************************/
+
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sequencer.h"
+#include "hostTest.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define BENCH_MAX_NB_OUTPUT             (256)
+#define BENCH_NB_SEQUENCE               (64)
+#define BENCH_MAX_NB_KEYFRAME           (8)
+#define BENCH_NB_RESTART_PER_OUTPUT     (8)
+#define BENCH_RUN_TIC                   (1000000)
+#define BENCH_START_TIC                 (UINT32_MAX - 100000)//Tic counter wraps during the run
+
+#define FNV_OFFSET                      (2166136261UL)
+#define FNV_PRIME                       (16777619UL)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct Bench_Record_s{
+    uint32_t nb_edge;
+    uint32_t hash;                      //Of the edges tic, level and fade time
+}Bench_Record_t;
+
+typedef struct Bench_Restart_s{
+    uint32_t tic;                       //From the run start
+    uint16_t output;
+    uint8_t sequence;
+}Bench_Restart_t;
+
+//Reference sequencer state of an output
+typedef struct Bench_RefOutput_s{
+    SEQUENCE_t const *pSequence;
+    bool playing;
+    uint32_t deadline;
+    uint8_t keyframe_index;
+    uint32_t loop_cptr;
+}Bench_RefOutput_t;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const uint16_t nb_output_table[] = {1, 16, 256};
+
+static SEQUENCE_Keyframe_t keyframe_pool[BENCH_NB_SEQUENCE][BENCH_MAX_NB_KEYFRAME];
+static SEQUENCE_t sequence_pool[BENCH_NB_SEQUENCE];
+
+static const SEQUENCE_Keyframe_t stop_keyframe = {SEQUENCE_LEVEL_OFF, SEQUENCE_EASE_STEP, SEQUENCE_ACTIVE_FOREVER};
+static const SEQUENCE_t seq_stop = {.pKeyframes = &stop_keyframe, .nb_keyframe = 1, .loop_start = 1, .nb_loop = 1};
+
+static Bench_Restart_t restart_table[BENCH_MAX_NB_OUTPUT * BENCH_NB_RESTART_PER_OUTPUT];
+static uint32_t nb_restart = 0;
+
+static SEQUENCE_OutputId_t output_id_table[BENCH_MAX_NB_OUTPUT];
+static Bench_Record_t wheel_record_table[BENCH_MAX_NB_OUTPUT];
+static Bench_Record_t ref_record_table[BENCH_MAX_NB_OUTPUT];
+static Bench_RefOutput_t ref_output_table[BENCH_MAX_NB_OUTPUT];
+
+static uint32_t now_tic = 0;
+static uint32_t random_state = 0x2545F491;
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static uint32_t randomGet(uint32_t range){
+
+    //xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+
+    return random_state % range;
+}
+
+//Durations below one tic, around the wheel level boundaries, within level 0,
+//within level 1 and beyond it
+static uint32_t randomDurationMs(void){
+
+    static const uint32_t boundary_tic_table[] = {63, 64, 65, (64 * 64) - 1, 64 * 64, (64 * 64) + 1};
+
+    switch(randomGet(5)){
+        case 0:
+            return randomGet(2 * SEQUENCER_TIC_PERIOD_MS);
+        case 1:
+            return boundary_tic_table[randomGet(sizeof(boundary_tic_table) / sizeof(boundary_tic_table[0]))] *
+                   SEQUENCER_TIC_PERIOD_MS;
+        case 2:
+            return randomGet(64 * SEQUENCER_TIC_PERIOD_MS);
+        case 3:
+            return randomGet(64 * 64 * SEQUENCER_TIC_PERIOD_MS);
+        default:
+            return randomGet(16 * 64 * 64 * SEQUENCER_TIC_PERIOD_MS);
+    }
+}
+
+static void buildSequencePool(void){
+
+    for(uint8_t i = 0; i < BENCH_NB_SEQUENCE; i++){
+        SEQUENCE_t *pSequence = &sequence_pool[i];
+        uint8_t nb_keyframe = (uint8_t)(1 + randomGet(BENCH_MAX_NB_KEYFRAME));
+
+        for(uint8_t j = 0; j < nb_keyframe; j++){
+            keyframe_pool[i][j].level = (uint8_t)randomGet(SEQUENCE_LEVEL_ON + 1);
+            keyframe_pool[i][j].easing = randomGet(2) ? SEQUENCE_EASE_LINEAR : SEQUENCE_EASE_STEP;
+            keyframe_pool[i][j].duration_ms = randomDurationMs();
+        }
+
+        //Some sequences end holding their last level
+        if(randomGet(4) == 0){
+            keyframe_pool[i][nb_keyframe - 1].duration_ms = SEQUENCE_ACTIVE_FOREVER;
+        }
+
+        pSequence->pKeyframes = keyframe_pool[i];
+        pSequence->nb_keyframe = nb_keyframe;
+        pSequence->loop_start = (uint8_t)randomGet(nb_keyframe + 1);//nb_keyframe: no loop
+        pSequence->nb_loop = randomGet(2) ? SEQUENCE_REPEAT_FOREVER : (1 + randomGet(5));
+        pSequence->duration_ms = SEQUENCE_ACTIVE_FOREVER;//Not used by the sequencer
+    }
+}
+
+//One restart per period, at a random tic of it
+static void buildRestartTable(uint16_t nb_output){
+
+    nb_restart = (uint32_t)nb_output * BENCH_NB_RESTART_PER_OUTPUT;
+    uint32_t period_tic = (BENCH_RUN_TIC - 1) / nb_restart;
+
+    for(uint32_t i = 0; i < nb_restart; i++){
+        restart_table[i].tic = 1 + (i * period_tic) + randomGet(period_tic);
+        restart_table[i].output = (uint16_t)randomGet(nb_output);
+        restart_table[i].sequence = (uint8_t)randomGet(BENCH_NB_SEQUENCE);
+    }
+}
+
+static void addEdge(Bench_Record_t *pRecord, uint32_t elapsed_tic, uint8_t level, uint32_t fade_time_ms){
+
+    uint32_t edge[3] = {elapsed_tic, level, fade_time_ms};
+
+    for(uint8_t i = 0; i < 3; i++){
+        pRecord->hash = (pRecord->hash ^ edge[i]) * FNV_PRIME;
+    }
+    pRecord->nb_edge++;
+}
+
+static void resetRecords(Bench_Record_t *pRecord_table){
+
+    for(uint16_t i = 0; i < BENCH_MAX_NB_OUTPUT; i++){
+        pRecord_table[i].nb_edge = 0;
+        pRecord_table[i].hash = FNV_OFFSET;
+    }
+}
+
+static SEQUENCER_Ret_t setOutputCallback(void *pArg, uint8_t level, uint32_t fade_time_ms){
+
+    addEdge((Bench_Record_t *)pArg, now_tic - BENCH_START_TIC, level, fade_time_ms);
+
+    return SEQUENCER_STATUS_OK;
+}
+
+static double elapsedMs(struct timespec const *pStart){
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((double)(end.tv_sec - pStart->tv_sec) * 1000.0) + ((double)(end.tv_nsec - pStart->tv_nsec) / 1000000.0);
+}
+
+//Reference: same keyframe rules as the sequencer, without curves
+static void refApplyKeyframe(uint16_t output){
+
+    Bench_RefOutput_t *pOutput = &ref_output_table[output];
+    SEQUENCE_Keyframe_t const *pKeyframe = &pOutput->pSequence->pKeyframes[pOutput->keyframe_index];
+    bool forever = (pKeyframe->duration_ms == SEQUENCE_ACTIVE_FOREVER);
+    uint32_t fade_time_ms = ((pKeyframe->easing == SEQUENCE_EASE_LINEAR) && (!forever)) ? pKeyframe->duration_ms : 0;
+
+    addEdge(&ref_record_table[output], now_tic - BENCH_START_TIC, pKeyframe->level, fade_time_ms);
+
+    pOutput->playing = !forever;
+    if(!forever){
+        uint32_t duration_tic = SEQUENCER_MS_TO_TIC(pKeyframe->duration_ms);
+        pOutput->deadline += (duration_tic == 0) ? 1 : duration_tic;
+    }
+}
+
+static void refNextKeyframe(uint16_t output){
+
+    Bench_RefOutput_t *pOutput = &ref_output_table[output];
+    SEQUENCE_t const *pSequence = pOutput->pSequence;
+
+    pOutput->keyframe_index++;
+    if(pOutput->keyframe_index >= pSequence->nb_keyframe){
+
+        if((pSequence->loop_start >= pSequence->nb_keyframe) ||
+           ((pSequence->nb_loop != SEQUENCE_REPEAT_FOREVER) && (++pOutput->loop_cptr >= pSequence->nb_loop))){
+            pOutput->playing = false;
+            return;
+        }
+        pOutput->keyframe_index = pSequence->loop_start;
+    }
+
+    refApplyKeyframe(output);
+}
+
+static void refStartSequence(uint16_t output, SEQUENCE_t const *pSequence){
+
+    ref_output_table[output].pSequence = pSequence;
+    ref_output_table[output].deadline = now_tic;
+    ref_output_table[output].keyframe_index = 0;
+    ref_output_table[output].loop_cptr = 0;
+
+    refApplyKeyframe(output);
+}
+
+//Scan every output at every tic
+static double runReference(uint16_t nb_output){
+
+    struct timespec start;
+    uint32_t restart_index = 0;
+
+    resetRecords(ref_record_table);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    now_tic = BENCH_START_TIC;
+    for(uint16_t i = 0; i < nb_output; i++){
+        refStartSequence(i, &sequence_pool[i % BENCH_NB_SEQUENCE]);
+    }
+
+    for(uint32_t elapsed = 1; elapsed < BENCH_RUN_TIC; elapsed++){
+        now_tic = BENCH_START_TIC + elapsed;
+
+        if((restart_index < nb_restart) && (restart_table[restart_index].tic == elapsed)){
+            refStartSequence(restart_table[restart_index].output, &sequence_pool[restart_table[restart_index].sequence]);
+            restart_index++;
+        }
+
+        for(uint16_t i = 0; i < nb_output; i++){
+            if(ref_output_table[i].playing && (ref_output_table[i].deadline == now_tic)){
+                refNextKeyframe(i);
+            }
+        }
+    }
+
+    return elapsedMs(&start);
+}
+
+//Call SEQUENCER_Process() at the returned deadlines and at the restarts
+static double runWheel(uint16_t nb_output, uint32_t *pNb_process){
+
+    struct timespec start;
+    uint32_t restart_index = 0;
+    uint32_t elapsed = 0;
+
+    resetRecords(wheel_record_table);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    now_tic = BENCH_START_TIC;
+    for(uint16_t i = 0; i < nb_output; i++){
+        SEQUENCER_DoSequence(output_id_table[i], &sequence_pool[i % BENCH_NB_SEQUENCE]);
+    }
+    uint32_t next_deadline = SEQUENCER_Process();
+    *pNb_process = 1;
+
+    while(true){
+        uint32_t next_elapsed = BENCH_RUN_TIC;
+
+        if((next_deadline != SEQUENCER_NO_DEADLINE) && (next_deadline < (BENCH_RUN_TIC - elapsed))){
+            next_elapsed = elapsed + next_deadline;
+        }
+        if((restart_index < nb_restart) && (restart_table[restart_index].tic < next_elapsed)){
+            next_elapsed = restart_table[restart_index].tic;
+        }
+        if((next_elapsed >= BENCH_RUN_TIC) || (!HOST_TEST_CHECK(next_elapsed > elapsed))){
+            break;
+        }
+
+        elapsed = next_elapsed;
+        now_tic = BENCH_START_TIC + elapsed;
+
+        if((restart_index < nb_restart) && (restart_table[restart_index].tic == elapsed)){
+            SEQUENCER_DoSequence(output_id_table[restart_table[restart_index].output],
+                                 &sequence_pool[restart_table[restart_index].sequence]);
+            restart_index++;
+        }
+
+        next_deadline = SEQUENCER_Process();
+        (*pNb_process)++;
+    }
+
+    return elapsedMs(&start);
+}
+
+static void stopOutputs(uint16_t nb_output){
+
+    for(uint16_t i = 0; i < nb_output; i++){
+        SEQUENCER_DoSequence(output_id_table[i], &seq_stop);
+    }
+    HOST_TEST_CHECK(SEQUENCER_NO_DEADLINE == SEQUENCER_Process());
+}
+
+static void runBench(uint16_t nb_output){
+
+    uint32_t nb_process = 0;
+    uint32_t nb_edge = 0;
+
+    buildRestartTable(nb_output);
+
+    double ref_ms = runReference(nb_output);
+    double wheel_ms = runWheel(nb_output, &nb_process);
+
+    for(uint16_t i = 0; i < nb_output; i++){
+        bool ok = HOST_TEST_CHECK(wheel_record_table[i].nb_edge == ref_record_table[i].nb_edge) &&
+                  HOST_TEST_CHECK(wheel_record_table[i].hash == ref_record_table[i].hash);
+
+        if((!ok) || host_test_verbose){
+            printf("    output %u: %u edges (reference %u)\n", (unsigned)i,
+                   (unsigned)wheel_record_table[i].nb_edge, (unsigned)ref_record_table[i].nb_edge);
+        }
+        nb_edge += ref_record_table[i].nb_edge;
+    }
+
+    printf("%3u outputs: %8u edges, %8u restarts, timer wheel %8.2f ms (%8u process calls), tic scan %8.2f ms\n",
+           (unsigned)nb_output, (unsigned)nb_edge, (unsigned)nb_restart, wheel_ms, (unsigned)nb_process, ref_ms);
+
+    stopOutputs(nb_output);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+uint32_t SEQUENCER_CFG_GetTic(void){
+    return now_tic;
+}
+
+int main(int argc, char *argv[]){
+
+    host_test_verbose = (argc > 1) && (0 == strcmp(argv[1], "-v"));
+
+    for(uint16_t i = 0; i < BENCH_MAX_NB_OUTPUT; i++){
+        SEQUENCE_Output_t output = {
+            .set_output_cb = setOutputCallback,
+            .play_curve_cb = NULL,
+            .pArg = &wheel_record_table[i],
+        };
+
+        if(!HOST_TEST_CHECK(SEQUENCER_STATUS_OK == SEQUENCER_RegisterOutput(&output, &output_id_table[i]))){
+            return hostTestResult();
+        }
+    }
+
+    buildSequencePool();
+
+    printf("%u tics of %u ms per run\n", (unsigned)BENCH_RUN_TIC, (unsigned)SEQUENCER_TIC_PERIOD_MS);
+    for(uint8_t i = 0; i < sizeof(nb_output_table) / sizeof(nb_output_table[0]); i++){
+        runBench(nb_output_table[i]);
+    }
+
+    return hostTestResult();
+}
@@ -0,0 +1,266 @@
+/******************************************************************************
+*   Sequencer host test.
+*
+*   Play the led sequences with a simulated tic counter and compare the
+*   output edges with the expected tic sequences. The blink tics are the
+*   ones of the original tic counter sequencer: the initial OFF time, then
+*   ON and OFF steps lasting their time plus one tic.
+*
+*   Each sequence is played from several start tics (including a tic counter
+*   wrap), calling SEQUENCER_Process() at the returned deadlines like the led
+*   controller does, and at every tic.
+*
+*   Usage: sequencerTest [-v]
+*******************************************************************************/
+
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sequencer.h"
+#include "ledSequence_cfg.h"
+#include "hostTest.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define MAX_NB_EDGE                     (64)
+#define EDGE_CURVE                      (0xFFFF)//Curve played by the output
+
+#define LVL_OFF                         (SEQUENCE_LEVEL_OFF)
+#define LVL_ON                          (SEQUENCE_LEVEL_ON)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct Test_Edge_s{
+    uint32_t tic;                       //From the sequence start
+    uint16_t level;                     //EDGE_CURVE for a curve
+    uint32_t fade_time_ms;              //Number of keyframes for a curve
+}Test_Edge_t;
+
+typedef struct Test_Case_s{
+    const char *pName;
+    SEQUENCE_t const *pSequence;
+    bool curve_output;
+    uint32_t run_tic;                   //Simulated time
+    bool ends;                          //No deadline left at the end
+    Test_Edge_t const *pEdges;
+    uint8_t nb_edge;
+}Test_Case_t;
+
+typedef enum Test_Drive_e{
+    TEST_DRIVE_DEADLINE,                //Process at the returned deadlines
+    TEST_DRIVE_EVERY_TIC,               //Process at every tic
+
+    TEST_DRIVE_NB,
+}Test_Drive_t;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const Test_Edge_t boot_edges[] = {
+    {0, LVL_OFF, 0}, {50, LVL_ON, 0}, {551, LVL_OFF, 0},
+};
+
+static const Test_Edge_t factory_reset_edges[] = {
+    {0, LVL_OFF, 0},
+    {25, LVL_ON, 0}, {76, LVL_OFF, 0}, {127, LVL_ON, 0}, {178, LVL_OFF, 0}, {229, LVL_ON, 0},
+    {280, LVL_OFF, 0}, {331, LVL_ON, 0}, {382, LVL_OFF, 0}, {433, LVL_ON, 0}, {484, LVL_OFF, 0},
+};
+
+static const Test_Edge_t scanning_edges[] = {
+    {0, LVL_OFF, 0},
+    {25, LVL_ON, 0}, {76, LVL_OFF, 0}, {127, LVL_ON, 0}, {178, LVL_OFF, 0}, {229, LVL_ON, 0},
+    {280, LVL_OFF, 0}, {331, LVL_ON, 0}, {382, LVL_OFF, 0}, {433, LVL_ON, 0}, {484, LVL_OFF, 0},
+    {535, LVL_ON, 0}, {586, LVL_OFF, 0},
+};
+
+static const Test_Edge_t status_edges[] = {
+    {0, LVL_OFF, 0}, {25, LVL_ON, 0}, {526, LVL_OFF, 0},
+};
+
+static const Test_Edge_t always_off_edges[] = {
+    {0, LVL_OFF, 0},
+};
+
+//Breathing: the ON/OFF fades are played as one curve by the led driver
+static const Test_Edge_t identify_curve_edges[] = {
+    {0, LVL_OFF, 0}, {25, EDGE_CURVE, 2}, {125, EDGE_CURVE, 2}, {225, EDGE_CURVE, 2},
+};
+
+//Breathing on an output without curve support: one fade per keyframe
+static const Test_Edge_t identify_fade_edges[] = {
+    {0, LVL_OFF, 0},
+    {25, LVL_ON, 500}, {75, LVL_OFF, 500}, {125, LVL_ON, 500}, {175, LVL_OFF, 500}, {225, LVL_ON, 500},
+    {275, LVL_OFF, 500},
+};
+
+#define TEST_EDGES(edges)               (edges), (uint8_t)(sizeof(edges) / sizeof((edges)[0]))
+
+static const Test_Case_t test_case_table[] = {
+    {"boot",            &seq_boot,          true,   1000,   true,   TEST_EDGES(boot_edges)},
+    {"factory reset",   &seq_factory_reset, true,   1000,   true,   TEST_EDGES(factory_reset_edges)},
+    {"scanning",        &seq_scanning,      true,   600,    false,  TEST_EDGES(scanning_edges)},
+    {"status",          &seq_status,        true,   1000,   true,   TEST_EDGES(status_edges)},
+    {"always off",      &seq_always_off,    true,   1000,   true,   TEST_EDGES(always_off_edges)},
+    {"identify curve",  &seq_identify,      true,   300,    false,  TEST_EDGES(identify_curve_edges)},
+    {"identify fade",   &seq_identify,      false,  300,    false,  TEST_EDGES(identify_fade_edges)},
+};
+
+static const uint32_t start_tic_table[] = {0, 1000003, UINT32_MAX - 200};
+
+static uint32_t now_tic = 0;
+static uint32_t start_tic = 0;
+static Test_Edge_t edge_table[MAX_NB_EDGE];
+static uint8_t nb_edge = 0;
+
+static SEQUENCE_OutputId_t curve_output_id = SEQUENCE_OUTPUT_ID_INVALID;
+static SEQUENCE_OutputId_t fade_output_id = SEQUENCE_OUTPUT_ID_INVALID;
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void addEdge(uint16_t level, uint32_t fade_time_ms){
+
+    if(HOST_TEST_CHECK(nb_edge < MAX_NB_EDGE)){
+        edge_table[nb_edge].tic = now_tic - start_tic;
+        edge_table[nb_edge].level = level;
+        edge_table[nb_edge].fade_time_ms = fade_time_ms;
+        nb_edge++;
+    }
+}
+
+static SEQUENCER_Ret_t setOutputCallback(void *pArg, uint8_t level, uint32_t fade_time_ms){
+
+    (void)pArg;
+    addEdge(level, fade_time_ms);
+
+    return SEQUENCER_STATUS_OK;
+}
+
+static SEQUENCER_Ret_t playCurveCallback(void *pArg, SEQUENCE_Keyframe_t const *pKeyframes, uint8_t nb_keyframe){
+
+    (void)pArg;
+    (void)pKeyframes;
+    addEdge(EDGE_CURVE, nb_keyframe);
+
+    return SEQUENCER_STATUS_OK;
+}
+
+//Play a sequence, return true if no deadline is left at the end
+static bool playSequence(SEQUENCE_OutputId_t output_id, SEQUENCE_t const *pSequence, uint32_t run_tic, Test_Drive_t drive){
+
+    now_tic = start_tic;
+    nb_edge = 0;
+
+    HOST_TEST_CHECK(SEQUENCER_STATUS_OK == SEQUENCER_DoSequence(output_id, pSequence));
+    uint32_t next_deadline = SEQUENCER_Process();
+
+    while((now_tic - start_tic) < run_tic){
+
+        if(drive == TEST_DRIVE_EVERY_TIC){
+            now_tic++;
+        }
+        else if((next_deadline == SEQUENCER_NO_DEADLINE) ||
+                (next_deadline > (run_tic - (now_tic - start_tic)))){
+            break;
+        }
+        else if(!HOST_TEST_CHECK(next_deadline > 0)){
+            return false;
+        }
+        else{
+            now_tic += next_deadline;
+        }
+
+        next_deadline = SEQUENCER_Process();
+    }
+
+    return (next_deadline == SEQUENCER_NO_DEADLINE);
+}
+
+static void stopOutput(SEQUENCE_OutputId_t output_id){
+
+    SEQUENCER_DoSequence(output_id, &seq_always_off);
+    SEQUENCER_Process();
+    nb_edge = 0;
+}
+
+static void printEdges(void){
+
+    for(uint8_t i = 0; i < nb_edge; i++){
+        printf("    %4u: level %3u, %u\n",
+               (unsigned)edge_table[i].tic,
+               (unsigned)edge_table[i].level,
+               (unsigned)edge_table[i].fade_time_ms);
+    }
+}
+
+static void runTestCase(Test_Case_t const *pTest, Test_Drive_t drive){
+
+    SEQUENCE_OutputId_t output_id = pTest->curve_output ? curve_output_id : fade_output_id;
+
+    bool ended = playSequence(output_id, pTest->pSequence, pTest->run_tic, drive);
+
+    bool ok = HOST_TEST_CHECK(nb_edge == pTest->nb_edge);
+    for(uint8_t i = 0; ok && (i < nb_edge); i++){
+        ok = HOST_TEST_CHECK(edge_table[i].tic == pTest->pEdges[i].tic) &&
+             HOST_TEST_CHECK(edge_table[i].level == pTest->pEdges[i].level) &&
+             HOST_TEST_CHECK(edge_table[i].fade_time_ms == pTest->pEdges[i].fade_time_ms);
+    }
+
+    //The deadline driven sequencer must not keep a deadline for a finished sequence
+    if(drive == TEST_DRIVE_DEADLINE){
+        ok = HOST_TEST_CHECK(ended == pTest->ends) && ok;
+    }
+
+    if((!ok) || host_test_verbose){
+        printf("  %s (start %u, drive %d):\n", pTest->pName, (unsigned)start_tic, drive);
+        printEdges();
+    }
+
+    stopOutput(output_id);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+uint32_t SEQUENCER_CFG_GetTic(void){
+    return now_tic;
+}
+
+int main(int argc, char *argv[]){
+
+    host_test_verbose = (argc > 1) && (0 == strcmp(argv[1], "-v"));
+
+    SEQUENCE_Output_t curve_output = {
+        .set_output_cb = setOutputCallback,
+        .play_curve_cb = playCurveCallback,
+        .pArg = NULL,
+    };
+    SEQUENCE_Output_t fade_output = {
+        .set_output_cb = setOutputCallback,
+        .play_curve_cb = NULL,
+        .pArg = NULL,
+    };
+
+    if((!HOST_TEST_CHECK(SEQUENCER_STATUS_OK == SEQUENCER_RegisterOutput(&curve_output, &curve_output_id))) ||
+       (!HOST_TEST_CHECK(SEQUENCER_STATUS_OK == SEQUENCER_RegisterOutput(&fade_output, &fade_output_id)))){
+        return hostTestResult();
+    }
+
+    for(uint8_t i = 0; i < sizeof(start_tic_table) / sizeof(start_tic_table[0]); i++){
+        start_tic = start_tic_table[i];
+
+        for(uint8_t drive = 0; drive < TEST_DRIVE_NB; drive++){
+            for(uint8_t j = 0; j < sizeof(test_case_table) / sizeof(test_case_table[0]); j++){
+                runTestCase(&test_case_table[j], (Test_Drive_t)drive);
+            }
+        }
+    }
+
+    return hostTestResult();
+}
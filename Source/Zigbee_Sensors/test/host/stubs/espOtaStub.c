@@ -0,0 +1,201 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_ota_ops.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define STUB_HANDLE                     (1)
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const esp_partition_t update_partition = {
+    .address = 0x100000,
+    .size = ESP_OTA_STUB_PARTITION_SIZE,
+    .label = "ota_0",
+};
+
+//Not erased: holds an older image until the sequential writes erase it
+static uint8_t partition_data[ESP_OTA_STUB_PARTITION_SIZE];
+static size_t write_offset = 0;
+static bool opened = false;
+static uint32_t nb_resume = 0;
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static bool isInPartition(const esp_partition_t *partition, size_t offset, size_t size){
+
+    return (partition == &update_partition) && (offset <= sizeof(partition_data)) &&
+           (size <= (sizeof(partition_data) - offset));
+}
+
+//NOR flash programming: bits can only go from 1 to 0
+static void programFlash(size_t offset, const uint8_t *pData, size_t size){
+
+    for(size_t i = 0; i < size; i++){
+        partition_data[offset + i] &= pData[i];
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+const char *esp_err_to_name(esp_err_t code){
+
+    switch(code){
+        case ESP_OK:                        return "ESP_OK";
+        case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_OTA_VALIDATE_FAILED:   return "ESP_ERR_OTA_VALIDATE_FAILED";
+        default:                            return "ESP_FAIL";
+    }
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from){
+
+    (void)start_from;
+    return &update_partition;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle){
+
+    (void)image_size;
+    if((partition != &update_partition) || (out_handle == NULL)){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    //Sequential writes: nothing is erased before the first write
+    write_offset = 0;
+    opened = true;
+    *out_handle = STUB_HANDLE;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_resume(const esp_partition_t *partition, size_t erase_size, size_t image_offset, esp_ota_handle_t *out_handle){
+
+    (void)erase_size;
+    if((partition != &update_partition) || (out_handle == NULL) || (image_offset > sizeof(partition_data))){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    write_offset = image_offset;
+    opened = true;
+    nb_resume++;
+    *out_handle = STUB_HANDLE;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size){
+
+    if((!opened) || (handle != STUB_HANDLE)){
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(size > (sizeof(partition_data) - write_offset)){
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    //Erase the sectors entered by the write, like esp_ota_write()
+    size_t first_sector = write_offset / SPI_FLASH_SEC_SIZE;
+    size_t last_sector = (write_offset + size - 1) / SPI_FLASH_SEC_SIZE;
+    if((size > 0) && ((write_offset % SPI_FLASH_SEC_SIZE) == 0)){
+        esp_partition_erase_range(&update_partition, write_offset, (last_sector - first_sector + 1) * SPI_FLASH_SEC_SIZE);
+    }
+    else if((size > 0) && (first_sector != last_sector)){
+        esp_partition_erase_range(&update_partition, (first_sector + 1) * SPI_FLASH_SEC_SIZE,
+                                  (last_sector - first_sector) * SPI_FLASH_SEC_SIZE);
+    }
+
+    programFlash(write_offset, data, size);
+    write_offset += size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle){
+
+    if((!opened) || (handle != STUB_HANDLE)){
+        return ESP_ERR_INVALID_STATE;
+    }
+    opened = false;
+
+    if((write_offset == 0) || (partition_data[0] != ESP_IMAGE_HEADER_MAGIC)){
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle){
+
+    (void)handle;
+    opened = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition){
+
+    return (partition == &update_partition) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size){
+
+    if((!isInPartition(partition, src_offset, size)) || (dst == NULL)){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(dst, &partition_data[src_offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size){
+
+    if((!isInPartition(partition, dst_offset, size)) || (src == NULL)){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    programFlash(dst_offset, src, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size){
+
+    if((!isInPartition(partition, offset, size)) ||
+       ((offset % SPI_FLASH_SEC_SIZE) != 0) || ((size % SPI_FLASH_SEC_SIZE) != 0)){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&partition_data[offset], 0xFF, size);
+    return ESP_OK;
+}
+
+const uint8_t *espOtaStubGetPartitionData(size_t *pWritten){
+
+    if(pWritten != NULL){
+        *pWritten = write_offset;
+    }
+    return partition_data;
+}
+
+void espOtaStubTornWrite(size_t offset, size_t size){
+
+    static const uint8_t pattern[] = {0x5A, 0xC3};
+
+    //Power lost while programming: some bits of the range are cleared
+    for(size_t i = offset; (i < (offset + size)) && (i < sizeof(partition_data)); i++){
+        programFlash(i, &pattern[i % sizeof(pattern)], 1);
+    }
+}
+
+uint32_t espOtaStubGetNbResume(void){
+
+    return nb_resume;
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "esp_zigbee_core.h"
+#include "esp_timer.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define STUB_CMD_QUEUE_SIZE             (16)
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static ESP_ZB_Stub_Cmd_t cmd_queue[STUB_CMD_QUEUE_SIZE];
+static uint8_t cmd_head = 0;
+static uint8_t cmd_count = 0;
+static uint8_t next_tsn = 0;
+
+//The engine keeps a single alarm pending
+static esp_zb_callback_t alarm_cb = NULL;
+static uint8_t alarm_param = 0;
+static int64_t alarm_time_ms = 0;
+
+static esp_zb_zdo_match_desc_callback_t match_cb = NULL;
+static void *match_ctx = NULL;
+
+static uint8_t image_status = 0;
+static uint32_t file_offset = 0;
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+//SET data type: the value is sent as the raw command payload
+uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req){
+
+    uint8_t tsn = next_tsn++;
+
+    if((cmd_count >= STUB_CMD_QUEUE_SIZE) || (cmd_req->data.size > ESP_ZB_STUB_MAX_PAYLOAD)){
+        return tsn;
+    }
+
+    ESP_ZB_Stub_Cmd_t *pCmd = &cmd_queue[(cmd_head + cmd_count) % STUB_CMD_QUEUE_SIZE];
+    pCmd->req = *cmd_req;
+    memcpy(pCmd->payload, cmd_req->data.value, cmd_req->data.size);
+    pCmd->req.data.value = pCmd->payload;
+    pCmd->tsn = tsn;
+    cmd_count++;
+
+    return tsn;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check){
+
+    (void)endpoint;
+    (void)check;
+    if((cluster_id != ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE) || (cluster_role != ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE)){
+        return 0x86;//Unsupported attribute
+    }
+
+    if(attr_id == ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID){
+        image_status = *(uint8_t *)value_p;
+    }
+    else if(attr_id == ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID){
+        memcpy(&file_offset, value_p, sizeof(file_offset));
+    }
+
+    return 0;
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time){
+
+    alarm_cb = cb;
+    alarm_param = param;
+    alarm_time_ms = (esp_timer_get_time() / 1000) + time;
+}
+
+void esp_zb_zdo_match_cluster(esp_zb_zdo_match_desc_req_param_t *param, esp_zb_zdo_match_desc_callback_t user_cb, void *user_ctx){
+
+    (void)param;
+    match_cb = user_cb;
+    match_ctx = user_ctx;
+}
+
+bool espZbStubPopCommand(ESP_ZB_Stub_Cmd_t *pCmd){
+
+    if(cmd_count == 0){
+        return false;
+    }
+
+    *pCmd = cmd_queue[cmd_head];
+    pCmd->req.data.value = pCmd->payload;
+    cmd_head = (cmd_head + 1) % STUB_CMD_QUEUE_SIZE;
+    cmd_count--;
+
+    return true;
+}
+
+bool espZbStubRunAlarm(void){
+
+    if((alarm_cb == NULL) || ((esp_timer_get_time() / 1000) < alarm_time_ms)){
+        return false;
+    }
+
+    esp_zb_callback_t cb = alarm_cb;
+    alarm_cb = NULL;
+    cb(alarm_param);
+
+    return true;
+}
+
+bool espZbStubAnswerMatch(esp_zb_zdp_status_t status, uint16_t addr, uint8_t endpoint){
+
+    if(match_cb == NULL){
+        return false;
+    }
+
+    esp_zb_zdo_match_desc_callback_t cb = match_cb;
+    match_cb = NULL;
+    cb(status, addr, endpoint, match_ctx);
+
+    return true;
+}
+
+uint8_t espZbStubGetImageStatus(void){
+
+    return image_status;
+}
+
+uint32_t espZbStubGetFileOffset(void){
+
+    return file_offset;
+}
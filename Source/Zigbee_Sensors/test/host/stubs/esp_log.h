@@ -0,0 +1,23 @@
+#ifndef _ESP_LOG_STUB_H
+#define _ESP_LOG_STUB_H
+
+#include <stdio.h>
+
+/******************************************************************************
+*   Host stub of the ESP-IDF logging macros, printed on stdout when
+*   HOST_TEST_VERBOSE is set.
+*******************************************************************************/
+#define ESP_LOG_NONE                    (0)
+#define ESP_LOG_ERROR                   (1)
+#define ESP_LOG_WARN                    (2)
+#define ESP_LOG_INFO                    (3)
+#define ESP_LOG_DEBUG                   (4)
+
+extern int host_test_verbose;
+
+#define ESP_LOGI(tag, fmt, ...)         do{ if(host_test_verbose){ printf("I (%s) " fmt "\n", tag, ##__VA_ARGS__); } }while(0)
+#define ESP_LOGW(tag, fmt, ...)         ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...)         ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)         do{ (void)(tag); }while(0)
+
+#endif//_ESP_LOG_STUB_H
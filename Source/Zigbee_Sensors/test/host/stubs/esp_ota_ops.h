@@ -0,0 +1,36 @@
+#ifndef _ESP_OTA_OPS_STUB_H
+#define _ESP_OTA_OPS_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+/******************************************************************************
+*   Host stub of the ESP-IDF OTA API. The update partition is a RAM buffer
+*   that the test reads back with espOtaStubGetPartitionData(). Sequential
+*   writes erase a sector when they enter it, like esp_ota_write().
+*******************************************************************************/
+#define OTA_SIZE_UNKNOWN                (0xFFFFFFFF)
+#define OTA_WITH_SEQUENTIAL_WRITES      (0xFFFFFFFE)
+
+#define ESP_OTA_STUB_PARTITION_SIZE     (1536 * 1024)
+#define ESP_IMAGE_HEADER_MAGIC          (0xE9)
+
+typedef uint32_t esp_ota_handle_t;
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from);
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle);
+esp_err_t esp_ota_resume(const esp_partition_t *partition, size_t erase_size, size_t image_offset, esp_ota_handle_t *out_handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+//Test helpers
+const uint8_t *espOtaStubGetPartitionData(size_t *pWritten);
+void espOtaStubTornWrite(size_t offset, size_t size);
+uint32_t espOtaStubGetNbResume(void);
+
+#endif//_ESP_OTA_OPS_STUB_H
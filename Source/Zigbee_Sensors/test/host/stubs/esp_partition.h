@@ -0,0 +1,25 @@
+#ifndef _ESP_PARTITION_STUB_H
+#define _ESP_PARTITION_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+/******************************************************************************
+*   Host stub of the ESP-IDF partition API. The partition behaves like NOR
+*   flash: writes can only clear bits, erases set whole sectors to 0xFF.
+*******************************************************************************/
+#define SPI_FLASH_SEC_SIZE              (4096)
+
+typedef struct esp_partition_s{
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+}esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+#endif//_ESP_PARTITION_STUB_H
@@ -0,0 +1,9 @@
+#ifndef _ESP_SYSTEM_STUB_H
+#define _ESP_SYSTEM_STUB_H
+
+/******************************************************************************
+*   Host stub of the ESP-IDF system API, the restart is recorded by the test.
+*******************************************************************************/
+void esp_restart(void);
+
+#endif//_ESP_SYSTEM_STUB_H
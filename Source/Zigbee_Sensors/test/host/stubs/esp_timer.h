@@ -0,0 +1,12 @@
+#ifndef _ESP_TIMER_STUB_H
+#define _ESP_TIMER_STUB_H
+
+#include <stdint.h>
+
+/******************************************************************************
+*   Host stub of the ESP-IDF high resolution timer, the time is given by the
+*   test.
+*******************************************************************************/
+int64_t esp_timer_get_time(void);
+
+#endif//_ESP_TIMER_STUB_H
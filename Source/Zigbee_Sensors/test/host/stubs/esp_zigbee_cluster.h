@@ -0,0 +1,6 @@
+#ifndef _ESP_ZIGBEE_CLUSTER_STUB_H
+#define _ESP_ZIGBEE_CLUSTER_STUB_H
+
+#include "esp_zigbee_core.h"
+
+#endif//_ESP_ZIGBEE_CLUSTER_STUB_H
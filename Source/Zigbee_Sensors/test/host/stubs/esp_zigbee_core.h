@@ -0,0 +1,117 @@
+#ifndef _ESP_ZIGBEE_CORE_STUB_H
+#define _ESP_ZIGBEE_CORE_STUB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/******************************************************************************
+*   Host stub of the esp-zigbee API used by the OTA fetch engine. Commands
+*   sent by the application are queued for the test, scheduler alarms and
+*   ZDO requests are run by the test.
+*******************************************************************************/
+#define ESP_ZB_AF_HA_PROFILE_ID                         (0x0104)
+#define ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE               (0x0019)
+#define ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE                  (0x02)
+#define ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT            (0x02)
+#define ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV                 (0x00)
+#define ESP_ZB_ZCL_ATTR_TYPE_SET                        (0x50)
+
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID      (0x0001)
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID     (0x0006)
+
+#define ESP_ZB_ZDP_STATUS_SUCCESS                       (0x00)
+#define ESP_ZB_ZDP_STATUS_TIMEOUT                       (0x85)
+
+#define ESP_ZB_STUB_MAX_PAYLOAD                         (128)
+
+typedef uint8_t esp_zb_zdp_status_t;
+typedef uint8_t esp_zb_zcl_status_t;
+
+typedef void (*esp_zb_callback_t)(uint8_t param);
+typedef void (*esp_zb_zdo_match_desc_callback_t)(esp_zb_zdp_status_t zdo_status, uint16_t addr, uint8_t endpoint, void *user_ctx);
+
+typedef struct esp_zb_cluster_list_s esp_zb_cluster_list_t;
+typedef struct esp_zb_zcl_ota_upgrade_value_message_s esp_zb_zcl_ota_upgrade_value_message_t;
+
+typedef struct esp_zb_zcl_custom_cluster_cmd_req_s{
+    struct{
+        union{
+            uint16_t addr_short;
+        }dst_addr_u;
+        uint8_t dst_endpoint;
+        uint8_t src_endpoint;
+    }zcl_basic_cmd;
+    uint8_t address_mode;
+    uint16_t profile_id;
+    uint16_t cluster_id;
+    uint8_t direction;
+    uint8_t dis_default_resp;
+    uint8_t custom_cmd_id;
+    struct{
+        uint8_t type;
+        uint16_t size;
+        void *value;
+    }data;
+}esp_zb_zcl_custom_cluster_cmd_req_t;
+
+typedef struct esp_zb_zcl_custom_cluster_command_message_s{
+    struct{
+        esp_zb_zcl_status_t status;
+        struct{
+            uint8_t tsn;
+        }header;
+        struct{
+            union{
+                uint16_t short_addr;
+            }u;
+        }src_address;
+        uint8_t src_endpoint;
+        uint8_t dst_endpoint;
+        uint16_t cluster;
+        struct{
+            uint8_t id;
+            uint8_t direction;
+        }command;
+    }info;
+    struct{
+        uint16_t size;
+        void *value;
+    }data;
+}esp_zb_zcl_custom_cluster_command_message_t;
+
+typedef struct esp_zb_zcl_command_send_status_message_s{
+    esp_err_t status;
+    uint8_t tsn;
+}esp_zb_zcl_command_send_status_message_t;
+
+typedef struct esp_zb_zdo_match_desc_req_param_s{
+    uint16_t dst_nwk_addr;
+    uint16_t addr_of_interest;
+    uint16_t profile_id;
+    uint8_t num_in_clusters;
+    uint8_t num_out_clusters;
+    uint16_t *cluster_list;
+}esp_zb_zdo_match_desc_req_param_t;
+
+uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req);
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check);
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+void esp_zb_zdo_match_cluster(esp_zb_zdo_match_desc_req_param_t *param, esp_zb_zdo_match_desc_callback_t user_cb, void *user_ctx);
+
+//Test helpers
+typedef struct ESP_ZB_Stub_Cmd_s{
+    esp_zb_zcl_custom_cluster_cmd_req_t req;//data.value points to payload
+    uint8_t payload[ESP_ZB_STUB_MAX_PAYLOAD];
+    uint8_t tsn;
+}ESP_ZB_Stub_Cmd_t;
+
+bool espZbStubPopCommand(ESP_ZB_Stub_Cmd_t *pCmd);
+bool espZbStubRunAlarm(void);
+bool espZbStubAnswerMatch(esp_zb_zdp_status_t status, uint16_t addr, uint8_t endpoint);
+uint8_t espZbStubGetImageStatus(void);
+uint32_t espZbStubGetFileOffset(void);
+
+#endif//_ESP_ZIGBEE_CORE_STUB_H
@@ -0,0 +1,37 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hostTest.h"
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+int host_test_verbose = 0;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static unsigned nb_check = 0;
+static unsigned nb_failed = 0;
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+bool hostTestCheck(bool cond, const char *pText, const char *pFile, int line){
+
+    nb_check++;
+    if(!cond){
+        nb_failed++;
+        printf("FAILED %s:%d: %s\n", pFile, line, pText);
+    }
+    return cond;
+}
+
+int hostTestResult(void){
+
+    printf("%u checks, %u failed\n", nb_check, nb_failed);
+    return (nb_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,17 @@
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdbool.h>
+
+/******************************************************************************
+*   Host test helpers. A failed check is reported and counted, the test keeps
+*   running; main() returns hostTestResult().
+*******************************************************************************/
+#define HOST_TEST_CHECK(cond)           hostTestCheck((cond), #cond, __FILE__, __LINE__)
+
+extern int host_test_verbose;
+
+bool hostTestCheck(bool cond, const char *pText, const char *pFile, int line);
+int hostTestResult(void);
+
+#endif//_HOST_TEST_H
@@ -0,0 +1,122 @@
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include <stdbool.h>
+
+#include "nvs.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define NVS_STUB_MAX_NB_KEY             (8)
+#define NVS_STUB_KEY_SIZE               (16)
+#define NVS_STUB_BLOB_SIZE              (4096)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct NVS_Stub_Entry_s{
+    bool used;
+    char key[NVS_STUB_KEY_SIZE];
+    uint8_t blob[NVS_STUB_BLOB_SIZE];
+    size_t length;
+}NVS_Stub_Entry_t;
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static NVS_Stub_Entry_t entry_table[NVS_STUB_MAX_NB_KEY];
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static NVS_Stub_Entry_t *findEntry(const char *key){
+
+    for(int i = 0; i < NVS_STUB_MAX_NB_KEY; i++){
+        if(entry_table[i].used && (0 == strncmp(entry_table[i].key, key, NVS_STUB_KEY_SIZE))){
+            return &entry_table[i];
+        }
+    }
+    return NULL;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle){
+
+    (void)name;
+    (void)open_mode;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length){
+
+    (void)handle;
+    if(length > NVS_STUB_BLOB_SIZE){
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    NVS_Stub_Entry_t *pEntry = findEntry(key);
+    for(int i = 0; (pEntry == NULL) && (i < NVS_STUB_MAX_NB_KEY); i++){
+        if(!entry_table[i].used){
+            pEntry = &entry_table[i];
+        }
+    }
+    if(pEntry == NULL){
+        return ESP_ERR_NO_MEM;
+    }
+
+    pEntry->used = true;
+    strncpy(pEntry->key, key, NVS_STUB_KEY_SIZE - 1);
+    memcpy(pEntry->blob, value, length);
+    pEntry->length = length;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length){
+
+    (void)handle;
+    NVS_Stub_Entry_t *pEntry = findEntry(key);
+    if(pEntry == NULL){
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if(out_value == NULL){
+        *length = pEntry->length;
+        return ESP_OK;
+    }
+    if(*length < pEntry->length){
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(out_value, pEntry->blob, pEntry->length);
+    *length = pEntry->length;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key){
+
+    (void)handle;
+    NVS_Stub_Entry_t *pEntry = findEntry(key);
+    if(pEntry == NULL){
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    pEntry->used = false;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle){
+
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle){
+
+    (void)handle;
+}
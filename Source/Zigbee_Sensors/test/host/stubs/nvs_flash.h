@@ -0,0 +1,6 @@
+#ifndef _NVS_FLASH_STUB_H
+#define _NVS_FLASH_STUB_H
+
+#include "nvs.h"
+
+#endif//_NVS_FLASH_STUB_H
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Build Zigbee OTA upgrade files for the Zigbee_Sensors firmware.
+
+The application binary produced by ESP-IDF is wrapped in a Zigbee OTA file
+(header + sub-elements). By default the binary is stored in a manufacturer
+specific sub-element (tag 0xF000) compressed with heatshrink, which the
+device decompresses on the fly while writing the OTA partition.
+
+Compressed sub-element layout (little-endian):
+    u8  window bits
+    u8  lookahead bits
+    u32 decompressed image size
+    ... heatshrink stream
+
+Example:
+    python ota_image_tool.py build/Zigbee_Sensors.bin --version 0x00000002
+"""
+
+import argparse
+import struct
+import sys
+
+OTA_FILE_IDENTIFIER = 0x0BEEF11E
+OTA_HEADER_VERSION = 0x0100
+OTA_HEADER_SIZE = 56
+OTA_STACK_VERSION = 0x0002  # Zigbee PRO
+
+TAG_UPGRADE_IMAGE = 0x0000
+TAG_COMPRESSED_IMAGE = 0xF000
+
+DEFAULT_MANUFACTURER_CODE = 0x131B
+DEFAULT_IMAGE_TYPE = 0x1001
+DEFAULT_WINDOW_BITS = 10
+DEFAULT_LOOKAHEAD_BITS = 5
+
+HSD_WINDOW_BITS_MIN = 4
+HSD_WINDOW_BITS_MAX = 11  # Must match heatshrinkDecoder.h
+HSD_LOOKAHEAD_BITS_MIN = 3
+
+MATCH_CANDIDATES = 32
+
+
+class BitWriter:
+    """MSB first bit writer."""
+
+    def __init__(self):
+        self.data = bytearray()
+        self.acc = 0
+        self.nbits = 0
+
+    def write(self, value, nbits):
+        self.acc = (self.acc << nbits) | (value & ((1 << nbits) - 1))
+        self.nbits += nbits
+        while self.nbits >= 8:
+            self.nbits -= 8
+            self.data.append((self.acc >> self.nbits) & 0xFF)
+        self.acc &= (1 << self.nbits) - 1
+
+    def finish(self):
+        if self.nbits:
+            self.data.append((self.acc << (8 - self.nbits)) & 0xFF)
+            self.acc = 0
+            self.nbits = 0
+        return bytes(self.data)
+
+
+def heatshrink_compress(data, window_bits, lookahead_bits):
+    """Compress data with heatshrink (LZSS) encoding.
+
+    Literal:        1 + 8 bits value
+    Back-reference: 0 + W bits (distance - 1) + L bits (count - 1)
+    """
+    window = 1 << window_bits
+    max_count = 1 << lookahead_bits
+    # Only emit back-references shorter than the equivalent literals
+    min_count = (1 + window_bits + lookahead_bits) // 9 + 1
+
+    out = BitWriter()
+    chains = {}
+    size = len(data)
+    pos = 0
+
+    def insert(i):
+        if i + 3 <= size:
+            key = data[i:i + 3]
+            lst = chains.setdefault(key, [])
+            lst.append(i)
+            if len(lst) > MATCH_CANDIDATES:
+                del lst[0]
+
+    while pos < size:
+        best_len = 0
+        best_dist = 0
+        if pos + 3 <= size:
+            limit = min(max_count, size - pos)
+            for cand in reversed(chains.get(data[pos:pos + 3], ())):
+                dist = pos - cand
+                if dist > window:
+                    break
+                length = 3
+                while length < limit and data[cand + length] == data[pos + length]:
+                    length += 1
+                if length > best_len:
+                    best_len = length
+                    best_dist = dist
+                    if length == limit:
+                        break
+
+        if best_len >= max(min_count, 3):
+            out.write(0, 1)
+            out.write(best_dist - 1, window_bits)
+            out.write(best_len - 1, lookahead_bits)
+            for i in range(pos, pos + best_len):
+                insert(i)
+            pos += best_len
+        else:
+            out.write(1, 1)
+            out.write(data[pos], 8)
+            insert(pos)
+            pos += 1
+
+    return out.finish()
+
+
+def heatshrink_decompress(data, window_bits, lookahead_bits):
+    """Reference decoder used to check the compressed stream."""
+    out = bytearray()
+    acc = 0
+    nbits = 0
+    it = iter(data)
+
+    def take(n):
+        nonlocal acc, nbits
+        while nbits < n:
+            b = next(it, None)
+            if b is None:
+                return None
+            acc = (acc << 8) | b
+            nbits += 8
+        nbits -= n
+        return (acc >> nbits) & ((1 << n) - 1)
+
+    while True:
+        tag = take(1)
+        if tag is None:
+            break
+        if tag:
+            value = take(8)
+            if value is None:
+                break
+            out.append(value)
+        else:
+            index = take(window_bits)
+            count = take(lookahead_bits) if index is not None else None
+            if count is None:
+                break
+            for _ in range(count + 1):
+                src = len(out) - (index + 1)
+                out.append(out[src] if src >= 0 else 0)
+    return bytes(out)
+
+
+def build_element(tag, payload):
+    return struct.pack('<HI', tag, len(payload)) + payload
+
+
+def build_ota_file(args, image):
+    if args.raw:
+        element = build_element(TAG_UPGRADE_IMAGE, image)
+    else:
+        stream = heatshrink_compress(image, args.window_bits, args.lookahead_bits)
+        if heatshrink_decompress(stream, args.window_bits, args.lookahead_bits)[:len(image)] != image:
+            raise RuntimeError('heatshrink round trip check failed')
+        payload = struct.pack('<BBI', args.window_bits, args.lookahead_bits, len(image)) + stream
+        element = build_element(TAG_COMPRESSED_IMAGE, payload)
+        print('Compressed %d -> %d bytes (%.1f%%)' % (len(image), len(stream), 100.0 * len(stream) / max(len(image), 1)))
+
+    header_string = args.header_string.encode('ascii')[:32].ljust(32, b'\0')
+    total_size = OTA_HEADER_SIZE + len(element)
+    header = struct.pack('<IHHHHHIH32sI',
+                         OTA_FILE_IDENTIFIER,
+                         OTA_HEADER_VERSION,
+                         OTA_HEADER_SIZE,
+                         0x0000,  # Field control: no optional fields
+                         args.manufacturer,
+                         args.image_type,
+                         args.version,
+                         OTA_STACK_VERSION,
+                         header_string,
+                         total_size)
+    return header + element
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build a Zigbee OTA file from an ESP-IDF application binary')
+    parser.add_argument('input', help='ESP-IDF application binary')
+    parser.add_argument('-o', '--output', help='Output OTA file (default: <input>.ota)')
+    parser.add_argument('--version', type=lambda x: int(x, 0), required=True, help='OTA file version')
+    parser.add_argument('--manufacturer', type=lambda x: int(x, 0), default=DEFAULT_MANUFACTURER_CODE)
+    parser.add_argument('--image-type', type=lambda x: int(x, 0), default=DEFAULT_IMAGE_TYPE)
+    parser.add_argument('--header-string', default='Zigbee_Sensors')
+    parser.add_argument('--window-bits', type=int, default=DEFAULT_WINDOW_BITS)
+    parser.add_argument('--lookahead-bits', type=int, default=DEFAULT_LOOKAHEAD_BITS)
+    parser.add_argument('--raw', action='store_true', help='Store the image uncompressed (tag 0x0000)')
+    args = parser.parse_args()
+
+    if not HSD_WINDOW_BITS_MIN <= args.window_bits <= HSD_WINDOW_BITS_MAX:
+        parser.error('window bits must be in [%d, %d]' % (HSD_WINDOW_BITS_MIN, HSD_WINDOW_BITS_MAX))
+    if not HSD_LOOKAHEAD_BITS_MIN <= args.lookahead_bits < args.window_bits:
+        parser.error('lookahead bits must be in [%d, window bits[' % HSD_LOOKAHEAD_BITS_MIN)
+
+    with open(args.input, 'rb') as f:
+        image = f.read()
+
+    ota = build_ota_file(args, image)
+
+    output = args.output or args.input + '.ota'
+    with open(output, 'wb') as f:
+        f.write(ota)
+    print('Wrote %s (%d bytes)' % (output, len(ota)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())